@@ -0,0 +1,45 @@
+#ifndef BENCHPERF_HPP
+#define BENCHPERF_HPP
+
+#include "benchmark/benchmark.h"
+#include "dbphd/perf/perfcounters.hpp"
+
+// Hardware counters of the manually timed part of every iteration of a CRUD
+// bench, sampled only when $DBPHD_PERF is set. Call start() before taking the
+// start time and stop() after taking the end time, so the two reads are not
+// timed. The per iteration averages are published as counters named after the
+// events (Cycles, Instructions, ...) when it goes out of scope after the loop.
+class PerfIterations {
+public:
+	explicit PerfIterations(benchmark::State& state)
+		: state(state), hardware(perf::enabled() ? &perf::ThreadCounters::forThread() : nullptr) {}
+
+	~PerfIterations() {
+		if(hardware == nullptr)
+			return;
+		for(int e = 0; e < perf::EVENTS; ++e) {
+			auto event = static_cast<perf::Event>(e);
+			// Summed over the threads, then divided by all their iterations
+			if(hardware->isOpen(event))
+				state.counters[perf::eventName(event)] = benchmark::Counter(totals.total(event), benchmark::Counter::kAvgIterations);
+		}
+	}
+
+	void start() {
+		if(hardware)
+			begin = hardware->read();
+	}
+
+	void stop() {
+		if(hardware)
+			totals.add(begin, hardware->read());
+	}
+
+private:
+	benchmark::State& state;
+	perf::ThreadCounters* hardware;
+	perf::Sample begin;
+	perf::EventTotals totals;
+};
+
+#endif /* BENCHPERF_HPP */
@@ -0,0 +1,51 @@
+#ifndef BENCHREPORT_HPP
+#define BENCHREPORT_HPP
+
+#include "benchmark/benchmark.h"
+#include "dbphd/report/runreport.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Prints like the console reporter and adds every run to the global run report
+class ReportCollector : public benchmark::ConsoleReporter {
+public:
+	void ReportRuns(const std::vector<Run>& reports) override {
+		for(auto& run : reports) {
+			report::RunRecord record;
+			record.name = run.benchmark_name();
+			record.label = run.report_label;
+			record.aggregate = run.run_type == Run::RT_Aggregate;
+			record.threads = run.threads;
+			record.iterations = run.iterations;
+			record.realTime = run.GetAdjustedRealTime();
+			record.cpuTime = run.GetAdjustedCPUTime();
+			record.timeUnit = benchmark::GetTimeUnitString(run.time_unit);
+			for(auto& counter : run.counters) {
+				record.counters[counter.first] = counter.second;
+			}
+			report::RunReport::global().addRun(record);
+		}
+		ConsoleReporter::ReportRuns(reports);
+	}
+};
+
+// Writes the run report to $DBPHD_REPORT, by default to
+// reports/bench_<date>.json, and returns the path
+inline std::string writeRunReport() {
+	const char* path = std::getenv("DBPHD_REPORT");
+	std::filesystem::path file = path != nullptr ? path : fmt::format("reports/bench_{:%Y%m%d_%H%M%S}.json", std::chrono::system_clock::now());
+	if(file.has_parent_path())
+		std::filesystem::create_directories(file.parent_path());
+	std::ofstream out(file);
+	report::RunReport::global().write(out);
+	return file.string();
+}
+
+#endif /* BENCHREPORT_HPP */
@@ -0,0 +1,50 @@
+#ifndef BENCHSTATS_HPP
+#define BENCHSTATS_HPP
+
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "dbphd/report/runreport.hpp"
+
+// Server side statistics (buffer pool reads, lock waits, WAL bytes, ...) of a
+// CRUD bench. Thread 0 snapshots them when constructed before the loop and
+// again when it goes out of scope after the loop, and publishes how much each
+// grew as a counter. The statistics are server wide, so they include anything
+// else the server did meanwhile, and the last iterations of other threads may
+// land after the second snapshot.
+class ServerStatistics {
+public:
+	ServerStatistics(benchmark::State& state, std::function<std::map<std::string, double>()> snapshot)
+		: state(state), snapshot(state.thread_index() == 0 ? std::move(snapshot) : nullptr) {
+		if(this->snapshot)
+			before = take();
+	}
+
+	~ServerStatistics() {
+		if(!snapshot)
+			return;
+		for(auto& statistic : report::statisticsDelta(before, take()))
+			state.counters[statistic.first] = statistic.second;
+	}
+
+private:
+	// A missing statistic must not fail the benchmark
+	std::map<std::string, double> take() {
+		try {
+			return snapshot();
+		} catch(std::exception& e) {
+			std::cerr << "Could not read server statistics: " << e.what() << std::endl;
+			return {};
+		}
+	}
+
+	benchmark::State& state;
+	std::function<std::map<std::string, double>()> snapshot;
+	std::map<std::string, double> before;
+};
+
+#endif /* BENCHSTATS_HPP */
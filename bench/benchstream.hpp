@@ -0,0 +1,69 @@
+#ifndef BENCHSTREAM_HPP
+#define BENCHSTREAM_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+// Time to first row and peak client memory of the large result reads, whose
+// rows per second are their items_per_second. Call start() with the start time
+// of every iteration and row() for every row the client gets to see, the first
+// one of each iteration ends its time to first row. Thread 0 resets the peak
+// resident set size of the process when constructed, and publishes how far it
+// grew above the size at that point when it goes out of scope. Other threads
+// share the process, so their results count too. Without a resettable peak
+// (anything but Linux) the peak is the one since the process started.
+class StreamStatistics {
+public:
+	explicit StreamStatistics(benchmark::State& state) : state(state), memory(state.thread_index() == 0) {
+		if(memory) {
+			std::ofstream("/proc/self/clear_refs") << "5";
+			baseline = residentKiB("VmRSS:");
+		}
+	}
+
+	~StreamStatistics() {
+		// Summed over the threads, then divided by all their iterations
+		state.counters["FirstRow"] = benchmark::Counter(firstRows, benchmark::Counter::kAvgIterations);
+		if(memory) {
+			int64_t peak = residentKiB("VmHWM:");
+			state.counters["ClientPeak"] = benchmark::Counter(peak > baseline ? (double)(peak - baseline) * 1024 : 0, benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+		}
+	}
+
+	void start(std::chrono::high_resolution_clock::time_point now) {
+		begin = now;
+		first = true;
+	}
+
+	void row() {
+		if(first) {
+			first = false;
+			firstRows += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+		}
+	}
+
+private:
+	// A line of /proc/self/status in KiB, 0 when there is none
+	static int64_t residentKiB(const std::string& name) {
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while(std::getline(status, line)) {
+			if(line.compare(0, name.size(), name) == 0)
+				return std::stoll(line.substr(name.size()));
+		}
+		return 0;
+	}
+
+	benchmark::State& state;
+	bool memory;
+	int64_t baseline = 0;
+	std::chrono::high_resolution_clock::time_point begin;
+	bool first = false;
+	double firstRows = 0;
+};
+
+#endif /* BENCHSTREAM_HPP */
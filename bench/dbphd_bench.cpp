@@ -4,7 +4,7 @@
 
 #include "benchmark/benchmark.h"
 #include "dbphd/dbphd.hpp"
-#include "precalculate.hpp"
+#include "benchreport.hpp"
 
 using namespace std;
 
@@ -17,12 +17,9 @@ static void BM_Basic(benchmark::State& state) {
 //BENCHMARK(BM_Basic)->Iterations(2);
 
 int main(int argc, char** argv) {
-	cout << "Precalculating...";
-	cout.flush();
-	Precalculator::PreCalculate();
-	cout << " Done" << endl;
-	cout.flush();
 	::benchmark::Initialize(&argc, argv); 
 	if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
-	::benchmark::RunSpecifiedBenchmarks(); 
+	ReportCollector reporter;
+	::benchmark::RunSpecifiedBenchmarks(&reporter);
+	cout << "Run report written to " << writeRunReport() << endl;
 }
@@ -0,0 +1,27 @@
+#include "benchmark/benchmark.h"
+#include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpcmemory.hpp"
+#include "dbphd/tpc/tpcpacing.hpp"
+#include "tpccdriver.hpp"
+#include "tpccreport.hpp"
+
+using namespace tpcc;
+
+#include <memory>
+
+using namespace std;
+
+// Shared by every terminal, loaded by thread 0 through its backend
+static MemoryDatabase database;
+
+// Reference line for the scaling plots: the same transactions and counters as
+// the client/server engines, in process and without durability.
+static void BM_MEMORY_TPCC(benchmark::State &state, ArrivalProcess arrival) {
+    runTPCC(state, "memory_tpcc", arrival, [](benchmark::State & /*state*/) {
+        return make_unique<MemoryBackend>(database);
+    });
+}
+
+BENCHMARK_CAPTURE(BM_MEMORY_TPCC, Closed, ArrivalProcess::Closed)->RangeMultiplier(2)->Range(1,10)->ThreadRange(1,16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_MEMORY_TPCC, Constant, ArrivalProcess::Constant)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_MEMORY_TPCC, Poisson, ArrivalProcess::Poisson)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
@@ -1,8 +1,11 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/mongodb/mongodb.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 #include "mongocxx/bulk_write.hpp"
 #include "mongocxx/model/insert_one.hpp"
 #include "mongocxx/options/bulk_write.hpp"
+#include <optional>
 #include <random>
 #include <string>
 #include <iostream>
@@ -32,6 +35,16 @@ static void CustomArgumentsInserts(benchmark::internal::Benchmark* b) {
 	}
 }
 
+// Drops and creates the collection with an index on each of the first
+// indexes fields
+static void CreateCollection(mongocxx::collection& collection, int indexes) {
+	collection.drop();
+	collection.create_index(make_document(kvp("_id", 1))); // This creates the collection too
+	for(int index = 0; index < indexes; ++index) {
+		collection.create_index(make_document(kvp(("a" + to_string(index)), 1)));
+	}
+}
+
 static void BM_MONGO_Insert(benchmark::State& state, bool transactions) {
 	auto conn = MongoDBHandler::GetConnection();
 	auto db = conn->database("bench");
@@ -42,15 +55,11 @@ static void BM_MONGO_Insert(benchmark::State& state, bool transactions) {
 	// Per thread settings...
 	if(state.thread_index() == 0) {
 		// This is the first thread, so do initialization here, build indexes etc...
-		collection.drop();
-		collection.create_index(make_document(kvp("_id", 1))); // This creates the collection too
-		if(state.range(2) > 0) {
-			for(int index = 0; index < state.range(2); ++index) {
-				collection.create_index(make_document(kvp(("a" + to_string(index)), 1)));
-			}
-		}
+		CreateCollection(collection, state.range(2));
 	}
 	auto session = conn->start_session();
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		std::vector<bsoncxx::document::value> documents;
@@ -64,6 +73,7 @@ static void BM_MONGO_Insert(benchmark::State& state, bool transactions) {
 			documents.push_back(doc << bsoncxx::builder::stream::finalize);
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -73,6 +83,7 @@ static void BM_MONGO_Insert(benchmark::State& state, bool transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -112,15 +123,11 @@ static void BM_MONGO_Insert_Bulk(benchmark::State& state, bool transactions) {
 	// Per thread settings...
 	if(state.thread_index() == 0) {
 		// This is the first thread, so do initialization here, build indexes etc...
-		collection.drop();
-		collection.create_index(make_document(kvp("_id", 1))); // This creates the collection too
-		if(state.range(2) > 0) {
-			for(int index = 0; index < state.range(2); ++index) {
-				collection.create_index(make_document(kvp(("a" + to_string(index)), 1)));
-			}
-		}
+		CreateCollection(collection, state.range(2));
 	}
 	auto session = conn->start_session();
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		mongocxx::options::bulk_write bulkOptions;
@@ -138,6 +145,7 @@ static void BM_MONGO_Insert_Bulk(benchmark::State& state, bool transactions) {
 			writer.append(inserter);
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -149,6 +157,7 @@ static void BM_MONGO_Insert_Bulk(benchmark::State& state, bool transactions) {
 		}
 
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -177,3 +186,111 @@ static void BM_MONGO_Insert_Bulk(benchmark::State& state, bool transactions) {
 
 BENCHMARK_CAPTURE(BM_MONGO_Insert_Bulk, Normal, false)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MONGO_Insert_Bulk, Transact, true)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+// How BM_MONGO_Insert_Strategy writes the documents
+enum class InsertStrategy {
+	InsertOne = 0,     // insert_one per document
+	InsertMany = 1,    // One insert_many, like BM_MONGO_Insert
+	OrderedBulk = 2,   // An ordered bulk write of insert_one models
+	UnorderedBulk = 3  // An unordered bulk write, like BM_MONGO_Insert_Bulk
+};
+
+// The grid of CustomArgumentsInserts with every insert strategy
+static void CustomArgumentsStrategies(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= (1 << 12); i*=8) { // Documents
+		for (int j = 1; j <= 16; j *= 2) { // Fields
+			for(int k = 0; k <= j; ) { // Indexes
+				for(int l = (int)InsertStrategy::InsertOne; l <= (int)InsertStrategy::UnorderedBulk; ++l) { // Insert strategy
+					b->Args({i, j, k, l});
+				}
+				if(k == 0) {
+					k = 1;
+				} else {
+					k *= 2;
+				}
+			}
+		}
+	}
+}
+
+// The documents of BM_MONGO_Insert written the way the last argument says,
+// built while the timing is paused
+static void BM_MONGO_Insert_Strategy(benchmark::State& state, bool transactions) {
+	auto conn = MongoDBHandler::GetConnection();
+	auto db = conn->database("bench");
+	auto collection = db.collection("create_bench");
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	std::uniform_int_distribution<> dis(0, (1 << 16));
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateCollection(collection, state.range(2));
+	}
+	auto strategy = (InsertStrategy)state.range(3);
+	auto session = conn->start_session();
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
+	for(auto _ : state) {
+		state.PauseTiming();
+		std::vector<bsoncxx::document::value> documents;
+		for(int n = 0; n < state.range(0); ++n) {
+			auto builder = bsoncxx::builder::stream::document{};
+			auto doc = builder << "a0" << to_string(dis(gen));
+			for(int fields = 1; fields < state.range(1); ++fields) {
+				doc << ("a" + to_string(fields)) << dis(gen);
+			}
+
+			documents.push_back(doc << bsoncxx::builder::stream::finalize);
+		}
+		std::optional<mongocxx::bulk_write> writer;
+		if(strategy == InsertStrategy::OrderedBulk || strategy == InsertStrategy::UnorderedBulk) {
+			mongocxx::options::bulk_write bulkOptions;
+			bulkOptions.bypass_document_validation(true);
+			bulkOptions.ordered(strategy == InsertStrategy::OrderedBulk);
+			writer.emplace(collection.create_bulk_write(session, bulkOptions));
+			for(auto& document : documents) {
+				writer->append(mongocxx::model::insert_one(document.view()));
+			}
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		if(transactions) {
+			session.start_transaction();
+		}
+		if(writer) {
+			writer->execute();
+		} else if(strategy == InsertStrategy::InsertMany) {
+			collection.insert_many(session, documents);
+		} else {
+			for(auto& document : documents) {
+				collection.insert_one(session, document.view());
+			}
+		}
+		if(transactions) {
+			session.commit_transaction();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	if(state.thread_index() == 0) {
+		collection.drop();
+		// This is the first thread, so do destruction here (delete documents etc..)
+	}
+
+	state.SetComplexityN(state.range(0));
+	state.counters["Ops"] = benchmark::Counter(state.iterations()*state.range(0), benchmark::Counter::kIsRate);
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations()*state.range(0), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Documents", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Fields", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Strategy", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK_CAPTURE(BM_MONGO_Insert_Strategy, Normal, false)->Apply(CustomArgumentsStrategies)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_MONGO_Insert_Strategy, Transact, true)->Apply(CustomArgumentsStrategies)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
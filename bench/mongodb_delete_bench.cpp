@@ -4,6 +4,8 @@
 #include <mongocxx/exception/bulk_write_exception.hpp>
 #include "mongocxx/model/insert_one.hpp"
 #include <map>
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 #include "precalculate.hpp"
 
 #include <random>
@@ -19,9 +21,11 @@ using bsoncxx::builder::basic::kvp;
 using bsoncxx::builder::basic::make_document;
 
 static void CustomArgumentsDeletes(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
 		for (int j = 0; j <= i; ++j) { //  Indexes
-			b->Args({i, j});
+			for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+				b->Args({i, j, d});
+			}
 		}
 	}
 }
@@ -41,13 +45,12 @@ static void CreateCollection(mongocxx::pool::entry& conn, std::string postfix =
 		mongocxx::options::bulk_write writeOptions;
 		writeOptions.ordered(false);
 		auto writer = collection.create_bulk_write(writeOptions);
-		for(int i = 0; i < Precalculator::Rows; i += 100) {
-			for(int j = 0; j < 100 && i+j < Precalculator::Rows;++j) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += 100) {
+			for(int j = 0; j < 100 && i+j < Precalculator::Rows();++j) {
 				auto builder = bsoncxx::builder::stream::document{};
-				auto doc = builder << "_id" << j+i;
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 0; f < Precalculator::Columns; ++f) {
+				auto doc = builder << "_id" << (int)(j+i);
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 0; f < Precalculator::Columns(); ++f) {
 					doc << ("a" + to_string(f)) << rowval[f];
 				}
 
@@ -76,7 +79,7 @@ static void BM_MONGO_Delete(benchmark::State& state, bool transactions) {
 	auto collection = db.collection("delete_bench" + postfix);
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(2), 5);
 	// Per thread settings...
 	CreateCollection(conn, postfix);
 	collection = db.collection("delete_bench" + postfix);
@@ -92,11 +95,13 @@ static void BM_MONGO_Delete(benchmark::State& state, bool transactions) {
 	}
 	auto session = conn->start_session();
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		auto builder = bsoncxx::builder::stream::document{};
 		for(int n = 0; n < state.range(0); ++n) {
-			builder << ("a" + to_string(n)) << dis(gen);
+			builder << ("a" + to_string(n)) << (int)dis(gen);
 		}
 		auto doc = builder << bsoncxx::builder::stream::finalize;
 		mongocxx::options::bulk_write writeOptions;
@@ -108,6 +113,7 @@ static void BM_MONGO_Delete(benchmark::State& state, bool transactions) {
 		}
 		
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -118,6 +124,7 @@ static void BM_MONGO_Delete(benchmark::State& state, bool transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -147,6 +154,7 @@ static void BM_MONGO_Delete(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 
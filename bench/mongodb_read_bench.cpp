@@ -2,6 +2,12 @@
 #include "bsoncxx/document/value.hpp"
 #include "bsoncxx/json.hpp"
 #include "dbphd/mongodb/mongodb.hpp"
+#include "dbphd/mongodb/bsondecoder.hpp"
+#include "dbphd/join/clientjoin.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
+#include "benchstream.hpp"
 #include "precalculate.hpp"
 
 #include <random>
@@ -29,19 +35,23 @@ using bsoncxx::builder::basic::kvp;
 using bsoncxx::builder::basic::make_document;
 
 static void CustomArgumentsInserts(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
 		for (int j = 0; j <= i; ++j) { //  Indexes
-			b->Args({i, j});
+			for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+				b->Args({i, j, d});
+			}
 		}
 	}
 }
 
 static void CustomArgumentsInserts2(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 0; j <= Precalculator::Columns; ++j) { // fields to return
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 0; j <= Precalculator::Columns(); ++j) { // fields to return
 			for (int k = 0; k <= i; ++k) { //  Indexes
-				for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns-i); l *= 2) { // Documents to return
-					b->Args({i, j, k, l});
+				for(int64_t l = 1; l <= (int64_t)Precalculator::Matching(i); l *= 2) { // Documents to return
+					for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+						b->Args({i, j, k, l, d});
+					}
 				}
 			}
 		}
@@ -49,15 +59,15 @@ static void CustomArgumentsInserts2(benchmark::internal::Benchmark* b) {
 }
 
 static void CustomArgumentsInserts3(benchmark::internal::Benchmark* b) {
-	for (int i = 1; i <= Precalculator::Rows; i *= 2) { // documents to process
+	for (int64_t i = 1; i <= (int64_t)Precalculator::Rows(); i *= 2) { // documents to process
 		b->Args({i});
 	}
 }
 
 static void CustomArgumentsInserts4(benchmark::internal::Benchmark* b) {
-	for (int i = 1; i <= Precalculator::Columns; ++i) { // fields to sort
+	for (int i = 1; i <= Precalculator::Columns(); ++i) { // fields to sort
 		for (int k = 0; k <= i; ++k) { //  Indexes
-			for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns); l *= 2) { // Documents to return
+			for(int64_t l = 1; l <= (int64_t)Precalculator::Rows(); l *= 2) { // Documents to return
 				b->Args({i, k, l});
 			}
 		}
@@ -66,7 +76,7 @@ static void CustomArgumentsInserts4(benchmark::internal::Benchmark* b) {
 
 static void CustomArgumentsInserts5(benchmark::internal::Benchmark* b) {
 	for (int i = 0; i <= 2; ++i) { // fields to index
-		for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns); l *= 2) { // Documents to return
+		for(int64_t l = 1; l <= (int64_t)Precalculator::Rows(); l *= 2) { // Documents to return
 			b->Args({i, l});
 		}
 	}
@@ -74,7 +84,7 @@ static void CustomArgumentsInserts5(benchmark::internal::Benchmark* b) {
 
 static void CustomArgumentsInserts6(benchmark::internal::Benchmark* b) {
 	for (int i = 0; i <= 2; ++i) { // fields to index
-		for(int j = 1; j <= (int)pow(Precalculator::Values,Precalculator::Columns); j *= 2) { // Documents to return
+		for(int64_t j = 1; j <= (int64_t)Precalculator::Rows(); j *= 2) { // Documents to return
 			for(int k = 1; k < 8192; k *= 2) { // Documents to query for batch
 				b->Args({i, j, k});
 			}
@@ -82,6 +92,27 @@ static void CustomArgumentsInserts6(benchmark::internal::Benchmark* b) {
 	}
 }
 
+static void CustomArgumentsInserts7(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= 2; ++i) { // fields to index
+		for(int64_t j = 1; j <= (int64_t)Precalculator::Rows(); j *= 2) { // Documents to return
+			for(int k = 1; k <= j; k *= 2) { // Documents to query for batch, more than returned is the same batch
+				for(int l = (int)JoinAlgorithm::Hash; l <= (int)JoinAlgorithm::SortMerge; ++l) { // Client join algorithm
+					b->Args({i, j, k, l});
+				}
+			}
+		}
+	}
+}
+
+// Large results at different cursor batch sizes, 0 for the driver's default
+static void CustomArgumentsStream(benchmark::internal::Benchmark* b) {
+	for(int64_t l = 100; l <= (int64_t)Precalculator::Rows(); l *= 10) { // Documents to return
+		for(int64_t batch : {(int64_t)0, (int64_t)100, (int64_t)1000, (int64_t)10000, (int64_t)INT32_MAX}) { // Documents per batch
+			b->Args({l, batch});
+		}
+	}
+}
+
 static void CreateCollection(mongocxx::pool::entry& conn) {
 	static volatile bool created = false;
 	if(!created) {
@@ -95,13 +126,12 @@ static void CreateCollection(mongocxx::pool::entry& conn) {
 		collection.create_index(make_document(kvp("_id", 1)));
 
 		auto writer = collection.create_bulk_write();
-		for(int i = 0; i < Precalculator::Rows; i += 100) {
-			for(int j = 0; j < 100 && i+j < Precalculator::Rows;++j) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += 100) {
+			for(int j = 0; j < 100 && i+j < Precalculator::Rows();++j) {
 				auto builder = bsoncxx::builder::stream::document{};
-				auto doc = builder << "_id" << j+i;
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 0; f < Precalculator::Columns; ++f) {
+				auto doc = builder << "_id" << (int)(j+i);
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 0; f < Precalculator::Columns(); ++f) {
 					doc << ("a" + to_string(f)) << rowval[f];
 				}
 
@@ -112,6 +142,8 @@ static void CreateCollection(mongocxx::pool::entry& conn) {
 		writer.execute();
 		auto end = chrono::steady_clock::now();
 		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("mongodb", "read_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("mongodb", [&] { return MongoDBHandler::ServerInfo(*conn); });
 		cout.flush();
 	}
 	created = true;
@@ -124,7 +156,7 @@ static void BM_MONGO_Read_Count(benchmark::State& state, bool transactions) {
 	auto collection = db.collection("read_bench");
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(2), 5);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
 		// This is the first thread, so do initialization here, build indexes etc...
@@ -145,13 +177,16 @@ static void BM_MONGO_Read_Count(benchmark::State& state, bool transactions) {
 	}
 	auto session = conn->start_session();
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		auto builder = bsoncxx::builder::stream::document{};
 		for(int n = 0; n < state.range(0); ++n) {
-			builder << ("a" + to_string(n)) << dis(gen);
+			builder << ("a" + to_string(n)) << (int)dis(gen);
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -161,6 +196,7 @@ static void BM_MONGO_Read_Count(benchmark::State& state, bool transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -187,6 +223,7 @@ static void BM_MONGO_Read_Count(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_MONGO_Read_Count, Normal, false)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -198,7 +235,7 @@ static void BM_MONGO_Reads(benchmark::State& state, bool transactions) {
 	auto collection = db.collection("read_bench");
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(4), 5);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
 		// This is the first thread, so do initialization here, build indexes etc...
@@ -219,11 +256,20 @@ static void BM_MONGO_Reads(benchmark::State& state, bool transactions) {
 	}
 	auto session = conn->start_session();
 	uint64_t count = 0;
+	// Read the projected fields like a client would, straight from the cursor
+	vector<string> fields;
+	for(int i = 0; i < state.range(1); ++i) {
+		fields.push_back("a" + to_string(i));
+	}
+	BSONDecoder decoder(fields);
+	int64_t checksum = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		auto builder = bsoncxx::builder::stream::document{};
 		for(int n = 0; n < state.range(0); ++n) {
-			builder << ("a" + to_string(n)) << dis(gen);
+			builder << ("a" + to_string(n)) << (int)dis(gen);
 		}
 		mongocxx::options::find options;
 		options.batch_size(INT32_MAX).limit(state.range(3));
@@ -237,17 +283,23 @@ static void BM_MONGO_Reads(benchmark::State& state, bool transactions) {
 			options.projection(bsoncxx::builder::stream::document{} << "_id " << 1 << bsoncxx::builder::stream::finalize);
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
 		}
 		for(auto i : collection.find(session, builder << bsoncxx::builder::stream::finalize, options)) {
+			decoder.Decode(i);
+			for(size_t f = 0; f < decoder.Fields(); ++f) {
+				checksum += decoder.Int32(f);
+			}
 			++count;
 		}
 		if(transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -262,6 +314,7 @@ static void BM_MONGO_Reads(benchmark::State& state, bool transactions) {
 		// TODO Figure out way to kill collection after all tests of suite is done
 	}
 
+	benchmark::DoNotOptimize(checksum);
 	state.SetItemsProcessed(count);
 
 	// Set the counter as a rate. It will be presented divided
@@ -274,11 +327,64 @@ static void BM_MONGO_Reads(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsProj", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_MONGO_Reads, Normal, false)->Apply(CustomArgumentsInserts2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MONGO_Reads, Transact, true)->Apply(CustomArgumentsInserts2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 
+// Every field of the first documents, decoded from a cursor that fetches
+// batches of the given size
+static void BM_MONGO_Read_Stream(benchmark::State& state) {
+	auto conn = MongoDBHandler::GetConnection();
+	auto db = conn->database("bench");
+	auto collection = db.collection("read_bench");
+	if(state.thread_index() == 0) {
+		CreateCollection(conn);
+	}
+	vector<string> fields;
+	for(int i = 0; i < Precalculator::Columns(); ++i) {
+		fields.push_back("a" + to_string(i));
+	}
+	BSONDecoder decoder(fields);
+	mongocxx::options::find options;
+	options.limit(state.range(0));
+	if(state.range(1) > 0)
+		options.batch_size((int32_t)state.range(1));
+	uint64_t count = 0;
+	int64_t checksum = 0;
+	PerfIterations perfIterations(state);
+	StreamStatistics streamStats(state);
+	for(auto _ : state) {
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		streamStats.start(start);
+		for(auto i : collection.find(make_document(), options)) {
+			streamStats.row();
+			decoder.Decode(i);
+			for(size_t f = 0; f < decoder.Fields(); ++f) {
+				checksum += decoder.Int32(f);
+			}
+			++count;
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	benchmark::DoNotOptimize(checksum);
+	state.SetComplexityN(state.range(0));
+	state.SetItemsProcessed(count);
+	state.counters.insert({{"Limit", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Batch", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK(BM_MONGO_Read_Stream)->Apply(CustomArgumentsStream)->DenseThreadRange(1, 8, 2)->UseManualTime();
+
 static void BM_MONGO_Read_Sum(benchmark::State& state, bool transactions) {
 	auto conn = MongoDBHandler::GetConnection();
 	auto db = conn->database("bench");
@@ -294,12 +400,15 @@ static void BM_MONGO_Read_Sum(benchmark::State& state, bool transactions) {
 		collection.indexes().drop_all();
 	}
 	auto session = conn->start_session();
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		mongocxx::pipeline pipe;
 		pipe.limit(state.range(0));
 		pipe.group(bsoncxx::builder::stream::document{} << "_id"  << 1 << "count" << bsoncxx::builder::stream::open_document << "$sum" << "$a0" <<  bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::finalize);
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -312,6 +421,7 @@ static void BM_MONGO_Read_Sum(benchmark::State& state, bool transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -358,12 +468,15 @@ static void BM_MONGO_Read_Avg(benchmark::State& state, bool transactions) {
 		collection.indexes().drop_all();
 	}
 	auto session = conn->start_session();
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		mongocxx::pipeline pipe;
 		pipe.limit(state.range(0));
 		pipe.group(bsoncxx::builder::stream::document{} << "_id"  << 1 << "count" << bsoncxx::builder::stream::open_document << "$avg" << "$a0" <<  bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::finalize);
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 
 		if(transactions) {
@@ -377,6 +490,7 @@ static void BM_MONGO_Read_Avg(benchmark::State& state, bool transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -423,12 +537,15 @@ static void BM_MONGO_Read_Mul(benchmark::State& state, bool transactions) {
 		collection.indexes().drop_all();
 	}
 	auto session = conn->start_session();
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		mongocxx::pipeline pipe;
 		pipe.limit(state.range(0));
 		pipe.project(bsoncxx::builder::stream::document{} << "_id"  << 1 << "a0" << bsoncxx::builder::stream::open_document << "$multiply" << bsoncxx::builder::stream::open_array << "$a0" << 2 << bsoncxx::builder::stream::close_array <<  bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::finalize);
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -441,6 +558,7 @@ static void BM_MONGO_Read_Mul(benchmark::State& state, bool transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -497,6 +615,8 @@ static void BM_MONGO_Read_Sort(benchmark::State& state, bool transactions) {
 	}
 	auto session = conn->start_session();
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		auto builder = bsoncxx::builder::stream::document{};
@@ -511,6 +631,7 @@ static void BM_MONGO_Read_Sort(benchmark::State& state, bool transactions) {
 		options.batch_size(INT32_MAX).limit(state.range(2));
 		state.ResumeTiming();
 
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -522,6 +643,7 @@ static void BM_MONGO_Read_Sort(benchmark::State& state, bool transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -577,6 +699,8 @@ static void BM_MONGO_Read_Join(benchmark::State& state, bool transactions) {
 	}
 	auto session = conn->start_session();
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		mongocxx::pipeline pipe;
@@ -612,6 +736,7 @@ static void BM_MONGO_Read_Join(benchmark::State& state, bool transactions) {
 		options.allow_disk_use(true);
 		options.bypass_document_validation(true);
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -625,6 +750,7 @@ static void BM_MONGO_Read_Join(benchmark::State& state, bool transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -680,14 +806,28 @@ static void BM_MONGO_Read_Join_Manual(benchmark::State& state, bool transactions
 		}
 	}
 	auto session = conn->start_session();
-	uint64_t count = 0;
+	size_t limit = state.range(1);
+	JoinAlgorithm algorithm = static_cast<JoinAlgorithm>(state.range(3));
+	BSONDecoder outerDecoder{"_id", "a0"};
+	BSONDecoder innerDecoder{"_id", "a1"};
+	// (_id, a0) of the outer rows and (_id, a1) of the inner rows, decoded instead
+	// of copying the documents
+	vector<pair<int32_t, int32_t>> batch;
+	vector<pair<int32_t, int32_t>> inner;
+	// (outer _id, inner _id) of every joined pair
+	vector<pair<int32_t, int32_t>> results;
+	HashJoin<int32_t> hashJoin;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
-		vector<bsoncxx::document::value> batch;
+		batch.clear();
 		batch.reserve(state.range(2));
-		vector<pair<bsoncxx::document::value, vector<bsoncxx::document::view>>> results;
+		hashJoin.Reserve(state.range(2));
+		results.clear();
 		results.reserve(state.range(1));
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -695,52 +835,72 @@ static void BM_MONGO_Read_Join_Manual(benchmark::State& state, bool transactions
 		mongocxx::options::find opts;
 		opts.limit(state.range(1));
 
-        auto batchQueryProc = [&]() {
-            auto query = bsoncxx::builder::stream::document{};
-            auto partial = query << "$or" << bsoncxx::builder::stream::open_array;
-            for(auto querydoc : batch) {
-                auto viewer = querydoc.view();
-                //cout<< bsoncxx::to_json(viewer) << endl;
-                vector<bsoncxx::document::view> a;
-                results.push_back(make_pair(querydoc, a));
-                partial = partial << bsoncxx::builder::stream::open_document << "$and" << bsoncxx::builder::stream::open_array << bsoncxx::builder::stream::open_document << "a1" << viewer["a0"].get_int32() << bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::open_document << "_id"  << bsoncxx::builder::stream::open_document << "$ne" << viewer["_id"].get_int32() << bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::close_array << bsoncxx::builder::stream::close_document;
-            } 
-            mongocxx::options::find opts;
-            opts.limit(state.range(1));
-            auto afterin = partial << bsoncxx::builder::stream::close_array;
-            auto cursorinternal = collection.find(session, afterin << bsoncxx::builder::stream::finalize, opts);
-            for(auto doc : cursorinternal) {
-                for(auto res: results) {
-                    if(res.first.view()["a0"].get_value() == doc["a0"].get_value()) {
-                        res.second.push_back(doc);
-                        ++count;
-                        break;
-                    }
-                }
-                if(count >= state.range(1))
-                    break;
-            }
-            batch.clear();
-        };
-        //cout << "Limit: " << state.range(1) << endl;
+		auto batchQueryProc = [&]() {
+			auto query = bsoncxx::builder::stream::document{};
+			auto partial = query << "$or" << bsoncxx::builder::stream::open_array;
+			for(auto& outer : batch) {
+				partial = partial << bsoncxx::builder::stream::open_document << "$and" << bsoncxx::builder::stream::open_array << bsoncxx::builder::stream::open_document << "a1" << outer.second << bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::open_document << "_id"  << bsoncxx::builder::stream::open_document << "$ne" << outer.first << bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::close_array << bsoncxx::builder::stream::close_document;
+			}
+			mongocxx::options::find opts;
+			opts.limit(state.range(1));
+			auto afterin = partial << bsoncxx::builder::stream::close_array;
+			auto cursorinternal = collection.find(session, afterin << bsoncxx::builder::stream::finalize, opts);
+			// Joins on inner.a1 = outer.a0, the _id != predicate is applied again since
+			// the $or of the batch can bring in a row through another outer row's term
+			if(algorithm == JoinAlgorithm::Hash) {
+				hashJoin.Clear();
+				for(auto& outer : batch) {
+					hashJoin.Insert(outer.second);
+				}
+				for(auto doc : cursorinternal) {
+					innerDecoder.Decode(doc);
+					int32_t id = innerDecoder.Int32(0);
+					hashJoin.Probe(innerDecoder.Int32(1), [&](size_t row) {
+						if(batch[row].first == id || results.size() >= limit)
+							return false;
+						results.emplace_back(batch[row].first, id);
+						return true;
+					});
+					if(results.size() >= limit)
+						break;
+				}
+			} else {
+				inner.clear();
+				for(auto doc : cursorinternal) {
+					innerDecoder.Decode(doc);
+					inner.emplace_back(innerDecoder.Int32(0), innerDecoder.Int32(1));
+				}
+				SortMergeJoin(batch, inner,
+						[](const pair<int32_t, int32_t>& o) { return o.second; },
+						[](const pair<int32_t, int32_t>& i) { return i.second; },
+						[&](const pair<int32_t, int32_t>& o, const pair<int32_t, int32_t>& i) {
+							if(o.first == i.first || results.size() >= limit)
+								return false;
+							results.emplace_back(o.first, i.first);
+							return true;
+						});
+			}
+			batch.clear();
+		};
 		auto cursor = collection.find(session, {}, opts);
 		for(auto doc : cursor) {
-            //cout<< "doc: " << bsoncxx::to_json(doc) << endl;
-			batch.push_back(bsoncxx::document::value(doc));
+			outerDecoder.Decode(doc);
+			batch.emplace_back(outerDecoder.Int32(0), outerDecoder.Int32(1));
 			// Our batch is ready...
 			if(batch.size() == state.range(2)) {
-                batchQueryProc();
+				batchQueryProc();
 			}
-			if(count >= state.range(1))
+			if(results.size() >= limit)
 				break;
 		}
-        if(!batch.empty()) {
-            batchQueryProc();
-        }
+		if(!batch.empty()) {
+			batchQueryProc();
+		}
 		if(transactions) {
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -767,8 +927,9 @@ static void BM_MONGO_Read_Join_Manual(benchmark::State& state, bool transactions
 	// by the duration of the benchmark, and the result inverted.
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-	state.counters.insert({{"Indexes", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Batch", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+	state.counters.insert({{"Indexes", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Batch", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Join", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	state.SetLabel(JoinAlgorithmName(static_cast<JoinAlgorithm>(state.range(3))));
 }
 
-BENCHMARK_CAPTURE(BM_MONGO_Read_Join_Manual, Normal, false)->Apply(CustomArgumentsInserts6)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
-BENCHMARK_CAPTURE(BM_MONGO_Read_Join_Manual, Transact, true)->Apply(CustomArgumentsInserts6)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_MONGO_Read_Join_Manual, Normal, false)->Apply(CustomArgumentsInserts7)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_MONGO_Read_Join_Manual, Transact, true)->Apply(CustomArgumentsInserts7)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -1,7 +1,10 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/mongodb/mongodb.hpp"
+#include "dbphd/mongodb/bsoncommand.hpp"
+#include "dbphd/mongodb/bsondecoder.hpp"
 #include <mongocxx/exception/exception.hpp>
 #include <mongocxx/exception/operation_exception.hpp>
+#include <mongocxx/pipeline.hpp>
 #include <bsoncxx/builder/list.hpp>
 #include <bsoncxx/types.hpp>
 #include <bsoncxx/types/bson_value/value.hpp>
@@ -10,17 +13,29 @@ using bsoncxx::builder::basic::make_document;
 using bsoncxx::builder::list;
 using bsoncxx::builder::document;
 
+#include "dbphd/perf/affinity.hpp"
 #include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpcbackend.hpp"
+#include "dbphd/tpc/tpcpacing.hpp"
+#include "dbphd/tpc/tpcconflicts.hpp"
+#include "dbphd/tpc/tpcphases.hpp"
+#include "dbphd/tpc/tpcsnapshot.hpp"
+#include "tpccdriver.hpp"
+#include "tpccreport.hpp"
 
 using namespace tpcc;
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <deque>
 #include <fmt/chrono.h>
 #include <fmt/core.h>
 #include <iostream>
+#include <memory>
+#include <map>
 #include <omp.h>
+#include <optional>
 #include <random>
 #include <thread>
 #include <vector>
@@ -30,26 +45,9 @@ using namespace tpcc;
 //#define PRINT_TRACE
 using namespace std;
 
-static void LoadBenchmark(mongocxx::pool::entry& conn,
-                          ScaleParameters &params, int warehouses, int clients) {
-    static volatile bool created = false;
-    static ScaleParameters oldParams = ScaleParameters::makeDefault(1);
-    static volatile int oldclients = 0;
-    if (created && oldParams == params && clients == oldclients)
-        return;
-    created = false;
-    oldParams = params;
-    oldclients = clients;
-    cout << endl
-         << "Creating mongodb old TPC-C Tables with " << omp_get_num_procs()
-         << " threads ..." << endl;
-    cout.flush();
-    auto start = chrono::steady_clock::now();
-    {
-        auto db = conn->database("bench");
-        db.drop();
-    }
-
+// Generates the warehouses of params, each OpenMP thread loading its share
+// over its own connection, and the items when loadItems
+static void PopulateBenchmark(ScaleParameters &params, int clients, bool loadItems) {
     // Use clients to scale loading too
     vector<vector<int>> w_ids;
     w_ids.resize(omp_get_num_procs());
@@ -67,6 +65,10 @@ static void LoadBenchmark(mongocxx::pool::entry& conn,
     const static int BATCH_SIZE = 500;
 #pragma omp parallel private(threadId) num_threads(omp_get_num_procs())
     {
+        // Placed like the terminals, and unpinned again at the end of the region
+        // because OpenMP keeps its threads for later regions
+        perf::ScopedAffinity pinned(perf::workerCpus(omp_get_thread_num()));
+        seedLoader(omp_get_thread_num());
         auto mongoconn = MongoDBHandler::GetConnection();
         auto db = mongoconn->database("bench");
         auto warehouseC = db.collection("warehouse");
@@ -82,7 +84,7 @@ static void LoadBenchmark(mongocxx::pool::entry& conn,
         cout << "Thread: " << threadId << endl;
 #endif
         // Need to load items...
-        if (threadId == 0) {
+        if (threadId == 0 && loadItems) {
             auto itemC = db.collection("item");
             auto originalRows =
                 randomHelper.uniqueIds(params.items / 10, 1, params.items);
@@ -526,6 +528,150 @@ static void LoadBenchmark(mongocxx::pool::entry& conn,
             }
         } // Warehouse
     }     // Per thread/client
+}
+
+static const vector<string> tpccCollections = {"warehouse", "district", "customer", "history",
+                                               "new_order", "order", "order_line", "item",
+                                               "stock"};
+
+// Puts the loaded dataset back the way it was loaded before the next run, so
+// repeated runs start from the same data. The orders, order lines, new orders
+// and payments of the run are range deleted above the load-time marks of the
+// snapshot (the next order id of each district and the date of its latest
+// payment), the new orders the run delivered are inserted again and the
+// documents a run can change are replaced by their snapshot copies. $merge
+// cannot tell which ones changed, so every customer and stock document is
+// replaced. Without a snapshot the data of the earlier runs stays.
+static void ResetBenchmark(mongocxx::pool::entry& conn, const string &key) {
+    if (!snapshotsEnabled())
+        return;
+    if (!MongoDBHandler::SnapshotExists(*conn, key)) {
+        cout << "No snapshot of " << key << " to reset to" << endl;
+        return;
+    }
+    auto start = chrono::steady_clock::now();
+    auto db = conn->database("bench");
+    auto snapshot = conn->database(key);
+    mongocxx::options::find latest;
+    latest.sort(make_document(kvp("h_date", -1)));
+    auto lastPayment = snapshot["history"].find_one({}, latest);
+    if (lastPayment) {
+        db["history"].delete_many(make_document(
+            kvp("h_date", make_document(kvp("$gt", (*lastPayment)["h_date"].get_date())))));
+    }
+    for (auto &&district : snapshot["district"].find({})) {
+        int wId = district["d_w_id"].get_int32();
+        int dId = district["d_id"].get_int32();
+        int nextOId = district["d_next_o_id"].get_int32();
+        db["new_order"].delete_many(make_document(
+            kvp("no_w_id", wId), kvp("no_d_id", dId),
+            kvp("no_o_id", make_document(kvp("$gte", nextOId)))));
+        db["order_line"].delete_many(make_document(
+            kvp("ol_w_id", wId), kvp("ol_d_id", dId),
+            kvp("ol_o_id", make_document(kvp("$gte", nextOId)))));
+        db["order"].delete_many(make_document(
+            kvp("o_w_id", wId), kvp("o_d_id", dId),
+            kvp("o_id", make_document(kvp("$gte", nextOId)))));
+    }
+    MongoDBHandler::ResetCollection(*conn, key, "bench", "new_order", {}, true);
+    // Undelivered orders are loaded with the carrier "null"
+    MongoDBHandler::ResetCollection(*conn, key, "bench", "order",
+                                    make_document(kvp("o_carrier_id", "null")), false);
+    MongoDBHandler::ResetCollection(*conn, key, "bench", "order_line",
+                                    make_document(kvp("ol_delivery_d", bsoncxx::types::b_null())),
+                                    false);
+    for (auto collection : {"customer", "stock", "district", "warehouse"})
+        MongoDBHandler::ResetCollection(*conn, key, "bench", collection, {}, false);
+    auto end = chrono::steady_clock::now();
+    cout << "Reset mongodb old TPC-C Tables in "
+         << chrono::duration<double, milli>(end - start).count() << " ms" << endl;
+    report::RunReport::global().recordLoad(
+        "mongodb", "tpcc_old_reset", chrono::duration<double, milli>(end - start).count());
+}
+
+// Adds the warehouses after the loaded ones, or deletes the surplus ones (with
+// their orders, customers and stock), leaving the items alone, and snapshots
+// the result as the resized dataset key, so later runs are reset to it. Order
+// lines of the remaining warehouses supplied by a deleted one are supplied
+// locally instead.
+static void ResizeBenchmark(mongocxx::pool::entry& conn, const ScaleParameters &loaded,
+                            ScaleParameters &params, int clients, const string &key) {
+    cout << endl
+         << "Resizing mongodb old TPC-C Tables from " << loaded.endingWarehouse << " to "
+         << params.endingWarehouse << " warehouses ..." << endl;
+    auto start = chrono::steady_clock::now();
+    if (params.endingWarehouse > loaded.endingWarehouse) {
+        auto added = warehouseRange(params, loaded.endingWarehouse + 1, params.endingWarehouse);
+        PopulateBenchmark(added, clients, false);
+    } else {
+        using bsoncxx::builder::basic::kvp;
+        using bsoncxx::builder::basic::make_document;
+        auto db = conn->database("bench");
+        // The field with the warehouse of each collection
+        const vector<pair<string, string>> warehouseFields = {
+            {"new_order", "no_w_id"}, {"order_line", "ol_w_id"}, {"history", "h_w_id"},
+            {"order", "o_w_id"}, {"customer", "c_w_id"}, {"stock", "s_w_id"},
+            {"district", "d_w_id"}, {"warehouse", "w_id"}};
+        for (auto &field : warehouseFields) {
+            db.collection(field.first)
+                .delete_many(make_document(
+                    kvp(field.second, make_document(kvp("$gt", params.endingWarehouse)))));
+        }
+        mongocxx::pipeline local;
+        local.set(make_document(kvp("ol_supply_w_id", "$ol_w_id")));
+        db.collection("order_line")
+            .update_many(make_document(kvp(
+                             "ol_supply_w_id", make_document(kvp("$gt", params.endingWarehouse)))),
+                         local);
+    }
+    if (snapshotsEnabled())
+        MongoDBHandler::SnapshotCollections(*conn, "bench", key, tpccCollections);
+    auto end = chrono::steady_clock::now();
+    cout << " Done in " << chrono::duration<double, milli>(end - start).count()
+         << " ms" << endl
+         << endl;
+    report::RunReport::global().recordLoad(
+        "mongodb", "tpcc_old_resize", chrono::duration<double, milli>(end - start).count());
+}
+
+static void LoadBenchmark(mongocxx::pool::entry& conn,
+                          ScaleParameters &params, int warehouses, int clients) {
+    // The data stays for runs that only change the number of terminals, reset
+    // to the way it was loaded
+    static optional<DatasetKey> loaded;
+    DatasetKey dataset{"mongodb", "old", params, loadSeed()};
+    string key = dataset.name();
+    if (loaded && loaded->sameScale(dataset)) {
+        ResetBenchmark(conn, loaded->name());
+        return;
+    }
+    if (loaded && loaded->resizesTo(dataset)) {
+        ResetBenchmark(conn, loaded->name());
+        dataset.resized = true;
+        ResizeBenchmark(conn, loaded->params, params, clients, dataset.name());
+        loaded = dataset;
+        return;
+    }
+    loaded.reset();
+    cout << endl
+         << "Creating mongodb old TPC-C Tables with " << omp_get_num_procs()
+         << " threads ..." << endl;
+    cout.flush();
+    auto start = chrono::steady_clock::now();
+    {
+        auto db = conn->database("bench");
+        db.drop();
+    }
+
+    bool restored = snapshotsEnabled() &&
+                    MongoDBHandler::RestoreCollections(*conn, key, "bench", tpccCollections);
+    if (restored) {
+        cout << "Restored " << key << endl;
+    } else {
+        PopulateBenchmark(params, clients, true);
+        if (snapshotsEnabled())
+            MongoDBHandler::SnapshotCollections(*conn, "bench", key, tpccCollections);
+    }
 
     cout << "Done populating, altering DB..." << endl;
 
@@ -553,15 +699,208 @@ static void LoadBenchmark(mongocxx::pool::entry& conn,
         auto stockC = db.collection("stock");
         stockC.create_index(MDV("s_w_id", 1, "s_i_id", 1), options);
     }
-    created = true;
+    loaded = dataset;
     auto end = chrono::steady_clock::now();
     cout << " Done in " << chrono::duration<double, milli>(end - start).count()
          << " ms" << endl
          << endl;
+    report::RunReport::global().recordLoad(
+        "mongodb", restored ? "tpcc_old_restore" : "tpcc_old",
+        chrono::duration<double, milli>(end - start).count());
+    report::RunReport::global().describeEngine("mongodb",
+                                               [&] { return MongoDBHandler::ServerInfo(*conn); });
 }
 
+namespace {
+// Decoded rows the NewOrder transaction keeps after its cursors have moved on
+struct NewOrderItem {
+    int32_t iId;
+    double iPrice;
+    string iName;
+    bool original;
+};
+
+struct NewOrderStock {
+    int32_t sIId;
+    int32_t sYtd;
+    int32_t sOrderCnt;
+    int32_t sRemoteCnt;
+    string sDist;
+    bool original;
+};
+
+// Per terminal command set. Collection handles are resolved once per connection and
+// every fixed shape filter, update and projection is built once, per call only the
+// slots are patched. Filters with variable length parts ($in lists, strings) are
+// still built on the fly.
+struct MongoTPCCCommands {
+    mongocxx::collection warehouse;
+    mongocxx::collection district;
+    mongocxx::collection customer;
+    mongocxx::collection history;
+    mongocxx::collection newOrder;
+    mongocxx::collection order;
+    mongocxx::collection orderLine;
+    mongocxx::collection item;
+    mongocxx::collection stock;
+
+    BSONCommand warehouseByKey{MDV("w_id", 0), {"w_id"}};
+    BSONCommand districtByKey{MDV("d_id", 0, "d_w_id", 0), {"d_w_id", "d_id"}};
+    BSONCommand customerByKey{MDV("c_id", 0, "c_w_id", 0, "c_d_id", 0),
+                              {"c_w_id", "c_d_id", "c_id"}};
+    BSONCommand newOrderByDistrict{MDV("no_d_id", 0, "no_w_id", 0),
+                                   {"no_w_id", "no_d_id"}};
+    BSONCommand newOrderByKey{MDV("no_d_id", 0, "no_w_id", 0, "no_o_id", 0),
+                              {"no_w_id", "no_d_id", "no_o_id"}};
+    BSONCommand orderByKey{MDV("o_d_id", 0, "o_w_id", 0, "o_id", 0),
+                           {"o_w_id", "o_d_id", "o_id"}};
+    BSONCommand orderByCustomer{MDV("o_c_id", 0, "o_w_id", 0, "o_d_id", 0),
+                                {"o_w_id", "o_d_id", "o_c_id"}};
+    BSONCommand orderLinesByOrder{MDV("ol_d_id", 0, "ol_w_id", 0, "ol_o_id", 0),
+                                  {"ol_w_id", "ol_d_id", "ol_o_id"}};
+    BSONCommand orderLinesRecent{
+        MDV("ol_w_id", 0, "ol_d_id", 0, "ol_o_id", MDV("$lt", 0, "$gte", 0)),
+        {"ol_w_id", "ol_d_id", "ol_o_id.$lt", "ol_o_id.$gte"}};
+    BSONCommand stockByKey{MDV("s_i_id", 0, "s_w_id", 0), {"s_w_id", "s_i_id"}};
+
+    BSONCommand orderCarrierUpdate{MDV("$set", MDV("o_carrier_id", 0)),
+                                   {"$set.o_carrier_id"}};
+    BSONCommand orderLineDeliveryUpdate{
+        MDV("$set", MDV("ol_delivery_d",
+                        bsoncxx::types::b_date{chrono::milliseconds(0)})),
+        {"$set.ol_delivery_d"}};
+    BSONCommand customerBalanceUpdate{MDV("$set", MDV("c_balance", 0.0)),
+                                      {"$set.c_balance"}};
+    BSONCommand districtYtdUpdate{MDV("$inc", MDV("d_ytd", 0.0)),
+                                  {"$inc.d_ytd"}};
+    BSONCommand warehouseYtdUpdate{MDV("$inc", MDV("w_ytd", 0.0)),
+                                   {"$inc.w_ytd"}};
+    BSONCommand stockUpdate{MDV("$set", MDV("s_quantity", 0, "s_ytd", 0,
+                                            "s_order_cnt", 0, "s_remote_cnt", 0)),
+                            {"$set.s_quantity", "$set.s_ytd",
+                             "$set.s_order_cnt", "$set.s_remote_cnt"}};
+    bsoncxx::document::value districtNextOrderUpdate =
+        MDV("$inc", MDV("d_next_o_id", 1));
+
+    BSONCommand orderInsert{
+        MDV("o_id", 0, "o_w_id", 0, "o_d_id", 0, "o_c_id", 0, "o_carrier_id", 0,
+            "o_ol_cnt", 0, "o_all_local", false, "o_entry_d",
+            bsoncxx::types::b_date{chrono::milliseconds(0)}),
+        {"o_id", "o_w_id", "o_d_id", "o_c_id", "o_carrier_id", "o_ol_cnt",
+         "o_all_local", "o_entry_d"}};
+    BSONCommand newOrderInsert{MDV("no_o_id", 0, "no_w_id", 0, "no_d_id", 0),
+                               {"no_o_id", "no_w_id", "no_d_id"}};
+
+    mongocxx::options::find deliveryNewOrderOptions;
+    mongocxx::options::find deliveryOrderOptions;
+    mongocxx::options::find deliveryOrderLineOptions;
+    mongocxx::options::find statusCustomerOptions;
+    mongocxx::options::find statusCustomerByLastOptions;
+    mongocxx::options::find statusOrderOptions;
+    mongocxx::options::find statusOrderLineOptions;
+    mongocxx::options::find_one_and_update paymentDistrictOptions;
+    mongocxx::options::find_one_and_update paymentWarehouseOptions;
+    mongocxx::options::find paymentCustomerOptions;
+    mongocxx::options::find paymentCustomerByLastOptions;
+    mongocxx::options::find stockLevelDistrictOptions;
+    mongocxx::options::find stockLevelOrderLineOptions;
+    mongocxx::options::find_one_and_update newOrderDistrictOptions;
+    mongocxx::options::find newOrderItemOptions;
+    mongocxx::options::find newOrderWarehouseOptions;
+    mongocxx::options::find newOrderCustomerOptions;
+    // Indexed by d_id, the s_dist_xx field differs per district
+    std::array<mongocxx::options::find, DISTRICTS_PER_WAREHOUSE + 1>
+        newOrderStockOptions;
+
+    // Result decoders, field indexes follow the projections above
+    BSONDecoder customerIdDecoder{"c_id"};
+    BSONDecoder orderIdDecoder{"o_id"};
+    BSONDecoder itemDecoder{"i_id", "i_price", "i_name", "i_data"};
+    // Only the s_dist_xx of the order's district is projected, it is field 4 + d_id
+    BSONDecoder stockDecoder{"s_i_id",    "s_ytd",     "s_order_cnt",
+                             "s_remote_cnt", "s_data", "s_dist_01",
+                             "s_dist_02", "s_dist_03", "s_dist_04",
+                             "s_dist_05", "s_dist_06", "s_dist_07",
+                             "s_dist_08", "s_dist_09", "s_dist_10"};
+
+    explicit MongoTPCCCommands(mongocxx::pool::entry &conn) {
+        auto db = conn->database("bench");
+        warehouse = db.collection("warehouse");
+        district = db.collection("district");
+        customer = db.collection("customer");
+        history = db.collection("history");
+        newOrder = db.collection("new_order");
+        order = db.collection("order");
+        orderLine = db.collection("order_line");
+        item = db.collection("item");
+        stock = db.collection("stock");
+
+        deliveryNewOrderOptions.sort(MDV("no_o_id", 1));
+        deliveryNewOrderOptions.limit(1);
+        deliveryNewOrderOptions.comment("DeliveryTXNNewOrder");
+        deliveryOrderOptions.projection(
+            MDV("o_c_id", 1, "o_id", 1, "o_d_id", 1, "o_w_id", 1, "_id", 0));
+        deliveryOrderOptions.comment("DeliveryTXNOrder");
+        deliveryOrderLineOptions.projection(MDV("ol_amount", 1, "_id", 0));
+        deliveryOrderLineOptions.comment("DeliveryTXNOrderLines");
+
+        auto statusCustomerProjection =
+            MDV("c_id", 1, "c_first", 1, "c_middle", 1, "c_last", 1,
+                "c_balance", 1, "_id", 0);
+        statusCustomerOptions.comment("OrderStatusTXNCustById");
+        statusCustomerOptions.projection(statusCustomerProjection);
+        statusCustomerByLastOptions.comment("OrderStatusTXNCustByLastName");
+        statusCustomerByLastOptions.projection(statusCustomerProjection);
+        statusCustomerByLastOptions.sort(MDV("c_first", 1));
+        statusOrderOptions.comment("OrderStatusTXNOrders");
+        statusOrderOptions.projection(
+            MDV("o_id", 1, "o_carrier_id", 1, "o_entry_d", 1, "_id", 0));
+        statusOrderOptions.sort(MDV("o_id", -1));
+        statusOrderOptions.limit(1);
+        statusOrderLineOptions.comment("OrderStatusTXNOrderLines");
+        statusOrderLineOptions.projection(
+            MDV("ol_supply_w_id", 1, "ol_i_id", 1, "ol_quantity", 1,
+                "ol_amount", 1, "ol_delivery_d", 1, "_id", 0));
+
+        paymentDistrictOptions.projection(
+            MDV("d_name", 1, "d_street_1", 1, "d_street_2", 1, "d_city", 1,
+                "d_state", 1, "d_zip", 1, "_id", 0));
+        paymentWarehouseOptions.projection(
+            MDV("w_name", 1, "w_street_1", 1, "w_street_2", 1, "w_city", 1,
+                "w_state", 1, "w_zip", 1, "_id", 0));
+        auto paymentCustomerProjection = MDV(
+            "c_id", 1, "c_w_id", 1, "c_d_id", 1, "c_delivery_cnt", 1,
+            "c_first", 1, "c_middle", 1, "c_last", 1, "c_street_1", 1,
+            "c_street_2", 1, "c_city", 1, "c_state", 1, "c_zip", 1, "c_phone",
+            1, "c_credit", 1, "c_credit_lim", 1, "c_discount", 1, "c_data", 1,
+            "c_since", 1, "_id", 0);
+        paymentCustomerOptions.projection(paymentCustomerProjection);
+        paymentCustomerByLastOptions.projection(paymentCustomerProjection);
+        paymentCustomerByLastOptions.sort(MDV("c_first", 1));
+
+        stockLevelDistrictOptions.projection(MDV("d_next_o_id", 1, "_id", 0));
+        stockLevelOrderLineOptions.projection(MDV("ol_i_id", 1, "_id", 0));
+        stockLevelOrderLineOptions.batch_size(1000);
+
+        newOrderDistrictOptions.projection(MDV("d_id", 1, "d_w_id", 1, "d_tax",
+                                               1, "d_next_o_id", 1, "_id", 0));
+        newOrderItemOptions.projection(MDV("i_id", 1, "i_price", 1, "i_name",
+                                           1, "i_data", 1, "_id", 0));
+        newOrderWarehouseOptions.projection(MDV("w_tax", 1, "_id", 0));
+        newOrderCustomerOptions.projection(
+            MDV("c_discount", 1, "c_last", 1, "c_credit", 1, "_id", 0));
+        for (int dId = 1; dId <= DISTRICTS_PER_WAREHOUSE; ++dId) {
+            newOrderStockOptions[dId].projection(MDV(
+                "s_i_id", 1, "s_w_id", 1, "s_quantity", 1, "s_data", 1,
+                "s_ytd", 1, "s_order_cnt", 1, "s_remote_cnt", 1,
+                fmt::format("s_dist_{:02d}", dId), 1, "_id", 0));
+        }
+    }
+};
+} // namespace
+
 static bool doDelivery(benchmark::State &state, ScaleParameters &params,
-                       DeliveryParams &dparams, mongocxx::pool::entry &conn,
+                       DeliveryParams &dparams, MongoTPCCCommands &cmd,
                        mongocxx::client_session &session) {
 #ifdef PRINT_TRACE
     cout << "DoDelivery" << endl;
@@ -569,12 +908,11 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "noq" << endl;
 #endif
-    auto colNewOrder = conn->database("bench").collection("new_order");
-    auto options = mongocxx::options::find();
-    options.sort(MDV("no_o_id", 1));
-    options.limit(1);
-    options.comment("DeliveryTXNNewOrder");
-    auto no_result = colNewOrder.find(session, MDV("no_d_id", dparams.dId, "no_w_id", dparams.wId), options);
+    markPhase("DeliveryTXNNewOrder", Phase::Build);
+    auto newOrderFilter = cmd.newOrderByDistrict.Bind(dparams.wId, dparams.dId);
+    markPhase("DeliveryTXNNewOrder", Phase::Execute);
+    auto no_result = cmd.newOrder.find(session, newOrderFilter,
+                                       cmd.deliveryNewOrderOptions);
     int count = 0;
     int oId = -1;
     for(auto result: no_result) {
@@ -596,23 +934,22 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "oq" << endl;
 #endif
-    auto options2 = mongocxx::options::find();
-    options2.projection(MDV("o_c_id", 1, "o_id", 1, "o_d_id", 1, "o_w_id", 1, "_id", 0));
-    options2.comment("DeliveryTXNOrder");
-    auto colOrder = conn->database("bench").collection("order");
-    auto o_result = colOrder.find_one(session, MDV("o_d_id", dparams.dId, "o_w_id", dparams.wId, "o_id", oId), options2);
+    markPhase("DeliveryTXNOrder", Phase::Build);
+    auto orderFilter = cmd.orderByKey.Bind(dparams.wId, dparams.dId, oId);
+    markPhase("DeliveryTXNOrder", Phase::Execute);
+    auto o_result = cmd.order.find_one(session, orderFilter, cmd.deliveryOrderOptions);
     assert(o_result.has_value() == true);
+    markPhase("DeliveryTXNOrder", Phase::Decode);
     int cId = (*o_result)["o_c_id"].get_int32();
 
 #ifdef PRINT_TRACE
     cout << "olq" << endl;
 #endif
 // TODO pipeline? why not SUM?
-    auto colOrderLine = conn->database("bench").collection("order_line");
-    options.projection(MDV("ol_amount", 1, "_id", 0));
-    options.limit(0);
-    options.comment("DeliveryTXNOrderLines");
-    auto ol_result = colOrderLine.find(session, MDV("ol_d_id", dparams.dId, "ol_w_id", dparams.wId, "ol_o_id", oId));
+    markPhase("DeliveryTXNOrderLines", Phase::Build);
+    auto orderLinesFilter = cmd.orderLinesByOrder.Bind(dparams.wId, dparams.dId, oId);
+    markPhase("DeliveryTXNOrderLines", Phase::Execute);
+    auto ol_result = cmd.orderLine.find(session, orderLinesFilter, cmd.deliveryOrderLineOptions);
     count = 0;
     double total = 0;
     for (auto ol : ol_result) {
@@ -624,7 +961,10 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "ouq" << endl;
 #endif
-    auto o_update_result = colOrder.update_one(session, MDV("o_d_id", dparams.dId, "o_w_id", dparams.wId, "o_id", oId), MDV("$set", MDV("o_carrier_id", dparams.oCarrierId)));
+    markPhase("DeliveryTXNUpdateOrder", Phase::Build);
+    auto orderUpdate = cmd.orderCarrierUpdate.Bind(dparams.oCarrierId);
+    markPhase("DeliveryTXNUpdateOrder", Phase::Execute);
+    auto o_update_result = cmd.order.update_one(session, orderFilter, orderUpdate);
     assert(o_update_result.has_value() == true);
     assert(o_update_result.value().modified_count() == 1);
 
@@ -632,22 +972,31 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "oluq" << endl;
 #endif
-    auto ol_update_result = colOrderLine.update_many(session, MDV("ol_d_id", dparams.dId, "ol_w_id", dparams.wId, "ol_o_id", oId), MDV("$set", MDV("ol_delivery_d", bsoncxx::types::b_date{dparams.olDeliveryD})));
+    markPhase("DeliveryTXNUpdateOrderLines", Phase::Build);
+    auto orderLinesUpdate = cmd.orderLineDeliveryUpdate.Bind(dparams.olDeliveryD);
+    markPhase("DeliveryTXNUpdateOrderLines", Phase::Execute);
+    auto ol_update_result = cmd.orderLine.update_many(session, orderLinesFilter, orderLinesUpdate);
     assert(ol_update_result.has_value() == true);
     assert(ol_update_result.value().modified_count() > 0);
 
 #ifdef PRINT_TRACE
     cout << "cuq" << endl;
 #endif
-    auto colCustomer = conn->database("bench").collection("customer");
-    auto cust_update_result = colCustomer.update_one(session, MDV("c_d_id", dparams.dId, "c_w_id", dparams.wId, "c_id", cId), MDV("$set", MDV("c_balance", total)));
+    markPhase("DeliveryTXNUpdateCust", Phase::Build);
+    auto customerFilter = cmd.customerByKey.Bind(dparams.wId, dparams.dId, cId);
+    auto customerUpdate = cmd.customerBalanceUpdate.Bind(total);
+    markPhase("DeliveryTXNUpdateCust", Phase::Execute);
+    auto cust_update_result = cmd.customer.update_one(session, customerFilter, customerUpdate);
     assert(cust_update_result.has_value() == true);
     assert(cust_update_result.value().modified_count() == 1);
 
 #ifdef PRINT_TRACE
     cout << "nod" << endl;
 #endif
-    auto no_delete_result = colNewOrder.delete_one(session, MDV("no_d_id", dparams.dId, "no_w_id", dparams.wId, "no_o_id", oId));
+    markPhase("DeliveryTXNNewOrderDelete", Phase::Build);
+    auto newOrderKey = cmd.newOrderByKey.Bind(dparams.wId, dparams.dId, oId);
+    markPhase("DeliveryTXNNewOrderDelete", Phase::Execute);
+    auto no_delete_result = cmd.newOrder.delete_one(session, newOrderKey);
     assert(no_delete_result.has_value() == true);
     assert(no_delete_result.value().deleted_count() == 1);
 
@@ -657,7 +1006,7 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 }
 
 static bool doDeliveryN(benchmark::State &state, ScaleParameters &params,
-                 mongocxx::pool::entry& conn, int &retries,
+                 mongocxx::pool::entry& conn, MongoTPCCCommands &cmd, int &retries,
                  int n = DISTRICTS_PER_WAREHOUSE) {
 #ifdef PRINT_TRACE
     cout << "DoDeliveryN" << endl;
@@ -669,15 +1018,20 @@ static bool doDeliveryN(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
             for (int dId = 1; dId <= n; ++dId) {
                 dparams.dId = dId;
+                markConflictKey(dparams.wId, dId);
                 bool result =
-                    doDelivery(state, params, dparams, conn, *session);
+                    doDelivery(state, params, dparams, cmd, *session);
                 if (!result)
                     return false;
             }
+            markPhase("commit", Phase::Execute);
             return true;
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries - 1;
@@ -685,7 +1039,7 @@ static bool doDeliveryN(benchmark::State &state, ScaleParameters &params,
 }
 
 static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
-                   mongocxx::pool::entry& conn, int &retries) {
+                   mongocxx::pool::entry& conn, MongoTPCCCommands &cmd, int &retries) {
 #ifdef PRINT_TRACE
     cout << "OrderStatus" << endl;
 #endif
@@ -695,95 +1049,81 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
-            auto colCustomer = conn->database("bench").collection("customer");
-
-            std::optional<bsoncxx::document::value> customer;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
+            auto &idDecoder = cmd.customerIdDecoder;
+            int cId;
             if (osparams.cId != INT32_MIN) {
 #ifdef PRINT_TRACE
                 cout << "cqi" << endl;
 #endif
-                auto findOptions = mongocxx::options::find();
-                findOptions.comment("OrderStatusTXNCustById");
-                findOptions.projection(MDV("c_id", 1, "c_first", 1, "c_middle",
-                                           1, "c_last", 1, "c_balance", 1,
-                                           "_id", 0));
-                customer = colCustomer.find_one(*session,
-                                                MDV("c_id", osparams.cId,
-                                                    "c_w_id", osparams.wId,
-                                                    "c_d_id", osparams.dId),
-                                                findOptions);
+                markPhase("OrderStatusTXNCustById", Phase::Build);
+                auto customerFilter = cmd.customerByKey.Bind(
+                    osparams.wId, osparams.dId, osparams.cId);
+                markPhase("OrderStatusTXNCustById", Phase::Execute);
+                auto customer = cmd.customer.find_one(
+                    *session, customerFilter, cmd.statusCustomerOptions);
+                assert(customer.has_value() == true);
+                markPhase("OrderStatusTXNCustById", Phase::Decode);
+                idDecoder.Decode(customer->view());
+                cId = idDecoder.Int32(0);
             } else {
 #ifdef PRINT_TRACE
                 cout << "cql" << endl;
 #endif
-                auto findOptions = mongocxx::options::find();
-                findOptions.comment("OrderStatusTXNCustByLastName");
-                findOptions.projection(MDV("c_id", 1, "c_first", 1, "c_middle",
-                                           1, "c_last", 1, "c_balance", 1,
-                                           "_id", 0));
-                findOptions.sort(MDV("c_first", 1));
+                markPhase("OrderStatusTXNCustByLastName", Phase::Build);
+                auto customerFilter = MDV("c_last", osparams.cLast, "c_w_id",
+                                          osparams.wId, "c_d_id", osparams.dId);
+                markPhase("OrderStatusTXNCustByLastName", Phase::Execute);
                 auto customers =
-                    colCustomer.find(*session,
-                                     MDV("c_last", osparams.cLast, "c_w_id",
-                                         osparams.wId, "c_d_id", osparams.dId),
-                                     findOptions);
-                std::vector<bsoncxx::document::value> results;
+                    cmd.customer.find(*session, customerFilter.view(),
+                                      cmd.statusCustomerByLastOptions);
+                std::vector<int32_t> results;
                 for (auto &&cust : customers) {
-                    results.push_back(MDV2(cust));
+                    idDecoder.Decode(cust);
+                    results.push_back(idDecoder.Int32(0));
                 }
                 assert(results.size() > 0);
                 int index = (results.size() - 1) / 2;
-                customer = results[index];
+                cId = results[index];
             }
-            assert(customer.has_value() == true);
-            int cId = (*customer)["c_id"].get_int32();
 
 #ifdef PRINT_TRACE
             cout << "oq" << endl;
 #endif
-            auto colOrder = conn->database("bench").collection("order");
-            auto findOptions = mongocxx::options::find();
-            findOptions.comment("OrderStatusTXNOrders");
-            findOptions.projection(
-                MDV("o_id", 1, "o_carrier_id", 1, "o_entry_d", 1, "_id", 0));
-            findOptions.sort(MDV("o_id", -1));
-            findOptions.limit(1);
+            markPhase("OrderStatusTXNOrders", Phase::Build);
+            auto orderFilter =
+                cmd.orderByCustomer.Bind(osparams.wId, osparams.dId, cId);
+            markPhase("OrderStatusTXNOrders", Phase::Execute);
             auto theOrders =
-                colOrder.find(*session,
-                              MDV("o_c_id", cId, "o_w_id", osparams.wId,
-                                  "o_d_id", osparams.dId),
-                              findOptions);
-            std::vector<bsoncxx::document::value> allOrders;
+                cmd.order.find(*session, orderFilter, cmd.statusOrderOptions);
+            int numOrders = 0;
+            int oId = -1;
             for (auto &&ord : theOrders) {
-                allOrders.push_back(MDV2(ord));
+                cmd.orderIdDecoder.Decode(ord);
+                oId = cmd.orderIdDecoder.Int32(0);
+                numOrders++;
             }
-            assert(allOrders.size() == 1);
-            auto order = allOrders[0];
-
-            int oId = order["o_id"].get_int32();
+            assert(numOrders == 1);
 
 #ifdef PRINT_TRACE
             cout << "olq" << endl;
 #endif
-            auto colOrderLines =
-                conn->database("bench").collection("order_line");
-            auto findOLOptions = mongocxx::options::find();
-            findOLOptions.comment("OrderStatusTXNOrderLines");
-            findOLOptions.projection(MDV("ol_supply_w_id", 1, "ol_i_id", 1,
-                                         "ol_quantity", 1, "ol_amount", 1,
-                                         "ol_delivery_d", 1, "_id", 0));
-            auto orderline =
-                colOrderLines.find(*session,
-                                   MDV("ol_d_id", osparams.dId, "ol_w_id",
-                                       osparams.wId, "ol_o_id", oId),
-                                   findOLOptions);
+            markPhase("OrderStatusTXNOrderLines", Phase::Build);
+            auto orderLinesFilter =
+                cmd.orderLinesByOrder.Bind(osparams.wId, osparams.dId, oId);
+            markPhase("OrderStatusTXNOrderLines", Phase::Execute);
+            auto orderline = cmd.orderLine.find(*session, orderLinesFilter,
+                                                cmd.statusOrderLineOptions);
             int olCount = 0;
             for (auto &&ol : orderline) {
                 olCount++;
             }
             assert(olCount > 0);
             // TODO actually return result... customer, order, orderlines
+            markPhase("commit", Phase::Execute);
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries - 1;
@@ -791,7 +1131,7 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
 }
 
 static bool doPayment(benchmark::State &state, ScaleParameters &params,
-               mongocxx::pool::entry& conn, int &retries) {
+               mongocxx::pool::entry& conn, MongoTPCCCommands &cmd, int &retries) {
 #ifdef PRINT_TRACE
     cout << "Payment" << endl;
 #endif
@@ -801,69 +1141,54 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
 #ifdef PRINT_TRACE
             cout << this_thread::get_id() << " distq" << endl;
 #endif
-            auto colDistrict = conn->database("bench").collection("district");
-            auto updateDistOptions = mongocxx::options::find_one_and_update();
-            updateDistOptions.projection(
-                MDV("d_name", 1, "d_street_1", 1, "d_street_2", 1, "d_city", 1,
-                    "d_state", 1, "d_zip", 1, "_id", 0));
-            auto district = colDistrict.find_one_and_update(
-                *session, MDV("d_id", pparams.dId, "d_w_id", pparams.wId),
-                MDV("$inc", MDV("d_ytd", pparams.hAmount)), updateDistOptions);
+            markPhase("PaymentTXNUpdateDistrict", Phase::Build);
+            auto districtFilter = cmd.districtByKey.Bind(pparams.wId, pparams.dId);
+            auto districtUpdate = cmd.districtYtdUpdate.Bind(pparams.hAmount);
+            markPhase("PaymentTXNUpdateDistrict", Phase::Execute);
+            auto district = cmd.district.find_one_and_update(
+                *session, districtFilter, districtUpdate,
+                cmd.paymentDistrictOptions);
             assert(district.has_value() == true);
 
 #ifdef PRINT_TRACE
             cout << this_thread::get_id() << " whq" << endl;
 #endif
-            auto colWarehouse = conn->database("bench").collection("warehouse");
-            auto updateWarehouseOptions =
-                mongocxx::options::find_one_and_update();
-            updateWarehouseOptions.projection(
-                MDV("w_name", 1, "w_street_1", 1, "w_street_2", 1, "w_city", 1,
-                    "w_state", 1, "w_zip", 1, "_id", 0));
-            auto warehouse = colWarehouse.find_one_and_update(
-                *session, MDV("w_id", pparams.wId),
-                MDV("$inc", MDV("w_ytd", pparams.hAmount)),
-                updateWarehouseOptions);
+            markPhase("PaymentTXNUpdateWarehouse", Phase::Build);
+            auto warehouseFilter = cmd.warehouseByKey.Bind(pparams.wId);
+            auto warehouseUpdate = cmd.warehouseYtdUpdate.Bind(pparams.hAmount);
+            markPhase("PaymentTXNUpdateWarehouse", Phase::Execute);
+            auto warehouse = cmd.warehouse.find_one_and_update(
+                *session, warehouseFilter, warehouseUpdate,
+                cmd.paymentWarehouseOptions);
             assert(warehouse.has_value() == true);
 
-            auto colCustomer = conn->database("bench").collection("customer");
             std::optional<bsoncxx::document::value> customer;
             if (pparams.cId != INT32_MIN) {
 #ifdef PRINT_TRACE
                 cout << this_thread::get_id() << " cqi" << endl;
 #endif
-                auto customerOptions = mongocxx::options::find();
-                customerOptions.projection(MDV(
-                    "c_id", 1, "c_w_id", 1, "c_d_id", 1, "c_delivery_cnt", 1,
-                    "c_first", 1, "c_middle", 1, "c_last", 1, "c_street_1", 1,
-                    "c_street_2", 1, "c_city", 1, "c_state", 1, "c_zip", 1,
-                    "c_phone", 1, "c_credit", 1, "c_credit_lim", 1,
-                    "c_discount", 1, "c_data", 1, "c_since", 1, "_id", 0));
-                customer = colCustomer.find_one(*session,
-                                                MDV("c_id", pparams.cId,
-                                                    "c_w_id", pparams.cWId,
-                                                    "c_d_id", pparams.cDId),
-                                                customerOptions);
+                markPhase("PaymentTXNCustById", Phase::Build);
+                auto customerFilter = cmd.customerByKey.Bind(
+                    pparams.cWId, pparams.cDId, pparams.cId);
+                markPhase("PaymentTXNCustById", Phase::Execute);
+                customer = cmd.customer.find_one(*session, customerFilter,
+                                                 cmd.paymentCustomerOptions);
             } else {
 #ifdef PRINT_TRACE
                 cout << this_thread::get_id() << " cql" << endl;
 #endif
-                auto customerOptions = mongocxx::options::find();
-                customerOptions.sort(MDV("c_first", 1));
-                customerOptions.projection(MDV(
-                    "c_id", 1, "c_w_id", 1, "c_d_id", 1, "c_delivery_cnt", 1,
-                    "c_first", 1, "c_middle", 1, "c_last", 1, "c_street_1", 1,
-                    "c_street_2", 1, "c_city", 1, "c_state", 1, "c_zip", 1,
-                    "c_phone", 1, "c_credit", 1, "c_credit_lim", 1,
-                    "c_discount", 1, "c_data", 1, "c_since", 1, "_id", 0));
+                markPhase("PaymentTXNCustByLastName", Phase::Build);
+                auto customerFilter = MDV("c_last", pparams.cLast, "c_w_id",
+                                          pparams.cWId, "c_d_id", pparams.cDId);
+                markPhase("PaymentTXNCustByLastName", Phase::Execute);
                 auto customers =
-                    colCustomer.find(*session,
-                                     MDV("c_last", pparams.cLast, "c_w_id",
-                                         pparams.cWId, "c_d_id", pparams.cDId),
-                                     customerOptions);
+                    cmd.customer.find(*session, customerFilter.view(),
+                                      cmd.paymentCustomerByLastOptions);
 
                 std::vector<bsoncxx::document::value> results;
                 for (auto &&cust : customers) {
@@ -874,6 +1199,9 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
                 customer = results[index];
             }
             assert(customer.has_value() == true);
+            markPhase(pparams.cId != INT32_MIN ? "PaymentTXNCustById"
+                                               : "PaymentTXNCustByLastName",
+                      Phase::Decode);
             int cId = (*customer)["c_id"].get_int32();
             string cData((*customer)["c_data"].get_string());
             string cCredit((*customer)["c_credit"].get_string());
@@ -890,16 +1218,20 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
             cout << "cuq" << endl;
 #endif
-            auto colHistory = conn->database("bench").collection("history");
-            auto c_update = colCustomer.update_one(
-                *session,
-                MDV("c_id", cId, "c_w_id", pparams.cWId, "c_d_id", pparams.cDId),
+            markPhase("PaymentTXNCustUpdate", Phase::Build);
+            auto customerFilter =
+                cmd.customerByKey.Bind(pparams.cWId, pparams.cDId, cId);
+            auto customerUpdate =
                 MDV("$set", MDV("c_data", cData), "$inc",
                     MDV("c_balance", -pparams.hAmount, "c_ytd_payment",
-                        pparams.hAmount, "c_payment_cnt", 1)));
+                        pparams.hAmount, "c_payment_cnt", 1));
+            markPhase("PaymentTXNCustUpdate", Phase::Execute);
+            auto c_update = cmd.customer.update_one(*session, customerFilter,
+                                                    customerUpdate.view());
             assert(c_update.has_value() == true);
             assert(c_update.value().modified_count() == 1);
 
+            markPhase("PaymentTXNHistory", Phase::Build);
             string h_data =
                 fmt::format("{:s}    {:s}", (*warehouse)["w_name"].get_string(),
                             (*district)["d_name"].get_string());
@@ -907,15 +1239,18 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
             cout << "hi" << endl;
 #endif
-            auto insertResult = colHistory.insert_one(
-                *session,
+            auto history =
                 MDV("h_c_id", cId, "h_c_w_id", pparams.cWId, "h_w_id",
                     pparams.wId, "h_c_d_id", pparams.cDId, "h_d_id",
                     pparams.dId, "h_amount", pparams.hAmount, "h_data", h_data,
-                    "h_date", bsoncxx::types::b_date{pparams.hDate}, ));
+                    "h_date", bsoncxx::types::b_date{pparams.hDate}, );
+            markPhase("PaymentTXNHistory", Phase::Execute);
+            auto insertResult = cmd.history.insert_one(*session, history.view());
             assert(insertResult.has_value() == true);
             assert(insertResult.value().result().inserted_count() == 1);
+            markPhase("commit", Phase::Execute);
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries-1;
@@ -923,7 +1258,7 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 }
 
 static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
-                  mongocxx::pool::entry& conn, int &retries) {
+                  mongocxx::pool::entry& conn, MongoTPCCCommands &cmd, int &retries) {
 #ifdef PRINT_TRACE
     cout << "stockLevel" << endl;
 #endif
@@ -933,38 +1268,33 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
-            string distQuery =
-                fmt::format("SELECT d_next_o_id from bench.district "
-                            "WHERE d_id = {:d} AND d_w_id = {:d} LIMIT 1;",
-                            sparams.dId, sparams.wId);
-
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
 #ifdef PRINT_TRACE
             cout << "dq" << endl;
 #endif
-            auto colDistrict = conn->database("bench").collection("district");
-            auto queryOptions = mongocxx::options::find();
-            queryOptions.projection(MDV("d_next_o_id", 1, "_id", 0));
-            auto district = colDistrict.find_one(
-                *session, MDV("d_id", sparams.dId, "d_w_id", sparams.wId));
+            markPhase("StockLevelTXNDistQuery", Phase::Build);
+            auto districtFilter = cmd.districtByKey.Bind(sparams.wId, sparams.dId);
+            markPhase("StockLevelTXNDistQuery", Phase::Execute);
+            auto district = cmd.district.find_one(
+                *session, districtFilter, cmd.stockLevelDistrictOptions);
             assert(district.has_value() == true);
+            markPhase("StockLevelTXNDistQuery", Phase::Decode);
             int nextOid = (*district)["d_next_o_id"].get_int32();
 
-            auto colOrderLine =
-                conn->database("bench").collection("order_line");
-            auto orderLinesQuery = mongocxx::options::find();
-            orderLinesQuery.projection(MDV("ol_i_id", 1, "_id", 0));
-            orderLinesQuery.batch_size(1000);
-            auto orderLinesResult = colOrderLine.find(
-                *session,
-                MDV("ol_w_id", sparams.wId, "ol_d_id", sparams.dId, "ol_o_id",
-                    MDV("$lt", nextOid, "$gte", nextOid - 20)),
-                orderLinesQuery);
+            markPhase("StockLevelTXNOrderLines", Phase::Build);
+            auto orderLinesFilter = cmd.orderLinesRecent.Bind(
+                sparams.wId, sparams.dId, nextOid, nextOid - 20);
+            markPhase("StockLevelTXNOrderLines", Phase::Execute);
+            auto orderLinesResult = cmd.orderLine.find(
+                *session, orderLinesFilter, cmd.stockLevelOrderLineOptions);
 
             unordered_set<int32_t> ols;
             for (auto &&ol : orderLinesResult) {
                 ols.insert(ol["ol_i_id"].get_int32());
             }
             assert(ols.size() > 0);
+            markPhase("StockLevelTXNStockQuery", Phase::Build);
             bsoncxx::builder::basic::array builder{};
             for (auto it = ols.begin(); it != ols.end();) {
                 builder.append(std::move(ols.extract(it++).value()));
@@ -973,12 +1303,15 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
             cout << "sq" << endl;
 #endif
-            auto colStock = conn->database("bench").collection("stock");
-            auto count = colStock.count_documents(
-                *session, MDV("s_w_id", sparams.wId, "s_i_id",
-                              MDV("$in", builder.extract()), "s_quantity",
-                              MDV("$lt", sparams.threshold)));
+            auto stockFilter =
+                MDV("s_w_id", sparams.wId, "s_i_id",
+                    MDV("$in", builder.extract()), "s_quantity",
+                    MDV("$lt", sparams.threshold));
+            markPhase("StockLevelTXNStockQuery", Phase::Execute);
+            auto count = cmd.stock.count_documents(*session, stockFilter.view());
+            markPhase("commit", Phase::Execute);
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries-1;
@@ -987,7 +1320,7 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
 }
 
 static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
-                mongocxx::pool::entry& conn, int &numFails, int &retries) {
+                mongocxx::pool::entry& conn, MongoTPCCCommands &cmd, int &numFails, int &retries) {
 #ifdef PRINT_TRACE
     cout << "newOrder" << endl;
 #endif
@@ -997,17 +1330,19 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
 #ifdef PRINT_TRACE
             cout << "du" << endl;
 #endif
-            auto colDistrict = conn->database("bench").collection("district");
-            auto optionsDist = mongocxx::options::find_one_and_update();
-            optionsDist.projection(MDV("d_id", 1, "d_w_id", 1, "d_tax", 1,
-                                       "d_next_o_id", 1, "_id", 0));
-            auto district = colDistrict.find_one_and_update(
-                *session, MDV("d_id", noparams.dId, "d_w_id", noparams.wId),
-                MDV("$inc", MDV("d_next_o_id", 1)), optionsDist);
+            markPhase("NewOrderTXNUpdateDistrict", Phase::Build);
+            auto districtFilter = cmd.districtByKey.Bind(noparams.wId, noparams.dId);
+            markPhase("NewOrderTXNUpdateDistrict", Phase::Execute);
+            auto district = cmd.district.find_one_and_update(
+                *session, districtFilter, cmd.districtNextOrderUpdate.view(),
+                cmd.newOrderDistrictOptions);
             assert(district.has_value() == true);
+            markPhase("NewOrderTXNUpdateDistrict", Phase::Decode);
 
             double dTax = (*district)["d_tax"].get_double();
             int dNextOId = (*district)["d_next_o_id"].get_int32();
@@ -1016,22 +1351,29 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
             cout << "iq" << endl;
 #endif
-            auto colItem = conn->database("bench").collection("item");
-            auto optionsItem = mongocxx::options::find();
-            optionsItem.projection(MDV("i_id", 1, "i_price", 1, "i_name", 1,
-                                       "i_data", 1, "_id", 0));
+            markPhase("NewOrderTXNItemQuery", Phase::Build);
             bsoncxx::builder::basic::array iids{};
             for (auto iId : noparams.iIds) {
                 iids.append(iId);
             }
-            auto itemsResults = colItem.find(
-                *session, MDV("i_id", MDV("$in", iids.view())), optionsItem);
-            std::vector<bsoncxx::document::value> items;
+            auto itemFilter = MDV("i_id", MDV("$in", iids.view()));
+            markPhase("NewOrderTXNItemQuery", Phase::Execute);
+            auto itemsResults =
+                cmd.item.find(*session, itemFilter.view(), cmd.newOrderItemOptions);
+            std::vector<NewOrderItem> items;
+            items.reserve(noparams.iIds.size());
+            auto &itemDecoder = cmd.itemDecoder;
             for (auto &&item : itemsResults) {
-                items.push_back(MDV2(item));
+                itemDecoder.Decode(item);
+                items.push_back(
+                    {itemDecoder.Int32(0), itemDecoder.Double(1),
+                     string(itemDecoder.String(2)),
+                     itemDecoder.String(3).find(ORIGINAL_STRING) !=
+                         string_view::npos});
             }
             if (items.size() != noparams.iIds.size()) {
                 numFails++;
+                markPhase("abort", Phase::Execute);
                 session->abort_transaction();
                 return false;
             }
@@ -1056,37 +1398,36 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                 return noparams.iQtys[index];
             };
 
-            auto getItem = [&](int iid) {
+            auto getItem = [&](int iid) -> const NewOrderItem & {
                 return *find_if(items.begin(), items.end(),
-                                [=](bsoncxx::document::value &row) {
-                                    return row["i_id"].get_int32() == iid;
+                                [=](const NewOrderItem &row) {
+                                    return row.iId == iid;
                                 });
             };
 
 #ifdef PRINT_TRACE
             cout << "whq" << endl;
 #endif
-            auto colWarehouse = conn->database("bench").collection("warehouse");
-            auto warehouseQuery = mongocxx::options::find();
-            warehouseQuery.projection(MDV("w_tax", 1, "_id", 0));
-            auto warehouse =
-                colWarehouse.find_one(*session, MDV("w_id", noparams.wId));
+            markPhase("NewOrderTXNQueryWarehouse", Phase::Build);
+            auto warehouseFilter = cmd.warehouseByKey.Bind(noparams.wId);
+            markPhase("NewOrderTXNQueryWarehouse", Phase::Execute);
+            auto warehouse = cmd.warehouse.find_one(
+                *session, warehouseFilter, cmd.newOrderWarehouseOptions);
             assert(warehouse.has_value() == true);
+            markPhase("NewOrderTXNQueryWarehouse", Phase::Decode);
             double wTax = (*warehouse)["w_tax"].get_double();
 
 #ifdef PRINT_TRACE
             cout << "cq" << endl;
 #endif
-            auto colCustomer = conn->database("bench").collection("customer");
-            auto customerQuery = mongocxx::options::find();
-            customerQuery.projection(
-                MDV("c_discount", 1, "c_last", 1, "c_credit", 1, "_id", 0));
-            auto customer =
-                colCustomer.find_one(*session,
-                                     MDV("c_w_id", noparams.wId, "c_d_id",
-                                         noparams.dId, "c_id", noparams.cId),
-                                     customerQuery);
+            markPhase("NewOrderTXNQueryCustomer", Phase::Build);
+            auto customerFilter =
+                cmd.customerByKey.Bind(noparams.wId, noparams.dId, noparams.cId);
+            markPhase("NewOrderTXNQueryCustomer", Phase::Execute);
+            auto customer = cmd.customer.find_one(
+                *session, customerFilter, cmd.newOrderCustomerOptions);
             assert(customer.has_value() == true);
+            markPhase("NewOrderTXNQueryCustomer", Phase::Decode);
             double cDiscount = (*customer)["c_discount"].get_double();
 
             int olCnt = noparams.iIds.size();
@@ -1097,27 +1438,35 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                 all_of(noparams.iIWds.begin(), noparams.iIWds.end(),
                        [=](int i) { return i == noparams.iIWds[0]; });
 
-            auto colStock = conn->database("bench").collection("stock");
-            std::vector<bsoncxx::document::value> stock;
+            auto &stockQuery = cmd.newOrderStockOptions[noparams.dId];
+            auto &stockDecoder = cmd.stockDecoder;
+            auto decodeStock = [&](bsoncxx::document::view stck) {
+                stockDecoder.Decode(stck);
+                return NewOrderStock{
+                    stockDecoder.Int32(0), stockDecoder.Int32(1),
+                    stockDecoder.Int32(2), stockDecoder.Int32(3),
+                    string(stockDecoder.String(4 + noparams.dId)),
+                    stockDecoder.String(4).find(ORIGINAL_STRING) !=
+                        string_view::npos};
+            };
+            std::vector<NewOrderStock> stock;
+            stock.reserve(olCnt);
             if (allLocal) {
 #ifdef PRINT_TRACE
                 cout << "sal" << endl;
 #endif
-                auto stockQuery = mongocxx::options::find();
-                stockQuery.projection(MDV(
-                    "s_i_id", 1, "s_w_id", 1, "s_quantity", 1, "s_data", 1,
-                    "s_ytd", 1, "s_order_cnt", 1, "s_remote_cnt", 1,
-                    fmt::format("s_dist_{:02d}", noparams.dId), 1, "_id", 0));
+                markPhase("NewOrderTXNStockLocal", Phase::Build);
+                auto stockFilter = MDV("s_w_id", noparams.wId, "s_i_id",
+                                       MDV("$in", iids.view()));
+                markPhase("NewOrderTXNStockLocal", Phase::Execute);
                 auto stockResult =
-                    colStock.find(*session,
-                                  MDV("s_w_id", noparams.wId, "s_i_id",
-                                      MDV("$in", iids.view())),
-                                  stockQuery);
+                    cmd.stock.find(*session, stockFilter.view(), stockQuery);
                 for (auto &&stck : stockResult) {
-                    stock.push_back(MDV2(stck));
+                    stock.push_back(decodeStock(stck));
                 }
                 assert(stock.size() == olCnt);
             } else {
+                markPhase("NewOrderTXNStockRemote", Phase::Build);
                 bsoncxx::builder::basic::array filters{};
                 for (int i = 0; i < noparams.iIds.size(); ++i) {
                     filters.append(MDV("s_w_id", getwId(noparams.iIds[i]),
@@ -1127,56 +1476,54 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
                 cout << "sor" << endl;
 #endif
-                auto stockQuery = mongocxx::options::find();
-                stockQuery.projection(MDV(
-                    "s_i_id", 1, "s_w_id", 1, "s_quantity", 1, "s_data", 1,
-                    "s_ytd", 1, "s_order_cnt", 1, "s_remote_cnt", 1,
-                    fmt::format("s_dist_{:02d}", noparams.dId), 1, "_id", 0));
-                auto stockResult = colStock.find(
-                    *session, MDV("$or", filters.view()), stockQuery);
+                auto stockFilter = MDV("$or", filters.view());
+                markPhase("NewOrderTXNStockRemote", Phase::Execute);
+                auto stockResult =
+                    cmd.stock.find(*session, stockFilter.view(), stockQuery);
                 for (auto &&stck : stockResult) {
-                    stock.push_back(MDV2(stck));
+                    stock.push_back(decodeStock(stck));
                 }
                 assert(stock.size() == olCnt);
             }
 
-            auto getStock = [&](int iid) {
+            auto getStock = [&](int iid) -> const NewOrderStock & {
                 return *find_if(stock.begin(), stock.end(),
-                                [=](bsoncxx::document::value &row) {
-                                    return row["s_i_id"].get_int32() == iid;
+                                [=](const NewOrderStock &row) {
+                                    return row.sIId == iid;
                                 });
             };
 
 #ifdef PRINT_TRACE
             cout << "io" << endl;
 #endif
-            auto colOrder = conn->database("bench").collection("order");
-            auto iOResult = colOrder.insert_one(
-                *session, MDV("o_id", dNextOId, "o_w_id", noparams.wId,
-                              "o_d_id", noparams.dId, "o_c_id", noparams.cId,
-                              "o_carrier_id", oCarrierId, "o_ol_cnt", olCnt,
-                              "o_all_local", allLocal, "o_entry_d",
-                              bsoncxx::types::b_date{noparams.oEntryDate}, ));
+            markPhase("NewOrderTXNInsertOrder", Phase::Build);
+            auto orderDoc =
+                cmd.orderInsert.Bind(dNextOId, noparams.wId, noparams.dId,
+                                     noparams.cId, oCarrierId, olCnt, allLocal,
+                                     noparams.oEntryDate);
+            markPhase("NewOrderTXNInsertOrder", Phase::Execute);
+            auto iOResult = cmd.order.insert_one(*session, orderDoc);
             assert(iOResult.has_value() == true);
             assert(iOResult.value().result().inserted_count() == 1);
 
 #ifdef PRINT_TRACE
             cout << "noi" << endl;
 #endif
-            auto colNewOrder = conn->database("bench").collection("new_order");
-            auto noResult = colNewOrder.insert_one(
-                *session, MDV("no_o_id", dNextOId, "no_w_id", noparams.wId,
-                              "no_d_id", noparams.dId, ));
+            markPhase("NewOrderTXNInsertNewOrder", Phase::Build);
+            auto newOrderDoc =
+                cmd.newOrderInsert.Bind(dNextOId, noparams.wId, noparams.dId);
+            markPhase("NewOrderTXNInsertNewOrder", Phase::Execute);
+            auto noResult = cmd.newOrder.insert_one(*session, newOrderDoc);
             assert(noResult.has_value() == true);
             assert(noResult.value().result().inserted_count() == 1);
 
+            // Both bulk writes are built line by line and sent at the end
+            markPhase("NewOrderTXNStockUpdate", Phase::Build);
             vector<tuple<string, int, string, double, double>> itemData;
             itemData.reserve(olCnt);
             double total = 0;
-            auto colOrderLine =
-                conn->database("bench").collection("order_line");
-            auto stockBulk = colStock.create_bulk_write(*session);
-            auto newOrderBulk = colOrderLine.create_bulk_write(*session);
+            auto stockBulk = cmd.stock.create_bulk_write(*session);
+            auto newOrderBulk = cmd.orderLine.create_bulk_write(*session);
             for (int i = 0; i < olCnt; ++i) {
                 int olNumber = i + 1;
                 int olIId = noparams.iIds[i];
@@ -1184,11 +1531,11 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                 int olSupplyWId = noparams.iIWds[i];
                 int olQuantity = noparams.iQtys[i];
 
-                auto item = getItem(olIId);
-                auto stockitem = getStock(olIId);
+                auto &item = getItem(olIId);
+                auto &stockitem = getStock(olIId);
 
-                int sQuantity = stockitem["s_ytd"].get_int32();
-                int sYtd = stockitem["s_ytd"].get_int32() + olQuantity;
+                int sQuantity = stockitem.sYtd;
+                int sYtd = stockitem.sYtd + olQuantity;
 
                 if (sQuantity >= olQuantity + 10) {
                     sQuantity = sQuantity - olQuantity;
@@ -1196,8 +1543,8 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                     sQuantity = sQuantity + 91 - olQuantity;
                 }
 
-                int sOrderCnt = stockitem["s_order_cnt"].get_int32() + 1;
-                int sRemoteCnt = stockitem["s_remote_cnt"].get_int32();
+                int sOrderCnt = stockitem.sOrderCnt + 1;
+                int sRemoteCnt = stockitem.sRemoteCnt;
 
                 if (olSupplyWId != noparams.wId) {
                     sRemoteCnt++;
@@ -1206,14 +1553,14 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
                 cout << "suq" << endl;
 #endif
+                // The bulk writer copies the documents on append, so the
+                // templates can be patched again for the next line.
                 mongocxx::model::update_one updater(
-                    MDV("s_i_id", olIId, "s_w_id", olSupplyWId),
-                    MDV("$set", MDV("s_quantity", sQuantity, "s_ytd", sYtd,
-                                    "s_order_cnt", sOrderCnt, "s_remote_cnt",
-                                    sRemoteCnt, )));
+                    cmd.stockByKey.Bind(olSupplyWId, olIId),
+                    cmd.stockUpdate.Bind(sQuantity, sYtd, sOrderCnt, sRemoteCnt));
                 stockBulk.append(updater);
 
-                double olAmount = olQuantity * item["i_price"].get_double();
+                double olAmount = olQuantity * item.iPrice;
                 total += olAmount;
 
 #ifdef PRINT_TRACE
@@ -1224,155 +1571,90 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                         noparams.dId, "ol_number", olNumber, "ol_i_id", olIId,
                         "ol_supply_w_id", olSupplyWId, "ol_quantity",
                         olQuantity, "ol_amount", olAmount, "ol_dist_info",
-                        stockitem[fmt::format("s_dist_{:02d}", noparams.dId)]
-                            .get_string(),
-                        "ol_delivery_d", bsoncxx::types::b_null(), ));
+                        stockitem.sDist, "ol_delivery_d",
+                        bsoncxx::types::b_null(), ));
                 newOrderBulk.append(inserter);
 
-                string iData(item["i_data"].get_string());
-                string sData(stockitem["s_data"].get_string());
                 string brandGeneric = "G";
-                if (iData.find(ORIGINAL_STRING) != -1 &&
-                    sData.find(ORIGINAL_STRING) != -1) {
+                if (item.original && stockitem.original) {
                     brandGeneric = "B";
                 }
-                itemData.push_back(make_tuple(
-                    string(item["i_name"].get_string()), sQuantity,
-                    brandGeneric, item["i_price"].get_double(), olAmount));
+                itemData.push_back(make_tuple(item.iName, sQuantity,
+                                              brandGeneric, item.iPrice,
+                                              olAmount));
             }
+            markPhase("NewOrderTXNStockUpdate", Phase::Execute);
             auto stockResult = stockBulk.execute();
             assert(stockResult.has_value() == true);
             assert(stockResult.value().matched_count() == olCnt);
+            markPhase("NewOrderTXNInsertOrderLine", Phase::Execute);
             auto olResult = newOrderBulk.execute();
             assert(olResult.has_value() == true);
             assert(olResult.value().inserted_count() == olCnt);
             total *= (1 - cDiscount) * (1 + wTax + dTax);
+            markPhase("commit", Phase::Execute);
             return true;
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries -1;
     return true;
 }
 
-static ScaleParameters params = ScaleParameters::makeDefault(4);
-static void BM_MONGO_TPCC_OLD(benchmark::State &state) {
-	auto conn = MongoDBHandler::GetConnection();
-    if (state.thread_index() == 0) {
-        int warehouses = state.range(0);
-        params = ScaleParameters::makeDefault(warehouses);
-        try {
-            LoadBenchmark(conn, params, warehouses, state.threads());
-        } catch (...) {
-            cerr << "Error loading benchmark" << endl;
-            throw;
-        }
+namespace {
+class MongoTPCCOld : public Backend {
+  public:
+    explicit MongoTPCCOld(benchmark::State &state)
+        : state(state), conn(MongoDBHandler::GetConnection()), cmd(conn) {}
+
+    void load(ScaleParameters &params, int clients) override {
+        LoadBenchmark(conn, params, params.warehouses, clients);
     }
-    int numDeliveries = 0;
-    int numOrderStatuses = 0;
-    int numNewOrders = 0;
-    int numFailedNewOrders = 0;
-    int numPayments = 0;
-    int numStockLevels = 0;
-    int numDeadlocks = 0;
-    int numOtherErrors = 0;
-    int retries = 0;
-    for (auto _ : state) {
-        // auto start = std::chrono::high_resolution_clock::now();
-        tpcc::TransactionType type = randomHelper.nextTransactionType();
-        // Start transaction
-
-        try {
-        bool result = false;
-        switch (type) {
-        case tpcc::TransactionType::Delivery:
-            result = doDeliveryN(state, params, conn, retries);
-            numDeliveries++;
-            break;
-        case tpcc::TransactionType::OrderStatus:
-            result = doOrderStatus(state, params, conn, retries);
-            numOrderStatuses++;
-            break;
-        case tpcc::TransactionType::Payment:
-            result = doPayment(state, params, conn, retries);
-            numPayments++;
-            break;
-        case tpcc::TransactionType::StockLevel:
-            result = doStockLevel(state, params, conn, retries);
-            numStockLevels++;
-            break;
-        case tpcc::TransactionType::NewOrder:
-            result = doNewOrder(state, params, conn, numFailedNewOrders, retries);
-            numNewOrders++;
-            break;
-        }
-        } catch(mongocxx::operation_exception& e) {
-            if(e.has_error_label("TransientTransactionError")) {
-                cout << this_thread::get_id() << " Operation exception! Transient \r\n" << e.what() << endl;
-            } else if(e.has_error_label("UnknownTransactionCommitResult")) {
-                cout << this_thread::get_id() << " Operation exception! Unknown \r\n" << e.what() << endl;
-            }
-        } catch(mongocxx::exception& e) {
-            cout << this_thread::get_id() << " mongocxxException!\r\n" << e.what() << endl;
-        } catch(std::exception& e) {
-            cout << this_thread::get_id() << " std exception!\r\n" << e.what() << endl;
-        } catch(...) {
-            cout << this_thread::get_id() << " Unknown exception!\r\n" << endl;
-            throw;
-        }
-        // auto end = std::chrono::high_resolution_clock::now();
-        // auto elapsed_seconds =
-        //     std::chrono::duration_cast<std::chrono::duration<double>>(end -
-        //                                                               start);
-        // state.SetIterationTime(elapsed_seconds.count());
+    bool newOrder(ScaleParameters &params) override {
+        int numFails = 0;
+        doNewOrder(state, params, conn, cmd, numFails, retries);
+        return numFails == 0;
+    }
+    bool payment(ScaleParameters &params) override {
+        return doPayment(state, params, conn, cmd, retries);
+    }
+    bool orderStatus(ScaleParameters &params) override {
+        return doOrderStatus(state, params, conn, cmd, retries);
+    }
+    bool delivery(ScaleParameters &params) override {
+        return doDeliveryN(state, params, conn, cmd, retries);
+    }
+    bool stockLevel(ScaleParameters &params) override {
+        return doStockLevel(state, params, conn, cmd, retries);
     }
+    // Transactions that exhausted their retries are logged and the terminal goes on
+    FailureKind classify(const std::exception &e) const override {
+        return FailureKind::Transient;
+    }
+    void counters(std::map<std::string, double> &out) const override {
+        out["retries"] = retries;
+    }
+    void serverStatistics(std::map<std::string, double> &out) override {
+        out = MongoDBHandler::ServerStats(*conn, "bench",
+                                          {"warehouse", "district", "customer", "history", "new_order",
+                                           "order", "order_line", "item", "stock"});
+    }
+
+  private:
+    benchmark::State &state;
+    mongocxx::pool::entry conn;
+    MongoTPCCCommands cmd;
+    int retries = 0;
+};
+} // namespace
 
-    int total = numDeliveries + numNewOrders + numFailedNewOrders +
-                numOrderStatuses + numPayments + numStockLevels;
-
-    state.counters["retries"] = retries;
-
-    state.counters["txn"] = total;
-    state.counters["txnRate"] =
-        benchmark::Counter(total, benchmark::Counter::kIsRate);
-    state.counters["txnRateInv"] = benchmark::Counter(
-        total, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-
-    state.counters["delivery"] = numDeliveries;
-    state.counters["deliveryRate"] =
-        benchmark::Counter(numDeliveries, benchmark::Counter::kIsRate);
-    state.counters["deliveryRateInv"] =
-        benchmark::Counter(numDeliveries, benchmark::Counter::kIsRate |
-                                              benchmark::Counter::kInvert);
-
-    state.counters["newOrder"] = numNewOrders;
-    state.counters["newOrderRate"] =
-        benchmark::Counter(numNewOrders, benchmark::Counter::kIsRate);
-    state.counters["newOrderRateInv"] =
-        benchmark::Counter(numNewOrders, benchmark::Counter::kIsRate |
-                                             benchmark::Counter::kInvert);
-
-    state.counters["newOrderFail"] = numFailedNewOrders;
-
-    state.counters["payment"] = numPayments;
-    state.counters["paymentRate"] =
-        benchmark::Counter(numPayments, benchmark::Counter::kIsRate);
-    state.counters["paymentRateInv"] = benchmark::Counter(
-        numPayments, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-
-    state.counters["status"] = numOrderStatuses;
-    state.counters["statusRate"] =
-        benchmark::Counter(numOrderStatuses, benchmark::Counter::kIsRate);
-    state.counters["statusRateInv"] =
-        benchmark::Counter(numOrderStatuses, benchmark::Counter::kIsRate |
-                                                 benchmark::Counter::kInvert);
-
-    state.counters["stock"] = numStockLevels;
-    state.counters["stockRate"] =
-        benchmark::Counter(numStockLevels, benchmark::Counter::kIsRate);
-    state.counters["stockRateInv"] =
-        benchmark::Counter(numStockLevels, benchmark::Counter::kIsRate |
-                                               benchmark::Counter::kInvert);
+static void BM_MONGO_TPCC_OLD(benchmark::State &state, ArrivalProcess arrival) {
+    runTPCC(state, "mongo_tpcc_old", arrival, [](benchmark::State &state) {
+        return make_unique<MongoTPCCOld>(state);
+    });
 }
 
-BENCHMARK(BM_MONGO_TPCC_OLD)->RangeMultiplier(2)->Range(1,10)->Iterations(10000)->ThreadRange(1,16)->UseRealTime();
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_OLD, Closed, ArrivalProcess::Closed)->RangeMultiplier(2)->Range(1,10)->ThreadRange(1,16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_OLD, Constant, ArrivalProcess::Constant)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_OLD, Poisson, ArrivalProcess::Poisson)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
@@ -1,26 +1,41 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/mongodb/mongodb.hpp"
+#include "dbphd/mongodb/bsondecoder.hpp"
 #include <mongocxx/exception/exception.hpp>
 #include <mongocxx/exception/operation_exception.hpp>
+#include <mongocxx/pipeline.hpp>
 #include <bsoncxx/builder/list.hpp>
 #include <bsoncxx/types.hpp>
 #include <bsoncxx/types/bson_value/value.hpp>
 using bsoncxx::builder::basic::kvp;
+using bsoncxx::builder::basic::make_array;
 using bsoncxx::builder::basic::make_document;
 using bsoncxx::builder::list;
 using bsoncxx::builder::document;
 
+#include "dbphd/perf/affinity.hpp"
 #include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpcbackend.hpp"
+#include "dbphd/tpc/tpcpacing.hpp"
+#include "dbphd/tpc/tpcconflicts.hpp"
+#include "dbphd/tpc/tpcphases.hpp"
+#include "dbphd/tpc/tpcsnapshot.hpp"
+#include "tpccdriver.hpp"
+#include "tpccreport.hpp"
 
 using namespace tpcc;
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <deque>
 #include <fmt/chrono.h>
 #include <fmt/core.h>
 #include <iostream>
+#include <memory>
+#include <map>
 #include <omp.h>
+#include <optional>
 #include <random>
 #include <thread>
 #include <vector>
@@ -30,26 +45,9 @@ using namespace tpcc;
 //#define PRINT_TRACE
 using namespace std;
 
-static void LoadBenchmark(mongocxx::pool::entry& conn,
-                          ScaleParameters &params, int warehouses, int clients) {
-    static volatile bool created = false;
-    static ScaleParameters oldParams = ScaleParameters::makeDefault(1);
-    static volatile int oldclients = 0;
-    if (created && oldParams == params && clients == oldclients)
-        return;
-    created = false;
-    oldParams = params;
-    oldclients = clients;
-    cout << endl
-         << "Creating mongodb modern TPC-C Tables with " << omp_get_num_procs()
-         << " threads ..." << endl;
-    cout.flush();
-    auto start = chrono::steady_clock::now();
-    {
-        auto db = conn->database("bench");
-        db.drop();
-    }
-
+// Generates the warehouses of params, each OpenMP thread loading its share
+// over its own connection, and the items when loadItems
+static void PopulateBenchmark(ScaleParameters &params, int clients, bool loadItems) {
     // Use clients to scale loading too
     vector<vector<int>> w_ids;
     w_ids.resize(omp_get_num_procs());
@@ -67,6 +65,10 @@ static void LoadBenchmark(mongocxx::pool::entry& conn,
     const static int BATCH_SIZE = 500;
 #pragma omp parallel private(threadId) num_threads(omp_get_num_procs())
     {
+        // Placed like the terminals, and unpinned again at the end of the region
+        // because OpenMP keeps its threads for later regions
+        perf::ScopedAffinity pinned(perf::workerCpus(omp_get_thread_num()));
+        seedLoader(omp_get_thread_num());
         auto mongoconn = MongoDBHandler::GetConnection();
         auto db = mongoconn->database("bench");
         auto warehouseC = db.collection("warehouse");
@@ -80,7 +82,7 @@ static void LoadBenchmark(mongocxx::pool::entry& conn,
         cout << "Thread: " << threadId << endl;
 #endif
         // Need to load items...
-        if (threadId == 0) {
+        if (threadId == 0 && loadItems) {
             auto itemC = db.collection("item");
             auto originalRows =
                 randomHelper.uniqueIds(params.items / 10, 1, params.items);
@@ -471,6 +473,147 @@ static void LoadBenchmark(mongocxx::pool::entry& conn,
             }
         } // Warehouse
     }     // Per thread/client
+}
+
+static const vector<string> tpccCollections = {"warehouse", "district", "customer", "history",
+                                               "order", "item", "stock"};
+
+// Puts the loaded dataset back the way it was loaded before the next run, so
+// repeated runs start from the same data. The orders and payments of the run
+// are range deleted above the load-time marks of the snapshot (the next order
+// id of each district and the date of its latest payment), and the orders the
+// run delivered and the documents it can change are replaced by their snapshot
+// copies, which also drops the tokens of retried transactions. $merge cannot
+// tell which ones changed, so every customer and stock document is replaced.
+// Without a snapshot the data of the earlier runs stays.
+static void ResetBenchmark(mongocxx::pool::entry& conn, const string &key) {
+    if (!snapshotsEnabled())
+        return;
+    if (!MongoDBHandler::SnapshotExists(*conn, key)) {
+        cout << "No snapshot of " << key << " to reset to" << endl;
+        return;
+    }
+    auto start = chrono::steady_clock::now();
+    auto db = conn->database("bench");
+    auto snapshot = conn->database(key);
+    mongocxx::options::find latest;
+    latest.sort(make_document(kvp("h_date", -1)));
+    auto lastPayment = snapshot["history"].find_one({}, latest);
+    if (lastPayment) {
+        db["history"].delete_many(make_document(
+            kvp("h_date", make_document(kvp("$gt", (*lastPayment)["h_date"].get_date())))));
+    }
+    for (auto &&district : snapshot["district"].find({})) {
+        db["order"].delete_many(make_document(
+            kvp("o_w_id", district["d_w_id"].get_int32()),
+            kvp("o_d_id", district["d_id"].get_int32()),
+            kvp("o_id", make_document(kvp("$gte", district["d_next_o_id"].get_int32())))));
+    }
+    MongoDBHandler::ResetCollection(*conn, key, "bench", "order",
+                                    make_document(kvp("o_new", true)), false);
+    for (auto collection : {"customer", "stock", "district", "warehouse"})
+        MongoDBHandler::ResetCollection(*conn, key, "bench", collection, {}, false);
+    auto end = chrono::steady_clock::now();
+    cout << "Reset mongodb modern TPC-C Tables in "
+         << chrono::duration<double, milli>(end - start).count() << " ms" << endl;
+    report::RunReport::global().recordLoad(
+        "mongodb", "tpcc_modern_reset", chrono::duration<double, milli>(end - start).count());
+}
+
+// Adds the warehouses after the loaded ones, or deletes the surplus ones (with
+// their orders, customers and stock), leaving the items alone, and snapshots
+// the result as the resized dataset key, so later runs are reset to it. Order
+// lines of the remaining warehouses supplied by a deleted one are supplied
+// locally instead.
+static void ResizeBenchmark(mongocxx::pool::entry& conn, const ScaleParameters &loaded,
+                            ScaleParameters &params, int clients, const string &key) {
+    cout << endl
+         << "Resizing mongodb modern TPC-C Tables from " << loaded.endingWarehouse << " to "
+         << params.endingWarehouse << " warehouses ..." << endl;
+    auto start = chrono::steady_clock::now();
+    if (params.endingWarehouse > loaded.endingWarehouse) {
+        auto added = warehouseRange(params, loaded.endingWarehouse + 1, params.endingWarehouse);
+        PopulateBenchmark(added, clients, false);
+    } else {
+        using bsoncxx::builder::basic::kvp;
+        using bsoncxx::builder::basic::make_document;
+        auto db = conn->database("bench");
+        // The field with the warehouse of each collection
+        const vector<pair<string, string>> warehouseFields = {
+            {"history", "h_w_id"}, {"order", "o_w_id"}, {"customer", "c_w_id"},
+            {"stock", "s_w_id"}, {"district", "d_w_id"}, {"warehouse", "w_id"}};
+        for (auto &field : warehouseFields) {
+            db.collection(field.first)
+                .delete_many(make_document(
+                    kvp(field.second, make_document(kvp("$gt", params.endingWarehouse)))));
+        }
+        // The embedded lines are rewritten whole, with a $map over o_lines
+        auto remote = make_document(
+            kvp("$gt", make_array("$$l.ol_supply_w_id", params.endingWarehouse)));
+        auto supplied = make_document(kvp(
+            "$mergeObjects", make_array("$$l", make_document(kvp("ol_supply_w_id", "$o_w_id")))));
+        mongocxx::pipeline local;
+        local.set(make_document(kvp(
+            "o_lines",
+            make_document(kvp(
+                "$map", make_document(kvp("input", "$o_lines"), kvp("as", "l"),
+                                      kvp("in", make_document(kvp(
+                                                    "$cond", make_array(remote.view(),
+                                                                        supplied.view(),
+                                                                        "$$l"))))))))));
+        db.collection("order").update_many(
+            make_document(kvp("o_lines.ol_supply_w_id",
+                               make_document(kvp("$gt", params.endingWarehouse)))),
+            local);
+    }
+    if (snapshotsEnabled())
+        MongoDBHandler::SnapshotCollections(*conn, "bench", key, tpccCollections);
+    auto end = chrono::steady_clock::now();
+    cout << " Done in " << chrono::duration<double, milli>(end - start).count()
+         << " ms" << endl
+         << endl;
+    report::RunReport::global().recordLoad(
+        "mongodb", "tpcc_modern_resize", chrono::duration<double, milli>(end - start).count());
+}
+
+static void LoadBenchmark(mongocxx::pool::entry& conn,
+                          ScaleParameters &params, int warehouses, int clients) {
+    // The data stays for runs that only change the number of terminals, reset
+    // to the way it was loaded
+    static optional<DatasetKey> loaded;
+    DatasetKey dataset{"mongodb", "modern", params, loadSeed()};
+    string key = dataset.name();
+    if (loaded && loaded->sameScale(dataset)) {
+        ResetBenchmark(conn, loaded->name());
+        return;
+    }
+    if (loaded && loaded->resizesTo(dataset)) {
+        ResetBenchmark(conn, loaded->name());
+        dataset.resized = true;
+        ResizeBenchmark(conn, loaded->params, params, clients, dataset.name());
+        loaded = dataset;
+        return;
+    }
+    loaded.reset();
+    cout << endl
+         << "Creating mongodb modern TPC-C Tables with " << omp_get_num_procs()
+         << " threads ..." << endl;
+    cout.flush();
+    auto start = chrono::steady_clock::now();
+    {
+        auto db = conn->database("bench");
+        db.drop();
+    }
+
+    bool restored = snapshotsEnabled() &&
+                    MongoDBHandler::RestoreCollections(*conn, key, "bench", tpccCollections);
+    if (restored) {
+        cout << "Restored " << key << endl;
+    } else {
+        PopulateBenchmark(params, clients, true);
+        if (snapshotsEnabled())
+            MongoDBHandler::SnapshotCollections(*conn, "bench", key, tpccCollections);
+    }
 
     cout << "Done populating, altering DB..." << endl;
 
@@ -500,13 +643,47 @@ static void LoadBenchmark(mongocxx::pool::entry& conn,
         auto stockC = db.collection("stock");
         stockC.create_index(MDV("s_w_id", 1, "s_i_id", 1), options);
     }
-    created = true;
+    loaded = dataset;
     auto end = chrono::steady_clock::now();
     cout << " Done in " << chrono::duration<double, milli>(end - start).count()
          << " ms" << endl
          << endl;
+    report::RunReport::global().recordLoad(
+        "mongodb", restored ? "tpcc_modern_restore" : "tpcc_modern",
+        chrono::duration<double, milli>(end - start).count());
+    report::RunReport::global().describeEngine("mongodb",
+                                               [&] { return MongoDBHandler::ServerInfo(*conn); });
 }
 
+namespace {
+// Decoded rows the NewOrder transaction keeps after its cursors have moved on
+struct NewOrderItem {
+    int32_t iId;
+    double iPrice;
+    string iName;
+    bool original;
+};
+
+struct NewOrderStock {
+    int32_t sIId;
+    int32_t sYtd;
+    int32_t sOrderCnt;
+    int32_t sRemoteCnt;
+    string sDist;
+    bool original;
+};
+
+// Per terminal result decoders, field indexes follow the projections used below
+thread_local BSONDecoder customerIdDecoder{"c_id"};
+thread_local BSONDecoder orderStatusDecoder{"o_id", "o_lines"};
+thread_local BSONDecoder itemDecoder{"i_id", "i_price", "i_name", "i_data"};
+// Only the s_dist_xx of the order's district is projected, it is field 4 + d_id
+thread_local BSONDecoder stockDecoder{
+    "s_i_id",    "s_ytd",     "s_order_cnt", "s_remote_cnt", "s_data",
+    "s_dist_01", "s_dist_02", "s_dist_03",   "s_dist_04",    "s_dist_05",
+    "s_dist_06", "s_dist_07", "s_dist_08",   "s_dist_09",    "s_dist_10"};
+} // namespace
+
 static bool doDelivery(benchmark::State &state, ScaleParameters &params,
                        DeliveryParams &dparams, mongocxx::pool::entry &conn,
                        mongocxx::client_session &session) {
@@ -516,12 +693,16 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "noq" << endl;
 #endif
+    markPhase("DeliveryTXNNewOrder", Phase::Build);
     auto colOrder = conn->database("bench").collection("order");
     auto options = mongocxx::options::find_one_and_update();
     options.projection(MDV("o_lines", 1, "o_c_id", 1, "o_id", 1, "o_d_id", 1, "o_w_id", 1, "_id", 0));
     options.sort(MDV("o_id", 1));
     options.return_document(mongocxx::options::return_document::k_after);
-    auto no_result = colOrder.find_one_and_update(session, MDV("o_d_id", dparams.dId, "o_w_id", dparams.wId, "o_new", true), MDV("$unset", MDV("o_new", 1),"$set", MDV("o_carrier_id", dparams.oCarrierId, "o_delivery_d", bsoncxx::types::b_date{dparams.olDeliveryD})), options);
+    auto orderFilter = MDV("o_d_id", dparams.dId, "o_w_id", dparams.wId, "o_new", true);
+    auto orderUpdate = MDV("$unset", MDV("o_new", 1),"$set", MDV("o_carrier_id", dparams.oCarrierId, "o_delivery_d", bsoncxx::types::b_date{dparams.olDeliveryD}));
+    markPhase("DeliveryTXNNewOrder", Phase::Execute);
+    auto no_result = colOrder.find_one_and_update(session, orderFilter.view(), orderUpdate.view(), options);
     if(no_result.has_value() == false) {
         // No orders for this district. TODO report when >1%
         if (state.counters.count("no_new_orders") == 0)
@@ -531,6 +712,7 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
         }
         return true;
     }
+    markPhase("DeliveryTXNNewOrder", Phase::Decode);
     bsoncxx::document::view o_result = *no_result;
     int oId = o_result["o_id"].get_int32();
     int cId = o_result["o_c_id"].get_int32();
@@ -550,8 +732,12 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
     #ifdef PRINT_TRACE
     cout << "cuq" << endl;
 #endif
+    markPhase("DeliveryTXNUpdateCust", Phase::Build);
     auto colCustomer = conn->database("bench").collection("customer");
-    auto cust_update_result = colCustomer.update_one(session, MDV("c_d_id", dparams.dId, "c_w_id", dparams.wId, "c_id", cId), MDV("$set", MDV("c_balance", total)));
+    auto customerFilter = MDV("c_d_id", dparams.dId, "c_w_id", dparams.wId, "c_id", cId);
+    auto customerUpdate = MDV("$set", MDV("c_balance", total));
+    markPhase("DeliveryTXNUpdateCust", Phase::Execute);
+    auto cust_update_result = colCustomer.update_one(session, customerFilter.view(), customerUpdate.view());
     assert(cust_update_result.has_value() == true);
     assert(cust_update_result.value().modified_count() == 1);
     assert(total > 0);
@@ -572,15 +758,20 @@ static bool doDeliveryN(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
             for (int dId = 1; dId <= n; ++dId) {
                 dparams.dId = dId;
+                markConflictKey(dparams.wId, dId);
                 bool result =
                     doDelivery(state, params, dparams, conn, *session);
                 if (!result)
                     return false;
             }
+            markPhase("commit", Phase::Execute);
             return true;
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries - 1;
@@ -598,52 +789,60 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
             auto colCustomer = conn->database("bench").collection("customer");
 
-            std::optional<bsoncxx::document::value> customer;
+            int cId;
             if (osparams.cId != INT32_MIN) {
 #ifdef PRINT_TRACE
                 cout << "cqi" << endl;
 #endif
+                markPhase("OrderStatusTXNCustById", Phase::Build);
                 auto findOptions = mongocxx::options::find();
                 findOptions.comment("OrderStatusTXNCustById");
                 findOptions.projection(MDV("c_id", 1, "c_first", 1, "c_middle",
                                            1, "c_last", 1, "c_balance", 1,
                                            "_id", 0));
-                customer = colCustomer.find_one(*session,
-                                                MDV("c_id", osparams.cId,
-                                                    "c_w_id", osparams.wId,
-                                                    "c_d_id", osparams.dId),
-                                                findOptions);
+                auto customerFilter = MDV("c_id", osparams.cId, "c_w_id",
+                                          osparams.wId, "c_d_id", osparams.dId);
+                markPhase("OrderStatusTXNCustById", Phase::Execute);
+                auto customer = colCustomer.find_one(
+                    *session, customerFilter.view(), findOptions);
+                assert(customer.has_value() == true);
+                markPhase("OrderStatusTXNCustById", Phase::Decode);
+                customerIdDecoder.Decode(customer->view());
+                cId = customerIdDecoder.Int32(0);
             } else {
 #ifdef PRINT_TRACE
                 cout << "cql" << endl;
 #endif
+                markPhase("OrderStatusTXNCustByLastName", Phase::Build);
                 auto findOptions = mongocxx::options::find();
                 findOptions.comment("OrderStatusTXNCustByLastName");
                 findOptions.projection(MDV("c_id", 1, "c_first", 1, "c_middle",
                                            1, "c_last", 1, "c_balance", 1,
                                            "_id", 0));
                 findOptions.sort(MDV("c_first", 1));
+                auto customerFilter = MDV("c_last", osparams.cLast, "c_w_id",
+                                          osparams.wId, "c_d_id", osparams.dId);
+                markPhase("OrderStatusTXNCustByLastName", Phase::Execute);
                 auto customers =
-                    colCustomer.find(*session,
-                                     MDV("c_last", osparams.cLast, "c_w_id",
-                                         osparams.wId, "c_d_id", osparams.dId),
-                                     findOptions);
-                std::vector<bsoncxx::document::value> results;
+                    colCustomer.find(*session, customerFilter.view(), findOptions);
+                std::vector<int32_t> results;
                 for (auto &&cust : customers) {
-                    results.push_back(MDV2(cust));
+                    customerIdDecoder.Decode(cust);
+                    results.push_back(customerIdDecoder.Int32(0));
                 }
                 assert(results.size() > 0);
                 int index = (results.size() - 1) / 2;
-                customer = results[index];
+                cId = results[index];
             }
-            assert(customer.has_value() == true);
-            int cId = (*customer)["c_id"].get_int32();
 
 #ifdef PRINT_TRACE
             cout << "oq" << endl;
 #endif
+            markPhase("OrderStatusTXNOrders", Phase::Build);
             auto colOrder = conn->database("bench").collection("order");
             auto findOptions = mongocxx::options::find();
             findOptions.comment("OrderStatusTXNOrders");
@@ -653,23 +852,27 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
                 "o_lines.ol_quantity", 1, "o_lines.ol_amount", 1, "_id", 0));
             findOptions.sort(MDV("o_id", -1));
             findOptions.limit(1);
+            auto orderFilter = MDV("o_c_id", cId, "o_w_id", osparams.wId,
+                                   "o_d_id", osparams.dId);
+            markPhase("OrderStatusTXNOrders", Phase::Execute);
             auto theOrders =
-                colOrder.find(*session,
-                              MDV("o_c_id", cId, "o_w_id", osparams.wId,
-                                  "o_d_id", osparams.dId),
-                              findOptions);
-            std::vector<bsoncxx::document::value> allOrders;
+                colOrder.find(*session, orderFilter.view(), findOptions);
+            int numOrders = 0;
+            int oId = -1;
+            int olCount = 0;
             for (auto &&ord : theOrders) {
-                allOrders.push_back(MDV2(ord));
+                orderStatusDecoder.Decode(ord);
+                oId = orderStatusDecoder.Int32(0);
+                auto lines = orderStatusDecoder.Array(1);
+                olCount = std::distance(lines.begin(), lines.end());
+                numOrders++;
             }
-            assert(allOrders.size() == 1);
-            auto order = allOrders[0];
-
-            int oId = order["o_id"].get_int32();
-            int olCount = order["o_lines"].get_array().value.length();
+            assert(numOrders == 1);
             assert(olCount > 0);
             // TODO actually return result... customer, order, orderlines
+            markPhase("commit", Phase::Execute);
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries - 1;
@@ -687,31 +890,40 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
 #ifdef PRINT_TRACE
             cout << this_thread::get_id() << " distq" << endl;
 #endif
+            markPhase("PaymentTXNUpdateDistrict", Phase::Build);
             auto colDistrict = conn->database("bench").collection("district");
             auto updateDistOptions = mongocxx::options::find_one_and_update();
             updateDistOptions.projection(
                 MDV("d_name", 1, "d_street_1", 1, "d_street_2", 1, "d_city", 1,
                     "d_state", 1, "d_zip", 1, "_id", 0));
+            auto districtFilter = MDV("d_id", pparams.dId, "d_w_id", pparams.wId);
+            auto districtUpdate = MDV("$inc", MDV("d_ytd", pparams.hAmount));
+            markPhase("PaymentTXNUpdateDistrict", Phase::Execute);
             auto district = colDistrict.find_one_and_update(
-                *session, MDV("d_id", pparams.dId, "d_w_id", pparams.wId),
-                MDV("$inc", MDV("d_ytd", pparams.hAmount)), updateDistOptions);
+                *session, districtFilter.view(), districtUpdate.view(),
+                updateDistOptions);
             assert(district.has_value() == true);
 
 #ifdef PRINT_TRACE
             cout << this_thread::get_id() << " whq" << endl;
 #endif
+            markPhase("PaymentTXNUpdateWarehouse", Phase::Build);
             auto colWarehouse = conn->database("bench").collection("warehouse");
             auto updateWarehouseOptions =
                 mongocxx::options::find_one_and_update();
             updateWarehouseOptions.projection(
                 MDV("w_name", 1, "w_street_1", 1, "w_street_2", 1, "w_city", 1,
                     "w_state", 1, "w_zip", 1, "_id", 0));
+            auto warehouseFilter = MDV("w_id", pparams.wId);
+            auto warehouseUpdate = MDV("$inc", MDV("w_ytd", pparams.hAmount));
+            markPhase("PaymentTXNUpdateWarehouse", Phase::Execute);
             auto warehouse = colWarehouse.find_one_and_update(
-                *session, MDV("w_id", pparams.wId),
-                MDV("$inc", MDV("w_ytd", pparams.hAmount)),
+                *session, warehouseFilter.view(), warehouseUpdate.view(),
                 updateWarehouseOptions);
             assert(warehouse.has_value() == true);
 
@@ -721,6 +933,7 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
                 cout << this_thread::get_id() << " cqi" << endl;
 #endif
+                markPhase("PaymentTXNCustById", Phase::Build);
                 auto customerOptions = mongocxx::options::find();
                 customerOptions.projection(MDV(
                     "c_id", 1, "c_w_id", 1, "c_d_id", 1, "c_delivery_cnt", 1,
@@ -728,15 +941,16 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
                     "c_street_2", 1, "c_city", 1, "c_state", 1, "c_zip", 1,
                     "c_phone", 1, "c_credit", 1, "c_credit_lim", 1,
                     "c_discount", 1, "c_data", 1, "c_since", 1, "_id", 0));
-                customer = colCustomer.find_one(*session,
-                                                MDV("c_id", pparams.cId,
-                                                    "c_w_id", pparams.cWId,
-                                                    "c_d_id", pparams.cDId),
+                auto customerFilter = MDV("c_id", pparams.cId, "c_w_id",
+                                          pparams.cWId, "c_d_id", pparams.cDId);
+                markPhase("PaymentTXNCustById", Phase::Execute);
+                customer = colCustomer.find_one(*session, customerFilter.view(),
                                                 customerOptions);
             } else {
 #ifdef PRINT_TRACE
                 cout << this_thread::get_id() << " cql" << endl;
 #endif
+                markPhase("PaymentTXNCustByLastName", Phase::Build);
                 auto customerOptions = mongocxx::options::find();
                 customerOptions.sort(MDV("c_first", 1));
                 customerOptions.projection(MDV(
@@ -745,11 +959,11 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
                     "c_street_2", 1, "c_city", 1, "c_state", 1, "c_zip", 1,
                     "c_phone", 1, "c_credit", 1, "c_credit_lim", 1,
                     "c_discount", 1, "c_data", 1, "c_since", 1, "_id", 0));
-                auto customers =
-                    colCustomer.find(*session,
-                                     MDV("c_last", pparams.cLast, "c_w_id",
-                                         pparams.cWId, "c_d_id", pparams.cDId),
-                                     customerOptions);
+                auto customerFilter = MDV("c_last", pparams.cLast, "c_w_id",
+                                          pparams.cWId, "c_d_id", pparams.cDId);
+                markPhase("PaymentTXNCustByLastName", Phase::Execute);
+                auto customers = colCustomer.find(
+                    *session, customerFilter.view(), customerOptions);
 
                 std::vector<bsoncxx::document::value> results;
                 for (auto &&cust : customers) {
@@ -760,6 +974,9 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
                 customer = results[index];
             }
             assert(customer.has_value() == true);
+            markPhase(pparams.cId != INT32_MIN ? "PaymentTXNCustById"
+                                               : "PaymentTXNCustByLastName",
+                      Phase::Decode);
             int cId = (*customer)["c_id"].get_int32();
             string cData((*customer)["c_data"].get_string());
             string cCredit((*customer)["c_credit"].get_string());
@@ -776,16 +993,21 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
             cout << "cuq" << endl;
 #endif
+            markPhase("PaymentTXNCustUpdate", Phase::Build);
             auto colHistory = conn->database("bench").collection("history");
-            auto c_update = colCustomer.update_one(
-                *session,
-                MDV("c_id", cId, "c_w_id", pparams.cWId, "c_d_id", pparams.cDId),
+            auto customerFilter =
+                MDV("c_id", cId, "c_w_id", pparams.cWId, "c_d_id", pparams.cDId);
+            auto customerUpdate =
                 MDV("$set", MDV("c_data", cData), "$inc",
                     MDV("c_balance", -pparams.hAmount, "c_ytd_payment",
-                        pparams.hAmount, "c_payment_cnt", 1)));
+                        pparams.hAmount, "c_payment_cnt", 1));
+            markPhase("PaymentTXNCustUpdate", Phase::Execute);
+            auto c_update = colCustomer.update_one(
+                *session, customerFilter.view(), customerUpdate.view());
             assert(c_update.has_value() == true);
             assert(c_update.value().modified_count() == 1);
 
+            markPhase("PaymentTXNHistory", Phase::Build);
             string h_data =
                 fmt::format("{:s}    {:s}", (*warehouse)["w_name"].get_string(),
                             (*district)["d_name"].get_string());
@@ -793,15 +1015,18 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
             cout << "hi" << endl;
 #endif
-            auto insertResult = colHistory.insert_one(
-                *session,
+            auto history =
                 MDV("h_c_id", cId, "h_c_w_id", pparams.cWId, "h_w_id",
                     pparams.wId, "h_c_d_id", pparams.cDId, "h_d_id",
                     pparams.dId, "h_amount", pparams.hAmount, "h_data", h_data,
-                    "h_date", bsoncxx::types::b_date{pparams.hDate}, ));
+                    "h_date", bsoncxx::types::b_date{pparams.hDate}, );
+            markPhase("PaymentTXNHistory", Phase::Execute);
+            auto insertResult = colHistory.insert_one(*session, history.view());
             assert(insertResult.has_value() == true);
             assert(insertResult.value().result().inserted_count() == 1);
+            markPhase("commit", Phase::Execute);
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries-1;
@@ -819,28 +1044,35 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
 
 #ifdef PRINT_TRACE
             cout << "dq" << endl;
 #endif
+            markPhase("StockLevelTXNDistQuery", Phase::Build);
             auto colDistrict = conn->database("bench").collection("district");
             auto queryOptions = mongocxx::options::find();
             queryOptions.projection(MDV("d_next_o_id", 1, "_id", 0));
-            auto district = colDistrict.find_one(
-                *session, MDV("d_id", sparams.dId, "d_w_id", sparams.wId));
+            auto districtFilter = MDV("d_id", sparams.dId, "d_w_id", sparams.wId);
+            markPhase("StockLevelTXNDistQuery", Phase::Execute);
+            auto district = colDistrict.find_one(*session, districtFilter.view());
             assert(district.has_value() == true);
+            markPhase("StockLevelTXNDistQuery", Phase::Decode);
             int nextOid = (*district)["d_next_o_id"].get_int32();
 
+            markPhase("StockLevelTXNOrderLines", Phase::Build);
             auto colOrderLine =
                 conn->database("bench").collection("order");
             auto orderLinesQuery = mongocxx::options::find();
             orderLinesQuery.projection(MDV("o_lines.ol_i_id", 1, "_id", 0));
             orderLinesQuery.batch_size(1000);
-            auto orderLinesResult = colOrderLine.find(
-                *session,
+            auto orderLinesFilter =
                 MDV("o_w_id", sparams.wId, "o_d_id", sparams.dId, "o_o_id",
-                    MDV("$lt", nextOid, "$gte", nextOid - 20)),
-                orderLinesQuery);
+                    MDV("$lt", nextOid, "$gte", nextOid - 20));
+            markPhase("StockLevelTXNOrderLines", Phase::Execute);
+            auto orderLinesResult = colOrderLine.find(
+                *session, orderLinesFilter.view(), orderLinesQuery);
 
             unordered_set<int32_t> ols;
             for (auto &&ol : orderLinesResult) {
@@ -849,6 +1081,7 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
                 }
             }
             assert(ols.size() > 0);
+            markPhase("StockLevelTXNStockQuery", Phase::Build);
             bsoncxx::builder::basic::array builder{};
             for (auto it = ols.begin(); it != ols.end();) {
                 builder.append(std::move(ols.extract(it++).value()));
@@ -858,10 +1091,12 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
             cout << "sq" << endl;
 #endif
             auto colStock = conn->database("bench").collection("stock");
-            auto count = colStock.count_documents(
-                *session, MDV("s_w_id", sparams.wId, "s_i_id",
-                              MDV("$in", builder.extract()), "s_quantity",
-                              MDV("$lt", sparams.threshold)));
+            auto stockFilter =
+                MDV("s_w_id", sparams.wId, "s_i_id",
+                    MDV("$in", builder.extract()), "s_quantity",
+                    MDV("$lt", sparams.threshold));
+            markPhase("StockLevelTXNStockQuery", Phase::Execute);
+            auto count = colStock.count_documents(*session, stockFilter.view());
 
             // auto colDistrict = conn->database("bench").collection("district");
             // auto pipeline = mongocxx::pipeline{};
@@ -897,7 +1132,9 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
             // }
             // if(counts.size() == 1)
             //     auto volatile count = counts[0];
+            markPhase("commit", Phase::Execute);
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries-1;
@@ -916,17 +1153,24 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
     mongocxx::client_session::with_transaction_cb callback =
         [&](mongocxx::client_session *session) {
             tries++;
+            if (tries > 1)
+                recordConflict(ConflictKind::Retry);
 #ifdef PRINT_TRACE
             cout << "du" << endl;
 #endif
+            markPhase("NewOrderTXNUpdateDistrict", Phase::Build);
             auto colDistrict = conn->database("bench").collection("district");
             auto optionsDist = mongocxx::options::find_one_and_update();
             optionsDist.projection(MDV("d_id", 1, "d_w_id", 1, "d_tax", 1,
                                        "d_next_o_id", 1, "_id", 0));
+            auto districtFilter = MDV("d_id", noparams.dId, "d_w_id", noparams.wId);
+            auto districtUpdate = MDV("$inc", MDV("d_next_o_id", 1));
+            markPhase("NewOrderTXNUpdateDistrict", Phase::Execute);
             auto district = colDistrict.find_one_and_update(
-                *session, MDV("d_id", noparams.dId, "d_w_id", noparams.wId),
-                MDV("$inc", MDV("d_next_o_id", 1)), optionsDist);
+                *session, districtFilter.view(), districtUpdate.view(),
+                optionsDist);
             assert(district.has_value() == true);
+            markPhase("NewOrderTXNUpdateDistrict", Phase::Decode);
 
             double dTax = (*district)["d_tax"].get_double();
             int dNextOId = (*district)["d_next_o_id"].get_int32();
@@ -935,6 +1179,7 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
             cout << "iq" << endl;
 #endif
+            markPhase("NewOrderTXNItemQuery", Phase::Build);
             auto colItem = conn->database("bench").collection("item");
             auto optionsItem = mongocxx::options::find();
             optionsItem.projection(MDV("i_id", 1, "i_price", 1, "i_name", 1,
@@ -943,14 +1188,23 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
             for (auto iId : noparams.iIds) {
                 iids.append(iId);
             }
-            auto itemsResults = colItem.find(
-                *session, MDV("i_id", MDV("$in", iids.view())), optionsItem);
-            std::vector<bsoncxx::document::value> items;
+            auto itemFilter = MDV("i_id", MDV("$in", iids.view()));
+            markPhase("NewOrderTXNItemQuery", Phase::Execute);
+            auto itemsResults =
+                colItem.find(*session, itemFilter.view(), optionsItem);
+            std::vector<NewOrderItem> items;
+            items.reserve(noparams.iIds.size());
             for (auto &&item : itemsResults) {
-                items.push_back(MDV2(item));
+                itemDecoder.Decode(item);
+                items.push_back(
+                    {itemDecoder.Int32(0), itemDecoder.Double(1),
+                     string(itemDecoder.String(2)),
+                     itemDecoder.String(3).find(ORIGINAL_STRING) !=
+                         string_view::npos});
             }
             if (items.size() != noparams.iIds.size()) {
                 numFails++;
+                markPhase("abort", Phase::Execute);
                 session->abort_transaction();
                 return false;
             }
@@ -975,37 +1229,43 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                 return noparams.iQtys[index];
             };
 
-            auto getItem = [&](int iid) {
+            auto getItem = [&](int iid) -> const NewOrderItem & {
                 return *find_if(items.begin(), items.end(),
-                                [=](bsoncxx::document::value &row) {
-                                    return row["i_id"].get_int32() == iid;
+                                [=](const NewOrderItem &row) {
+                                    return row.iId == iid;
                                 });
             };
 
 #ifdef PRINT_TRACE
             cout << "whq" << endl;
 #endif
+            markPhase("NewOrderTXNQueryWarehouse", Phase::Build);
             auto colWarehouse = conn->database("bench").collection("warehouse");
             auto warehouseQuery = mongocxx::options::find();
             warehouseQuery.projection(MDV("w_tax", 1, "_id", 0));
+            auto warehouseFilter = MDV("w_id", noparams.wId);
+            markPhase("NewOrderTXNQueryWarehouse", Phase::Execute);
             auto warehouse =
-                colWarehouse.find_one(*session, MDV("w_id", noparams.wId));
+                colWarehouse.find_one(*session, warehouseFilter.view());
             assert(warehouse.has_value() == true);
+            markPhase("NewOrderTXNQueryWarehouse", Phase::Decode);
             double wTax = (*warehouse)["w_tax"].get_double();
 
 #ifdef PRINT_TRACE
             cout << "cq" << endl;
 #endif
+            markPhase("NewOrderTXNQueryCustomer", Phase::Build);
             auto colCustomer = conn->database("bench").collection("customer");
             auto customerQuery = mongocxx::options::find();
             customerQuery.projection(
                 MDV("c_discount", 1, "c_last", 1, "c_credit", 1, "_id", 0));
-            auto customer =
-                colCustomer.find_one(*session,
-                                     MDV("c_w_id", noparams.wId, "c_d_id",
-                                         noparams.dId, "c_id", noparams.cId),
-                                     customerQuery);
+            auto customerFilter = MDV("c_w_id", noparams.wId, "c_d_id",
+                                      noparams.dId, "c_id", noparams.cId);
+            markPhase("NewOrderTXNQueryCustomer", Phase::Execute);
+            auto customer = colCustomer.find_one(*session, customerFilter.view(),
+                                                 customerQuery);
             assert(customer.has_value() == true);
+            markPhase("NewOrderTXNQueryCustomer", Phase::Decode);
             double cDiscount = (*customer)["c_discount"].get_double();
 
             int olCnt = noparams.iIds.size();
@@ -1017,26 +1277,38 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                        [=](int i) { return i == noparams.iIWds[0]; });
 
             auto colStock = conn->database("bench").collection("stock");
-            std::vector<bsoncxx::document::value> stock;
+            auto decodeStock = [&](bsoncxx::document::view stck) {
+                stockDecoder.Decode(stck);
+                return NewOrderStock{
+                    stockDecoder.Int32(0), stockDecoder.Int32(1),
+                    stockDecoder.Int32(2), stockDecoder.Int32(3),
+                    string(stockDecoder.String(4 + noparams.dId)),
+                    stockDecoder.String(4).find(ORIGINAL_STRING) !=
+                        string_view::npos};
+            };
+            std::vector<NewOrderStock> stock;
+            stock.reserve(olCnt);
             if (allLocal) {
 #ifdef PRINT_TRACE
                 cout << "sal" << endl;
 #endif
+                markPhase("NewOrderTXNStockLocal", Phase::Build);
                 auto stockQuery = mongocxx::options::find();
                 stockQuery.projection(MDV(
                     "s_i_id", 1, "s_w_id", 1, "s_quantity", 1, "s_data", 1,
                     "s_ytd", 1, "s_order_cnt", 1, "s_remote_cnt", 1,
                     fmt::format("s_dist_{:02d}", noparams.dId), 1, "_id", 0));
+                auto stockFilter = MDV("s_w_id", noparams.wId, "s_i_id",
+                                       MDV("$in", iids.view()));
+                markPhase("NewOrderTXNStockLocal", Phase::Execute);
                 auto stockResult =
-                    colStock.find(*session,
-                                  MDV("s_w_id", noparams.wId, "s_i_id",
-                                      MDV("$in", iids.view())),
-                                  stockQuery);
+                    colStock.find(*session, stockFilter.view(), stockQuery);
                 for (auto &&stck : stockResult) {
-                    stock.push_back(MDV2(stck));
+                    stock.push_back(decodeStock(stck));
                 }
                 assert(stock.size() == olCnt);
             } else {
+                markPhase("NewOrderTXNStockRemote", Phase::Build);
                 bsoncxx::builder::basic::array filters{};
                 for (int i = 0; i < noparams.iIds.size(); ++i) {
                     filters.append(MDV("s_w_id", getwId(noparams.iIds[i]),
@@ -1051,22 +1323,26 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                     "s_i_id", 1, "s_w_id", 1, "s_quantity", 1, "s_data", 1,
                     "s_ytd", 1, "s_order_cnt", 1, "s_remote_cnt", 1,
                     fmt::format("s_dist_{:02d}", noparams.dId), 1, "_id", 0));
-                auto stockResult = colStock.find(
-                    *session, MDV("$or", filters.view()), stockQuery);
+                auto stockFilter = MDV("$or", filters.view());
+                markPhase("NewOrderTXNStockRemote", Phase::Execute);
+                auto stockResult =
+                    colStock.find(*session, stockFilter.view(), stockQuery);
                 for (auto &&stck : stockResult) {
-                    stock.push_back(MDV2(stck));
+                    stock.push_back(decodeStock(stck));
                 }
                 assert(stock.size() == olCnt);
             }
 
-            auto getStock = [&](int iid) {
+            auto getStock = [&](int iid) -> const NewOrderStock & {
                 return *find_if(stock.begin(), stock.end(),
-                                [=](bsoncxx::document::value &row) {
-                                    return row["s_i_id"].get_int32() == iid;
+                                [=](const NewOrderStock &row) {
+                                    return row.sIId == iid;
                                 });
             };
 
-
+            // The stock updates are sent as one bulk write and the order lines
+            // are embedded in the order, both are built line by line first
+            markPhase("NewOrderTXNStockUpdate", Phase::Build);
             vector<tuple<string, int, string, double, double>> itemData;
             itemData.reserve(olCnt);
             double total = 0;
@@ -1079,11 +1355,11 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                 int olSupplyWId = noparams.iIWds[i];
                 int olQuantity = noparams.iQtys[i];
 
-                auto item = getItem(olIId);
-                auto stockitem = getStock(olIId);
+                auto &item = getItem(olIId);
+                auto &stockitem = getStock(olIId);
 
-                int sQuantity = stockitem["s_ytd"].get_int32();
-                int sYtd = stockitem["s_ytd"].get_int32() + olQuantity;
+                int sQuantity = stockitem.sYtd;
+                int sYtd = stockitem.sYtd + olQuantity;
 
                 if (sQuantity >= olQuantity + 10) {
                     sQuantity = sQuantity - olQuantity;
@@ -1091,8 +1367,8 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                     sQuantity = sQuantity + 91 - olQuantity;
                 }
 
-                int sOrderCnt = stockitem["s_order_cnt"].get_int32() + 1;
-                int sRemoteCnt = stockitem["s_remote_cnt"].get_int32();
+                int sOrderCnt = stockitem.sOrderCnt + 1;
+                int sRemoteCnt = stockitem.sRemoteCnt;
 
                 if (olSupplyWId != noparams.wId) {
                     sRemoteCnt++;
@@ -1108,7 +1384,7 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                                     sRemoteCnt, )));
                 stockBulk.append(updater);
 
-                double olAmount = olQuantity * item["i_price"].get_double();
+                double olAmount = olQuantity * item.iPrice;
                 total += olAmount;
 
 #ifdef PRINT_TRACE
@@ -1118,166 +1394,824 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                         noparams.dId, "ol_number", olNumber, "ol_i_id", olIId,
                         "ol_supply_w_id", olSupplyWId, "ol_quantity",
                         olQuantity, "ol_amount", olAmount, "ol_dist_info",
-                        stockitem[fmt::format("s_dist_{:02d}", noparams.dId)]
-                            .get_string(),
-                        );
+                        stockitem.sDist, );
                 newOrderBulk.append(bsoncxx::types::b_document{ol});
 
-                string iData(item["i_data"].get_string());
-                string sData(stockitem["s_data"].get_string());
                 string brandGeneric = "G";
-                if (iData.find(ORIGINAL_STRING) != -1 &&
-                    sData.find(ORIGINAL_STRING) != -1) {
+                if (item.original && stockitem.original) {
                     brandGeneric = "B";
                 }
-                itemData.push_back(make_tuple(
-                    string(item["i_name"].get_string()), sQuantity,
-                    brandGeneric, item["i_price"].get_double(), olAmount));
+                itemData.push_back(make_tuple(item.iName, sQuantity,
+                                              brandGeneric, item.iPrice,
+                                              olAmount));
             }
 #ifdef PRINT_TRACE
             cout << "io" << endl;
 #endif
+            markPhase("NewOrderTXNInsertOrder", Phase::Build);
             auto colOrder = conn->database("bench").collection("order");
-            auto iOResult = colOrder.insert_one(
-                *session,
+            auto orderDoc =
                 MDV("o_id", dNextOId, "o_w_id", noparams.wId, "o_d_id",
                     noparams.dId, "o_c_id", noparams.cId, "o_carrier_id",
                     oCarrierId, "o_ol_cnt", olCnt, "o_all_local", allLocal,
                     "o_new", true, "o_entry_d",
                     bsoncxx::types::b_date{noparams.oEntryDate}, "o_lines",
-                    newOrderBulk.extract(), ));
+                    newOrderBulk.extract(), );
+            markPhase("NewOrderTXNInsertOrder", Phase::Execute);
+            auto iOResult = colOrder.insert_one(*session, orderDoc.view());
             assert(iOResult.has_value() == true);
             assert(iOResult.value().result().inserted_count() == 1);
+            markPhase("NewOrderTXNStockUpdate", Phase::Execute);
             auto stockResult = stockBulk.execute();
             assert(stockResult.has_value() == true);
             assert(stockResult.value().matched_count() == olCnt);
             total *= (1 - cDiscount) * (1 + wTax + dTax);
+            markPhase("commit", Phase::Execute);
             return true;
         };
+    markPhase("begin", Phase::Execute);
     auto session = conn->start_session();
     session.with_transaction(callback);
     retries += tries -1;
     return true;
 }
 
-static ScaleParameters params = ScaleParameters::makeDefault(4);
-static void BM_MONGO_TPCC_MODERN(benchmark::State &state) {
-	auto conn = MongoDBHandler::GetConnection();
-    if (state.thread_index() == 0) {
-        int warehouses = state.range(0);
-        params = ScaleParameters::makeDefault(warehouses);
+// Single document mode: every TPC-C transaction is a sequence of single document
+// atomic operations without a session. Writes that are not naturally idempotent
+// carry a token (a deterministic _id, or a guard on a bounded $push'ed token list),
+// so replaying them after an ambiguous failure is a no-op.
+static const int SINGLE_DOC_MAX_ATTEMPTS = 5;
+
+namespace {
+// Anomalies the single document mode can observe from the client
+struct SingleDocAnomalies {
+    int orderIdGaps = 0;     // d_next_o_id allocated but the order was never written
+    int lostDeliveries = 0;  // order claimed but the customer was never credited
+    int partialPayments = 0; // payment stopped after its first write
+};
+
+// TPC-C consistency conditions 1-3 (clause 3.3.2), as violating warehouses/districts
+struct ConsistencyReport {
+    int warehouseYtd = 0;
+    int districtNextOId = 0;
+    int newOrderGaps = 0;
+};
+} // namespace
+
+static bool isRetryable(const mongocxx::operation_exception &e) {
+    return e.has_error_label("RetryableWriteError") ||
+           e.has_error_label("TransientTransactionError");
+}
+
+static bool isDuplicateKey(const mongocxx::operation_exception &e) {
+    return e.code().value() == 11000;
+}
+
+// Runs op(attempt) until it succeeds or the error is not retryable, op must be idempotent
+template <typename Op>
+static auto retrySingleDoc(Op &&op, int &retries) {
+    for (int attempt = 1;; ++attempt) {
         try {
-            LoadBenchmark(conn, params, warehouses, state.threads());
-        } catch (...) {
-            cerr << "Error loading benchmark" << endl;
-            throw;
+            return op(attempt);
+        } catch (mongocxx::operation_exception &e) {
+            if (attempt >= SINGLE_DOC_MAX_ATTEMPTS || !isRetryable(e))
+                throw;
+            retries++;
+            recordConflict(ConflictKind::Retry);
         }
     }
-    int numDeliveries = 0;
-    int numOrderStatuses = 0;
-    int numNewOrders = 0;
-    int numFailedNewOrders = 0;
-    int numPayments = 0;
-    int numStockLevels = 0;
-    int numDeadlocks = 0;
-    int numOtherErrors = 0;
-    int retries = 0;
-    for (auto _ : state) {
-        // auto start = std::chrono::high_resolution_clock::now();
-        tpcc::TransactionType type = randomHelper.nextTransactionType();
-        // Start transaction
+}
 
+static int64_t orderToken(int wId, int dId, int oId) {
+    return (int64_t(wId) << 40) | (int64_t(dId) << 32) | uint32_t(oId);
+}
+
+// Random 63 bit token, unique across terminals and runs for all practical purposes
+static int64_t nextToken() {
+    static thread_local std::mt19937_64 gen(std::random_device{}());
+    return int64_t(gen() >> 1);
+}
+
+// How many tokens a row keeps. Warehouse and district rows are shared by every
+// terminal, so the list holds a write of each terminal for each attempt, and
+// a replay still finds its token after the others wrote the row in between.
+static int singleDocTokens(const benchmark::State &state) {
+    return state.threads() * SINGLE_DOC_MAX_ATTEMPTS;
+}
+
+// $push that records token while keeping only the last keep
+static bsoncxx::document::value pushToken(const string &field, int64_t token,
+                                          int keep) {
+    return make_document(
+        kvp(field, make_document(kvp("$each", make_array(token)),
+                                 kvp("$slice", -keep))));
+}
+
+// The same as pushToken, as an aggregation expression for pipeline updates
+static bsoncxx::document::value pushTokenExpr(const string &field, int64_t token,
+                                              int keep) {
+    return make_document(kvp(
+        "$slice",
+        make_array(make_document(kvp(
+                       "$concatArrays",
+                       make_array(make_document(kvp(
+                                      "$ifNull", make_array("$" + field,
+                                                            make_array()))),
+                                  make_array(token)))),
+                   -keep)));
+}
+
+static bool doDeliverySingleDoc(benchmark::State &state, ScaleParameters &params,
+                                mongocxx::pool::entry &conn, int &retries,
+                                SingleDocAnomalies &anomalies,
+                                int n = DISTRICTS_PER_WAREHOUSE) {
+#ifdef PRINT_TRACE
+    cout << "DoDeliverySingleDoc" << endl;
+#endif
+    DeliveryParams dparams;
+    randomHelper.generateDeliveryParams(params, dparams);
+    auto colOrder = conn->database("bench").collection("order");
+    auto colCustomer = conn->database("bench").collection("customer");
+    auto options = mongocxx::options::find_one_and_update();
+    options.projection(MDV("o_lines.ol_amount", 1, "o_c_id", 1, "o_id", 1, "_id", 0));
+    options.sort(MDV("o_id", 1));
+    for (int dId = 1; dId <= n; ++dId) {
+        dparams.dId = dId;
+        markConflictKey(dparams.wId, dId);
+        int64_t claim = nextToken();
+        // Claiming the oldest new order is the only synchronisation point. A retry
+        // also matches the order a lost attempt may have claimed already.
+        auto claimed = retrySingleDoc(
+            [&](int attempt) {
+                markPhase("DeliveryTXNNewOrder", Phase::Build);
+                auto update = MDV("$unset", MDV("o_new", 1), "$set",
+                                  MDV("o_carrier_id", dparams.oCarrierId,
+                                      "o_delivery_d",
+                                      bsoncxx::types::b_date{dparams.olDeliveryD},
+                                      "o_claim", claim));
+                auto filter =
+                    attempt == 1
+                        ? MDV("o_d_id", dparams.dId, "o_w_id", dparams.wId,
+                              "o_new", true)
+                        : make_document(
+                              kvp("o_d_id", dparams.dId),
+                              kvp("o_w_id", dparams.wId),
+                              kvp("$or", make_array(MDV("o_new", true),
+                                                    MDV("o_claim", claim))));
+                markPhase("DeliveryTXNNewOrder", Phase::Execute);
+                return colOrder.find_one_and_update(filter.view(),
+                                                    update.view(), options);
+            },
+            retries);
+        if (!claimed.has_value()) {
+            if (state.counters.count("no_new_orders") == 0)
+                state.counters["no_new_orders"] = benchmark::Counter(1);
+            else {
+                state.counters["no_new_orders"].value++;
+            }
+            continue;
+        }
+        markPhase("DeliveryTXNNewOrder", Phase::Decode);
+        auto order = claimed->view();
+        int oId = order["o_id"].get_int32();
+        int cId = order["o_c_id"].get_int32();
+        double total = 0;
+        for (auto ol : order["o_lines"].get_array().value) {
+            total += ol["ol_amount"].get_double();
+        }
+
+#ifdef PRINT_TRACE
+        cout << "cuq" << endl;
+#endif
+        int64_t token = orderToken(dparams.wId, dparams.dId, oId);
         try {
-        bool result = false;
-        switch (type) {
-        case tpcc::TransactionType::Delivery:
-            result = doDeliveryN(state, params, conn, retries);
-            numDeliveries++;
-            break;
-        case tpcc::TransactionType::OrderStatus:
-            result = doOrderStatus(state, params, conn, retries);
-            numOrderStatuses++;
-            break;
-        case tpcc::TransactionType::Payment:
-            result = doPayment(state, params, conn, retries);
-            numPayments++;
-            break;
-        case tpcc::TransactionType::StockLevel:
-            result = doStockLevel(state, params, conn, retries);
-            numStockLevels++;
-            break;
-        case tpcc::TransactionType::NewOrder:
-            result = doNewOrder(state, params, conn, numFailedNewOrders, retries);
-            numNewOrders++;
-            break;
+            retrySingleDoc(
+                [&](int) {
+                    markPhase("DeliveryTXNUpdateCust", Phase::Build);
+                    auto filter = MDV("c_d_id", dparams.dId, "c_w_id", dparams.wId,
+                                      "c_id", cId, "c_tokens", MDV("$ne", token));
+                    auto update =
+                        MDV("$inc", MDV("c_balance", total, "c_delivery_cnt", 1),
+                            "$push",
+                            pushToken("c_tokens", token, singleDocTokens(state)));
+                    markPhase("DeliveryTXNUpdateCust", Phase::Execute);
+                    return colCustomer.update_one(filter.view(), update.view());
+                },
+                retries);
+        } catch (mongocxx::exception &e) {
+            anomalies.lostDeliveries++;
+            throw;
         }
-        } catch(mongocxx::operation_exception& e) {
-            if(e.has_error_label("TransientTransactionError")) {
-                cout << this_thread::get_id() << " Operation exception! Transient \r\n" << e.what() << endl;
-            } else if(e.has_error_label("UnknownTransactionCommitResult")) {
-                cout << this_thread::get_id() << " Operation exception! Unknown \r\n" << e.what() << endl;
+    }
+    return true;
+}
+
+static bool doOrderStatusSingleDoc(benchmark::State &state,
+                                   ScaleParameters &params,
+                                   mongocxx::pool::entry &conn) {
+#ifdef PRINT_TRACE
+    cout << "OrderStatusSingleDoc" << endl;
+#endif
+    OrderStatusParams osparams;
+    randomHelper.generateOrderStatusParams(params, osparams);
+    const char *customerStatement = osparams.cId != INT32_MIN
+                                        ? "OrderStatusTXNCustById"
+                                        : "OrderStatusTXNCustByLastName";
+    markPhase(customerStatement, Phase::Build);
+    auto colCustomer = conn->database("bench").collection("customer");
+    auto findOptions = mongocxx::options::find();
+    findOptions.projection(MDV("c_id", 1, "c_first", 1, "c_middle", 1, "c_last",
+                               1, "c_balance", 1, "_id", 0));
+    int cId;
+    if (osparams.cId != INT32_MIN) {
+        findOptions.comment("OrderStatusTXNCustById");
+        auto customerFilter = MDV("c_id", osparams.cId, "c_w_id", osparams.wId,
+                                  "c_d_id", osparams.dId);
+        markPhase(customerStatement, Phase::Execute);
+        auto customer = colCustomer.find_one(customerFilter.view(), findOptions);
+        assert(customer.has_value() == true);
+        markPhase(customerStatement, Phase::Decode);
+        customerIdDecoder.Decode(customer->view());
+        cId = customerIdDecoder.Int32(0);
+    } else {
+        findOptions.comment("OrderStatusTXNCustByLastName");
+        findOptions.sort(MDV("c_first", 1));
+        std::vector<int32_t> results;
+        auto customerFilter = MDV("c_last", osparams.cLast, "c_w_id",
+                                  osparams.wId, "c_d_id", osparams.dId);
+        markPhase(customerStatement, Phase::Execute);
+        for (auto &&cust : colCustomer.find(customerFilter.view(), findOptions)) {
+            customerIdDecoder.Decode(cust);
+            results.push_back(customerIdDecoder.Int32(0));
+        }
+        assert(results.size() > 0);
+        cId = results[(results.size() - 1) / 2];
+    }
+
+    // The order embeds its lines, so one document read is a consistent snapshot
+    markPhase("OrderStatusTXNOrders", Phase::Build);
+    auto colOrder = conn->database("bench").collection("order");
+    auto orderOptions = mongocxx::options::find();
+    orderOptions.comment("OrderStatusTXNOrders");
+    orderOptions.projection(MDV(
+        "o_id", 1, "o_delivery_d", 1, "o_carrier_id", 1, "o_entry_d", 1,
+        "o_lines.ol_supply_w_id", 1, "o_lines.ol_i_id", 1,
+        "o_lines.ol_quantity", 1, "o_lines.ol_amount", 1, "_id", 0));
+    orderOptions.sort(MDV("o_id", -1));
+    auto orderFilter =
+        MDV("o_c_id", cId, "o_w_id", osparams.wId, "o_d_id", osparams.dId);
+    markPhase("OrderStatusTXNOrders", Phase::Execute);
+    auto order = colOrder.find_one(orderFilter.view(), orderOptions);
+    assert(order.has_value() == true);
+    markPhase("OrderStatusTXNOrders", Phase::Decode);
+    orderStatusDecoder.Decode(order->view());
+    auto lines = orderStatusDecoder.Array(1);
+    assert(lines.begin() != lines.end());
+    return true;
+}
+
+static bool doPaymentSingleDoc(benchmark::State &state, ScaleParameters &params,
+                               mongocxx::pool::entry &conn, int &retries,
+                               SingleDocAnomalies &anomalies) {
+#ifdef PRINT_TRACE
+    cout << "PaymentSingleDoc" << endl;
+#endif
+    PaymentParams pparams;
+    randomHelper.generatePaymentParams(params, pparams);
+    int64_t token = nextToken();
+    auto db = conn->database("bench");
+
+    // $inc guarded by the token, a replay that already applied returns nothing
+    // and the (immutable) name fields are read back instead.
+    auto colDistrict = db.collection("district");
+    auto distOptions = mongocxx::options::find_one_and_update();
+    distOptions.projection(MDV("d_name", 1, "_id", 0));
+    auto district = retrySingleDoc(
+        [&](int) {
+            markPhase("PaymentTXNUpdateDistrict", Phase::Build);
+            auto filter = MDV("d_id", pparams.dId, "d_w_id", pparams.wId,
+                              "d_tokens", MDV("$ne", token));
+            auto update = MDV("$inc", MDV("d_ytd", pparams.hAmount), "$push",
+                              pushToken("d_tokens", token, singleDocTokens(state)));
+            markPhase("PaymentTXNUpdateDistrict", Phase::Execute);
+            return colDistrict.find_one_and_update(filter.view(), update.view(),
+                                                   distOptions);
+        },
+        retries);
+    if (!district.has_value()) {
+        markPhase("PaymentTXNDistrictReplay", Phase::Execute);
+        district = colDistrict.find_one(MDV("d_id", pparams.dId, "d_w_id", pparams.wId));
+    }
+    assert(district.has_value() == true);
+
+    try {
+        auto colWarehouse = db.collection("warehouse");
+        auto whOptions = mongocxx::options::find_one_and_update();
+        whOptions.projection(MDV("w_name", 1, "_id", 0));
+        auto warehouse = retrySingleDoc(
+            [&](int) {
+                markPhase("PaymentTXNUpdateWarehouse", Phase::Build);
+                auto filter =
+                    MDV("w_id", pparams.wId, "w_tokens", MDV("$ne", token));
+                auto update = MDV("$inc", MDV("w_ytd", pparams.hAmount),
+                                  "$push",
+                                  pushToken("w_tokens", token, singleDocTokens(state)));
+                markPhase("PaymentTXNUpdateWarehouse", Phase::Execute);
+                return colWarehouse.find_one_and_update(
+                    filter.view(), update.view(), whOptions);
+            },
+            retries);
+        if (!warehouse.has_value()) {
+            markPhase("PaymentTXNWarehouseReplay", Phase::Execute);
+            warehouse = colWarehouse.find_one(MDV("w_id", pparams.wId));
+        }
+        assert(warehouse.has_value() == true);
+
+        auto colCustomer = db.collection("customer");
+        int cId = pparams.cId;
+        if (cId == INT32_MIN) {
+            markPhase("PaymentTXNCustByLastName", Phase::Build);
+            auto customerOptions = mongocxx::options::find();
+            customerOptions.sort(MDV("c_first", 1));
+            customerOptions.projection(MDV("c_id", 1, "_id", 0));
+            std::vector<int32_t> results;
+            auto customerFilter = MDV("c_last", pparams.cLast, "c_w_id",
+                                      pparams.cWId, "c_d_id", pparams.cDId);
+            markPhase("PaymentTXNCustByLastName", Phase::Execute);
+            for (auto &&cust :
+                 colCustomer.find(customerFilter.view(), customerOptions)) {
+                customerIdDecoder.Decode(cust);
+                results.push_back(customerIdDecoder.Int32(0));
             }
-        } catch(mongocxx::exception& e) {
-            cout << this_thread::get_id() << " mongocxxException!\r\n" << e.what() << endl;
-        } catch(std::exception& e) {
-            cout << this_thread::get_id() << " std exception!\r\n" << e.what() << endl;
-        } catch(...) {
-            cout << this_thread::get_id() << " Unknown exception!\r\n" << endl;
-            throw;
+            assert(results.size() > 0);
+            cId = results[(results.size() - 1) / 2];
+        }
+
+        // Bad credit c_data rewrite is a read-modify-write, so it is done by the
+        // server in a pipeline update instead of on the client.
+        markPhase("PaymentTXNCustUpdate", Phase::Build);
+        string newData =
+            fmt::format("{:d} {:d} {:d} {:d} {:d} {:f}", cId, pparams.cDId,
+                        pparams.cWId, pparams.dId, pparams.wId, pparams.hAmount);
+        mongocxx::pipeline customerUpdate;
+        customerUpdate.add_fields(make_document(
+            kvp("c_balance", MDV("$subtract", make_array("$c_balance", pparams.hAmount))),
+            kvp("c_ytd_payment", MDV("$add", make_array("$c_ytd_payment", pparams.hAmount))),
+            kvp("c_payment_cnt", MDV("$add", make_array("$c_payment_cnt", 1))),
+            kvp("c_data",
+                MDV("$cond",
+                    make_array(
+                        MDV("$eq", make_array("$c_credit", BAD_CREDIT)),
+                        MDV("$substrCP",
+                            make_array(MDV("$concat", make_array(newData, "|", "$c_data")),
+                                       0, MAX_C_DATA)),
+                        "$c_data"))),
+            kvp("c_tokens",
+                pushTokenExpr("c_tokens", token, singleDocTokens(state)))));
+        retrySingleDoc(
+            [&](int) {
+                auto filter = MDV("c_id", cId, "c_w_id", pparams.cWId, "c_d_id",
+                                  pparams.cDId, "c_tokens", MDV("$ne", token));
+                markPhase("PaymentTXNCustUpdate", Phase::Execute);
+                return colCustomer.update_one(filter.view(), customerUpdate);
+            },
+            retries);
+
+        markPhase("PaymentTXNHistory", Phase::Build);
+        string h_data =
+            fmt::format("{:s}    {:s}", (*warehouse)["w_name"].get_string(),
+                        (*district)["d_name"].get_string());
+        auto colHistory = db.collection("history");
+        auto history =
+            MDV("_id", token, "h_c_id", cId, "h_c_w_id", pparams.cWId, "h_w_id",
+                pparams.wId, "h_c_d_id", pparams.cDId, "h_d_id", pparams.dId,
+                "h_amount", pparams.hAmount, "h_data", h_data, "h_date",
+                bsoncxx::types::b_date{pparams.hDate}, );
+        retrySingleDoc(
+            [&](int) {
+                try {
+                    markPhase("PaymentTXNHistory", Phase::Execute);
+                    colHistory.insert_one(history.view());
+                } catch (mongocxx::operation_exception &e) {
+                    if (!isDuplicateKey(e))
+                        throw;
+                }
+                return true;
+            },
+            retries);
+    } catch (mongocxx::exception &e) {
+        anomalies.partialPayments++;
+        throw;
+    }
+    return true;
+}
+
+static bool doStockLevelSingleDoc(benchmark::State &state,
+                                  ScaleParameters &params,
+                                  mongocxx::pool::entry &conn) {
+#ifdef PRINT_TRACE
+    cout << "stockLevelSingleDoc" << endl;
+#endif
+    StockLevelParams sparams;
+    randomHelper.generateStockLevelParams(params, sparams);
+    markPhase("StockLevelTXNDistQuery", Phase::Build);
+    auto db = conn->database("bench");
+    auto queryOptions = mongocxx::options::find();
+    queryOptions.projection(MDV("d_next_o_id", 1, "_id", 0));
+    auto districtFilter = MDV("d_id", sparams.dId, "d_w_id", sparams.wId);
+    markPhase("StockLevelTXNDistQuery", Phase::Execute);
+    auto district =
+        db.collection("district").find_one(districtFilter.view(), queryOptions);
+    assert(district.has_value() == true);
+    markPhase("StockLevelTXNDistQuery", Phase::Decode);
+    int nextOid = (*district)["d_next_o_id"].get_int32();
+
+    markPhase("StockLevelTXNOrderLines", Phase::Build);
+    auto orderLinesQuery = mongocxx::options::find();
+    orderLinesQuery.projection(MDV("o_lines.ol_i_id", 1, "_id", 0));
+    orderLinesQuery.batch_size(1000);
+    unordered_set<int32_t> ols;
+    auto orderLinesFilter = MDV("o_w_id", sparams.wId, "o_d_id", sparams.dId,
+                                "o_id", MDV("$lt", nextOid, "$gte", nextOid - 20));
+    markPhase("StockLevelTXNOrderLines", Phase::Execute);
+    for (auto &&ol :
+         db.collection("order").find(orderLinesFilter.view(), orderLinesQuery)) {
+        for (auto &&oline : ol["o_lines"].get_array().value) {
+            ols.insert(oline["ol_i_id"].get_int32());
+        }
+    }
+    markPhase("StockLevelTXNStockQuery", Phase::Build);
+    bsoncxx::builder::basic::array builder{};
+    for (auto it = ols.begin(); it != ols.end();) {
+        builder.append(std::move(ols.extract(it++).value()));
+    }
+    auto stockFilter =
+        MDV("s_w_id", sparams.wId, "s_i_id", MDV("$in", builder.extract()),
+            "s_quantity", MDV("$lt", sparams.threshold));
+    markPhase("StockLevelTXNStockQuery", Phase::Execute);
+    auto count = db.collection("stock").count_documents(stockFilter.view());
+    return true;
+}
+
+static bool doNewOrderSingleDoc(benchmark::State &state, ScaleParameters &params,
+                                mongocxx::pool::entry &conn, int &numFails,
+                                int &retries, SingleDocAnomalies &anomalies) {
+#ifdef PRINT_TRACE
+    cout << "newOrderSingleDoc" << endl;
+#endif
+    NewOrderParams noparams;
+    randomHelper.generateNewOrderParams(params, noparams);
+    auto db = conn->database("bench");
+
+    // Items first, an invalid item must fail the order before an o_id is allocated
+    markPhase("NewOrderTXNItemQuery", Phase::Build);
+    auto colItem = db.collection("item");
+    auto optionsItem = mongocxx::options::find();
+    optionsItem.projection(MDV("i_id", 1, "i_price", 1, "i_name", 1, "i_data", 1, "_id", 0));
+    bsoncxx::builder::basic::array iids{};
+    for (auto iId : noparams.iIds) {
+        iids.append(iId);
+    }
+    std::vector<NewOrderItem> items;
+    items.reserve(noparams.iIds.size());
+    auto itemFilter = MDV("i_id", MDV("$in", iids.view()));
+    markPhase("NewOrderTXNItemQuery", Phase::Execute);
+    for (auto &&item : colItem.find(itemFilter.view(), optionsItem)) {
+        itemDecoder.Decode(item);
+        items.push_back({itemDecoder.Int32(0), itemDecoder.Double(1),
+                         string(itemDecoder.String(2)),
+                         itemDecoder.String(3).find(ORIGINAL_STRING) !=
+                             string_view::npos});
+    }
+    if (items.size() != noparams.iIds.size()) {
+        numFails++;
+        return false;
+    }
+    auto getItem = [&](int iid) -> const NewOrderItem & {
+        return *find_if(items.begin(), items.end(),
+                        [=](const NewOrderItem &row) { return row.iId == iid; });
+    };
+
+    markPhase("NewOrderTXNQueryWarehouse", Phase::Build);
+    auto warehouseQuery = mongocxx::options::find();
+    warehouseQuery.projection(MDV("w_tax", 1, "_id", 0));
+    auto warehouseFilter = MDV("w_id", noparams.wId);
+    markPhase("NewOrderTXNQueryWarehouse", Phase::Execute);
+    auto warehouse = db.collection("warehouse").find_one(warehouseFilter.view(), warehouseQuery);
+    assert(warehouse.has_value() == true);
+    markPhase("NewOrderTXNQueryWarehouse", Phase::Decode);
+    double wTax = (*warehouse)["w_tax"].get_double();
+
+    markPhase("NewOrderTXNQueryCustomer", Phase::Build);
+    auto customerQuery = mongocxx::options::find();
+    customerQuery.projection(MDV("c_discount", 1, "c_last", 1, "c_credit", 1, "_id", 0));
+    auto customerFilter =
+        MDV("c_w_id", noparams.wId, "c_d_id", noparams.dId, "c_id", noparams.cId);
+    markPhase("NewOrderTXNQueryCustomer", Phase::Execute);
+    auto customer =
+        db.collection("customer").find_one(customerFilter.view(), customerQuery);
+    assert(customer.has_value() == true);
+    markPhase("NewOrderTXNQueryCustomer", Phase::Decode);
+    double cDiscount = (*customer)["c_discount"].get_double();
+
+    int olCnt = noparams.iIds.size();
+    bool allLocal = all_of(noparams.iIWds.begin(), noparams.iIWds.end(),
+                           [=](int i) { return i == noparams.iIWds[0]; });
+
+    // Stock is only read for s_data and s_dist_xx, which never change. The quantity
+    // update itself is computed by the server so it needs no read.
+    markPhase("NewOrderTXNStockRemote", Phase::Build);
+    auto colStock = db.collection("stock");
+    auto stockQuery = mongocxx::options::find();
+    stockQuery.projection(MDV("s_i_id", 1, "s_ytd", 1, "s_order_cnt", 1,
+                              "s_remote_cnt", 1, "s_data", 1,
+                              fmt::format("s_dist_{:02d}", noparams.dId), 1,
+                              "_id", 0));
+    bsoncxx::builder::basic::array filters{};
+    for (int i = 0; i < olCnt; ++i) {
+        filters.append(MDV("s_w_id", noparams.iIWds[i], "s_i_id", noparams.iIds[i]));
+    }
+    std::vector<NewOrderStock> stock;
+    stock.reserve(olCnt);
+    auto stockFilter = MDV("$or", filters.view());
+    markPhase("NewOrderTXNStockRemote", Phase::Execute);
+    for (auto &&stck : colStock.find(stockFilter.view(), stockQuery)) {
+        stockDecoder.Decode(stck);
+        stock.push_back({stockDecoder.Int32(0), stockDecoder.Int32(1),
+                         stockDecoder.Int32(2), stockDecoder.Int32(3),
+                         string(stockDecoder.String(4 + noparams.dId)),
+                         stockDecoder.String(4).find(ORIGINAL_STRING) !=
+                             string_view::npos});
+    }
+    assert(stock.size() == olCnt);
+    auto getStock = [&](int iid) -> const NewOrderStock & {
+        return *find_if(stock.begin(), stock.end(),
+                        [=](const NewOrderStock &row) { return row.sIId == iid; });
+    };
+
+#ifdef PRINT_TRACE
+    cout << "du" << endl;
+#endif
+    // Allocating the order id is the only write before the order exists
+    markPhase("NewOrderTXNUpdateDistrict", Phase::Build);
+    auto colDistrict = db.collection("district");
+    auto optionsDist = mongocxx::options::find_one_and_update();
+    optionsDist.projection(MDV("d_tax", 1, "d_next_o_id", 1, "_id", 0));
+    auto districtFilter = MDV("d_id", noparams.dId, "d_w_id", noparams.wId);
+    auto districtUpdate = MDV("$inc", MDV("d_next_o_id", 1));
+    markPhase("NewOrderTXNUpdateDistrict", Phase::Execute);
+    auto district = colDistrict.find_one_and_update(
+        districtFilter.view(), districtUpdate.view(), optionsDist);
+    assert(district.has_value() == true);
+    markPhase("NewOrderTXNUpdateDistrict", Phase::Decode);
+    double dTax = (*district)["d_tax"].get_double();
+    int dNextOId = (*district)["d_next_o_id"].get_int32();
+    int64_t token = orderToken(noparams.wId, noparams.dId, dNextOId);
+
+    try {
+        markPhase("NewOrderTXNInsertOrder", Phase::Build);
+        double total = 0;
+        auto orderLines = bsoncxx::builder::basic::array{};
+        for (int i = 0; i < olCnt; ++i) {
+            auto &item = getItem(noparams.iIds[i]);
+            auto &stockitem = getStock(noparams.iIds[i]);
+            double olAmount = noparams.iQtys[i] * item.iPrice;
+            total += olAmount;
+            orderLines.append(MDV(
+                "ol_o_id", dNextOId, "ol_w_id", noparams.wId, "ol_d_id",
+                noparams.dId, "ol_number", i + 1, "ol_i_id", noparams.iIds[i],
+                "ol_supply_w_id", noparams.iIWds[i], "ol_quantity",
+                noparams.iQtys[i], "ol_amount", olAmount, "ol_dist_info",
+                stockitem.sDist, ));
         }
-        // auto end = std::chrono::high_resolution_clock::now();
-        // auto elapsed_seconds =
-        //     std::chrono::duration_cast<std::chrono::duration<double>>(end -
-        //                                                               start);
-        // state.SetIterationTime(elapsed_seconds.count());
+
+#ifdef PRINT_TRACE
+        cout << "suq" << endl;
+#endif
+        retrySingleDoc(
+            [&](int) {
+                markPhase("NewOrderTXNStockUpdate", Phase::Build);
+                auto stockBulk = colStock.create_bulk_write(
+                    mongocxx::options::bulk_write{}.ordered(false));
+                for (int i = 0; i < olCnt; ++i) {
+                    int olQuantity = noparams.iQtys[i];
+                    int remote = noparams.iIWds[i] != noparams.wId ? 1 : 0;
+                    mongocxx::pipeline update;
+                    update.add_fields(make_document(
+                        kvp("s_quantity",
+                            MDV("$cond",
+                                make_array(
+                                    MDV("$gte", make_array("$s_quantity", olQuantity + 10)),
+                                    MDV("$subtract", make_array("$s_quantity", olQuantity)),
+                                    MDV("$add", make_array("$s_quantity", 91 - olQuantity))))),
+                        kvp("s_ytd", MDV("$add", make_array("$s_ytd", olQuantity))),
+                        kvp("s_order_cnt", MDV("$add", make_array("$s_order_cnt", 1))),
+                        kvp("s_remote_cnt", MDV("$add", make_array("$s_remote_cnt", remote))),
+                        kvp("s_tokens", pushTokenExpr("s_tokens", token,
+                                                      singleDocTokens(state)))));
+                    mongocxx::model::update_one updater(
+                        MDV("s_i_id", noparams.iIds[i], "s_w_id",
+                            noparams.iIWds[i], "s_tokens", MDV("$ne", token)),
+                        update);
+                    stockBulk.append(updater);
+                }
+                markPhase("NewOrderTXNStockUpdate", Phase::Execute);
+                return stockBulk.execute();
+            },
+            retries);
+
+#ifdef PRINT_TRACE
+        cout << "io" << endl;
+#endif
+        // The order's _id is its token, a replayed insert is a duplicate key
+        markPhase("NewOrderTXNInsertOrder", Phase::Build);
+        auto orderDoc = MDV(
+            "_id", token, "o_id", dNextOId, "o_w_id", noparams.wId, "o_d_id",
+            noparams.dId, "o_c_id", noparams.cId, "o_carrier_id",
+            NULL_CARRIER_ID, "o_ol_cnt", olCnt, "o_all_local", allLocal,
+            "o_new", true, "o_entry_d",
+            bsoncxx::types::b_date{noparams.oEntryDate}, "o_lines",
+            orderLines.extract(), );
+        auto colOrder = db.collection("order");
+        retrySingleDoc(
+            [&](int) {
+                try {
+                    markPhase("NewOrderTXNInsertOrder", Phase::Execute);
+                    colOrder.insert_one(orderDoc.view());
+                } catch (mongocxx::operation_exception &e) {
+                    if (!isDuplicateKey(e))
+                        throw;
+                }
+                return true;
+            },
+            retries);
+        total *= (1 - cDiscount) * (1 + wTax + dTax);
+    } catch (mongocxx::exception &e) {
+        anomalies.orderIdGaps++;
+        throw;
+    }
+    return true;
+}
+
+static ConsistencyReport checkConsistency(mongocxx::pool::entry &conn) {
+    auto db = conn->database("bench");
+    ConsistencyReport report;
+
+    map<int, double> districtYtd;
+    map<pair<int, int>, int> districtNextOId;
+    auto districtOptions = mongocxx::options::find();
+    districtOptions.projection(MDV("d_w_id", 1, "d_id", 1, "d_ytd", 1, "d_next_o_id", 1, "_id", 0));
+    for (auto &&d : db.collection("district").find({}, districtOptions)) {
+        int wId = d["d_w_id"].get_int32();
+        districtYtd[wId] += d["d_ytd"].get_double();
+        districtNextOId[{wId, d["d_id"].get_int32()}] = d["d_next_o_id"].get_int32();
+    }
+
+    // 1: W_YTD = sum(D_YTD)
+    auto warehouseOptions = mongocxx::options::find();
+    warehouseOptions.projection(MDV("w_id", 1, "w_ytd", 1, "_id", 0));
+    for (auto &&w : db.collection("warehouse").find({}, warehouseOptions)) {
+        if (fabs(w["w_ytd"].get_double() - districtYtd[w["w_id"].get_int32()]) > 0.005)
+            report.warehouseYtd++;
+    }
+
+    // 2: D_NEXT_O_ID - 1 = max(O_ID)
+    mongocxx::pipeline maxOrders;
+    maxOrders.group(make_document(
+        kvp("_id", make_document(kvp("w", "$o_w_id"), kvp("d", "$o_d_id"))),
+        kvp("maxId", make_document(kvp("$max", "$o_id")))));
+    for (auto &&g : db.collection("order").aggregate(maxOrders)) {
+        auto key = g["_id"].get_document().value;
+        pair<int, int> district{key["w"].get_int32(), key["d"].get_int32()};
+        if (districtNextOId[district] - 1 != g["maxId"].get_int32())
+            report.districtNextOId++;
+    }
+
+    // 3: the new orders of a district are contiguous
+    mongocxx::pipeline newOrders;
+    newOrders.match(MDV("o_new", true));
+    newOrders.group(make_document(
+        kvp("_id", make_document(kvp("w", "$o_w_id"), kvp("d", "$o_d_id"))),
+        kvp("minId", make_document(kvp("$min", "$o_id"))),
+        kvp("maxId", make_document(kvp("$max", "$o_id"))),
+        kvp("n", make_document(kvp("$sum", 1)))));
+    for (auto &&g : db.collection("order").aggregate(newOrders)) {
+        if (g["maxId"].get_int32() - g["minId"].get_int32() + 1 != g["n"].get_int32())
+            report.newOrderGaps++;
+    }
+    return report;
+}
+
+static void reportConsistency(std::map<std::string, double> &counters,
+                              mongocxx::pool::entry &conn) {
+    auto report = checkConsistency(conn);
+    counters["anomalyWarehouseYtd"] = report.warehouseYtd;
+    counters["anomalyDistrictNextOId"] = report.districtNextOId;
+    counters["anomalyNewOrderGaps"] = report.newOrderGaps;
+}
+
+namespace {
+class MongoTPCCModern : public Backend {
+  public:
+    explicit MongoTPCCModern(benchmark::State &state)
+        : state(state), conn(MongoDBHandler::GetConnection()) {}
+
+    void load(ScaleParameters &params, int clients) override {
+        LoadBenchmark(conn, params, params.warehouses, clients);
+    }
+    bool newOrder(ScaleParameters &params) override {
+        int numFails = 0;
+        doNewOrder(state, params, conn, numFails, retries);
+        return numFails == 0;
+    }
+    bool payment(ScaleParameters &params) override {
+        return doPayment(state, params, conn, retries);
+    }
+    bool orderStatus(ScaleParameters &params) override {
+        return doOrderStatus(state, params, conn, retries);
+    }
+    bool delivery(ScaleParameters &params) override {
+        return doDeliveryN(state, params, conn, retries);
     }
+    bool stockLevel(ScaleParameters &params) override {
+        return doStockLevel(state, params, conn, retries);
+    }
+    // Transactions that exhausted their retries are logged and the terminal goes on
+    FailureKind classify(const std::exception &e) const override {
+        return FailureKind::Transient;
+    }
+    void counters(std::map<std::string, double> &out) const override {
+        out["retries"] = retries;
+    }
+    void serverStatistics(std::map<std::string, double> &out) override {
+        out = MongoDBHandler::ServerStats(
+            *conn, "bench", {"warehouse", "district", "customer", "history", "order", "item", "stock"});
+    }
+    void finish(std::map<std::string, double> &out) override {
+        reportConsistency(out, conn);
+    }
+
+  protected:
+    benchmark::State &state;
+    mongocxx::pool::entry conn;
+    int retries = 0;
+};
+
+// The same schema without sessions, see doNewOrderSingleDoc and friends
+class MongoTPCCModernSingleDoc : public MongoTPCCModern {
+  public:
+    using MongoTPCCModern::MongoTPCCModern;
+
+    bool newOrder(ScaleParameters &params) override {
+        int numFails = 0;
+        doNewOrderSingleDoc(state, params, conn, numFails, retries, anomalies);
+        return numFails == 0;
+    }
+    bool payment(ScaleParameters &params) override {
+        return doPaymentSingleDoc(state, params, conn, retries, anomalies);
+    }
+    bool orderStatus(ScaleParameters &params) override {
+        return doOrderStatusSingleDoc(state, params, conn);
+    }
+    bool delivery(ScaleParameters &params) override {
+        return doDeliverySingleDoc(state, params, conn, retries, anomalies);
+    }
+    bool stockLevel(ScaleParameters &params) override {
+        return doStockLevelSingleDoc(state, params, conn);
+    }
+    void counters(std::map<std::string, double> &out) const override {
+        MongoTPCCModern::counters(out);
+        out["orderIdGaps"] = anomalies.orderIdGaps;
+        out["lostDeliveries"] = anomalies.lostDeliveries;
+        out["partialPayments"] = anomalies.partialPayments;
+    }
+
+  private:
+    SingleDocAnomalies anomalies;
+};
+} // namespace
+
+static void BM_MONGO_TPCC_MODERN(benchmark::State &state,
+                                 ArrivalProcess arrival) {
+    runTPCC(state, "mongo_tpcc_modern", arrival, [](benchmark::State &state) {
+        return make_unique<MongoTPCCModern>(state);
+    });
+}
 
-    int total = numDeliveries + numNewOrders + numFailedNewOrders +
-                numOrderStatuses + numPayments + numStockLevels;
-
-    state.counters["retries"] = retries;
-
-    state.counters["txn"] = total;
-    state.counters["txnRate"] =
-        benchmark::Counter(total, benchmark::Counter::kIsRate);
-    state.counters["txnRateInv"] = benchmark::Counter(
-        total, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-
-    state.counters["delivery"] = numDeliveries;
-    state.counters["deliveryRate"] =
-        benchmark::Counter(numDeliveries, benchmark::Counter::kIsRate);
-    state.counters["deliveryRateInv"] =
-        benchmark::Counter(numDeliveries, benchmark::Counter::kIsRate |
-                                              benchmark::Counter::kInvert);
-
-    state.counters["newOrder"] = numNewOrders;
-    state.counters["newOrderRate"] =
-        benchmark::Counter(numNewOrders, benchmark::Counter::kIsRate);
-    state.counters["newOrderRateInv"] =
-        benchmark::Counter(numNewOrders, benchmark::Counter::kIsRate |
-                                             benchmark::Counter::kInvert);
-
-    state.counters["newOrderFail"] = numFailedNewOrders;
-
-    state.counters["payment"] = numPayments;
-    state.counters["paymentRate"] =
-        benchmark::Counter(numPayments, benchmark::Counter::kIsRate);
-    state.counters["paymentRateInv"] = benchmark::Counter(
-        numPayments, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-
-    state.counters["status"] = numOrderStatuses;
-    state.counters["statusRate"] =
-        benchmark::Counter(numOrderStatuses, benchmark::Counter::kIsRate);
-    state.counters["statusRateInv"] =
-        benchmark::Counter(numOrderStatuses, benchmark::Counter::kIsRate |
-                                                 benchmark::Counter::kInvert);
-
-    state.counters["stock"] = numStockLevels;
-    state.counters["stockRate"] =
-        benchmark::Counter(numStockLevels, benchmark::Counter::kIsRate);
-    state.counters["stockRateInv"] =
-        benchmark::Counter(numStockLevels, benchmark::Counter::kIsRate |
-                                               benchmark::Counter::kInvert);
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_MODERN, Closed, ArrivalProcess::Closed)->RangeMultiplier(2)->Range(1,10)->ThreadRange(1,16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_MODERN, Constant, ArrivalProcess::Constant)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_MODERN, Poisson, ArrivalProcess::Poisson)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
+
+// Run after all terminals stopped, so the consistency counters compare directly
+// with the ones of the transactional BM_MONGO_TPCC_MODERN
+static void BM_MONGO_TPCC_MODERN_SINGLE_DOC(benchmark::State &state,
+                                            ArrivalProcess arrival) {
+    runTPCC(state, "mongo_tpcc_modern_single_doc", arrival,
+            [](benchmark::State &state) {
+                return make_unique<MongoTPCCModernSingleDoc>(state);
+            });
 }
 
-BENCHMARK(BM_MONGO_TPCC_MODERN)->RangeMultiplier(2)->Range(1,10)->Iterations(10000)->ThreadRange(1,16)->UseRealTime();
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_MODERN_SINGLE_DOC, Closed, ArrivalProcess::Closed)->RangeMultiplier(2)->Range(1,10)->ThreadRange(1,16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_MODERN_SINGLE_DOC, Constant, ArrivalProcess::Constant)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_MONGO_TPCC_MODERN_SINGLE_DOC, Poisson, ArrivalProcess::Poisson)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
@@ -1,6 +1,13 @@
 #include "benchmark/benchmark.h"
 #include "bsoncxx/builder/stream/helpers.hpp"
+#include "mongocxx/bulk_write.hpp"
+#include "mongocxx/exception/operation_exception.hpp"
+#include "mongocxx/model/update_one.hpp"
+#include "mongocxx/options/bulk_write.hpp"
 #include "dbphd/mongodb/mongodb.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 #include "precalculate.hpp"
 
 #include <random>
@@ -21,20 +28,38 @@ using bsoncxx::builder::basic::kvp;
 using bsoncxx::builder::basic::make_document;
 
 static void CustomArgumentsUpdates(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 1; j <= Precalculator::Columns; ++j) { // fields to write
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
 			for (int k = 0; k <= i; ++k) { //  Indexes
-				b->Args({i, j, k});
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
 			}
 		}
 	}
 }
 
 static void CustomArgumentsUpdates2(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 1; j <= Precalculator::Columns; ++j) { // fields to write
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
 			for (int k = 0; k <= j; ++k) { //  Indexes
-				b->Args({i, j, k});
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
+			}
+		}
+	}
+}
+
+// Keyed batches of changes: batch size, fields changed and how many of them
+// are indexed, with every key distribution
+static void CustomArgumentsBulkUpdates(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= 10000 && i <= (int64_t)Precalculator::Rows(); i *= 10) { // Changes per batch
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
+			for (int k = 0; k <= j; ++k) { //  Indexes on the written fields
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
 			}
 		}
 	}
@@ -54,13 +79,12 @@ static void CreateCollection(mongocxx::pool::entry& conn, bool doublefields = fa
 		collection.create_index(make_document(kvp("_id", 1)));
 
 		auto writer = collection.create_bulk_write();
-		for(int i = 0; i < Precalculator::Rows; i += 100) {
-			for(int j = 0; j < 100 && i+j < Precalculator::Rows;++j) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += 100) {
+			for(int j = 0; j < 100 && i+j < Precalculator::Rows();++j) {
 				auto builder = bsoncxx::builder::stream::document{};
-				auto doc = builder << "_id" << j+i;
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 0; f < Precalculator::Columns; ++f) {
+				auto doc = builder << "_id" << (int)(j+i);
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 0; f < Precalculator::Columns(); ++f) {
 					doc << ("a" + to_string(f)) << rowval[f]; // values for query
 					if(doublefields)
 						doc << ("b" + to_string(f)) << rowval[f]; // values for writing
@@ -73,6 +97,8 @@ static void CreateCollection(mongocxx::pool::entry& conn, bool doublefields = fa
 		writer.execute();
 		auto end = chrono::steady_clock::now();
 		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("mongodb", "update_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("mongodb", [&] { return MongoDBHandler::ServerInfo(*conn); });
 		cout.flush();
 	}
 	created = true;
@@ -84,7 +110,7 @@ static void BM_MONGO_Update(benchmark::State& state, bool transactions, bool tes
 	auto collection = db.collection("update_bench");
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(3), 5);
 	std::uniform_int_distribution<> dis2(1,100);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
@@ -126,11 +152,13 @@ static void BM_MONGO_Update(benchmark::State& state, bool transactions, bool tes
 	}
 	auto session = conn->start_session();
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		auto builder = bsoncxx::builder::stream::document{};
 		for(int n = 0; n < state.range(0); ++n) {
-			builder << ("a" + to_string(n)) << dis(gen);
+			builder << ("a" + to_string(n)) << (int)dis(gen);
 		}
 		auto builderupdate = bsoncxx::builder::stream::document{};
 		builderupdate << "$inc" << bsoncxx::builder::stream::open_document;
@@ -141,6 +169,7 @@ static void BM_MONGO_Update(benchmark::State& state, bool transactions, bool tes
 		auto query = builder << bsoncxx::builder::stream::finalize;
 		auto update = builderupdate << bsoncxx::builder::stream::finalize;
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			session.start_transaction();
@@ -151,6 +180,7 @@ static void BM_MONGO_Update(benchmark::State& state, bool transactions, bool tes
 			session.commit_transaction();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -177,9 +207,103 @@ static void BM_MONGO_Update(benchmark::State& state, bool transactions, bool tes
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"FieldsQueried", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsChanged", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_MONGO_Update, Normal, false, false)->Apply(CustomArgumentsUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MONGO_Update, Transact, true, false)->Apply(CustomArgumentsUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MONGO_Update, NormalWriteIdx, false, true)->Apply(CustomArgumentsUpdates2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MONGO_Update, TransactWriteIdx, true, true)->Apply(CustomArgumentsUpdates2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+// Sets the first fields b fields of a batch of documents picked by their _id
+// with an unordered bulk write of update_one models, as an ETL job applying
+// keyed changes would. The keys of a batch are sorted and each is sent once;
+// the write conflicts of concurrent transactions are counted as Conflicts
+// instead of failing the run.
+static void BM_MONGO_Update_Bulk(benchmark::State& state, bool transactions) {
+	auto conn = MongoDBHandler::GetConnection();
+	auto db = conn->database("bench");
+	auto collection = db.collection("update_bench");
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	KeyDistribution keys = Precalculator::QueryKeys(state.range(3), Precalculator::Rows());
+	std::uniform_int_distribution<> dis2(1,100);
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateCollection(conn, true);
+		collection = db.collection("update_bench");
+		collection.indexes().drop_all();
+		if(state.range(2) > 0) {
+			auto idxbuilder = bsoncxx::builder::stream::document{};
+			auto idx = idxbuilder << "b0" << 1;
+			for(int index = 1; index < state.range(2); ++index) {
+				idx << ("b" + to_string(index)) << 1;
+			}
+			collection.create_index(idx << bsoncxx::builder::stream::finalize);
+		}
+	}
+	const int batch = state.range(0), fields = state.range(1);
+	auto session = conn->start_session();
+	int64_t changes = 0, conflicts = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MongoDBHandler::ServerStats(*conn); });
+	for(auto _ : state) {
+		state.PauseTiming();
+		auto batchKeys = keys.Batch(gen, batch);
+		mongocxx::options::bulk_write bulkOptions;
+		bulkOptions.ordered(false);
+		auto writer = collection.create_bulk_write(session, bulkOptions);
+		for(auto key : batchKeys) {
+			auto builderupdate = bsoncxx::builder::stream::document{};
+			builderupdate << "$set" << bsoncxx::builder::stream::open_document;
+			for(int i = 0; i < fields; ++i) {
+				builderupdate << ("b" + to_string(i)) << dis2(gen);
+			}
+			builderupdate << bsoncxx::builder::stream::close_document;
+			writer.append(mongocxx::model::update_one(make_document(kvp("_id", (int)key)), builderupdate << bsoncxx::builder::stream::finalize));
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		try {
+			if(transactions) {
+				session.start_transaction();
+			}
+			writer.execute();
+			if(transactions) {
+				session.commit_transaction();
+			}
+			changes += batchKeys.size();
+		} catch(mongocxx::operation_exception& e) {
+			// WriteConflict, outside of transactions the server retries it itself
+			if(!e.has_error_label("TransientTransactionError") && e.code().value() != 112)
+				throw;
+			++conflicts;
+			if(transactions) {
+				session.abort_transaction();
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	state.SetComplexityN(state.range(0));
+	// The changes committed, a key drawn more than once in a batch counts once.
+	// modified_count would leave out those that set the same values.
+	state.SetItemsProcessed(changes);
+	state.counters["Conflicts"] = conflicts;
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Batch", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsChanged", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, keys);
+}
+
+BENCHMARK_CAPTURE(BM_MONGO_Update_Bulk, Normal, false)->Apply(CustomArgumentsBulkUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_MONGO_Update_Bulk, Transact, true)->Apply(CustomArgumentsBulkUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
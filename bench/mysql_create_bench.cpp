@@ -1,7 +1,11 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/mysqldb/mysqldb.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 
+#include <algorithm>
 #include <random>
+#include <vector>
 
 using namespace std;
 
@@ -20,37 +24,45 @@ static void CustomArgumentsInserts(benchmark::internal::Benchmark* b) {
 	}
 }
 
-static void BM_MYSQL_Insert(benchmark::State& state, bool transactions) {
-	auto conn = MySQLDBHandler::GetConnection();	
-	std::random_device rd;  //Will be used to obtain a seed for the random number engine
-	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, (1 << 16));
-	// Per thread settings...
-	if(state.thread_index() == 0) {
-		// This is the first thread, so do initialization here, build indexes etc...
-		MySQLDBHandler::CreateDatabase(conn, "bench");
-		MySQLDBHandler::DropTable(conn, "bench", "create_bench");
-		string createQuery = R"|(
+// Drops and creates bench.create_bench with fields INT columns a0.. and an
+// index on each of the first indexes of them
+static void CreateTable(mysqlx::Session& conn, int fields, int indexes) {
+	MySQLDBHandler::CreateDatabase(conn, "bench");
+	MySQLDBHandler::DropTable(conn, "bench", "create_bench");
+	string createQuery = R"|(
 CREATE TABLE create_bench (
 	_id  INT AUTO_INCREMENT,
 	a0 INT,
 )|";
-		for(int field = 1; field < state.range(1); ++field) {
-			createQuery.append("a" + to_string(field) + " INT,");
-		}
-		createQuery.append(R"|(
+	for(int field = 1; field < fields; ++field) {
+		createQuery.append("a" + to_string(field) + " INT,");
+	}
+	createQuery.append(R"|(
 	PRIMARY KEY(_id)
 ) ENGINE=INNODB;
 )|");
-		conn.sql(createQuery).execute();
-		if(state.range(2) > 0) {
-			for(int index = 0; index < state.range(2); ++index) {
-				conn.sql("CREATE INDEX field" + to_string(index) + " ON bench.create_bench(a" + to_string(index) + ");").execute();
-			}
+	conn.sql(createQuery).execute();
+	if(indexes > 0) {
+		for(int index = 0; index < indexes; ++index) {
+			conn.sql("CREATE INDEX field" + to_string(index) + " ON bench.create_bench(a" + to_string(index) + ");").execute();
 		}
 	}
+}
+
+static void BM_MYSQL_Insert(benchmark::State& state, bool transactions) {
+	auto conn = MySQLDBHandler::GetConnection();	
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	std::uniform_int_distribution<> dis(0, (1 << 16));
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn, state.range(1), state.range(2));
+	}
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("create_bench");
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		auto tableInsert = table.insert();
@@ -63,6 +75,7 @@ CREATE TABLE create_bench (
 			tableInsert.rows(row);
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -72,6 +85,7 @@ CREATE TABLE create_bench (
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -100,3 +114,157 @@ CREATE TABLE create_bench (
 
 BENCHMARK_CAPTURE(BM_MYSQL_Insert, Normal, false)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MYSQL_Insert, Transact, true)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+// How BM_MYSQL_Insert_Strategy writes the rows
+enum class InsertStrategy {
+	Rows = 0,        // X DevAPI table inserts of rows, like BM_MYSQL_Insert
+	Prepared = 1,    // Multi-row SQL INSERTs with ? placeholders, prepared once and rebound
+	Literal = 2      // One multi-row SQL INSERT with the values in its text
+};
+
+// The grid of CustomArgumentsInserts with every insert strategy
+static void CustomArgumentsStrategies(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= (1 << 12); i*=8) { // Documents
+		for (int j = 1; j <= 16; j *= 2) { // Fields
+			for(int k = 0; k <= j; ) { // Indexes
+				for(int l = (int)InsertStrategy::Rows; l <= (int)InsertStrategy::Literal; ++l) { // Insert strategy
+					b->Args({i, j, k, l});
+				}
+				if(k == 0) {
+					k = 1;
+				} else {
+					k *= 2;
+				}
+			}
+		}
+	}
+}
+
+// The most placeholders one statement can bind
+static const int MaxPlaceholders = 65535;
+
+// The rows of BM_MYSQL_Insert written the way the last argument says, built
+// while the timing is paused. LOAD DATA is not an option, X Protocol
+// sessions cannot send a LOCAL file, so Literal is the bulk text path.
+// Prepared builds its statements once and rebinds them every iteration; the
+// connector (8.0.16+) prepares a statement on the server when it is executed
+// again with new values, so only the first iteration sends the SQL text.
+static void BM_MYSQL_Insert_Strategy(benchmark::State& state, bool transactions) {
+	auto conn = MySQLDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	std::uniform_int_distribution<> dis(0, (1 << 16));
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn, state.range(1), state.range(2));
+	}
+	const int rows = state.range(0), fields = state.range(1);
+	auto strategy = (InsertStrategy)state.range(3);
+	string insert = "INSERT INTO bench.create_bench (a0";
+	for(int field = 1; field < fields; ++field) {
+		insert += ",a" + to_string(field);
+	}
+	insert += ") VALUES ";
+	// Prepared INSERTs take as many rows as fit, the rest goes last. Each
+	// chunk has its own statement, so all are bound while the timing is paused
+	const int chunk = min(rows, MaxPlaceholders / fields);
+	string placeholders = "(?";
+	for(int field = 1; field < fields; ++field) {
+		placeholders += ",?";
+	}
+	placeholders += ")";
+	vector<mysqlx::SqlStatement> prepared;
+	if(strategy == InsertStrategy::Prepared) {
+		for(int first = 0; first < rows; first += chunk) {
+			int count = min(chunk, rows - first);
+			string sql = insert + placeholders;
+			for(int n = 1; n < count; ++n) {
+				sql += "," + placeholders;
+			}
+			prepared.push_back(conn.sql(sql));
+		}
+	}
+	auto db = conn.getSchema("bench");
+	auto table = db.getTable("create_bench");
+	vector<int> values(rows * fields);
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
+	for(auto _ : state) {
+		state.PauseTiming();
+		for(auto& value : values) {
+			value = dis(gen);
+		}
+		auto tableInsert = table.insert();
+		vector<mysqlx::SqlStatement> statements;
+		if(strategy == InsertStrategy::Rows) {
+			for(int n = 0; n < rows; ++n) {
+				mysqlx::Row row;
+				row.set(0, mysqlx::nullvalue);
+				for(int field = 0; field < fields; ++field) {
+					row.set(field + 1, values[n * fields + field]);
+				}
+				tableInsert.rows(row);
+			}
+		} else if(strategy == InsertStrategy::Prepared) {
+			for(size_t c = 0; c < prepared.size(); ++c) {
+				int first = c * chunk;
+				int count = min(chunk, rows - first);
+				for(int value = first * fields; value < (first + count) * fields; ++value) {
+					prepared[c].bind(values[value]);
+				}
+			}
+		} else {
+			string sql = insert;
+			for(int n = 0; n < rows; ++n) {
+				sql += n == 0 ? "(" : ",(";
+				for(int field = 0; field < fields; ++field) {
+					sql += (field == 0 ? "" : ",") + to_string(values[n * fields + field]);
+				}
+				sql += ")";
+			}
+			statements.push_back(conn.sql(sql));
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		if(transactions) {
+			conn.startTransaction();
+		}
+		if(strategy == InsertStrategy::Rows) {
+			tableInsert.execute();
+		} else if(strategy == InsertStrategy::Prepared) {
+			for(auto& statement : prepared) {
+				statement.execute();
+			}
+		} else {
+			for(auto& statement : statements) {
+				statement.execute();
+			}
+		}
+		if(transactions) {
+			conn.commit();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	if(state.thread_index() == 0) {
+		MySQLDBHandler::DropTable(conn, "bench", "create_bench");
+		// This is the first thread, so do destruction here (delete documents etc..)
+	}
+
+	state.SetComplexityN(state.range(0));
+	state.counters["Ops"] = benchmark::Counter(state.iterations()*state.range(0), benchmark::Counter::kIsRate);
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations()*state.range(0), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Documents", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Fields", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Strategy", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK_CAPTURE(BM_MYSQL_Insert_Strategy, Normal, false)->Apply(CustomArgumentsStrategies)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_MYSQL_Insert_Strategy, Transact, true)->Apply(CustomArgumentsStrategies)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -1,5 +1,8 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/mysqldb/mysqldb.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 #include "precalculate.hpp"
 
 #include <random>
@@ -9,9 +12,11 @@
 using namespace std;
 
 static void CustomArgumentsDeletes(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
 		for (int j = 0; j <= i; ++j) { //  Indexes
-			b->Args({i, j});
+			for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+				b->Args({i, j, d});
+			}
 		}
 	}
 }
@@ -29,7 +34,7 @@ CREATE TABLE )|" + string("delete_bench") + postfix +R"|( (
 	_id  INT AUTO_INCREMENT,
 	a0 INT,
 )|";
-		for(int field = 1; field < Precalculator::Columns; ++field) {
+		for(int field = 1; field < Precalculator::Columns(); ++field) {
 			createQuery.append("a" + to_string(field) + " INT,");
 		}
 		createQuery.append(R"|(
@@ -41,14 +46,13 @@ CREATE TABLE )|" + string("delete_bench") + postfix +R"|( (
 		auto table = db.getTable("delete_bench"+postfix);
 
 		int batchsize = 10000;
-		for(int i = 0; i < Precalculator::Rows; i += batchsize) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += batchsize) {
 			auto tableInsert = table.insert();
-			for(int j = 0; j < batchsize && i+j < Precalculator::Rows;++j) {
+			for(int j = 0; j < batchsize && i+j < Precalculator::Rows();++j) {
 				mysqlx::Row row;
 				row.set(0, mysqlx::nullvalue);
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 1; f <= Precalculator::Columns; ++f) {
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 1; f <= Precalculator::Columns(); ++f) {
 					row.set(f, rowval[f-1]);
 				}
 				tableInsert.rows(row);
@@ -57,6 +61,8 @@ CREATE TABLE )|" + string("delete_bench") + postfix +R"|( (
 		}
 		auto end = chrono::steady_clock::now();
 		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("mysql", "delete_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("mysql", [&] { return MySQLDBHandler::ServerInfo(conn); });
 		cout.flush();
 		created[postfix] = true;
 	}
@@ -67,7 +73,7 @@ static void BM_MYSQL_Delete(benchmark::State& state, bool transactions) {
 	std::string postfix = std::to_string(state.thread_index());
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(2), 5);
 	// Per thread settings...
 		// This is the first thread, so do initialization here, build indexes etc...
 	CreateTable(conn, postfix);
@@ -86,6 +92,8 @@ static void BM_MYSQL_Delete(benchmark::State& state, bool transactions) {
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("delete_bench"+postfix);
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		auto tablePrequery = table.select("*");
@@ -101,6 +109,7 @@ static void BM_MYSQL_Delete(benchmark::State& state, bool transactions) {
 		std::deque<mysqlx::Row> deleters = tablePrequery.execute().fetchAll();
 		
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -111,6 +120,7 @@ static void BM_MYSQL_Delete(benchmark::State& state, bool transactions) {
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -144,6 +154,7 @@ static void BM_MYSQL_Delete(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_MYSQL_Delete, Normal, false)->Apply(CustomArgumentsDeletes)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -1,5 +1,10 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/mysqldb/mysqldb.hpp"
+#include "dbphd/join/clientjoin.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
+#include "benchstream.hpp"
 #include "precalculate.hpp"
 
 #include <random>
@@ -9,19 +14,23 @@
 using namespace std;
 
 static void CustomArgumentsInserts(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
 		for (int j = 0; j <= i; ++j) { //  Indexes
-			b->Args({i, j});
+			for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+				b->Args({i, j, d});
+			}
 		}
 	}
 }
 
 static void CustomArgumentsInserts2(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 0; j <= Precalculator::Columns; ++j) { // fields to return
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 0; j <= Precalculator::Columns(); ++j) { // fields to return
 			for (int k = 0; k <= i; ++k) { //  Indexes
-				for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns-i); l *= 2) { // Documents to return
-					b->Args({i, j, k, l});
+				for(int64_t l = 1; l <= (int64_t)Precalculator::Matching(i); l *= 2) { // Documents to return
+					for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+						b->Args({i, j, k, l, d});
+					}
 				}
 			}
 		}
@@ -29,15 +38,15 @@ static void CustomArgumentsInserts2(benchmark::internal::Benchmark* b) {
 }
 
 static void CustomArgumentsInserts3(benchmark::internal::Benchmark* b) {
-	for (int i = 1; i <= Precalculator::Rows; i *= 2) { // documents to process
+	for (int64_t i = 1; i <= (int64_t)Precalculator::Rows(); i *= 2) { // documents to process
 		b->Args({i});
 	}
 }
 
 static void CustomArgumentsInserts4(benchmark::internal::Benchmark* b) {
-	for (int i = 1; i <= Precalculator::Columns; ++i) { // fields to sort
+	for (int i = 1; i <= Precalculator::Columns(); ++i) { // fields to sort
 		for (int k = 0; k <= i; ++k) { //  Indexes
-			for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns); l *= 2) { // Documents to return
+			for(int64_t l = 1; l <= (int64_t)Precalculator::Rows(); l *= 2) { // Documents to return
 				b->Args({i, k, l});
 			}
 		}
@@ -46,7 +55,7 @@ static void CustomArgumentsInserts4(benchmark::internal::Benchmark* b) {
 
 static void CustomArgumentsInserts5(benchmark::internal::Benchmark* b) {
 	for (int i = 0; i <= 2; ++i) { // fields to index
-		for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns); l *= 2) { // Documents to return
+		for(int64_t l = 1; l <= (int64_t)Precalculator::Rows(); l *= 2) { // Documents to return
 			b->Args({i, l});
 		}
 	}
@@ -54,7 +63,7 @@ static void CustomArgumentsInserts5(benchmark::internal::Benchmark* b) {
 
 static void CustomArgumentsInserts6(benchmark::internal::Benchmark* b) {
 	for (int i = 0; i <= 2; ++i) { // fields to index
-		for(int j = 1; j <= (int)pow(Precalculator::Values,Precalculator::Columns); j *= 2) { // Documents to return
+		for(int64_t j = 1; j <= (int64_t)Precalculator::Rows(); j *= 2) { // Documents to return
 			for(int k = 1; k < 8192; k *= 2) { // Documents to query for batch
 				b->Args({i, j, k});
 			}
@@ -62,6 +71,27 @@ static void CustomArgumentsInserts6(benchmark::internal::Benchmark* b) {
 	}
 }
 
+static void CustomArgumentsInserts7(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= 2; ++i) { // fields to index
+		for(int64_t j = 1; j <= (int64_t)Precalculator::Rows(); j *= 2) { // Documents to return
+			for(int k = 1; k <= j; k *= 2) { // Documents to query for batch, more than returned is the same batch
+				for(int l = (int)JoinAlgorithm::Hash; l <= (int)JoinAlgorithm::SortMerge; ++l) { // Client join algorithm
+					b->Args({i, j, k, l});
+				}
+			}
+		}
+	}
+}
+
+// Large results, buffered by fetchAll (0) or read a row at a time by fetchOne (1)
+static void CustomArgumentsStream(benchmark::internal::Benchmark* b) {
+	for(int64_t l = 100; l <= (int64_t)Precalculator::Rows(); l *= 10) { // Rows to return
+		for(int64_t fetch = 0; fetch <= 1; ++fetch) { // Row fetch mode
+			b->Args({l, fetch});
+		}
+	}
+}
+
 static void CreateTable(mysqlx::Session &conn) {
 	static volatile bool created = false;
 	if(!created) {
@@ -75,7 +105,7 @@ CREATE TABLE read_bench (
 	_id  INT AUTO_INCREMENT,
 	a0 INT,
 )|";
-		for(int field = 1; field < Precalculator::Columns; ++field) {
+		for(int field = 1; field < Precalculator::Columns(); ++field) {
 			createQuery.append("a" + to_string(field) + " INT,");
 		}
 		createQuery.append(R"|(
@@ -87,14 +117,13 @@ CREATE TABLE read_bench (
 		auto table = db.getTable("read_bench");
 
 		int batchsize = 10000;
-		for(int i = 0; i < Precalculator::Rows; i += batchsize) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += batchsize) {
 			auto tableInsert = table.insert();
-			for(int j = 0; j < batchsize && i+j < Precalculator::Rows;++j) {
+			for(int j = 0; j < batchsize && i+j < Precalculator::Rows();++j) {
 				mysqlx::Row row;
 				row.set(0, mysqlx::nullvalue);
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 1; f <= Precalculator::Columns; ++f) {
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 1; f <= Precalculator::Columns(); ++f) {
 					row.set(f, rowval[f-1]);
 				}
 				tableInsert.rows(row);
@@ -103,6 +132,8 @@ CREATE TABLE read_bench (
 		}
 		auto end = chrono::steady_clock::now();
 		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("mysql", "read_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("mysql", [&] { return MySQLDBHandler::ServerInfo(conn); });
 		cout.flush();
 	}
 	created = true;
@@ -112,7 +143,7 @@ static void BM_MYSQL_Read_Count(benchmark::State& state, bool transactions) {
 	auto conn = MySQLDBHandler::GetConnection();	
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(2), 5);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
 		// This is the first thread, so do initialization here, build indexes etc...
@@ -133,6 +164,8 @@ static void BM_MYSQL_Read_Count(benchmark::State& state, bool transactions) {
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("read_bench");
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		auto tableSelect = table.select("COUNT(*)");
@@ -144,6 +177,7 @@ static void BM_MYSQL_Read_Count(benchmark::State& state, bool transactions) {
 			tableSelect.where(whereclause);
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -154,6 +188,7 @@ static void BM_MYSQL_Read_Count(benchmark::State& state, bool transactions) {
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -179,6 +214,7 @@ static void BM_MYSQL_Read_Count(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_MYSQL_Read_Count, Normal, false)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -188,7 +224,7 @@ static void BM_MYSQL_Reads(benchmark::State& state, bool transactions) {
 	auto conn = MySQLDBHandler::GetConnection();	
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(4), 5);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
 		// This is the first thread, so do initialization here, build indexes etc...
@@ -209,6 +245,8 @@ static void BM_MYSQL_Reads(benchmark::State& state, bool transactions) {
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("read_bench");
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		std::list<string> selectclause = {"_id"};
@@ -226,6 +264,7 @@ static void BM_MYSQL_Reads(benchmark::State& state, bool transactions) {
 		}
 		tableSelect.limit(state.range(3));
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -238,6 +277,7 @@ static void BM_MYSQL_Reads(benchmark::State& state, bool transactions) {
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -263,11 +303,75 @@ static void BM_MYSQL_Reads(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsProj", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_MYSQL_Reads, Normal, false)->Apply(CustomArgumentsInserts2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MYSQL_Reads, Transact, true)->Apply(CustomArgumentsInserts2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 
+// Every column of the first rows, fetched all at once into a list or row by
+// row. The X DevAPI has no batch size of its own. The a columns are converted
+// and summed like the fields the MongoDB variant decodes.
+static void BM_MYSQL_Read_Stream(benchmark::State& state) {
+	auto conn = MySQLDBHandler::GetConnection();
+	if(state.thread_index() == 0) {
+		CreateTable(conn);
+	}
+	auto db = conn.getSchema("bench");
+	auto table = db.getTable("read_bench");
+	std::list<string> selectclause = {"_id"};
+	for(int i = 0; i < Precalculator::Columns(); ++i) {
+		selectclause.push_back("a" + to_string(i));
+	}
+	uint64_t count = 0;
+	int64_t checksum = 0;
+	PerfIterations perfIterations(state);
+	StreamStatistics streamStats(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		auto tableSelect = table.select(selectclause);
+		tableSelect.limit(state.range(0));
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		streamStats.start(start);
+		auto result = tableSelect.execute();
+		if(state.range(1) == 0) {
+			std::list<mysqlx::Row> rows = result.fetchAll();
+			for(auto& row: rows) {
+				streamStats.row();
+				for(int f = 1; f <= Precalculator::Columns(); ++f) {
+					checksum += row[f].get<int>();
+				}
+				++count;
+			}
+		} else {
+			for(auto row = result.fetchOne(); !row.isNull(); row = result.fetchOne()) {
+				streamStats.row();
+				for(int f = 1; f <= Precalculator::Columns(); ++f) {
+					checksum += row[f].get<int>();
+				}
+				++count;
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	benchmark::DoNotOptimize(checksum);
+	state.SetComplexityN(state.range(0));
+	state.SetItemsProcessed(count);
+	state.counters.insert({{"Limit", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Fetch", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK(BM_MYSQL_Read_Stream)->Apply(CustomArgumentsStream)->DenseThreadRange(1, 8, 2)->UseManualTime();
+
 static void BM_MYSQL_Read_Sum(benchmark::State& state, bool transactions) {
 	auto conn = MySQLDBHandler::GetConnection();	
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
@@ -284,6 +388,8 @@ static void BM_MYSQL_Read_Sum(benchmark::State& state, bool transactions) {
 	}
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("read_bench");
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT SUM(new.a0)";
@@ -291,6 +397,7 @@ static void BM_MYSQL_Read_Sum(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(0));
 		query += ") new;";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -302,6 +409,7 @@ static void BM_MYSQL_Read_Sum(benchmark::State& state, bool transactions) {
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -348,6 +456,8 @@ static void BM_MYSQL_Read_Avg(benchmark::State& state, bool transactions) {
 	}
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("read_bench");
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT AVG(new.a0)";
@@ -355,6 +465,7 @@ static void BM_MYSQL_Read_Avg(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(0));
 		query += ") new;";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -366,6 +477,7 @@ static void BM_MYSQL_Read_Avg(benchmark::State& state, bool transactions) {
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -412,12 +524,15 @@ static void BM_MYSQL_Read_Mul(benchmark::State& state, bool transactions) {
 	}
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("read_bench");
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "a0*2";
 		auto tableSelect = table.select(selectclause);
 		tableSelect.limit(state.range(0));
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -429,6 +544,7 @@ static void BM_MYSQL_Read_Mul(benchmark::State& state, bool transactions) {
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -484,6 +600,8 @@ static void BM_MYSQL_Read_Sort(benchmark::State& state, bool transactions) {
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("read_bench");
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		std::list<string> selectclause = {"*"};
@@ -498,6 +616,7 @@ static void BM_MYSQL_Read_Sort(benchmark::State& state, bool transactions) {
 		}
 		tableSelect.limit(state.range(2));
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -510,6 +629,7 @@ static void BM_MYSQL_Read_Sort(benchmark::State& state, bool transactions) {
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -567,6 +687,8 @@ static void BM_MYSQL_Read_Join(benchmark::State& state, bool transactions) {
 	}
 	auto db = conn.getSchema("bench");
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT *";
@@ -574,6 +696,7 @@ static void BM_MYSQL_Read_Join(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(1));
 		query += ";";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -586,6 +709,7 @@ static void BM_MYSQL_Read_Join(benchmark::State& state, bool transactions) {
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -636,18 +760,29 @@ static void BM_MYSQL_Read_Join_Manual(benchmark::State& state, bool	transactions
 		}
 	}
 	auto db = conn.getSchema("bench");
-	uint64_t count = 0;
+	size_t limit = state.range(1);
+	JoinAlgorithm algorithm = static_cast<JoinAlgorithm>(state.range(3));
+	// (_id, a0) of the outer rows and (_id, a1) of the inner rows
+	vector<pair<int32_t, int32_t>> batch;
+	vector<pair<int32_t, int32_t>> inner;
+	// (outer _id, inner _id) of every joined pair
+	vector<pair<int32_t, int32_t>> results;
+	HashJoin<int32_t> hashJoin;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT *";
 		string query = selectclause + " FROM bench.read_bench";
 		query += " LIMIT " + to_string(state.range(1));
 		query += ";";
-		vector<mysqlx::Row> batch;
+		batch.clear();
 		batch.reserve(state.range(2));
-		vector<pair<mysqlx::Row, vector<mysqlx::Row>>> results;
+		hashJoin.Reserve(state.range(2));
+		results.clear();
 		results.reserve(state.range(1));
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -656,40 +791,60 @@ static void BM_MYSQL_Read_Join_Manual(benchmark::State& state, bool	transactions
             string selectclause = "SELECT *";
             string query = selectclause + " FROM bench.read_bench WHERE	";
             bool first = true;
-            for(auto querydoc: batch) {
-                vector<mysqlx::Row> a;
-                results.push_back(make_pair(querydoc, a));
+            for(auto& outer: batch) {
                 if(!first)
                     query += " OR ";
-                query += " (a1 = " + to_string(querydoc.get(1).get<uint32_t>()) + " AND _id != " + to_string(querydoc.get(0).get<uint32_t>());
+                query += " (a1 = " + to_string(outer.second) + " AND _id != " + to_string(outer.first);
                 query += ") ";
                 first = false;
             }
             query += " LIMIT " + to_string(state.range(1));
             query += ";";
             auto cursorinternal = conn.sql(query).execute();
-            for(auto row: cursorinternal) {
-                for(auto res: results) {
-                    if(res.first.get(1).get<uint32_t>() == row.get(0).get<uint32_t>()) {
-                        res.second.push_back(row);
-                        ++count;
+            // Joins on inner.a1 = outer.a0, the _id != predicate is applied again since
+            // the OR of the batch can bring in a row through another outer row's term
+            if(algorithm == JoinAlgorithm::Hash) {
+                hashJoin.Clear();
+                for(auto& outer: batch) {
+                    hashJoin.Insert(outer.second);
+                }
+                for(auto row: cursorinternal) {
+                    int32_t id = row.get(0).get<int>();
+                    hashJoin.Probe(row.get(2).get<int>(), [&](size_t outer) {
+                        if(batch[outer].first == id || results.size() >= limit)
+                            return false;
+                        results.emplace_back(batch[outer].first, id);
+                        return true;
+                    });
+                    if(results.size() >= limit)
                         break;
-                    }
                 }
-                if(count >= state.range(1))
-                    break;
+            } else {
+                inner.clear();
+                for(auto row: cursorinternal) {
+                    inner.emplace_back(row.get(0).get<int>(), row.get(2).get<int>());
+                }
+                SortMergeJoin(batch, inner,
+                        [](const pair<int32_t, int32_t>& o) { return o.second; },
+                        [](const pair<int32_t, int32_t>& i) { return i.second; },
+                        [&](const pair<int32_t, int32_t>& o, const pair<int32_t, int32_t>& i) {
+                            if(o.first == i.first || results.size() >= limit)
+                                return false;
+                            results.emplace_back(o.first, i.first);
+                            return true;
+                        });
             }
             batch.clear();
         };
 
 		auto res = conn.sql(query).execute();
-		for(auto i: res) {
-			batch.push_back(i);
+		for(auto row: res) {
+			batch.emplace_back(row.get(0).get<int>(), row.get(1).get<int>());
 			// Our batch is ready...
 			if(batch.size() == state.range(2)) {
                 batchQueryProc();
 			}
-			if(count >= state.range(1))
+			if(results.size() >= limit)
 				break;
 		}
 
@@ -701,6 +856,7 @@ static void BM_MYSQL_Read_Join_Manual(benchmark::State& state, bool	transactions
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -726,8 +882,9 @@ static void BM_MYSQL_Read_Join_Manual(benchmark::State& state, bool	transactions
 	// by the duration of the benchmark, and the result inverted.
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-	state.counters.insert({{"Indexes", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Batch", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+	state.counters.insert({{"Indexes", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Batch", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Join", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	state.SetLabel(JoinAlgorithmName(static_cast<JoinAlgorithm>(state.range(3))));
 }
 
-BENCHMARK_CAPTURE(BM_MYSQL_Read_Join_Manual, Normal, false)->Apply(CustomArgumentsInserts6)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
-BENCHMARK_CAPTURE(BM_MYSQL_Read_Join_Manual, Transact, true)->Apply(CustomArgumentsInserts6)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_MYSQL_Read_Join_Manual, Normal, false)->Apply(CustomArgumentsInserts7)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_MYSQL_Read_Join_Manual, Transact, true)->Apply(CustomArgumentsInserts7)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -1,6 +1,9 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/mysqldb/mysqldb.hpp"
 #include "mysqlx/devapi/document.h"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 #include "precalculate.hpp"
 
 #include <random>
@@ -10,20 +13,40 @@
 using namespace std;
 
 static void CustomArgumentsUpdates(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 1; j <= Precalculator::Columns; ++j) { // fields to write
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
 			for (int k = 0; k <= i; ++k) { //  Indexes
-				b->Args({i, j, k});
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
 			}
 		}
 	}
 }
 
 static void CustomArgumentsUpdates2(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 1; j <= Precalculator::Columns; ++j) { // fields to write
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
 			for (int k = 0; k <= j; ++k) { //  Indexes
-				b->Args({i, j, k});
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
+			}
+		}
+	}
+}
+
+// Keyed batches of changes: batch size, fields changed and how many of them
+// are indexed, with every bulk update method and key distribution
+static void CustomArgumentsBulkUpdates(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= 10000 && i <= (int64_t)Precalculator::Rows(); i *= 10) { // Changes per batch
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
+			for (int k = 0; k <= j; ++k) { //  Indexes on the written fields
+				for (int l = 0; l <= 1; ++l) { // Bulk update method
+					for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+						b->Args({i, j, k, l, d});
+					}
+				}
 			}
 		}
 	}
@@ -42,11 +65,11 @@ CREATE TABLE update_bench (
 	_id  INT AUTO_INCREMENT,
 	a0 INT,
 )|";
-		for(int field = 1; field < Precalculator::Columns; ++field) {
+		for(int field = 1; field < Precalculator::Columns(); ++field) {
 			createQuery.append("a" + to_string(field) + " INT,");
 		}
 		if(doublefields) {
-			for(int field = 0; field < Precalculator::Columns; ++field) {
+			for(int field = 0; field < Precalculator::Columns(); ++field) {
 				createQuery.append("b" + to_string(field) + " INT,");
 			}
 		}
@@ -59,17 +82,16 @@ CREATE TABLE update_bench (
 		auto table = db.getTable("update_bench");
 
 		int batchsize = 10000;
-		for(int i = 0; i < Precalculator::Rows; i += batchsize) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += batchsize) {
 			auto tableInsert = table.insert();
-			for(int j = 0; j < batchsize && i+j < Precalculator::Rows;++j) {
+			for(int j = 0; j < batchsize && i+j < Precalculator::Rows();++j) {
 				mysqlx::Row row;
 				row.set(0, mysqlx::nullvalue);
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 1; f <= Precalculator::Columns; ++f) {
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 1; f <= Precalculator::Columns(); ++f) {
 					row.set(f, rowval[f-1]);
 					if(doublefields)
-						row.set(f+Precalculator::Columns, rowval[f-1]);
+						row.set(f+Precalculator::Columns(), rowval[f-1]);
 				}
 				tableInsert.rows(row);
 			}
@@ -77,6 +99,8 @@ CREATE TABLE update_bench (
 		}
 		auto end = chrono::steady_clock::now();
 		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("mysql", "update_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("mysql", [&] { return MySQLDBHandler::ServerInfo(conn); });
 		cout.flush();
 	}
 	created = true;
@@ -86,7 +110,7 @@ static void BM_MYSQL_Update(benchmark::State& state, bool transactions, bool tes
 	auto conn = MySQLDBHandler::GetConnection();	
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(3), 5);
 	std::uniform_int_distribution<> dis2(1,100);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
@@ -131,6 +155,8 @@ static void BM_MYSQL_Update(benchmark::State& state, bool transactions, bool tes
 	auto db = conn.getSchema("bench");
 	auto table = db.getTable("update_bench");
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 
@@ -147,6 +173,7 @@ static void BM_MYSQL_Update(benchmark::State& state, bool transactions, bool tes
 			tableUpdate.set(field, mysqlx::expr(field + " + " + to_string(dis2(gen))));
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		if(transactions) {
 			conn.startTransaction();
@@ -156,6 +183,7 @@ static void BM_MYSQL_Update(benchmark::State& state, bool transactions, bool tes
 			conn.commit();
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -181,9 +209,132 @@ static void BM_MYSQL_Update(benchmark::State& state, bool transactions, bool tes
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"FieldsQueried", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsChanged", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_MYSQL_Update, Normal, false, false)->Apply(CustomArgumentsUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MYSQL_Update, Transact, true, false)->Apply(CustomArgumentsUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MYSQL_Update, NormalWriteIdx, false, true)->Apply(CustomArgumentsUpdates2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_MYSQL_Update, TransactWriteIdx, true, true)->Apply(CustomArgumentsUpdates2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+// How BM_MYSQL_Update_Bulk applies a batch of keyed changes
+enum class BulkUpdate {
+	Upsert = 0, // INSERT ... VALUES ... ON DUPLICATE KEY UPDATE
+	Join = 1    // UPDATE ... JOIN (VALUES ROW(...), ...)
+};
+
+// Sets the first fields b columns of a batch of rows picked by their _id, all
+// in one statement with the changes in its text, as an ETL job applying
+// keyed changes would. The keys of a batch are sorted and each is sent once,
+// so concurrent batches lock their rows in the same order; the deadlocks and
+// lock wait timeouts left are counted as Conflicts instead of failing the run.
+static void BM_MYSQL_Update_Bulk(benchmark::State& state, bool transactions) {
+	auto conn = MySQLDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	KeyDistribution keys = Precalculator::QueryKeys(state.range(4), Precalculator::Rows());
+	std::uniform_int_distribution<> dis2(1,100);
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn, true);
+		try {
+			conn.sql("DROP INDEX idx ON bench.update_bench;").execute();
+		}catch(...) {
+		}
+		try {
+			conn.sql("DROP INDEX idx2 ON bench.update_bench;").execute();
+		}catch(...) {
+		}
+		if(state.range(2) > 0) {
+			string indexCreate = "CREATE INDEX idx2 on bench.update_bench (b0";
+			for(int index = 1; index < state.range(2); ++index) {
+				indexCreate += ",b" + to_string(index);
+			}
+			indexCreate += ") ALGORITHM INPLACE;";
+			conn.sql(indexCreate).execute();
+		}
+	}
+	const int batch = state.range(0), fields = state.range(1);
+	auto method = (BulkUpdate)state.range(3);
+	string prefix, suffix, row;
+	if(method == BulkUpdate::Upsert) {
+		prefix = "INSERT INTO bench.update_bench (_id,b0";
+		suffix = " ON DUPLICATE KEY UPDATE b0 = VALUES(b0)";
+		for(int i = 1; i < fields; ++i) {
+			prefix += ",b" + to_string(i);
+			suffix += ",b" + to_string(i) + " = VALUES(b" + to_string(i) + ")";
+		}
+		prefix += ") VALUES ";
+		suffix += ";";
+		row = "(";
+	} else {
+		prefix = "UPDATE bench.update_bench u JOIN (VALUES ";
+		string columns = "id,b0", set = "u.b0 = v.b0";
+		for(int i = 1; i < fields; ++i) {
+			columns += ",b" + to_string(i);
+			set += ",u.b" + to_string(i) + " = v.b" + to_string(i);
+		}
+		suffix = ") AS v (" + columns + ") ON u._id = v.id SET " + set + ";";
+		row = "ROW(";
+	}
+	int64_t changes = 0, conflicts = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return MySQLDBHandler::ServerStats(conn); });
+	for(auto _ : state) {
+		state.PauseTiming();
+		auto batchKeys = keys.Batch(gen, batch);
+		string query = prefix;
+		for(size_t n = 0; n < batchKeys.size(); ++n) {
+			query += (n == 0 ? row : "," + row) + to_string(batchKeys[n] + 1);
+			for(int i = 0; i < fields; ++i) {
+				query += "," + to_string(dis2(gen));
+			}
+			query += ")";
+		}
+		query += suffix;
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		try {
+			if(transactions) {
+				conn.startTransaction();
+			}
+			conn.sql(query).execute();
+			if(transactions) {
+				conn.commit();
+			}
+			changes += batchKeys.size();
+		} catch(mysqlx::Error& e) {
+			// The X DevAPI has no error codes, only the server's message
+			string message = e.what();
+			if(message.find("Deadlock") == string::npos && message.find("Lock wait timeout") == string::npos)
+				throw;
+			++conflicts;
+			if(transactions) {
+				conn.rollback();
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	state.SetComplexityN(state.range(0));
+	// The changes committed, a key drawn more than once in a batch counts once.
+	// The affected rows of an upsert would count its updates twice.
+	state.SetItemsProcessed(changes);
+	state.counters["Conflicts"] = conflicts;
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Batch", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsChanged", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Method", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, keys);
+}
+
+BENCHMARK_CAPTURE(BM_MYSQL_Update_Bulk, Normal, false)->Apply(CustomArgumentsBulkUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_MYSQL_Update_Bulk, Transact, true)->Apply(CustomArgumentsBulkUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
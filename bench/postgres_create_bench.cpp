@@ -1,12 +1,19 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/postgresql/postgresql.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 
+#include <libpq-fe.h>
 #include <pqxx/nontransaction.hxx>
 #include <pqxx/result.hxx>
 #include <pqxx/transaction_base.hxx>
+#include <algorithm>
 #include <random>
 #include <iostream>
 #include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 
 using namespace std;
 
@@ -25,43 +32,51 @@ static void CustomArgumentsInserts(benchmark::internal::Benchmark* b) {
 	}
 }
 
-static void BM_PQXX_Insert(benchmark::State& state, bool transactions) {
-	auto conn = PostgreSQLDBHandler::GetConnection();
-	std::random_device rd;  //Will be used to obtain a seed for the random number engine
-	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, (1 << 16));
-	// Per thread settings...
-	if(state.thread_index() == 0) {
-		// This is the first thread, so do initialization here, build indexes etc...
-		try{
-			PostgreSQLDBHandler::CreateDatabase(conn, "bench");
-		} catch(...) {
+// Drops and creates bench.create_bench with fields INT columns a0.. and an
+// index on each of the first indexes of them
+static void CreateTable(std::shared_ptr<pqxx::connection> conn, int fields, int indexes) {
+	try{
+		PostgreSQLDBHandler::CreateDatabase(conn, "bench");
+	} catch(...) {
 
-		}
-		PostgreSQLDBHandler::DropTable(conn, "bench", "create_bench");
-		string createQuery = R"|(
+	}
+	PostgreSQLDBHandler::DropTable(conn, "bench", "create_bench");
+	string createQuery = R"|(
 CREATE TABLE create_bench (
 	_id  serial PRIMARY KEY,
 )|";
-		for(int field = 0; field < state.range(1); ++field) {
-			createQuery.append("a" + to_string(field) + " INT");
-			if(field != state.range(1) - 1)
-				createQuery.append(",\r\n");
-		}
-		createQuery.append(R"|(
+	for(int field = 0; field < fields; ++field) {
+		createQuery.append("a" + to_string(field) + " INT");
+		if(field != fields - 1)
+			createQuery.append(",\r\n");
+	}
+	createQuery.append(R"|(
 );
 )|");
-		{
+	{
+		pqxx::nontransaction N(*conn);
+		pqxx::result R(N.exec(createQuery));
+	}
+	if(indexes > 0) {
+		for(int index = 0; index < indexes; ++index) {
 			pqxx::nontransaction N(*conn);
-			pqxx::result R(N.exec(createQuery));
-		}
-		if(state.range(2) > 0) {
-			for(int index = 0; index < state.range(2); ++index) {
-				pqxx::nontransaction N(*conn);
-				pqxx::result R(N.exec("CREATE INDEX field" + to_string(index) + " ON bench.create_bench\r\n(a" + to_string(index) + ");"));
-			}
+			pqxx::result R(N.exec("CREATE INDEX field" + to_string(index) + " ON bench.create_bench\r\n(a" + to_string(index) + ");"));
 		}
 	}
+}
+
+static void BM_PQXX_Insert(benchmark::State& state, bool transactions) {
+	auto conn = PostgreSQLDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	std::uniform_int_distribution<> dis(0, (1 << 16));
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn, state.range(1), state.range(2));
+	}
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string query = "INSERT INTO bench.create_bench VALUES\r\n";
@@ -77,6 +92,7 @@ CREATE TABLE create_bench (
 			}
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -94,6 +110,7 @@ CREATE TABLE create_bench (
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -123,3 +140,253 @@ CREATE TABLE create_bench (
 
 BENCHMARK_CAPTURE(BM_PQXX_Insert, Normal, false)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_PQXX_Insert, Transact, true)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+// How BM_PQXX_Insert_Strategy writes the rows
+enum class InsertStrategy {
+	Values = 0,        // One multi-row INSERT ... VALUES string, like BM_PQXX_Insert
+	Prepared = 1,      // A prepared single row INSERT per row
+	PreparedMulti = 2, // Prepared multi-row INSERTs of as many rows as the parameters allow
+	Unnest = 3,        // A prepared INSERT ... SELECT of the unnest() of an array per field
+	CopyText = 4,      // COPY FROM STDIN in the text format
+	CopyBinary = 5     // COPY FROM STDIN in the binary format
+};
+
+// The grid of CustomArgumentsInserts with every insert strategy
+static void CustomArgumentsStrategies(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= (1 << 12); i*=8) { // Documents
+		for (int j = 1; j <= 16; j *= 2) { // Fields
+			for(int k = 0; k <= j; ) { // Indexes
+				for(int l = (int)InsertStrategy::Values; l <= (int)InsertStrategy::CopyBinary; ++l) { // Insert strategy
+					b->Args({i, j, k, l});
+				}
+				if(k == 0) {
+					k = 1;
+				} else {
+					k *= 2;
+				}
+			}
+		}
+	}
+}
+
+// The most parameters one statement can bind
+static const int MaxParameters = 65535;
+
+// "INSERT INTO bench.create_bench (a0,..) VALUES ($first,..),.." of rows rows
+static string PreparedInsert(int rows, int fields) {
+	string insert = "INSERT INTO bench.create_bench (a0";
+	for(int field = 1; field < fields; ++field) {
+		insert += ",a" + to_string(field);
+	}
+	insert += ") VALUES ";
+	int parameter = 1;
+	for(int row = 0; row < rows; ++row) {
+		insert += row == 0 ? "(" : ",(";
+		for(int field = 0; field < fields; ++field) {
+			insert += (field == 0 ? "$" : ",$") + to_string(parameter++);
+		}
+		insert += ")";
+	}
+	return insert;
+}
+
+// Appends value to a binary COPY in network byte order
+template <typename T>
+static void AppendBinary(string& copy, T value) {
+	for(int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+		copy.push_back((char)((value >> shift) & 0xff));
+	}
+}
+
+// Runs a statement on a libpq connection, throws its error if it fails
+static void Exec(PGconn* pg, const string& sql) {
+	unique_ptr<PGresult, decltype(&PQclear)> res(PQexec(pg, sql.c_str()), &PQclear);
+	if(PQresultStatus(res.get()) != PGRES_COMMAND_OK)
+		throw runtime_error(PQerrorMessage(pg));
+}
+
+// Sends data, the rows of the COPY FROM STDIN statement copy, in one go.
+// pqxx has no binary COPY, so both formats go through libpq.
+static void Copy(PGconn* pg, const string& copy, const string& data) {
+	{
+		unique_ptr<PGresult, decltype(&PQclear)> res(PQexec(pg, copy.c_str()), &PQclear);
+		if(PQresultStatus(res.get()) != PGRES_COPY_IN)
+			throw runtime_error(PQerrorMessage(pg));
+	}
+	if(PQputCopyData(pg, data.data(), (int)data.size()) != 1 || PQputCopyEnd(pg, nullptr) != 1)
+		throw runtime_error(PQerrorMessage(pg));
+	bool copied = true;
+	while(PGresult* res = PQgetResult(pg)) {
+		copied = copied && PQresultStatus(res) == PGRES_COMMAND_OK;
+		PQclear(res);
+	}
+	if(!copied)
+		throw runtime_error(PQerrorMessage(pg));
+}
+
+// The rows of BM_PQXX_Insert written the way the last argument says. The
+// statements and payloads of an iteration are built while the timing is
+// paused, like the query string of BM_PQXX_Insert.
+static void BM_PQXX_Insert_Strategy(benchmark::State& state, bool transactions) {
+	auto conn = PostgreSQLDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	std::uniform_int_distribution<> dis(0, (1 << 16));
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn, state.range(1), state.range(2));
+	}
+	const int rows = state.range(0), fields = state.range(1);
+	auto strategy = (InsertStrategy)state.range(3);
+	string columns = "a0";
+	for(int field = 1; field < fields; ++field) {
+		columns += ",a" + to_string(field);
+	}
+	// The multi-row INSERTs take as many rows as fit, the rest goes last
+	const int chunk = min(rows, MaxParameters / fields);
+	if(strategy == InsertStrategy::Prepared) {
+		conn->prepare("insert_row", PreparedInsert(1, fields));
+	} else if(strategy == InsertStrategy::PreparedMulti) {
+		conn->prepare("insert_rows", PreparedInsert(chunk, fields));
+		if(rows % chunk != 0)
+			conn->prepare("insert_rest", PreparedInsert(rows % chunk, fields));
+	} else if(strategy == InsertStrategy::Unnest) {
+		string unnest = "INSERT INTO bench.create_bench (" + columns + ") SELECT * FROM unnest($1::int[]";
+		for(int field = 1; field < fields; ++field) {
+			unnest += ",$" + to_string(field + 1) + "::int[]";
+		}
+		conn->prepare("insert_unnest", unnest + ")");
+	}
+	unique_ptr<PGconn, decltype(&PQfinish)> pg(nullptr, &PQfinish);
+	string copy = "COPY bench.create_bench (" + columns + ") FROM STDIN";
+	if(strategy == InsertStrategy::CopyText || strategy == InsertStrategy::CopyBinary) {
+		pg.reset(PQconnectdb(conn->connection_string().c_str()));
+		if(PQstatus(pg.get()) != CONNECTION_OK)
+			throw runtime_error(PQerrorMessage(pg.get()));
+		if(strategy == InsertStrategy::CopyBinary)
+			copy += " (FORMAT binary)";
+	}
+	vector<int> values(rows * fields);
+	string payload;
+	vector<pqxx::params> parameters;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
+	for(auto _ : state) {
+		state.PauseTiming();
+		for(auto& value : values) {
+			value = dis(gen);
+		}
+		payload.clear();
+		parameters.clear();
+		switch(strategy) {
+			case InsertStrategy::Values:
+				payload = "INSERT INTO bench.create_bench VALUES\r\n";
+				for(int n = 0; n < rows; ++n) {
+					payload.append(n == 0 ? "	(DEFAULT" : ",\r\n	(DEFAULT");
+					for(int field = 0; field < fields; ++field) {
+						payload.append("," + to_string(values[n * fields + field]));
+					}
+					payload.append(")");
+				}
+				payload.append(";");
+				break;
+			case InsertStrategy::Prepared:
+			case InsertStrategy::PreparedMulti: {
+				int perStatement = strategy == InsertStrategy::Prepared ? 1 : chunk;
+				for(int n = 0; n < rows; ++n) {
+					if(n % perStatement == 0)
+						parameters.emplace_back();
+					for(int field = 0; field < fields; ++field) {
+						parameters.back().append(values[n * fields + field]);
+					}
+				}
+				break;
+			}
+			case InsertStrategy::Unnest:
+				parameters.emplace_back();
+				for(int field = 0; field < fields; ++field) {
+					string array = "{";
+					for(int n = 0; n < rows; ++n) {
+						array += (n == 0 ? "" : ",") + to_string(values[n * fields + field]);
+					}
+					parameters.back().append(array + "}");
+				}
+				break;
+			case InsertStrategy::CopyText:
+				for(int n = 0; n < rows; ++n) {
+					for(int field = 0; field < fields; ++field) {
+						payload += to_string(values[n * fields + field]) + (field == fields - 1 ? "\n" : "\t");
+					}
+				}
+				break;
+			case InsertStrategy::CopyBinary:
+				payload.append("PGCOPY\n\377\r\n\0", 11);
+				AppendBinary<int32_t>(payload, 0); // Flags
+				AppendBinary<int32_t>(payload, 0); // Header extension
+				for(int n = 0; n < rows; ++n) {
+					AppendBinary<int16_t>(payload, fields);
+					for(int field = 0; field < fields; ++field) {
+						AppendBinary<int32_t>(payload, sizeof(int32_t));
+						AppendBinary<int32_t>(payload, values[n * fields + field]);
+					}
+				}
+				AppendBinary<int16_t>(payload, -1);
+				break;
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		if(pg) {
+			if(transactions)
+				Exec(pg.get(), "BEGIN;");
+			Copy(pg.get(), copy, payload);
+			if(transactions)
+				Exec(pg.get(), "COMMIT;");
+		} else {
+			pqxx::transaction_base* T = nullptr;
+			if(transactions) {
+				T = new pqxx::work(*conn);
+			} else {
+				T = new pqxx::nontransaction(*conn);
+			}
+			if(strategy == InsertStrategy::Values) {
+				T->exec(payload);
+			} else if(strategy == InsertStrategy::Unnest) {
+				T->exec_prepared("insert_unnest", parameters[0]);
+			} else if(strategy == InsertStrategy::Prepared) {
+				for(auto& row : parameters) {
+					T->exec_prepared("insert_row", row);
+				}
+			} else {
+				for(size_t p = 0; p < parameters.size(); ++p) {
+					bool rest = p == parameters.size() - 1 && rows % chunk != 0;
+					T->exec_prepared(rest ? "insert_rest" : "insert_rows", parameters[p]);
+				}
+			}
+			T->commit();
+			delete T;
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	if(state.thread_index() == 0) {
+		PostgreSQLDBHandler::DropTable(conn, "bench", "create_bench");
+		// This is the first thread, so do destruction here (delete documents etc..)
+	}
+
+	state.SetComplexityN(state.range(0));
+	state.counters["Ops"] = benchmark::Counter(state.iterations()*state.range(0), benchmark::Counter::kIsRate);
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations()*state.range(0), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Documents", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Fields", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Strategy", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK_CAPTURE(BM_PQXX_Insert_Strategy, Normal, false)->Apply(CustomArgumentsStrategies)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_PQXX_Insert_Strategy, Transact, true)->Apply(CustomArgumentsStrategies)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
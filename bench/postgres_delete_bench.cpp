@@ -1,5 +1,8 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/postgresql/postgresql.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 #include "precalculate.hpp"
 
 #include <random>
@@ -9,9 +12,11 @@
 using namespace std;
 
 static void CustomArgumentsDeletes(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
 		for (int j = 0; j <= i; ++j) { //  Indexes
-			b->Args({i, j});
+			for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+				b->Args({i, j, d});
+			}
 		}
 	}
 }
@@ -32,9 +37,9 @@ static void CreateTable(std::shared_ptr<pqxx::connection> conn, std::string post
 CREATE TABLE )|" + string("delete_bench")+postfix + R"|( (
 	_id  serial PRIMARY KEY,
 )|";
-		for(int field = 0; field < Precalculator::Columns; ++field) {
+		for(int field = 0; field < Precalculator::Columns(); ++field) {
 			createQuery.append("a" + to_string(field) + " INT");
-			if(field != Precalculator::Columns-1)
+			if(field != Precalculator::Columns()-1)
 				createQuery.append(",\r\n");
 		}
 		createQuery.append(R"|(
@@ -47,16 +52,15 @@ CREATE TABLE )|" + string("delete_bench")+postfix + R"|( (
 		
 		int batchsize = 10000;
 
-		for(int i = 0; i < Precalculator::Rows; i += batchsize) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += batchsize) {
 			string query = "INSERT INTO bench.delete_bench" + postfix + " VALUES\r\n";
-			for(int j = 0; j < batchsize && i+j < Precalculator::Rows;++j) {
+			for(int j = 0; j < batchsize && i+j < Precalculator::Rows();++j) {
 				query.append("	(DEFAULT");
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 0; f < Precalculator::Columns; ++f) {
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 0; f < Precalculator::Columns(); ++f) {
 					query.append("," + to_string(rowval[f]));
 				}
-				if((j != batchsize - 1) && j+i != Precalculator::Rows-1) {
+				if((j != batchsize - 1) && j+i != Precalculator::Rows()-1) {
 					query.append("),");
 				} else {
 					query.append(");");
@@ -67,6 +71,8 @@ CREATE TABLE )|" + string("delete_bench")+postfix + R"|( (
 		}
 		auto end = chrono::steady_clock::now();
 		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("postgres", "delete_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("postgres", [&] { return PostgreSQLDBHandler::ServerInfo(conn); });
 		cout.flush();
 		created[postfix] = true;
 	}
@@ -77,7 +83,7 @@ static void BM_PQXX_Delete(benchmark::State& state, bool transactions) {
 	string postfix = std::to_string(state.thread_index());
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(2), 5);
 	// Per thread settings...
 		// This is the first thread, so do initialization here, build indexes etc...
 	CreateTable(conn, postfix);
@@ -97,6 +103,8 @@ static void BM_PQXX_Delete(benchmark::State& state, bool transactions) {
 		pqxx::result R(N.exec(indexCreate));
 	}
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string query = "SELECT * FROM bench.delete_bench"+postfix;
@@ -116,6 +124,7 @@ static void BM_PQXX_Delete(benchmark::State& state, bool transactions) {
 		query = "DELETE FROM bench.delete_bench"+postfix;
 		query += whereclause;
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -135,6 +144,7 @@ static void BM_PQXX_Delete(benchmark::State& state, bool transactions) {
 		}
         state.PauseTiming();
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -179,6 +189,7 @@ static void BM_PQXX_Delete(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_PQXX_Delete, Normal, false)->Apply(CustomArgumentsDeletes)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
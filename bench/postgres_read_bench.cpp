@@ -1,5 +1,10 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/postgresql/postgresql.hpp"
+#include "dbphd/join/clientjoin.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
+#include "benchstream.hpp"
 #include "precalculate.hpp"
 
 #include <random>
@@ -9,19 +14,23 @@
 using namespace std;
 
 static void CustomArgumentsInserts(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
 		for (int j = 0; j <= i; ++j) { //  Indexes
-			b->Args({i, j});
+			for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+				b->Args({i, j, d});
+			}
 		}
 	}
 }
 
 static void CustomArgumentsInserts2(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 0; j <= Precalculator::Columns; ++j) { // fields to return
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 0; j <= Precalculator::Columns(); ++j) { // fields to return
 			for (int k = 0; k <= i; ++k) { //  Indexes
-				for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns-i); l *= 2) { // Documents to return
-					b->Args({i, j, k, l});
+				for(int64_t l = 1; l <= (int64_t)Precalculator::Matching(i); l *= 2) { // Documents to return
+					for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+						b->Args({i, j, k, l, d});
+					}
 				}
 			}
 		}
@@ -29,15 +38,15 @@ static void CustomArgumentsInserts2(benchmark::internal::Benchmark* b) {
 }
 
 static void CustomArgumentsInserts3(benchmark::internal::Benchmark* b) {
-	for (int i = 1; i <= Precalculator::Rows; i *= 2) { // documents to process
+	for (int64_t i = 1; i <= (int64_t)Precalculator::Rows(); i *= 2) { // documents to process
 		b->Args({i});
 	}
 }
 
 static void CustomArgumentsInserts4(benchmark::internal::Benchmark* b) {
-	for (int i = 1; i <= Precalculator::Columns; ++i) { // fields to sort
+	for (int i = 1; i <= Precalculator::Columns(); ++i) { // fields to sort
 		for (int k = 0; k <= i; ++k) { //  Indexes
-			for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns); l *= 2) { // Documents to return
+			for(int64_t l = 1; l <= (int64_t)Precalculator::Rows(); l *= 2) { // Documents to return
 				b->Args({i, k, l});
 			}
 		}
@@ -46,7 +55,7 @@ static void CustomArgumentsInserts4(benchmark::internal::Benchmark* b) {
 
 static void CustomArgumentsInserts5(benchmark::internal::Benchmark* b) {
 	for (int i = 0; i <= 2; ++i) { // fields to index
-		for(int l = 1; l <= (int)pow(Precalculator::Values,Precalculator::Columns); l *= 2) { // Documents to return
+		for(int64_t l = 1; l <= (int64_t)Precalculator::Rows(); l *= 2) { // Documents to return
 			b->Args({i, l});
 		}
 	}
@@ -54,7 +63,7 @@ static void CustomArgumentsInserts5(benchmark::internal::Benchmark* b) {
 
 static void CustomArgumentsInserts6(benchmark::internal::Benchmark* b) {
 	for (int i = 0; i <= 2; ++i) { // fields to index
-		for(int j = 1; j <= (int)pow(Precalculator::Values,Precalculator::Columns); j *= 2) { // Documents to return
+		for(int64_t j = 1; j <= (int64_t)Precalculator::Rows(); j *= 2) { // Documents to return
 			for(int k = 1; k < 8192; k *= 2) { // Documents to query for batch
 				b->Args({i, j, k});
 			}
@@ -62,6 +71,29 @@ static void CustomArgumentsInserts6(benchmark::internal::Benchmark* b) {
 	}
 }
 
+static void CustomArgumentsInserts7(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= 2; ++i) { // fields to index
+		for(int64_t j = 1; j <= (int64_t)Precalculator::Rows(); j *= 2) { // Documents to return
+			for(int k = 1; k <= j; k *= 2) { // Documents to query for batch, more than returned is the same batch
+				for(int l = (int)JoinAlgorithm::Hash; l <= (int)JoinAlgorithm::SortMerge; ++l) { // Client join algorithm
+					b->Args({i, j, k, l});
+				}
+			}
+		}
+	}
+}
+
+// Large results, fetched whole or a batch at a time
+static void CustomArgumentsStream(benchmark::internal::Benchmark* b) {
+	for(int64_t l = 100; l <= (int64_t)Precalculator::Rows(); l *= 10) { // Rows to return
+		b->Args({l, 0, 0}); // The whole result at once
+		for(int64_t batch = 100; batch <= 10000; batch *= 10) { // Rows per FETCH
+			b->Args({l, 1, batch});
+		}
+		b->Args({l, 2, 0}); // COPY, a row at a time
+	}
+}
+
 static void CreateTable(std::shared_ptr<pqxx::connection> conn) {
 	static volatile bool created = false;
 	if(!created) {
@@ -78,9 +110,9 @@ static void CreateTable(std::shared_ptr<pqxx::connection> conn) {
 CREATE TABLE read_bench (
 	_id  serial PRIMARY KEY,
 )|";
-		for(int field = 0; field < Precalculator::Columns; ++field) {
+		for(int field = 0; field < Precalculator::Columns(); ++field) {
 			createQuery.append("a" + to_string(field) + " INT");
-			if(field != Precalculator::Columns-1)
+			if(field != Precalculator::Columns()-1)
 				createQuery.append(",\r\n");
 		}
 		createQuery.append(R"|(
@@ -93,16 +125,15 @@ CREATE TABLE read_bench (
 		
 		int batchsize = 10000;
 
-		for(int i = 0; i < Precalculator::Rows; i += batchsize) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += batchsize) {
 			string query = "INSERT INTO bench.read_bench VALUES\r\n";
-			for(int j = 0; j < batchsize && i+j < Precalculator::Rows;++j) {
+			for(int j = 0; j < batchsize && i+j < Precalculator::Rows();++j) {
 				query.append("	(DEFAULT");
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 0; f < Precalculator::Columns; ++f) {
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 0; f < Precalculator::Columns(); ++f) {
 					query.append("," + to_string(rowval[f]));
 				}
-				if((j != batchsize - 1) && j+i != Precalculator::Rows-1) {
+				if((j != batchsize - 1) && j+i != Precalculator::Rows()-1) {
 					query.append("),");
 				} else {
 					query.append(");");
@@ -113,6 +144,8 @@ CREATE TABLE read_bench (
 		}
 		auto end = chrono::steady_clock::now();
 		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("postgres", "read_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("postgres", [&] { return PostgreSQLDBHandler::ServerInfo(conn); });
 		cout.flush();
 	}
 	created = true;
@@ -122,7 +155,7 @@ static void BM_PQXX_Read_Count(benchmark::State& state, bool transactions) {
 	auto conn = PostgreSQLDBHandler::GetConnection();
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(2), 5);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
 		// This is the first thread, so do initialization here, build indexes etc...
@@ -133,7 +166,7 @@ static void BM_PQXX_Read_Count(benchmark::State& state, bool transactions) {
             pqxx::result R(N.exec(query));
         }catch(...) {
         }
-		for(int index = 0; index < 8; ++index) {
+		for(int index = 0; index < Precalculator::Columns(); ++index) {
             try {
                 string query = "DROP INDEX IF EXISTS bench.read_bench_idx_a" + to_string(index) + ";";
                 pqxx::nontransaction N(*conn);
@@ -152,6 +185,8 @@ static void BM_PQXX_Read_Count(benchmark::State& state, bool transactions) {
 		}
 	}
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string query = "SELECT COUNT(*) FROM bench.read_bench";
@@ -162,6 +197,7 @@ static void BM_PQXX_Read_Count(benchmark::State& state, bool transactions) {
 			}
 		}
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -180,6 +216,7 @@ static void BM_PQXX_Read_Count(benchmark::State& state, bool transactions) {
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -205,6 +242,7 @@ static void BM_PQXX_Read_Count(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_PQXX_Read_Count, Normal, false)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -214,7 +252,7 @@ static void BM_PQXX_Reads(benchmark::State& state, bool transactions) {
 	auto conn = PostgreSQLDBHandler::GetConnection();
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(4), 5);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
 		// This is the first thread, so do initialization here, build indexes etc...
@@ -225,7 +263,7 @@ static void BM_PQXX_Reads(benchmark::State& state, bool transactions) {
             pqxx::result R(N.exec(query));
         }catch(...) {
         }
-		for(int index = 0; index < 8; ++index) {
+		for(int index = 0; index < Precalculator::Columns(); ++index) {
             try {
                 string query = "DROP INDEX IF EXISTS bench.read_bench_idx_a" + to_string(index) + ";";
                 pqxx::nontransaction N(*conn);
@@ -244,6 +282,8 @@ static void BM_PQXX_Reads(benchmark::State& state, bool transactions) {
 		}
 	}
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT _id";
@@ -260,6 +300,7 @@ static void BM_PQXX_Reads(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(3));
 		query += ";";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -279,6 +320,7 @@ static void BM_PQXX_Reads(benchmark::State& state, bool transactions) {
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -304,11 +346,92 @@ static void BM_PQXX_Reads(benchmark::State& state, bool transactions) {
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsProj", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_PQXX_Reads, Normal, false)->Apply(CustomArgumentsInserts2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_PQXX_Reads, Transact, true)->Apply(CustomArgumentsInserts2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 
+// Every column of the first rows, fetched as one pqxx::result (0), from a
+// server side cursor a batch of rows at a time (1) or streamed with COPY
+// through pqxx::stream_from (2). The a columns are converted and summed like
+// the fields the MongoDB variant decodes.
+static void BM_PQXX_Read_Stream(benchmark::State& state) {
+	auto conn = PostgreSQLDBHandler::GetConnection();
+	if(state.thread_index() == 0) {
+		CreateTable(conn);
+	}
+	string query = "SELECT _id";
+	for(int i = 0; i < Precalculator::Columns(); ++i) {
+		query += ",a" + to_string(i);
+	}
+	// No ; for COPY
+	query += " FROM bench.read_bench LIMIT " + to_string(state.range(0));
+	string fetch = "FETCH FORWARD " + to_string(state.range(2)) + " FROM read_stream;";
+	uint64_t count = 0;
+	int64_t checksum = 0;
+	PerfIterations perfIterations(state);
+	StreamStatistics streamStats(state);
+	for(auto _ : state) {
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		streamStats.start(start);
+		// Cursors and COPY need a transaction
+		pqxx::work W(*conn);
+		if(state.range(1) == 0) {
+			auto res = W.exec(query + ";");
+			for(auto row: res) {
+				streamStats.row();
+				for(int f = 1; f <= Precalculator::Columns(); ++f) {
+					checksum += row[f].as<int>();
+				}
+				++count;
+			}
+		} else if(state.range(1) == 1) {
+			W.exec("DECLARE read_stream NO SCROLL CURSOR FOR " + query + ";");
+			while(true) {
+				auto res = W.exec(fetch);
+				if(res.empty())
+					break;
+				for(auto row: res) {
+					streamStats.row();
+					for(int f = 1; f <= Precalculator::Columns(); ++f) {
+						checksum += row[f].as<int>();
+					}
+					++count;
+				}
+			}
+			W.exec("CLOSE read_stream;");
+		} else {
+			auto stream = pqxx::stream_from::query(W, query);
+			while(auto fields = stream.read_row()) {
+				streamStats.row();
+				for(int f = 1; f <= Precalculator::Columns(); ++f) {
+					checksum += pqxx::from_string<int>((*fields)[f]);
+				}
+				++count;
+			}
+			stream.complete();
+		}
+		W.commit();
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	benchmark::DoNotOptimize(checksum);
+	state.SetComplexityN(state.range(0));
+	state.SetItemsProcessed(count);
+	state.counters.insert({{"Limit", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Fetch", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Batch", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK(BM_PQXX_Read_Stream)->Apply(CustomArgumentsStream)->DenseThreadRange(1, 8, 2)->UseManualTime();
+
 static void BM_PQXX_Read_Sum(benchmark::State& state, bool transactions) {
 	auto conn = PostgreSQLDBHandler::GetConnection();
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
@@ -324,7 +447,7 @@ static void BM_PQXX_Read_Sum(benchmark::State& state, bool transactions) {
             pqxx::result R(N.exec(query));
         }catch(...) {
         }
-		for(int index = 0; index < 8; ++index) {
+		for(int index = 0; index < Precalculator::Columns(); ++index) {
             try {
                 string query = "DROP INDEX IF EXISTS bench.read_bench_idx_a" + to_string(index) + ";";
                 pqxx::nontransaction N(*conn);
@@ -333,6 +456,8 @@ static void BM_PQXX_Read_Sum(benchmark::State& state, bool transactions) {
             }
         }
 	}
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT SUM(new.a0)";
@@ -340,6 +465,7 @@ static void BM_PQXX_Read_Sum(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(0));
 		query += ") new;";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -358,6 +484,7 @@ static void BM_PQXX_Read_Sum(benchmark::State& state, bool transactions) {
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -403,7 +530,7 @@ static void BM_PQXX_Read_Avg(benchmark::State& state, bool transactions) {
             pqxx::result R(N.exec(query));
         }catch(...) {
         }
-		for(int index = 0; index < 8; ++index) {
+		for(int index = 0; index < Precalculator::Columns(); ++index) {
             try {
                 string query = "DROP INDEX IF EXISTS bench.read_bench_idx_a" + to_string(index) + ";";
                 pqxx::nontransaction N(*conn);
@@ -412,6 +539,8 @@ static void BM_PQXX_Read_Avg(benchmark::State& state, bool transactions) {
             }
         }
 	}
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT AVG(new.a0)";
@@ -419,6 +548,7 @@ static void BM_PQXX_Read_Avg(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(0));
 		query += ") new;";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -437,6 +567,7 @@ static void BM_PQXX_Read_Avg(benchmark::State& state, bool transactions) {
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -482,7 +613,7 @@ static void BM_PQXX_Read_Mul(benchmark::State& state, bool transactions) {
             pqxx::result R(N.exec(query));
         }catch(...) {
         }
-		for(int index = 0; index < 8; ++index) {
+		for(int index = 0; index < Precalculator::Columns(); ++index) {
             try {
                 string query = "DROP INDEX IF EXISTS bench.read_bench_idx_a" + to_string(index) + ";";
                 pqxx::nontransaction N(*conn);
@@ -491,6 +622,8 @@ static void BM_PQXX_Read_Mul(benchmark::State& state, bool transactions) {
             }
         }
 	}
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT a0*2";
@@ -498,6 +631,7 @@ static void BM_PQXX_Read_Mul(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(0));
 		query += ";";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -516,6 +650,7 @@ static void BM_PQXX_Read_Mul(benchmark::State& state, bool transactions) {
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -572,6 +707,8 @@ static void BM_PQXX_Read_Sort(benchmark::State& state, bool transactions) {
 		}
 	}
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT _id";
@@ -585,6 +722,7 @@ static void BM_PQXX_Read_Sort(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(2));
 		query += ";";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -604,6 +742,7 @@ static void BM_PQXX_Read_Sort(benchmark::State& state, bool transactions) {
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -649,7 +788,7 @@ static void BM_PQXX_Read_Join(benchmark::State& state, bool transactions) {
             pqxx::result R(N.exec(query));
         }catch(...) {
         }
-		for(int index = 0; index < 8; ++index) {
+		for(int index = 0; index < Precalculator::Columns(); ++index) {
             try {
                 string query = "DROP INDEX IF EXISTS bench.read_bench_idx_a" + to_string(index) + ";";
                 pqxx::nontransaction N(*conn);
@@ -665,6 +804,8 @@ static void BM_PQXX_Read_Join(benchmark::State& state, bool transactions) {
 		}
 	}
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT *";
@@ -672,6 +813,7 @@ static void BM_PQXX_Read_Join(benchmark::State& state, bool transactions) {
 		query += " LIMIT " + to_string(state.range(1));
 		query += ";";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -692,6 +834,7 @@ static void BM_PQXX_Read_Join(benchmark::State& state, bool transactions) {
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -738,7 +881,7 @@ static void BM_PQXX_Read_Join_Manual(benchmark::State& state, bool transactions)
             pqxx::result R(N.exec(query));
         }catch(...) {
         }
-		for(int index = 0; index < 8; ++index) {
+		for(int index = 0; index < Precalculator::Columns(); ++index) {
             try {
                 string query = "DROP INDEX IF EXISTS bench.read_bench_idx_a" + to_string(index) + ";";
                 pqxx::nontransaction N(*conn);
@@ -753,18 +896,29 @@ static void BM_PQXX_Read_Join_Manual(benchmark::State& state, bool transactions)
 			pqxx::result R(N.exec(indexCreate));
 		}
 	}
-	uint64_t count = 0;
+	size_t limit = state.range(1);
+	JoinAlgorithm algorithm = static_cast<JoinAlgorithm>(state.range(3));
+	// (_id, a0) of the outer rows and (_id, a1) of the inner rows
+	vector<pair<int32_t, int32_t>> batch;
+	vector<pair<int32_t, int32_t>> inner;
+	// (outer _id, inner _id) of every joined pair
+	vector<pair<int32_t, int32_t>> results;
+	HashJoin<int32_t> hashJoin;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string selectclause = "SELECT *";
 		string query = selectclause + " FROM bench.read_bench";
 		query += " LIMIT " + to_string(state.range(1));
 		query += ";";
-		vector<pqxx::row> batch;
+		batch.clear();
 		batch.reserve(state.range(2));
-		vector<pair<pqxx::row, vector<pqxx::row>>> results;
+		hashJoin.Reserve(state.range(2));
+		results.clear();
 		results.reserve(state.range(1));
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -779,40 +933,64 @@ static void BM_PQXX_Read_Join_Manual(benchmark::State& state, bool transactions)
             string selectclause = "SELECT *";
             string query = selectclause + " FROM bench.read_bench WHERE	";
             bool first = true;
-            for(auto querydoc: batch) {
-                vector<pqxx::row> a;
-                results.push_back(make_pair(querydoc, a));
+            for(auto& outer: batch) {
                 if(!first)
                     query += " OR ";
-                query += " (a1 = " + to_string(querydoc.at("a0").as<uint64_t>()) + " AND _id != " + querydoc.at("_id").c_str();
+                query += " (a1 = " + to_string(outer.second) + " AND _id != " + to_string(outer.first);
                 query += ") ";
                 first = false;
             }
             query += " LIMIT " + to_string(state.range(1));
             query += ";";
             auto cursorinternal = T->exec(query);
-            for(auto row: cursorinternal) {
-                for(auto res: results) {
-                    if(res.first.at("a0") == row.at("a0")) {
-                        res.second.push_back(row);
-                        ++count;
+            auto idColumn = cursorinternal.column_number("_id");
+            auto keyColumn = cursorinternal.column_number("a1");
+            // Joins on inner.a1 = outer.a0, the _id != predicate is applied again since
+            // the OR of the batch can bring in a row through another outer row's term
+            if(algorithm == JoinAlgorithm::Hash) {
+                hashJoin.Clear();
+                for(auto& outer: batch) {
+                    hashJoin.Insert(outer.second);
+                }
+                for(auto row: cursorinternal) {
+                    int32_t id = row[idColumn].as<int32_t>();
+                    hashJoin.Probe(row[keyColumn].as<int32_t>(), [&](size_t outer) {
+                        if(batch[outer].first == id || results.size() >= limit)
+                            return false;
+                        results.emplace_back(batch[outer].first, id);
+                        return true;
+                    });
+                    if(results.size() >= limit)
                         break;
-                    }
                 }
-                if(count >= state.range(1))
-                    break;
+            } else {
+                inner.clear();
+                for(auto row: cursorinternal) {
+                    inner.emplace_back(row[idColumn].as<int32_t>(), row[keyColumn].as<int32_t>());
+                }
+                SortMergeJoin(batch, inner,
+                        [](const pair<int32_t, int32_t>& o) { return o.second; },
+                        [](const pair<int32_t, int32_t>& i) { return i.second; },
+                        [&](const pair<int32_t, int32_t>& o, const pair<int32_t, int32_t>& i) {
+                            if(o.first == i.first || results.size() >= limit)
+                                return false;
+                            results.emplace_back(o.first, i.first);
+                            return true;
+                        });
             }
             batch.clear();
         };
 
 		auto res = T->exec(query);
-		for(auto i: res) {
-			batch.push_back(i);
+		auto idColumn = res.column_number("_id");
+		auto keyColumn = res.column_number("a0");
+		for(auto row: res) {
+			batch.emplace_back(row[idColumn].as<int32_t>(), row[keyColumn].as<int32_t>());
 			// Our batch is ready...
 			if(batch.size() == state.range(2)) {
                 batchQueryProc();
 			}
-			if(count >= state.range(1))
+			if(results.size() >= limit)
 				break;
 		}
 
@@ -827,6 +1005,7 @@ static void BM_PQXX_Read_Join_Manual(benchmark::State& state, bool transactions)
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -852,8 +1031,9 @@ static void BM_PQXX_Read_Join_Manual(benchmark::State& state, bool transactions)
 	// by the duration of the benchmark, and the result inverted.
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-	state.counters.insert({{"Indexes", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Batch", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+	state.counters.insert({{"Indexes", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Batch", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Join", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	state.SetLabel(JoinAlgorithmName(static_cast<JoinAlgorithm>(state.range(3))));
 }
 
-BENCHMARK_CAPTURE(BM_PQXX_Read_Join_Manual, Normal, false)->Apply(CustomArgumentsInserts6)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
-BENCHMARK_CAPTURE(BM_PQXX_Read_Join_Manual, Transact, true)->Apply(CustomArgumentsInserts6)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_PQXX_Read_Join_Manual, Normal, false)->Apply(CustomArgumentsInserts7)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_PQXX_Read_Join_Manual, Transact, true)->Apply(CustomArgumentsInserts7)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -1,6 +1,14 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/postgresql/postgresql.hpp"
+#include "dbphd/perf/affinity.hpp"
 #include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpcbackend.hpp"
+#include "dbphd/tpc/tpcpacing.hpp"
+#include "dbphd/tpc/tpcconflicts.hpp"
+#include "dbphd/tpc/tpcphases.hpp"
+#include "dbphd/tpc/tpcsnapshot.hpp"
+#include "tpccdriver.hpp"
+#include "tpccreport.hpp"
 
 using namespace tpcc;
 
@@ -10,7 +18,10 @@ using namespace tpcc;
 #include <fmt/chrono.h>
 #include <fmt/core.h>
 #include <iostream>
+#include <memory>
+#include <map>
 #include <omp.h>
+#include <optional>
 #include <pqxx/nontransaction.hxx>
 #include <pqxx/result.hxx>
 #include <pqxx/transaction_base.hxx>
@@ -22,164 +33,9 @@ using namespace tpcc;
 //#define PRINT_TRACE
 using namespace std;
 
-static void LoadBenchmark(std::shared_ptr<pqxx::connection> conn,
-                          ScaleParameters &params, int warehouses, int clients) {
-    static volatile bool created = false;
-    static ScaleParameters oldParams = ScaleParameters::makeDefault(1);
-    static volatile int oldclients = 0;
-    if (created && oldParams == params && clients == oldclients)
-        return;
-    created = false;
-    oldParams = params;
-    oldclients = clients;
-    cout << endl
-         << "Creating Postgres old TPC-C Tables with " << omp_get_num_procs()
-         << " threads ..." << endl;
-    cout.flush();
-    auto start = chrono::steady_clock::now();
-    try {
-        PostgreSQLDBHandler::CreateDatabase(conn, "bench");
-    } catch (...) {
-    }
-    PostgreSQLDBHandler::DropTable(conn, "bench", "new_order");
-    PostgreSQLDBHandler::DropTable(conn, "bench", "history");
-    PostgreSQLDBHandler::DropTable(conn, "bench", "order_line");
-    PostgreSQLDBHandler::DropTable(conn, "bench", "\"order\"");
-    PostgreSQLDBHandler::DropTable(conn, "bench", "stock");
-    PostgreSQLDBHandler::DropTable(conn, "bench", "item");
-    PostgreSQLDBHandler::DropTable(conn, "bench", "customer");
-    PostgreSQLDBHandler::DropTable(conn, "bench", "district");
-    PostgreSQLDBHandler::DropTable(conn, "bench", "warehouse");
-    string createQuery = R"|(
-CREATE TABLE warehouse (
-	w_id integer PRIMARY KEY DEFAULT '1' NOT NULL,
-	w_name VARCHAR(10) NOT NULL,
-	w_street_1 VARCHAR(20) NOT NULL,
-	w_street_2 VARCHAR(20) NOT NULL,
-	w_city VARCHAR(20) NOT NULL,
-	w_state VARCHAR(2) NOT NULL,
-	w_zip VARCHAR(9) NOT NULL,
-	w_tax numeric(4,4) NOT NULL,
-	w_ytd numeric(12,2) NOT NULL
-);
-
-CREATE TABLE "district" (
-  "d_w_id" integer NOT NULL,
-  "d_next_o_id" integer NOT NULL,
-  "d_id" SMALLINT NOT NULL,
-  "d_ytd" numeric(12,2) NOT NULL,
-  "d_tax" numeric(4,4) NOT NULL,
-  "d_name" VARCHAR(10) NOT NULL,
-  "d_street_1" VARCHAR(20) NOT NULL,
-  "d_street_2" VARCHAR(20) NOT NULL,
-  "d_city" VARCHAR(20) NOT NULL,
-  "d_state" VARCHAR(2) NOT NULL,
-  "d_zip" VARCHAR(9) NOT NULL,
-  PRIMARY KEY ("d_w_id", "d_id")
-);
-
-CREATE TABLE "customer" (
-  "c_id" integer NOT NULL,
-  "c_w_id" integer NOT NULL,
-  "c_d_id" smallint NOT NULL,
-  "c_payment_cnt" numeric(4) NOT NULL,
-  "c_delivery_cnt" numeric(4) NOT NULL,
-  "c_first" VARCHAR(16) NOT NULL,
-  "c_middle" VARCHAR(2) NOT NULL,
-  "c_last" VARCHAR(16) NOT NULL,
-  "c_street_1" VARCHAR(20) NOT NULL,
-  "c_street_2" VARCHAR(20) NOT NULL,
-  "c_city" VARCHAR(20) NOT NULL,
-  "c_state" VARCHAR(2) NOT NULL,
-  "c_zip" VARCHAR(9) NOT NULL,
-  "c_phone" VARCHAR(16) NOT NULL,
-  "c_credit" VARCHAR(2) NOT NULL,
-  "c_credit_lim" numeric(12,2) NOT NULL,
-  "c_discount" numeric(4,4) NOT NULL,
-  "c_balance" numeric(12,2) NOT NULL,
-  "c_ytd_payment" numeric(12,2) NOT NULL,
-  "c_data" VARCHAR(500) NOT NULL,
-  "c_since" timestamp DEFAULT 'now' NOT NULL,
-  PRIMARY KEY ("c_w_id", "c_d_id", "c_id")
-);
-
-CREATE TABLE "history" (
-  "h_c_id" integer,
-  "h_c_w_id" integer NOT NULL,
-  "h_w_id" integer NOT NULL,
-  "h_c_d_id" smallint NOT NULL,
-  "h_d_id" smallint NOT NULL,
-  "h_amount" numeric(6,2) NOT NULL,
-  "h_data" varchar(24) NOT NULL,
-  "h_date" timestamp NOT NULL
-);
-
-CREATE TABLE "new_order" (
-  "no_w_id" integer NOT NULL,
-  "no_o_id" integer NOT NULL,
-  "no_d_id" smallint NOT NULL,
-  PRIMARY KEY ("no_w_id", "no_d_id", "no_o_id")
-);
-
-CREATE TABLE "order" (
-  "o_id" integer NOT NULL,
-  "o_w_id" integer NOT NULL,
-  "o_d_id" smallint NOT NULL,
-  "o_c_id" integer NOT NULL,
-  "o_carrier_id" smallint,
-  "o_ol_cnt" numeric(2) NOT NULL,
-  "o_all_local" numeric(1) NOT NULL,
-  "o_entry_d" timestamp default 'now' NOT NULL,
-  PRIMARY KEY ("o_w_id", "o_d_id", "o_id")
-);
-
-CREATE TABLE "order_line" (
-  "ol_o_id" integer NOT NULL,
-  "ol_w_id" integer NOT NULL,
-  "ol_d_id" smallint NOT NULL,
-  "ol_number" smallint NOT NULL,
-  "ol_i_id" integer NOT NULL,
-  "ol_supply_w_id" integer NOT NULL,
-  "ol_quantity" numeric(2) NOT NULL,
-  "ol_amount" numeric(6,2),
-  "ol_dist_info" varchar(24),
-  "ol_delivery_d" timestamp,
-  PRIMARY KEY ("ol_w_id", "ol_d_id", "ol_o_id", "ol_number")
-);
-
-CREATE TABLE "item" (
-  "i_id" integer PRIMARY KEY NOT NULL,
-  "i_im_id" integer NOT NULL,
-  "i_name" VARCHAR(24) NOT NULL,
-  "i_price" numeric(5,2) NOT NULL,
-  "i_data" VARCHAR(50) NOT NULL
-);
-
-CREATE TABLE "stock" (
-  "s_i_id" integer NOT NULL,
-  "s_w_id" integer NOT NULL,
-  "s_ytd" numeric(8) NOT NULL,
-  "s_quantity" numeric(4) NOT NULL,
-  "s_order_cnt" numeric(4) NOT NULL,
-  "s_remote_cnt" numeric(4) NOT NULL,
-  "s_dist_01" varchar(24) NOT NULL,
-  "s_dist_02" varchar(24) NOT NULL,
-  "s_dist_03" varchar(24) NOT NULL,
-  "s_dist_04" varchar(24) NOT NULL,
-  "s_dist_05" varchar(24) NOT NULL,
-  "s_dist_06" varchar(24) NOT NULL,
-  "s_dist_07" varchar(24) NOT NULL,
-  "s_dist_08" varchar(24) NOT NULL,
-  "s_dist_09" varchar(24) NOT NULL,
-  "s_dist_10" varchar(24) NOT NULL,
-  "s_data" varchar(50) NOT NULL,
-  PRIMARY KEY ("s_w_id", "s_i_id")
-);
-)|";
-    {
-        pqxx::nontransaction N(*conn);
-        pqxx::result R(N.exec(createQuery));
-    }
+// Generates the warehouses of params, each OpenMP thread loading its share
+// over its own connection, and the items when loadItems
+static void PopulateBenchmark(ScaleParameters &params, int clients, bool loadItems) {
     // Use clients to scale loading too
     vector<vector<int>> w_ids;
     w_ids.resize(omp_get_num_procs());
@@ -197,13 +53,17 @@ CREATE TABLE "stock" (
     const static int BATCH_SIZE = 500;
 #pragma omp parallel private(threadId) num_threads(omp_get_num_procs())
     {
+        // Placed like the terminals, and unpinned again at the end of the region
+        // because OpenMP keeps its threads for later regions
+        perf::ScopedAffinity pinned(perf::workerCpus(omp_get_thread_num()));
+        seedLoader(omp_get_thread_num());
         auto pgconn = PostgreSQLDBHandler::GetConnection();
         threadId = omp_get_thread_num();
 #ifdef PRINT_BENCH_GEN
         cout << "Thread: " << threadId << endl;
 #endif
         // Need to load items...
-        if (threadId == 0) {
+        if (threadId == 0 && loadItems) {
             auto originalRows =
                 randomHelper.uniqueIds(params.items / 10, 1, params.items);
             std::vector<Item> items;
@@ -628,6 +488,282 @@ CREATE TABLE "stock" (
             }
         } // Warehouse
     }     // Per thread/client
+}
+
+// Copied into a snapshot and restored from it, in the order of the foreign keys
+static const vector<string> tpccTables = {"warehouse", "district", "customer", "history",
+                                          "new_order", "order", "order_line", "item", "stock"};
+
+// What the transactions of a run change, put back from the snapshot schema {0}
+// of the loaded dataset. The orders, order lines, new orders and payments of
+// the run are range deleted above the load-time marks of the snapshot (the
+// next order id of each district and the date of its latest payment), the new
+// orders the run delivered are inserted again and only the rows whose changed
+// columns differ from the snapshot are updated back.
+static const char *RESET_QUERY = R"|(
+DELETE FROM bench.history WHERE h_date > (SELECT max(h_date) FROM {0}.history);
+DELETE FROM bench.new_order n USING {0}.district d
+  WHERE n.no_w_id = d.d_w_id AND n.no_d_id = d.d_id AND n.no_o_id >= d.d_next_o_id;
+DELETE FROM bench.order_line l USING {0}.district d
+  WHERE l.ol_w_id = d.d_w_id AND l.ol_d_id = d.d_id AND l.ol_o_id >= d.d_next_o_id;
+DELETE FROM bench."order" o USING {0}.district d
+  WHERE o.o_w_id = d.d_w_id AND o.o_d_id = d.d_id AND o.o_id >= d.d_next_o_id;
+INSERT INTO bench.new_order SELECT * FROM {0}.new_order ON CONFLICT DO NOTHING;
+UPDATE bench."order" o SET o_carrier_id = NULL FROM {0}."order" s
+  WHERE o.o_w_id = s.o_w_id AND o.o_d_id = s.o_d_id AND o.o_id = s.o_id
+  AND s.o_carrier_id IS NULL AND o.o_carrier_id IS NOT NULL;
+UPDATE bench.order_line l SET ol_delivery_d = NULL FROM {0}.order_line s
+  WHERE l.ol_w_id = s.ol_w_id AND l.ol_d_id = s.ol_d_id AND l.ol_o_id = s.ol_o_id
+  AND l.ol_number = s.ol_number AND s.ol_delivery_d IS NULL AND l.ol_delivery_d IS NOT NULL;
+UPDATE bench.customer c SET (c_balance, c_ytd_payment, c_payment_cnt, c_delivery_cnt, c_data) =
+  (s.c_balance, s.c_ytd_payment, s.c_payment_cnt, s.c_delivery_cnt, s.c_data)
+  FROM {0}.customer s
+  WHERE c.c_w_id = s.c_w_id AND c.c_d_id = s.c_d_id AND c.c_id = s.c_id
+  AND (c.c_payment_cnt, c.c_delivery_cnt) IS DISTINCT FROM (s.c_payment_cnt, s.c_delivery_cnt);
+UPDATE bench.stock t SET (s_quantity, s_ytd, s_order_cnt, s_remote_cnt) =
+  (s.s_quantity, s.s_ytd, s.s_order_cnt, s.s_remote_cnt)
+  FROM {0}.stock s
+  WHERE t.s_w_id = s.s_w_id AND t.s_i_id = s.s_i_id AND t.s_order_cnt <> s.s_order_cnt;
+UPDATE bench.district t SET (d_next_o_id, d_ytd) = (s.d_next_o_id, s.d_ytd) FROM {0}.district s
+  WHERE t.d_w_id = s.d_w_id AND t.d_id = s.d_id
+  AND (t.d_next_o_id, t.d_ytd) IS DISTINCT FROM (s.d_next_o_id, s.d_ytd);
+UPDATE bench.warehouse t SET w_ytd = s.w_ytd FROM {0}.warehouse s
+  WHERE t.w_id = s.w_id AND t.w_ytd <> s.w_ytd;
+)|";
+
+// Puts the loaded dataset back the way it was loaded before the next run, so
+// repeated runs start from the same data. Without a snapshot the data of the
+// earlier runs stays.
+static void ResetBenchmark(std::shared_ptr<pqxx::connection> conn, const string &key) {
+    if (!snapshotsEnabled())
+        return;
+    auto start = chrono::steady_clock::now();
+    if (!PostgreSQLDBHandler::ResetTables(conn, key, fmt::format(RESET_QUERY, key))) {
+        cout << "No snapshot of " << key << " to reset to" << endl;
+        return;
+    }
+    auto end = chrono::steady_clock::now();
+    cout << "Reset Postgres old TPC-C Tables in "
+         << chrono::duration<double, milli>(end - start).count() << " ms" << endl;
+    report::RunReport::global().recordLoad(
+        "postgres", "tpcc_old_reset", chrono::duration<double, milli>(end - start).count());
+}
+
+// Adds the warehouses after the loaded ones, or deletes the surplus ones (with
+// the payments of their customers), leaving the items alone, and snapshots the
+// result as the resized dataset key, so later runs are reset to it. Order lines
+// of the remaining warehouses supplied by a deleted one are supplied locally
+// instead, so every order keeps its o_ol_cnt lines and amounts.
+static void ResizeBenchmark(std::shared_ptr<pqxx::connection> conn, const ScaleParameters &loaded,
+                            ScaleParameters &params, int clients, const string &key) {
+    cout << endl
+         << "Resizing Postgres old TPC-C Tables from " << loaded.endingWarehouse << " to "
+         << params.endingWarehouse << " warehouses ..." << endl;
+    auto start = chrono::steady_clock::now();
+    if (params.endingWarehouse > loaded.endingWarehouse) {
+        auto added = warehouseRange(params, loaded.endingWarehouse + 1, params.endingWarehouse);
+        PopulateBenchmark(added, clients, false);
+    } else {
+        string last = to_string(params.endingWarehouse);
+        pqxx::work W(*conn);
+        W.exec0("DELETE FROM bench.new_order WHERE no_w_id > " + last);
+        W.exec0("DELETE FROM bench.order_line WHERE ol_w_id > " + last);
+        W.exec0("UPDATE bench.order_line SET ol_supply_w_id = ol_w_id WHERE ol_supply_w_id > " +
+                last);
+        W.exec0("DELETE FROM bench.history WHERE h_w_id > " + last + " OR h_c_w_id > " + last);
+        W.exec0("DELETE FROM bench.\"order\" WHERE o_w_id > " + last);
+        W.exec0("DELETE FROM bench.customer WHERE c_w_id > " + last);
+        W.exec0("DELETE FROM bench.stock WHERE s_w_id > " + last);
+        W.exec0("DELETE FROM bench.district WHERE d_w_id > " + last);
+        W.exec0("DELETE FROM bench.warehouse WHERE w_id > " + last);
+        W.commit();
+    }
+    if (snapshotsEnabled())
+        PostgreSQLDBHandler::SnapshotTables(conn, "bench", key, tpccTables);
+    auto end = chrono::steady_clock::now();
+    cout << " Done in " << chrono::duration<double, milli>(end - start).count()
+         << " ms" << endl
+         << endl;
+    report::RunReport::global().recordLoad(
+        "postgres", "tpcc_old_resize", chrono::duration<double, milli>(end - start).count());
+}
+
+static void LoadBenchmark(std::shared_ptr<pqxx::connection> conn,
+                          ScaleParameters &params, int warehouses, int clients) {
+    // The data stays for runs that only change the number of terminals, reset
+    // to the way it was loaded
+    static optional<DatasetKey> loaded;
+    DatasetKey dataset{"postgres", "old", params, loadSeed()};
+    string key = dataset.name();
+    if (loaded && loaded->sameScale(dataset)) {
+        ResetBenchmark(conn, loaded->name());
+        return;
+    }
+    if (loaded && loaded->resizesTo(dataset)) {
+        ResetBenchmark(conn, loaded->name());
+        dataset.resized = true;
+        ResizeBenchmark(conn, loaded->params, params, clients, dataset.name());
+        loaded = dataset;
+        return;
+    }
+    loaded.reset();
+    cout << endl
+         << "Creating Postgres old TPC-C Tables with " << omp_get_num_procs()
+         << " threads ..." << endl;
+    cout.flush();
+    auto start = chrono::steady_clock::now();
+    try {
+        PostgreSQLDBHandler::CreateDatabase(conn, "bench");
+    } catch (...) {
+    }
+    PostgreSQLDBHandler::DropTable(conn, "bench", "new_order");
+    PostgreSQLDBHandler::DropTable(conn, "bench", "history");
+    PostgreSQLDBHandler::DropTable(conn, "bench", "order_line");
+    PostgreSQLDBHandler::DropTable(conn, "bench", "\"order\"");
+    PostgreSQLDBHandler::DropTable(conn, "bench", "stock");
+    PostgreSQLDBHandler::DropTable(conn, "bench", "item");
+    PostgreSQLDBHandler::DropTable(conn, "bench", "customer");
+    PostgreSQLDBHandler::DropTable(conn, "bench", "district");
+    PostgreSQLDBHandler::DropTable(conn, "bench", "warehouse");
+    string createQuery = R"|(
+CREATE TABLE warehouse (
+	w_id integer PRIMARY KEY DEFAULT '1' NOT NULL,
+	w_name VARCHAR(10) NOT NULL,
+	w_street_1 VARCHAR(20) NOT NULL,
+	w_street_2 VARCHAR(20) NOT NULL,
+	w_city VARCHAR(20) NOT NULL,
+	w_state VARCHAR(2) NOT NULL,
+	w_zip VARCHAR(9) NOT NULL,
+	w_tax numeric(4,4) NOT NULL,
+	w_ytd numeric(12,2) NOT NULL
+);
+
+CREATE TABLE "district" (
+  "d_w_id" integer NOT NULL,
+  "d_next_o_id" integer NOT NULL,
+  "d_id" SMALLINT NOT NULL,
+  "d_ytd" numeric(12,2) NOT NULL,
+  "d_tax" numeric(4,4) NOT NULL,
+  "d_name" VARCHAR(10) NOT NULL,
+  "d_street_1" VARCHAR(20) NOT NULL,
+  "d_street_2" VARCHAR(20) NOT NULL,
+  "d_city" VARCHAR(20) NOT NULL,
+  "d_state" VARCHAR(2) NOT NULL,
+  "d_zip" VARCHAR(9) NOT NULL,
+  PRIMARY KEY ("d_w_id", "d_id")
+);
+
+CREATE TABLE "customer" (
+  "c_id" integer NOT NULL,
+  "c_w_id" integer NOT NULL,
+  "c_d_id" smallint NOT NULL,
+  "c_payment_cnt" numeric(4) NOT NULL,
+  "c_delivery_cnt" numeric(4) NOT NULL,
+  "c_first" VARCHAR(16) NOT NULL,
+  "c_middle" VARCHAR(2) NOT NULL,
+  "c_last" VARCHAR(16) NOT NULL,
+  "c_street_1" VARCHAR(20) NOT NULL,
+  "c_street_2" VARCHAR(20) NOT NULL,
+  "c_city" VARCHAR(20) NOT NULL,
+  "c_state" VARCHAR(2) NOT NULL,
+  "c_zip" VARCHAR(9) NOT NULL,
+  "c_phone" VARCHAR(16) NOT NULL,
+  "c_credit" VARCHAR(2) NOT NULL,
+  "c_credit_lim" numeric(12,2) NOT NULL,
+  "c_discount" numeric(4,4) NOT NULL,
+  "c_balance" numeric(12,2) NOT NULL,
+  "c_ytd_payment" numeric(12,2) NOT NULL,
+  "c_data" VARCHAR(500) NOT NULL,
+  "c_since" timestamp DEFAULT 'now' NOT NULL,
+  PRIMARY KEY ("c_w_id", "c_d_id", "c_id")
+);
+
+CREATE TABLE "history" (
+  "h_c_id" integer,
+  "h_c_w_id" integer NOT NULL,
+  "h_w_id" integer NOT NULL,
+  "h_c_d_id" smallint NOT NULL,
+  "h_d_id" smallint NOT NULL,
+  "h_amount" numeric(6,2) NOT NULL,
+  "h_data" varchar(24) NOT NULL,
+  "h_date" timestamp NOT NULL
+);
+
+CREATE TABLE "new_order" (
+  "no_w_id" integer NOT NULL,
+  "no_o_id" integer NOT NULL,
+  "no_d_id" smallint NOT NULL,
+  PRIMARY KEY ("no_w_id", "no_d_id", "no_o_id")
+);
+
+CREATE TABLE "order" (
+  "o_id" integer NOT NULL,
+  "o_w_id" integer NOT NULL,
+  "o_d_id" smallint NOT NULL,
+  "o_c_id" integer NOT NULL,
+  "o_carrier_id" smallint,
+  "o_ol_cnt" numeric(2) NOT NULL,
+  "o_all_local" numeric(1) NOT NULL,
+  "o_entry_d" timestamp default 'now' NOT NULL,
+  PRIMARY KEY ("o_w_id", "o_d_id", "o_id")
+);
+
+CREATE TABLE "order_line" (
+  "ol_o_id" integer NOT NULL,
+  "ol_w_id" integer NOT NULL,
+  "ol_d_id" smallint NOT NULL,
+  "ol_number" smallint NOT NULL,
+  "ol_i_id" integer NOT NULL,
+  "ol_supply_w_id" integer NOT NULL,
+  "ol_quantity" numeric(2) NOT NULL,
+  "ol_amount" numeric(6,2),
+  "ol_dist_info" varchar(24),
+  "ol_delivery_d" timestamp,
+  PRIMARY KEY ("ol_w_id", "ol_d_id", "ol_o_id", "ol_number")
+);
+
+CREATE TABLE "item" (
+  "i_id" integer PRIMARY KEY NOT NULL,
+  "i_im_id" integer NOT NULL,
+  "i_name" VARCHAR(24) NOT NULL,
+  "i_price" numeric(5,2) NOT NULL,
+  "i_data" VARCHAR(50) NOT NULL
+);
+
+CREATE TABLE "stock" (
+  "s_i_id" integer NOT NULL,
+  "s_w_id" integer NOT NULL,
+  "s_ytd" numeric(8) NOT NULL,
+  "s_quantity" numeric(4) NOT NULL,
+  "s_order_cnt" numeric(4) NOT NULL,
+  "s_remote_cnt" numeric(4) NOT NULL,
+  "s_dist_01" varchar(24) NOT NULL,
+  "s_dist_02" varchar(24) NOT NULL,
+  "s_dist_03" varchar(24) NOT NULL,
+  "s_dist_04" varchar(24) NOT NULL,
+  "s_dist_05" varchar(24) NOT NULL,
+  "s_dist_06" varchar(24) NOT NULL,
+  "s_dist_07" varchar(24) NOT NULL,
+  "s_dist_08" varchar(24) NOT NULL,
+  "s_dist_09" varchar(24) NOT NULL,
+  "s_dist_10" varchar(24) NOT NULL,
+  "s_data" varchar(50) NOT NULL,
+  PRIMARY KEY ("s_w_id", "s_i_id")
+);
+)|";
+    {
+        pqxx::nontransaction N(*conn);
+        pqxx::result R(N.exec(createQuery));
+    }
+    bool restored =
+        snapshotsEnabled() && PostgreSQLDBHandler::RestoreTables(conn, key, "bench", tpccTables);
+    if (restored) {
+        cout << "Restored " << key << endl;
+    } else {
+        PopulateBenchmark(params, clients, true);
+        if (snapshotsEnabled())
+            PostgreSQLDBHandler::SnapshotTables(conn, "bench", key, tpccTables);
+    }
 
     cout << "Done populating, altering DB..." << endl;
 
@@ -659,11 +795,16 @@ ALTER TABLE "new_order" ADD FOREIGN KEY ("no_w_id", "no_d_id", "no_o_id") REFERE
         pqxx::nontransaction N(*conn);
         pqxx::result R(N.exec(alterQuery));
     }
-    created = true;
+    loaded = dataset;
     auto end = chrono::steady_clock::now();
     cout << " Done in " << chrono::duration<double, milli>(end - start).count()
          << " ms" << endl
          << endl;
+    report::RunReport::global().recordLoad(
+        "postgres", restored ? "tpcc_old_restore" : "tpcc_old",
+        chrono::duration<double, milli>(end - start).count());
+    report::RunReport::global().describeEngine("postgres",
+                                               [&] { return PostgreSQLDBHandler::ServerInfo(conn); });
 }
 
 static bool doDelivery(benchmark::State &state, ScaleParameters &params,
@@ -671,6 +812,7 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "DoDelivery" << endl;
 #endif
+    markPhase("DeliveryTXNNewOrder", Phase::Build);
     string newOrderQuery =
         fmt::format("SELECT * from bench.new_order WHERE no_d_id = {:d} AND "
                     "no_w_id = {:d} ORDER BY no_o_id ASC LIMIT 1;",
@@ -678,8 +820,10 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "noq" << endl;
 #endif
+    markPhase("DeliveryTXNNewOrder", Phase::Execute);
     pqxx::result no_result =
         transaction.exec(newOrderQuery, "DeliveryTXNNewOrder");
+    markPhase("DeliveryTXNNewOrder", Phase::Decode);
 
     if (no_result.size() == 0) {
         // No orders for this district. TODO report when >1%
@@ -694,6 +838,7 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
     int oId = no_result.front().at("no_o_id").as<int>();
     assert(oId >= 1);
 
+    markPhase("DeliveryTXNOrder", Phase::Build);
     string orderQuery = fmt::format(
         "SELECT o_c_id,o_id,o_d_id,o_w_id from bench.\"order\" WHERE o_d_id = "
         "{:d} AND o_w_id = {:d} AND o_id = {:d} LIMIT 1;",
@@ -702,9 +847,12 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "oq" << endl;
 #endif
+    markPhase("DeliveryTXNOrder", Phase::Execute);
     pqxx::row o_result = transaction.exec1(orderQuery, "DeliveryTXNOrder");
+    markPhase("DeliveryTXNOrder", Phase::Decode);
     int cId = o_result.at("o_c_id").as<int>();
 
+    markPhase("DeliveryTXNOrderLines", Phase::Build);
     string orderLinesQuery =
         fmt::format("SELECT ol_amount from bench.order_line WHERE ol_d_id = "
                     "{:d} AND ol_w_id = {:d} AND ol_o_id = {:d};",
@@ -713,14 +861,17 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "olq" << endl;
 #endif
+    markPhase("DeliveryTXNOrderLines", Phase::Execute);
     pqxx::result ol_result =
         transaction.exec(orderLinesQuery, "DeliveryTXNOrderLines");
+    markPhase("DeliveryTXNOrderLines", Phase::Decode);
     assert(ol_result.size() > 0);
     double total = 0;
     for (auto ol : ol_result) {
         total += ol.at("ol_amount").as<double>();
     }
 
+    markPhase("DeliveryTXNUpdateOrder", Phase::Build);
     string orderUpdate =
         fmt::format("UPDATE bench.\"order\" SET o_carrier_id = {:d} WHERE "
                     "o_d_id = {:d} AND o_w_id = {:d} AND o_id = {:d};",
@@ -728,10 +879,12 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "ouq" << endl;
 #endif
+    markPhase("DeliveryTXNUpdateOrder", Phase::Execute);
     pqxx::result o_update_result =
         transaction.exec(orderUpdate, "DeliveryTXNUpdateOrder");
     assert(o_update_result.affected_rows() == 1);
 
+    markPhase("DeliveryTXNUpdateOrderLines", Phase::Build);
     string orderLineUpdate = fmt::format(
         "UPDATE bench.order_line SET ol_delivery_d = '{:%Y-%m-%d %H:%M:%S}' "
         "WHERE ol_d_id = {:d} AND ol_w_id = {:d} AND ol_o_id = {:d};",
@@ -740,10 +893,12 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "oluq" << endl;
 #endif
+    markPhase("DeliveryTXNUpdateOrderLines", Phase::Execute);
     pqxx::result ol_update_result =
         transaction.exec(orderLineUpdate, "DeliveryTXNUpdateOrderLines");
     assert(ol_update_result.affected_rows() > 0);
 
+    markPhase("DeliveryTXNUpdateCust", Phase::Build);
     string custUpdate =
         fmt::format("UPDATE bench.customer SET c_balance = c_balance + {:f} "
                     "WHERE c_d_id = {:d} AND c_w_id = {:d} AND c_id = {:d};",
@@ -752,10 +907,12 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "cuq" << endl;
 #endif
+    markPhase("DeliveryTXNUpdateCust", Phase::Execute);
     pqxx::result cust_update_result =
         transaction.exec(custUpdate, "DeliveryTXNUpdateCust");
     assert(cust_update_result.affected_rows() == 1);
 
+    markPhase("DeliveryTXNNewOrderDelete", Phase::Build);
     string newOrderDelete =
         fmt::format("DELETE from bench.new_order WHERE no_d_id = {:d} AND "
                     "no_w_id = {:d} AND no_o_id = {:d};",
@@ -763,6 +920,7 @@ static bool doDelivery(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "nod" << endl;
 #endif
+    markPhase("DeliveryTXNNewOrderDelete", Phase::Execute);
     pqxx::result no_delete_result =
         transaction.exec0(newOrderDelete, "DeliveryTXNNewOrderDelete");
     assert(no_delete_result.affected_rows() == 1);
@@ -780,13 +938,16 @@ static bool doDeliveryN(benchmark::State &state, ScaleParameters &params,
 #endif
     DeliveryParams dparams;
     randomHelper.generateDeliveryParams(params, dparams);
+    markPhase("begin", Phase::Execute);
     pqxx::transaction<> transaction(*conn);
     for (int dId = 1; dId <= n; ++dId) {
         dparams.dId = dId;
+        markConflictKey(dparams.wId, dId);
         bool result = doDelivery(state, params, dparams, transaction);
         if (!result)
             return false;
     }
+    markPhase("commit", Phase::Execute);
     transaction.commit();
     return true;
 }
@@ -798,10 +959,12 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
 #endif
     OrderStatusParams osparams;
     randomHelper.generateOrderStatusParams(params, osparams);
+    markPhase("begin", Phase::Execute);
     pqxx::transaction<> transaction(*conn);
 
     pqxx::row customer;
     if (osparams.cId != INT32_MIN) {
+        markPhase("OrderStatusTXNCustById", Phase::Build);
         string custById = fmt::format(
             "SELECT c_id,c_first,c_middle,c_last,c_balance from bench.customer "
             "WHERE c_id = {:d} AND c_w_id = {:d} AND c_d_id = {:d};",
@@ -810,8 +973,11 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
         cout << "cqi" << endl;
 #endif
+        markPhase("OrderStatusTXNCustById", Phase::Execute);
         customer = transaction.exec1(custById, "OrderStatusTXNCustById");
+        markPhase("OrderStatusTXNCustById", Phase::Decode);
     } else {
+        markPhase("OrderStatusTXNCustByLastName", Phase::Build);
         string custByLastName = fmt::format(
             "SELECT c_id,c_first,c_middle,c_last,c_balance from bench.customer "
             "WHERE c_last = '{:s}' AND c_w_id = {:d} AND c_d_id = {:d} ORDER BY c_first;",
@@ -820,14 +986,17 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
         cout << "cql" << endl;
 #endif
+        markPhase("OrderStatusTXNCustByLastName", Phase::Execute);
         pqxx::result customers =
             transaction.exec(custByLastName, "OrderStatusTXNCustByLastName");
+        markPhase("OrderStatusTXNCustByLastName", Phase::Decode);
         assert(customers.size() > 0);
         int index = (customers.size() - 1) / 2;
         customer = customers[index];
     }
     int cId = customer.at("c_id").as<int>();
 
+    markPhase("OrderStatusTXNOrders", Phase::Build);
     string orderQuery =
         fmt::format("SELECT o_id,o_carrier_id,o_entry_d from bench.\"order\" "
                     "WHERE o_c_id = {:d} AND o_w_id = {:d} AND o_d_id = {:d} "
@@ -837,11 +1006,14 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "oq" << endl;
 #endif
+    markPhase("OrderStatusTXNOrders", Phase::Execute);
     pqxx::row order = transaction.exec1(orderQuery, "OrderStatusTXNOrders");
+    markPhase("OrderStatusTXNOrders", Phase::Decode);
     assert(!order.empty());
 
     int oId = order.at("o_id").as<int>();
 
+    markPhase("OrderStatusTXNOrderLines", Phase::Build);
     string orderLinesQuery = fmt::format(
         "SELECT ol_supply_w_id,ol_i_id,ol_quantity,ol_amount,ol_delivery_d "
         "from bench.order_line WHERE ol_d_id = {:d} AND ol_w_id = {:d} AND "
@@ -851,11 +1023,14 @@ static bool doOrderStatus(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "olq" << endl;
 #endif
+    markPhase("OrderStatusTXNOrderLines", Phase::Execute);
     pqxx::result ol_result =
         transaction.exec(orderLinesQuery, "OrderStatusTXNOrderLines");
+    markPhase("OrderStatusTXNOrderLines", Phase::Decode);
     assert(ol_result.size() > 0);
     // TODO actually return result... customer, order, orderlines
 
+    markPhase("commit", Phase::Execute);
     transaction.commit();
     return true;
 }
@@ -867,8 +1042,10 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #endif
     PaymentParams pparams;
     randomHelper.generatePaymentParams(params, pparams);
+    markPhase("begin", Phase::Execute);
     pqxx::transaction<> transaction(*conn);
 
+    markPhase("PaymentTXNUpdateDistrict", Phase::Build);
     string updateDistrict =
         fmt::format("UPDATE bench.district SET d_ytd = d_ytd + {:f} WHERE d_id "
                     "= {:d} AND d_w_id = {:d} RETURNING "
@@ -878,10 +1055,13 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "distq" << endl;
 #endif
+    markPhase("PaymentTXNUpdateDistrict", Phase::Execute);
     pqxx::row district =
         transaction.exec1(updateDistrict, "PaymentTXNUpdateDistrict");
+    markPhase("PaymentTXNUpdateDistrict", Phase::Decode);
     assert(!district.empty());
 
+    markPhase("PaymentTXNUpdateWarehouse", Phase::Build);
     string updateWarehouse = fmt::format(
         "UPDATE bench.warehouse SET w_ytd = w_ytd + {:f} WHERE w_id = {:d} "
         "RETURNING w_name,w_street_1,w_street_2,w_city,w_state,w_zip;",
@@ -890,12 +1070,15 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "whq" << endl;
 #endif
+    markPhase("PaymentTXNUpdateWarehouse", Phase::Execute);
     pqxx::row warehouse =
         transaction.exec1(updateWarehouse, "PaymentTXNUpdateWarehouse");
+    markPhase("PaymentTXNUpdateWarehouse", Phase::Decode);
     assert(!warehouse.empty());
 
     pqxx::row customer;
     if (pparams.cId != INT32_MIN) {
+        markPhase("PaymentTXNCustById", Phase::Build);
         string custById = fmt::format(
             "SELECT "
             "c_id,c_w_id,c_d_id,c_delivery_cnt,c_first,c_middle,c_last,c_"
@@ -907,8 +1090,11 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
         cout << "cqi" << endl;
 #endif
+        markPhase("PaymentTXNCustById", Phase::Execute);
         customer = transaction.exec1(custById, "PaymentTXNCustById");
+        markPhase("PaymentTXNCustById", Phase::Decode);
     } else {
+        markPhase("PaymentTXNCustByLastName", Phase::Build);
         string custByLastName = fmt::format(
             "SELECT "
             "c_id,c_w_id,c_d_id,c_delivery_cnt,c_first,c_middle,c_last,c_"
@@ -920,8 +1106,10 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
         cout << "cql" << endl;
 #endif
+        markPhase("PaymentTXNCustByLastName", Phase::Execute);
         pqxx::result customers =
             transaction.exec(custByLastName, "PaymentTXNCustByLastName");
+        markPhase("PaymentTXNCustByLastName", Phase::Decode);
         assert(customers.size() > 0);
         int index = (customers.size() - 1) / 2;
         customer = customers[index];
@@ -942,6 +1130,7 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
         cDataChanged = fmt::format(" c_data = '{:s}',", cData);
     }
 
+    markPhase("PaymentTXNCustUpdate", Phase::Build);
     string updateCustomer = fmt::format(
         "UPDATE bench.customer SET{:s} c_balance = c_balance - {:f}, "
         "c_ytd_payment = c_ytd_payment + {:f}, c_payment_cnt = c_payment_cnt + "
@@ -951,6 +1140,7 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "cuq" << endl;
 #endif
+    markPhase("PaymentTXNCustUpdate", Phase::Execute);
     pqxx::result c_update =
         transaction.exec0(updateCustomer, "PaymentTXNCustUpdate");
     assert(c_update.affected_rows() == 1);
@@ -959,6 +1149,7 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
         fmt::format("{:s}    {:s}", warehouse["w_name"].as<string>(),
                     district["d_name"].as<string>());
 
+    markPhase("PaymentTXNHistory", Phase::Build);
     string insertQuery = fmt::format(
         "INSERT INTO bench.history VALUES\r\n ({:d}, {:d}, {:d}, {:d}, "
         "{:d}, {:f}, '{:s}', '{:%Y-%m-%d %H:%M:%S}'",
@@ -967,9 +1158,11 @@ static bool doPayment(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "hi" << endl;
 #endif
+    markPhase("PaymentTXNHistory", Phase::Execute);
     pqxx::result insertResult =
         transaction.exec0(updateCustomer, "PaymentTXNHistory");
     assert(insertResult.affected_rows() == 1);
+    markPhase("commit", Phase::Execute);
     transaction.commit();
     return true;
 }
@@ -981,8 +1174,10 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
 #endif
     StockLevelParams sparams;
     randomHelper.generateStockLevelParams(params, sparams);
+    markPhase("begin", Phase::Execute);
     pqxx::transaction<> transaction(*conn);
 
+    markPhase("StockLevelTXNDistQuery", Phase::Build);
     string distQuery =
         fmt::format("SELECT d_next_o_id from bench.district "
                     "WHERE d_id = {:d} AND d_w_id = {:d} LIMIT 1;",
@@ -991,10 +1186,13 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "dq" << endl;
 #endif
+    markPhase("StockLevelTXNDistQuery", Phase::Execute);
     pqxx::row district = transaction.exec1(distQuery, "StockLevelTXNDistQuery");
+    markPhase("StockLevelTXNDistQuery", Phase::Decode);
     assert(!district.empty());
     int nextOid = district["d_next_o_id"].as<int>();
 
+    markPhase("StockLevelTXNStockQuery", Phase::Build);
     string stockQuery = fmt::format(
         "SELECT COUNT(DISTINCT(s_i_id)) from bench.order_line, bench.stock "
         "WHERE ol_w_id = {:d} AND ol_d_id = {:d} AND ol_o_id < {:d} AND "
@@ -1005,9 +1203,12 @@ static bool doStockLevel(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "sq" << endl;
 #endif
+    markPhase("StockLevelTXNStockQuery", Phase::Execute);
     pqxx::result stock =
         transaction.exec(stockQuery, "StockLevelTXNStockQuery");
+    markPhase("StockLevelTXNStockQuery", Phase::Decode);
     assert(stock.size() > 0);
+    markPhase("commit", Phase::Execute);
     transaction.commit();
     return true;
 }
@@ -1020,7 +1221,9 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
     NewOrderParams noparams;
     randomHelper.generateNewOrderParams(params, noparams);
 
+    markPhase("begin", Phase::Execute);
     pqxx::transaction<> transaction(*conn);
+    markPhase("NewOrderTXNUpdateDistrict", Phase::Build);
     string updateDistrict = fmt::format(
         "UPDATE bench.district SET d_next_o_id = d_next_o_id + 1 WHERE d_id = "
         "{:d} AND d_w_id = {:d} RETURNING d_id,d_w_id,d_tax,d_next_o_id;",
@@ -1029,14 +1232,17 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "du" << endl;
 #endif
+    markPhase("NewOrderTXNUpdateDistrict", Phase::Execute);
     pqxx::row district =
         transaction.exec1(updateDistrict, "NewOrderTXNUpdateDistrict");
+    markPhase("NewOrderTXNUpdateDistrict", Phase::Decode);
     assert(!district.empty());
 
     double dTax = district["d_tax"].as<double>();
     int dNextOId = district["d_next_o_id"].as<int>();
 
     // TODO sharding?
+    markPhase("NewOrderTXNItemQuery", Phase::Build);
     string itemQuery =
         fmt::format("SELECT i_id,i_price,i_name,i_data from bench.item "
                     "WHERE i_id IN ({});",
@@ -1044,9 +1250,12 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "iq" << endl;
 #endif
+    markPhase("NewOrderTXNItemQuery", Phase::Execute);
     pqxx::result items = transaction.exec(itemQuery, "StockLevelTXNItemQuery");
+    markPhase("NewOrderTXNItemQuery", Phase::Decode);
     if (items.size() != noparams.iIds.size()) {
         numFails++;
+        markPhase("abort", Phase::Execute);
         transaction.abort();
         return false;
     }
@@ -1077,16 +1286,20 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                         });
     };
 
+    markPhase("NewOrderTXNQueryWarehouse", Phase::Build);
     string queryWarehouse = fmt::format(
         "SELECT w_tax FROM bench.warehouse WHERE w_id = {:d};", noparams.wId);
 #ifdef PRINT_TRACE
     cout << "whq" << endl;
 #endif
+    markPhase("NewOrderTXNQueryWarehouse", Phase::Execute);
     pqxx::row warehouse =
         transaction.exec1(queryWarehouse, "NewOrderTXNQueryWarehouse");
+    markPhase("NewOrderTXNQueryWarehouse", Phase::Decode);
     assert(!warehouse.empty());
     double wTax = warehouse["w_tax"].as<double>();
 
+    markPhase("NewOrderTXNQueryCustomer", Phase::Build);
     string queryCustomer =
         fmt::format("SELECT c_discount,c_last,c_credit FROM bench.customer "
                     "WHERE c_w_id = {:d} AND c_d_id = {:d} AND c_id = {:d};",
@@ -1094,8 +1307,10 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "cq" << endl;
 #endif
+    markPhase("NewOrderTXNQueryCustomer", Phase::Execute);
     pqxx::row customer =
         transaction.exec1(queryCustomer, "NewOrderTXNQueryCustomer");
+    markPhase("NewOrderTXNQueryCustomer", Phase::Decode);
     assert(!customer.empty());
     double cDiscount = customer["c_discount"].as<double>();
 
@@ -1108,6 +1323,7 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 
     pqxx::result stock;
     if (allLocal) {
+        markPhase("NewOrderTXNStockLocal", Phase::Build);
         string stockQuery = fmt::format(
             "SELECT "
             "s_i_id,s_w_id,s_quantity,s_data,s_ytd,s_order_cnt,s_remote_cnt,s_"
@@ -1119,9 +1335,12 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
         cout << "sal" << endl;
 #endif
+        markPhase("NewOrderTXNStockLocal", Phase::Execute);
         stock = transaction.exec(stockQuery, "StockLevelTXNStockLocal");
+        markPhase("NewOrderTXNStockLocal", Phase::Decode);
         assert(stock.size() == olCnt);
     } else {
+        markPhase("NewOrderTXNStockRemote", Phase::Build);
         string stockQuery =
             fmt::format("SELECT "
                         "s_i_id,s_w_id,s_quantity,s_data,s_ytd,s_order_cnt,s_"
@@ -1144,7 +1363,9 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
         cout << "sor" << endl;
 #endif
+        markPhase("NewOrderTXNStockRemote", Phase::Execute);
         stock = transaction.exec(stockQuery, "StockLevelTXNStockRemote");
+        markPhase("NewOrderTXNStockRemote", Phase::Decode);
         assert(stock.size() == olCnt);
     }
 
@@ -1155,6 +1376,7 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
                         });
     };
 
+    markPhase("NewOrderTXNInsertOrder", Phase::Build);
     string insertOrder = fmt::format(
         "INSERT INTO bench.order VALUES\r\n "
         "({:d},{:d},{:d},{:d},{:d},{:d},{:d},'{:%Y-%m-%d %H:%M:%S}');",
@@ -1163,16 +1385,19 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
     cout << "io" << endl;
 #endif
+    markPhase("NewOrderTXNInsertOrder", Phase::Execute);
     pqxx::result iOResult =
         transaction.exec0(insertOrder, "StockLevelTXNInsertOrder");
     assert(iOResult.affected_rows() == 1);
 
+    markPhase("NewOrderTXNInsertNewOrder", Phase::Build);
     string insertQuery = fmt::format(
         "INSERT INTO bench.new_order VALUES\r\n ({:d}, {:d}, {:d});",
         noparams.wId, dNextOId, noparams.dId);
 #ifdef PRINT_TRACE
     cout << "noi" << endl;
 #endif
+    markPhase("NewOrderTXNInsertNewOrder", Phase::Execute);
     pqxx::result noInsert =
         transaction.exec0(insertQuery, "NewOrderTXNInsertNewOrder");
     assert(noInsert.affected_rows() == 1);
@@ -1206,6 +1431,7 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
             sRemoteCnt++;
         }
 
+        markPhase("NewOrderTXNStockUpdate", Phase::Build);
         string updateStock = fmt::format(
             "UPDATE bench.stock SET s_quantity = {:d}, s_ytd = {:d}, "
             "s_order_cnt = {:d}, s_remote_cnt = {:d} WHERE s_i_id = {:d} AND "
@@ -1214,6 +1440,7 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
         cout << "suq" << endl;
 #endif
+        markPhase("NewOrderTXNStockUpdate", Phase::Execute);
         pqxx::result updateStockResult =
             transaction.exec0(updateStock, "StockLevelTXNStockUpdate");
         assert(updateStockResult.affected_rows() == 1);
@@ -1221,6 +1448,7 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
         double olAmount = olQuantity * item["i_price"].as<double>();
         total += olAmount;
 
+        markPhase("NewOrderTXNInsertOrderLine", Phase::Build);
         string insertOrderLine = fmt::format(
             "INSERT INTO bench.order_line VALUES\r\n "
             "({:d},{:d},{:d},{:d},{:d},{:d},{:d},{:f},'{:s}');",
@@ -1229,6 +1457,7 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
 #ifdef PRINT_TRACE
         cout << "iol" << endl;
 #endif
+        markPhase("NewOrderTXNInsertOrderLine", Phase::Execute);
         pqxx::result iOlResult =
             transaction.exec0(insertOrderLine, "StockLevelTXNInsertOrderLine");
         assert(iOlResult.affected_rows() == 1);
@@ -1246,124 +1475,59 @@ static bool doNewOrder(benchmark::State &state, ScaleParameters &params,
     }
     total *= (1 - cDiscount) * (1 + wTax + dTax);
 
+    markPhase("commit", Phase::Execute);
     transaction.commit();
     return true;
 }
 
-static ScaleParameters params = ScaleParameters::makeDefault(4);
-static void BM_PQXX_TPCC_OLD(benchmark::State &state) {
-    auto conn = PostgreSQLDBHandler::GetConnection();
-    if (state.thread_index() == 0) {
-        int warehouses = state.range(0);
-        params = ScaleParameters::makeDefault(warehouses);
-        try {
-            LoadBenchmark(conn, params, warehouses, state.threads());
-        } catch (...) {
-            cerr << "Error loading benchmark" << endl;
-            throw;
-        }
+namespace {
+class PQXXTPCCOld : public Backend {
+  public:
+    explicit PQXXTPCCOld(benchmark::State &state)
+        : state(state), conn(PostgreSQLDBHandler::GetConnection()) {}
+
+    void load(ScaleParameters &params, int clients) override {
+        LoadBenchmark(conn, params, params.warehouses, clients);
     }
-    int numDeliveries = 0;
-    int numOrderStatuses = 0;
-    int numNewOrders = 0;
-    int numFailedNewOrders = 0;
-    int numPayments = 0;
-    int numStockLevels = 0;
-    int numDeadlocks = 0;
-    int numOtherErrors = 0;
-    for (auto _ : state) {
-        // auto start = std::chrono::high_resolution_clock::now();
-        tpcc::TransactionType type = randomHelper.nextTransactionType();
-        // Start transaction
-
-        try {
-        bool result = false;
-        switch (type) {
-        case tpcc::TransactionType::Delivery:
-            result = doDeliveryN(state, params, conn);
-            numDeliveries++;
-            break;
-        case tpcc::TransactionType::OrderStatus:
-            result = doOrderStatus(state, params, conn);
-            numOrderStatuses++;
-            break;
-        case tpcc::TransactionType::Payment:
-            result = doPayment(state, params, conn);
-            numPayments++;
-            break;
-        case tpcc::TransactionType::StockLevel:
-            result = doStockLevel(state, params, conn);
-            numStockLevels++;
-            break;
-        case tpcc::TransactionType::NewOrder:
-            result = doNewOrder(state, params, conn, numFailedNewOrders);
-            numNewOrders++;
-            break;
-        }
-        } catch(pqxx::deadlock_detected& e) {
-            cout << "Deadlock!\r\n" << e.what() << endl;
-            numDeadlocks++;
-        } catch(pqxx::pqxx_exception& e) {
-            cout << "pqxxException!\r\n" << e.base().what() << endl;
-        } catch(std::exception& e) {
-            cout << "std exception!\r\n" << e.what() << endl;
-        } catch(...) {
-            cout << "Unknown exception!\r\n" << endl;
-            throw;
-        }
-        // auto end = std::chrono::high_resolution_clock::now();
-        // auto elapsed_seconds =
-        //     std::chrono::duration_cast<std::chrono::duration<double>>(end -
-        //                                                               start);
-        // state.SetIterationTime(elapsed_seconds.count());
+    bool newOrder(ScaleParameters &params) override {
+        int numFails = 0;
+        doNewOrder(state, params, conn, numFails);
+        return numFails == 0;
+    }
+    bool payment(ScaleParameters &params) override {
+        return doPayment(state, params, conn);
+    }
+    bool orderStatus(ScaleParameters &params) override {
+        return doOrderStatus(state, params, conn);
     }
+    bool delivery(ScaleParameters &params) override {
+        return doDeliveryN(state, params, conn);
+    }
+    bool stockLevel(ScaleParameters &params) override {
+        return doStockLevel(state, params, conn);
+    }
+    // Other pqxx errors are logged and the terminal goes on, as before
+    FailureKind classify(const std::exception &e) const override {
+        if (dynamic_cast<const pqxx::deadlock_detected *>(&e) != nullptr)
+            return FailureKind::Conflict;
+        return FailureKind::Transient;
+    }
+    void serverStatistics(std::map<std::string, double> &out) override {
+        out = PostgreSQLDBHandler::ServerStats(conn);
+    }
+
+  private:
+    benchmark::State &state;
+    shared_ptr<pqxx::connection> conn;
+};
+} // namespace
 
-    int total = numDeliveries + numNewOrders + numFailedNewOrders +
-                numOrderStatuses + numPayments + numStockLevels;
-
-    state.counters["deadlocks"] = numDeadlocks;
-
-    state.counters["txn"] = total;
-    state.counters["txnRate"] =
-        benchmark::Counter(total, benchmark::Counter::kIsRate);
-    state.counters["txnRateInv"] = benchmark::Counter(
-        total, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-
-    state.counters["delivery"] = numDeliveries;
-    state.counters["deliveryRate"] =
-        benchmark::Counter(numDeliveries, benchmark::Counter::kIsRate);
-    state.counters["deliveryRateInv"] =
-        benchmark::Counter(numDeliveries, benchmark::Counter::kIsRate |
-                                              benchmark::Counter::kInvert);
-
-    state.counters["newOrder"] = numNewOrders;
-    state.counters["newOrderRate"] =
-        benchmark::Counter(numNewOrders, benchmark::Counter::kIsRate);
-    state.counters["newOrderRateInv"] =
-        benchmark::Counter(numNewOrders, benchmark::Counter::kIsRate |
-                                             benchmark::Counter::kInvert);
-
-    state.counters["newOrderFail"] = numFailedNewOrders;
-
-    state.counters["payment"] = numPayments;
-    state.counters["paymentRate"] =
-        benchmark::Counter(numPayments, benchmark::Counter::kIsRate);
-    state.counters["paymentRateInv"] = benchmark::Counter(
-        numPayments, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
-
-    state.counters["status"] = numOrderStatuses;
-    state.counters["statusRate"] =
-        benchmark::Counter(numOrderStatuses, benchmark::Counter::kIsRate);
-    state.counters["statusRateInv"] =
-        benchmark::Counter(numOrderStatuses, benchmark::Counter::kIsRate |
-                                                 benchmark::Counter::kInvert);
-
-    state.counters["stock"] = numStockLevels;
-    state.counters["stockRate"] =
-        benchmark::Counter(numStockLevels, benchmark::Counter::kIsRate);
-    state.counters["stockRateInv"] =
-        benchmark::Counter(numStockLevels, benchmark::Counter::kIsRate |
-                                               benchmark::Counter::kInvert);
+static void BM_PQXX_TPCC_OLD(benchmark::State &state, ArrivalProcess arrival) {
+    runTPCC(state, "pqxx_tpcc_old", arrival, [](benchmark::State &state) {
+        return make_unique<PQXXTPCCOld>(state);
+    });
 }
 
-BENCHMARK(BM_PQXX_TPCC_OLD)->RangeMultiplier(2)->Range(1,10)->Iterations(10000)->ThreadRange(1,16)->UseRealTime();
+BENCHMARK_CAPTURE(BM_PQXX_TPCC_OLD, Closed, ArrivalProcess::Closed)->RangeMultiplier(2)->Range(1,10)->ThreadRange(1,16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_PQXX_TPCC_OLD, Constant, ArrivalProcess::Constant)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_PQXX_TPCC_OLD, Poisson, ArrivalProcess::Poisson)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
@@ -1,28 +1,53 @@
 #include "benchmark/benchmark.h"
 #include "dbphd/postgresql/postgresql.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "benchstats.hpp"
 #include "precalculate.hpp"
 
 #include <random>
 #include <iostream>
 #include <chrono>
+#include <memory>
+#include <vector>
 
 using namespace std;
 
 static void CustomArgumentsUpdates(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 1; j <= Precalculator::Columns; ++j) { // fields to write
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
 			for (int k = 0; k <= i; ++k) { //  Indexes
-				b->Args({i, j, k});
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
 			}
 		}
 	}
 }
 
 static void CustomArgumentsUpdates2(benchmark::internal::Benchmark* b) {
-	for (int i = 0; i <= Precalculator::Columns; ++i) { // fields to query
-		for (int j = 1; j <= Precalculator::Columns; ++j) { // fields to write
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
 			for (int k = 0; k <= j; ++k) { //  Indexes
-				b->Args({i, j, k});
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
+			}
+		}
+	}
+}
+
+// Keyed batches of changes: batch size, fields changed and how many of them
+// are indexed, with every bulk update method and key distribution
+static void CustomArgumentsBulkUpdates(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= 10000 && i <= (int64_t)Precalculator::Rows(); i *= 10) { // Changes per batch
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
+			for (int k = 0; k <= j; ++k) { //  Indexes on the written fields
+				for (int l = 0; l <= 1; ++l) { // Bulk update method
+					for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+						b->Args({i, j, k, l, d});
+					}
+				}
 			}
 		}
 	}
@@ -44,16 +69,16 @@ static void CreateTable(std::shared_ptr<pqxx::connection> conn, bool doublefield
 CREATE TABLE update_bench (
 	_id  serial PRIMARY KEY,
 )|";
-		for(int field = 0; field < Precalculator::Columns; ++field) {
+		for(int field = 0; field < Precalculator::Columns(); ++field) {
 			createQuery.append("a" + to_string(field) + " INT");
-			if(field != Precalculator::Columns-1)
+			if(field != Precalculator::Columns()-1)
 				createQuery.append(",\r\n");
 		}
 		if(doublefields) {
 			createQuery.append(",\r\n");
-			for(int field = 0; field < Precalculator::Columns; ++field) {
+			for(int field = 0; field < Precalculator::Columns(); ++field) {
 				createQuery.append("b" + to_string(field) + " INT");
-				if(field != Precalculator::Columns-1)
+				if(field != Precalculator::Columns()-1)
 					createQuery.append(",\r\n");
 			}
 		}
@@ -67,21 +92,20 @@ CREATE TABLE update_bench (
 		
 		int batchsize = 10000;
 
-		for(int i = 0; i < Precalculator::Rows; i += batchsize) {
+		for(uint64_t i = 0; i < Precalculator::Rows(); i += batchsize) {
 			string query = "INSERT INTO bench.update_bench VALUES\r\n";
-			for(int j = 0; j < batchsize && i+j < Precalculator::Rows;++j) {
+			for(int j = 0; j < batchsize && i+j < Precalculator::Rows();++j) {
 				query.append("	(DEFAULT");
-				int iteration = i+j;
-				auto& rowval = Precalculator::PrecalcValues[iteration];
-				for(int f = 0; f < Precalculator::Columns; ++f) {
+				auto rowval = Precalculator::RowAt(i+j);
+				for(int f = 0; f < Precalculator::Columns(); ++f) {
 					query.append("," + to_string(rowval[f]));
 				}
 				if(doublefields) {
-					for(int f = 0; f < Precalculator::Columns; ++f) {
+					for(int f = 0; f < Precalculator::Columns(); ++f) {
 						query.append("," + to_string(rowval[f]));
 					}
 				}
-				if((j != batchsize - 1) && j+i != Precalculator::Rows-1) {
+				if((j != batchsize - 1) && j+i != Precalculator::Rows()-1) {
 					query.append("),");
 				} else {
 					query.append(");");
@@ -92,6 +116,8 @@ CREATE TABLE update_bench (
 		}
 		auto end = chrono::steady_clock::now();
 		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("postgres", "update_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("postgres", [&] { return PostgreSQLDBHandler::ServerInfo(conn); });
 		cout.flush();
 	}
 	created = true;
@@ -101,7 +127,7 @@ static void BM_PQXX_Update(benchmark::State& state, bool transactions, bool test
 	auto conn = PostgreSQLDBHandler::GetConnection();
 	std::random_device rd;  //Will be used to obtain a seed for the random number engine
 	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
-	std::uniform_int_distribution<> dis(0, 4);
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(3), 5);
 	std::uniform_int_distribution<> dis2(1, 100);
 	// Per thread settings...
 	if(state.thread_index() == 0) {
@@ -151,6 +177,8 @@ static void BM_PQXX_Update(benchmark::State& state, bool transactions, bool test
 		}
 	}
 	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
 	for(auto _ : state) {
 		state.PauseTiming();
 		string query = "UPDATE bench.update_bench SET b0 = b0 + " + to_string(dis2(gen));
@@ -165,6 +193,7 @@ static void BM_PQXX_Update(benchmark::State& state, bool transactions, bool test
 		}
 		query += ";";
 		state.ResumeTiming();
+		perfIterations.start();
 		auto start = std::chrono::high_resolution_clock::now();
 		pqxx::transaction_base* T = nullptr;
 		if(transactions) {
@@ -183,6 +212,7 @@ static void BM_PQXX_Update(benchmark::State& state, bool transactions, bool test
 			delete (pqxx::work*)T;
 		}
 		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
 
 		auto elapsed_seconds =
 			std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -208,9 +238,138 @@ static void BM_PQXX_Update(benchmark::State& state, bool transactions, bool test
 	// Meaning: how many seconds it takes to process one 'foo'?
 	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
 	state.counters.insert({{"FieldsQueried", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsChanged", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
 }
 
 BENCHMARK_CAPTURE(BM_PQXX_Update, Normal, false, false)->Apply(CustomArgumentsUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_PQXX_Update, Transact, true, false)->Apply(CustomArgumentsUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_PQXX_Update, NormalWriteIdx, false, true)->Apply(CustomArgumentsUpdates2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
 BENCHMARK_CAPTURE(BM_PQXX_Update, TransactWriteIdx, true, true)->Apply(CustomArgumentsUpdates2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+// How BM_PQXX_Update_Bulk applies a batch of keyed changes
+enum class BulkUpdate {
+	Values = 0, // UPDATE ... FROM (VALUES ...) with the changes in its text
+	Unnest = 1  // A prepared UPDATE ... FROM unnest() of an int[] of keys and one per field
+};
+
+// Sets the first fields b columns of a batch of rows picked by their _id, all
+// in one statement, as an ETL job applying keyed changes would. The keys of a
+// batch are sorted and each is sent once, so concurrent batches lock their
+// rows in the same order as far as the plan follows it; the deadlocks and
+// serialization failures left are counted as Conflicts instead of failing the
+// run.
+static void BM_PQXX_Update_Bulk(benchmark::State& state, bool transactions) {
+	auto conn = PostgreSQLDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	KeyDistribution keys = Precalculator::QueryKeys(state.range(4), Precalculator::Rows());
+	std::uniform_int_distribution<> dis2(1, 100);
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn, true);
+		pqxx::nontransaction N(*conn);
+		N.exec("DROP INDEX IF EXISTS bench.update_bench_idx;");
+		N.exec("DROP INDEX IF EXISTS bench.update_bench_idx2;");
+		if(state.range(2) > 0) {
+			string indexCreate = "CREATE INDEX update_bench_idx2 on bench.update_bench (b0";
+			for(int index = 1; index < state.range(2); ++index) {
+				indexCreate += ",b" + to_string(index);
+			}
+			indexCreate += ");";
+			N.exec(indexCreate);
+		}
+	}
+	const int batch = state.range(0), fields = state.range(1);
+	auto method = (BulkUpdate)state.range(3);
+	string set = "b0 = v.b0", columns = "id,b0";
+	for(int i = 1; i < fields; ++i) {
+		set += ",b" + to_string(i) + " = v.b" + to_string(i);
+		columns += ",b" + to_string(i);
+	}
+	string update = "UPDATE bench.update_bench u SET " + set + " FROM ";
+	string join = " AS v(" + columns + ") WHERE u._id = v.id";
+	if(method == BulkUpdate::Unnest) {
+		string arrays = "unnest($1::int[]";
+		for(int i = 0; i < fields; ++i) {
+			arrays += ",$" + to_string(i + 2) + "::int[]";
+		}
+		conn->prepare("update_unnest", update + arrays + ")" + join);
+	}
+	vector<string> arrays(fields + 1);
+	int64_t changes = 0, conflicts = 0;
+	PerfIterations perfIterations(state);
+	ServerStatistics serverStats(state, [&] { return PostgreSQLDBHandler::ServerStats(conn); });
+	for(auto _ : state) {
+		state.PauseTiming();
+		auto batchKeys = keys.Batch(gen, batch);
+		string query;
+		pqxx::params parameters;
+		if(method == BulkUpdate::Values) {
+			query = update + "(VALUES ";
+			for(size_t n = 0; n < batchKeys.size(); ++n) {
+				query += (n == 0 ? "(" : ",(") + to_string(batchKeys[n] + 1);
+				for(int i = 0; i < fields; ++i) {
+					query += "," + to_string(dis2(gen));
+				}
+				query += ")";
+			}
+			query += ")" + join + ";";
+		} else {
+			for(auto& array : arrays) {
+				array = "{";
+			}
+			for(size_t n = 0; n < batchKeys.size(); ++n) {
+				string separator = n == 0 ? "" : ",";
+				arrays[0] += separator + to_string(batchKeys[n] + 1);
+				for(int i = 0; i < fields; ++i) {
+					arrays[i + 1] += separator + to_string(dis2(gen));
+				}
+			}
+			for(auto& array : arrays) {
+				parameters.append(array + "}");
+			}
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		try {
+			std::unique_ptr<pqxx::transaction_base> T;
+			if(transactions) {
+				T.reset(new pqxx::work(*conn));
+			} else {
+				T.reset(new pqxx::nontransaction(*conn));
+			}
+			if(method == BulkUpdate::Values) {
+				T->exec(query);
+			} else {
+				T->exec_prepared("update_unnest", parameters);
+			}
+			T->commit();
+			changes += batchKeys.size();
+		} catch(pqxx::transaction_rollback&) {
+			// Deadlocks and serialization failures, rolled back by the server
+			++conflicts;
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	state.SetComplexityN(state.range(0));
+	// The changes committed, a key drawn more than once in a batch counts once
+	state.SetItemsProcessed(changes);
+	state.counters["Conflicts"] = conflicts;
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Batch", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsChanged", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Method", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, keys);
+}
+
+BENCHMARK_CAPTURE(BM_PQXX_Update_Bulk, Normal, false)->Apply(CustomArgumentsBulkUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_PQXX_Update_Bulk, Transact, true)->Apply(CustomArgumentsBulkUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -1,40 +1,109 @@
 #include "precalculate.hpp"
 
-#include <cmath>
+#include "benchmark/benchmark.h"
+
 #include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
 
 using namespace std;
-template <typename T>
-constexpr T ipow(T num, unsigned int pow)
-{
-    return (pow >= sizeof(unsigned int)*8) ? 0 :
-        pow == 0 ? 1 : num * ipow(num, pow-1);
-}
-
-std::vector<std::vector<int>> Precalculator::PrecalcValues;
-int Precalculator::Values = 10;
-int Precalculator::Columns = 6;
-uint64_t Precalculator::Rows = 1000000;
-volatile bool Precalculator::PreCalculated = false;
-bool Precalculator::PreCalculate() {
-	if(PreCalculated)
-		return true;
-	vector<int> vals;
-	for(int i = 0; i < Values; ++i) 
-		vals.push_back(i);
-	PrecalcValues.resize(Rows);
-
-	#pragma omp parallel for
-	for(uint64_t row = 0;  row < Rows; ++row) {
-		int iteration = row;
-		vector<int> rowvals;
-		for(int col = 0; col < Columns; ++col) {
-			rowvals.push_back(vals[iteration%Values]);
-			iteration /= Values;
+
+// The environment variable name as a number, fallback when unset or not a number
+static uint64_t environmentNumber(const char* name, uint64_t fallback) {
+	const char* value = getenv(name);
+	if(value == nullptr || *value == '\0')
+		return fallback;
+	char* end;
+	unsigned long long number = strtoull(value, &end, 10);
+	return *end == '\0' ? number : fallback;
+}
+
+const Precalculator::Fixture& Precalculator::fixture() {
+	static const Fixture fixture = [] {
+		Fixture f;
+		f.rows = environmentNumber("DBPHD_FIXTURE_ROWS", 1000000);
+		f.columns = (int)environmentNumber("DBPHD_FIXTURE_COLUMNS", 6);
+		if(f.columns < 1 || f.columns > MaxColumns)
+			f.columns = 6;
+		f.values = (int)environmentNumber("DBPHD_FIXTURE_VALUES", 10);
+		if(f.values < 2)
+			f.values = 10;
+		uint64_t power = 1;
+		for(int column = 0; column < MaxColumns; ++column) {
+			f.powers[column] = power;
+			power = power > UINT64_MAX / f.values ? UINT64_MAX : power * f.values;
+		}
+		f.distribution = KeyDistribution::Uniform(f.values);
+		const char* distribution = getenv("DBPHD_FIXTURE_DISTRIBUTION");
+		if(distribution != nullptr && *distribution != '\0')
+			KeyDistribution::Parse(distribution, f.values, f.distribution);
+		return f;
+	}();
+	return fixture;
+}
+
+uint64_t Precalculator::Rows() {
+	return fixture().rows;
+}
+
+int Precalculator::Columns() {
+	return fixture().columns;
+}
+
+int Precalculator::Values() {
+	return fixture().values;
+}
+
+uint64_t Precalculator::Matching(int columns) {
+	const Fixture& f = fixture();
+	if(columns >= MaxColumns)
+		return 1;
+	uint64_t matching = f.rows / f.powers[columns];
+	return matching > 0 ? matching : 1;
+}
+
+Precalculator::Row Precalculator::RowAt(uint64_t row) {
+	const Fixture& f = fixture();
+	bool skewed = f.distribution.Type() != Distribution::Uniform;
+	return Row(row, f.powers.data(), f.values, skewed ? &f.distribution : nullptr);
+}
+
+const vector<string>& Precalculator::querySpecs() {
+	static const vector<string> specs = [] {
+		vector<string> specs;
+		const char* value = getenv("DBPHD_KEY_DISTRIBUTIONS");
+		istringstream list(value != nullptr ? value : "");
+		string spec;
+		while(getline(list, spec, ',')) {
+			KeyDistribution parsed;
+			if(KeyDistribution::Parse(spec, 2, parsed))
+				specs.push_back(spec);
+			else
+				cerr << "Ignoring key distribution \"" << spec << "\"" << endl;
 		}
-		PrecalcValues[row] = rowvals;
-	}
+		if(specs.empty())
+			specs.push_back("uniform");
+		return specs;
+	}();
+	return specs;
+}
+
+int Precalculator::QueryDistributions() {
+	return (int)querySpecs().size();
+}
+
+KeyDistribution Precalculator::QueryKeys(int64_t distribution, uint64_t keys) {
+	KeyDistribution d = KeyDistribution::Uniform(keys);
+	const vector<string>& specs = querySpecs();
+	if(distribution >= 0 && distribution < (int64_t)specs.size())
+		KeyDistribution::Parse(specs[distribution], keys, d);
+	return d;
+}
 
-	PreCalculated = true;
-	return true;
+void Precalculator::KeyCounters(benchmark::State& state, const KeyDistribution& keys) {
+	state.counters.insert({{"Distribution", benchmark::Counter((int)keys.Type(), benchmark::Counter::kAvgThreads)},
+		{"DistributionTheta", benchmark::Counter(keys.Theta(), benchmark::Counter::kAvgThreads)},
+		{"DistributionHotKeys", benchmark::Counter(keys.HotKeys(), benchmark::Counter::kAvgThreads)},
+		{"DistributionHotAccesses", benchmark::Counter(keys.HotAccesses(), benchmark::Counter::kAvgThreads)}});
 }
@@ -1,20 +1,80 @@
 #ifndef PRECALCULATE_HPP
 #define PRECALCULATE_HPP
 
-#include <vector>
+#include <array>
 #include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dbphd/workload/keydistribution.hpp"
 
+namespace benchmark {
+class State;
+}
+
+// The rows of the CRUD fixtures. Row r holds the digits of r in base Values(),
+// least significant first, one per column, so a row is computed when a loader
+// asks for it instead of being kept in memory. The sizes are
+// $DBPHD_FIXTURE_ROWS, $DBPHD_FIXTURE_COLUMNS and $DBPHD_FIXTURE_VALUES
+// (1000000, 6 and 10 by default), read on first use, which is while the
+// benchmarks register. $DBPHD_FIXTURE_DISTRIBUTION, a KeyDistribution spec
+// such as "zipfian:0.99", skews the values instead: each one is then drawn
+// from the distribution by a hash of its row and column, so the same row
+// comes out the same on every load but rows may repeat.
 class Precalculator {
 public:
-	static std::vector<std::vector<int>> PrecalcValues;
-	static volatile bool PreCalculated;
-	static uint64_t Rows;
-	static int Values;
-	static int Columns;
-	static bool PreCalculate();
-};
+	static const int MaxColumns = 64;
 
-#endif /* ifndef PRECALCULATE_HPP
+	// One row as a view over its index, rowval[column] like a vector of the values
+	class Row {
+	public:
+		constexpr Row(uint64_t row, const uint64_t* powers, int values, const KeyDistribution* skew = nullptr)
+			: row(row), powers(powers), values(values), skew(skew) {}
+		int operator[](int column) const {
+			if(skew)
+				return (int)skew->KeyAt(row * MaxColumns + column);
+			return (int)(row / powers[column] % values);
+		}
 
+	private:
+		uint64_t row;
+		const uint64_t* powers;
+		int values;
+		// Null for uniform fixtures, which keep the digits
+		const KeyDistribution* skew;
+	};
+
+	static uint64_t Rows();
+	static int Columns();
+	static int Values();
+	static Row RowAt(uint64_t row);
+	// Rows of a uniform fixture an equality query on its first columns columns
+	// matches, Rows() / Values()^columns but at least 1
+	static uint64_t Matching(int columns);
+
+	// How many key distributions the CRUD queries are run with, one benchmark
+	// argument value each: $DBPHD_KEY_DISTRIBUTIONS, a comma separated list of
+	// KeyDistribution specs such as "uniform,zipfian:0.99,hotspot:0.2:0.8",
+	// only uniform when unset. Specs that do not parse are left out.
+	static int QueryDistributions();
+	// Entry distribution of that list, uniform if out of range, over the keys 0 .. keys-1
+	static KeyDistribution QueryKeys(int64_t distribution, uint64_t keys);
+	// The Distribution counter, the Distribution::Type of keys, and the
+	// DistributionTheta, DistributionHotKeys and DistributionHotAccesses
+	// parameters that tell the runs of one type apart (0 where they don't apply)
+	static void KeyCounters(benchmark::State& state, const KeyDistribution& keys);
+
+private:
+	struct Fixture {
+		uint64_t rows;
+		int columns;
+		int values;
+		// Values^column, saturated, so the columns beyond the largest row are 0
+		std::array<uint64_t, MaxColumns> powers;
+		KeyDistribution distribution;
+	};
+	static const Fixture& fixture();
+	static const std::vector<std::string>& querySpecs();
+};
 
- */
+#endif /* ifndef PRECALCULATE_HPP */
@@ -0,0 +1,116 @@
+#include "benchmark/benchmark.h"
+#include "dbphd/sqlite/sqlite.hpp"
+#include "benchperf.hpp"
+
+#include <random>
+#include <iostream>
+#include <chrono>
+
+using namespace std;
+
+static void CustomArgumentsInserts(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= (1 << 12); i*=8) { // Documents
+		for (int j = 1; j <= 16; j *= 2) { // Fields
+			for(int k = 0; k <= j; ) { // Indexes
+				b->Args({i, j, k});
+				if(k == 0) {
+					k = 1;
+				} else {
+					k *= 2;
+				}
+			}
+		}
+	}
+}
+
+// Without transactions every row is its own autocommit statement, with them the
+// batch commits once. Either way the statement is prepared once per thread.
+static void BM_SQLITE_Insert(benchmark::State& state, bool transactions) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	std::uniform_int_distribution<> dis(0, (1 << 16));
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		SQLiteDBHandler::DropTable(conn, "create_bench");
+		string createQuery = R"|(
+CREATE TABLE create_bench (
+	_id  INTEGER PRIMARY KEY,
+)|";
+		for(int field = 0; field < state.range(1); ++field) {
+			createQuery.append("a" + to_string(field) + " INT");
+			if(field != state.range(1) - 1)
+				createQuery.append(",\r\n");
+		}
+		createQuery.append(R"|(
+);
+)|");
+		SQLiteDBHandler::Exec(conn, createQuery);
+		if(state.range(2) > 0) {
+			for(int index = 0; index < state.range(2); ++index) {
+				SQLiteDBHandler::Exec(conn, "CREATE INDEX field" + to_string(index) + " ON create_bench\r\n(a" + to_string(index) + ");");
+			}
+		}
+	}
+	string insertQuery = "INSERT INTO create_bench VALUES (NULL";
+	for(int fields = 0; fields < state.range(1); ++fields) {
+		insertQuery.append(",?");
+	}
+	insertQuery.append(");");
+	unique_ptr<SQLiteStatement> insert;
+	vector<int64_t> values(state.range(0)*state.range(1));
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		// Prepared after the start barrier, when thread 0 created the table
+		if(!insert)
+			insert = make_unique<SQLiteStatement>(conn, insertQuery);
+		for(auto& value : values) {
+			value = dis(gen);
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		unique_ptr<SQLiteTransaction> T;
+		if(transactions)
+			T = make_unique<SQLiteTransaction>(conn);
+		for(int n = 0; n < state.range(0); ++n) {
+			for(int fields = 0; fields < state.range(1); ++fields) {
+				insert->Bind(fields + 1, values[n*state.range(1) + fields]);
+			}
+			insert->Execute();
+		}
+		if(transactions)
+			T->Commit();
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+	insert.reset();
+
+	if(state.thread_index() == 0) {
+		SQLiteDBHandler::DropTable(conn, "create_bench");
+		// This is the first thread, so do destruction here (delete documents etc..)
+	}
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark.
+	// Meaning: per one second, how many 'foo's are processed?
+	state.counters["Ops"] = benchmark::Counter(state.iterations()*state.range(0), benchmark::Counter::kIsRate);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark, and the result inverted.
+	// Meaning: how many seconds it takes to process one 'foo'?
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations()*state.range(0), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+
+	state.counters.insert({{"Documents", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Fields", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Insert, Normal, false)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Insert, Transact, true)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
@@ -0,0 +1,171 @@
+#include "benchmark/benchmark.h"
+#include "dbphd/sqlite/sqlite.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "precalculate.hpp"
+
+#include <random>
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+static void CustomArgumentsDeletes(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 0; j <= i; ++j) { //  Indexes
+			for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+				b->Args({i, j, d});
+			}
+		}
+	}
+}
+
+static string InsertQuery(std::string postfix) {
+	string insertQuery = "INSERT INTO delete_bench" + postfix + " VALUES (?";
+	for(int field = 0; field < Precalculator::Columns(); ++field) {
+		insertQuery.append(",?");
+	}
+	insertQuery.append(");");
+	return insertQuery;
+}
+
+static void CreateTable(std::shared_ptr<sqlite3> conn, std::string postfix = "") {
+	static unordered_map<string, bool> created;
+	static mutex createdMutex;
+	lock_guard<mutex> lock(createdMutex);
+	if(!created.count(postfix)) {
+		cout << endl << "Creating SQLite Delete Table " << postfix << "...";
+		cout.flush();
+		auto start = chrono::steady_clock::now();
+		SQLiteDBHandler::DropTable(conn, "delete_bench"+postfix);
+		string createQuery = R"|(
+CREATE TABLE )|" + string("delete_bench")+postfix + R"|( (
+	_id  INTEGER PRIMARY KEY,
+)|";
+		for(int field = 0; field < Precalculator::Columns(); ++field) {
+			createQuery.append("a" + to_string(field) + " INT");
+			if(field != Precalculator::Columns()-1)
+				createQuery.append(",\r\n");
+		}
+		createQuery.append(R"|(
+);
+)|");
+		SQLiteDBHandler::Exec(conn, createQuery);
+
+		SQLiteTransaction T(conn);
+		SQLiteStatement insert(conn, InsertQuery(postfix));
+		for(uint64_t i = 0; i < Precalculator::Rows(); ++i) {
+			auto rowval = Precalculator::RowAt(i);
+			insert.BindNull(1);
+			for(int f = 0; f < Precalculator::Columns(); ++f) {
+				insert.Bind(f + 2, (int64_t)rowval[f]);
+			}
+			insert.Execute();
+		}
+		T.Commit();
+		auto end = chrono::steady_clock::now();
+		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("sqlite", "delete_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("sqlite", [&] { return SQLiteDBHandler::ServerInfo(conn); });
+		cout.flush();
+		created[postfix] = true;
+	}
+}
+
+static void BM_SQLITE_Delete(benchmark::State& state, bool transactions) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	string postfix = std::to_string(state.thread_index());
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(2), 5);
+	// Per thread settings...
+	// Every thread deletes from (and restores) its own table
+	CreateTable(conn, postfix);
+	SQLiteDBHandler::Exec(conn, "DROP INDEX IF EXISTS delete_bench"+postfix+"_idx;");
+	if(state.range(1) > 0) {
+		string indexCreate = "CREATE INDEX delete_bench"+postfix+"_idx on delete_bench" + postfix + " (a0";
+		for(int index = 1; index < state.range(1); ++index) {
+			indexCreate += ",a" + to_string(index);
+		}
+		indexCreate += ");";
+		SQLiteDBHandler::Exec(conn, indexCreate);
+	}
+	string whereclause = "";
+	if(state.range(0) > 0)  {
+		whereclause += " WHERE\r\n a0 = ?";
+		for(int n = 1; n < state.range(0); ++n) {
+			whereclause += " AND a" + to_string(n) + " = ?";
+		}
+	}
+	SQLiteStatement select(conn, "SELECT * FROM delete_bench"+postfix+whereclause);
+	SQLiteStatement remove(conn, "DELETE FROM delete_bench"+postfix+whereclause);
+	SQLiteStatement insert(conn, InsertQuery(postfix));
+	vector<vector<int64_t>> results;
+	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		for(int n = 0; n < state.range(0); ++n) {
+			int64_t value = dis(gen);
+			select.Bind(n + 1, value);
+			remove.Bind(n + 1, value);
+		}
+		results.clear();
+		while(select.Step()) {
+			vector<int64_t> row(select.Columns());
+			for(size_t field = 0; field < row.size(); ++field) {
+				row[field] = select.Int(field);
+			}
+			results.push_back(move(row));
+		}
+		select.Reset();
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		unique_ptr<SQLiteTransaction> T;
+		if(transactions)
+			T = make_unique<SQLiteTransaction>(conn);
+		count += remove.Execute();
+		if(transactions)
+			T->Commit();
+		state.PauseTiming();
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+		{
+			SQLiteTransaction restore(conn);
+			for(auto& row : results) {
+				for(size_t field = 0; field < row.size(); ++field) {
+					insert.Bind(field + 1, row[field]);
+				}
+				insert.Execute();
+			}
+			restore.Commit();
+		}
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(count);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark.
+	// Meaning: per one second, how many 'foo's are processed?
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark, and the result inverted.
+	// Meaning: how many seconds it takes to process one 'foo'?
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Delete, Normal, false)->Apply(CustomArgumentsDeletes)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Delete, Transact, true)->Apply(CustomArgumentsDeletes)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
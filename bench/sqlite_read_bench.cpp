@@ -0,0 +1,441 @@
+#include "benchmark/benchmark.h"
+#include "dbphd/sqlite/sqlite.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "precalculate.hpp"
+
+#include <random>
+#include <iostream>
+#include <chrono>
+
+using namespace std;
+
+static void CustomArgumentsInserts(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 0; j <= i; ++j) { //  Indexes
+			for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+				b->Args({i, j, d});
+			}
+		}
+	}
+}
+
+static void CustomArgumentsInserts2(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 0; j <= Precalculator::Columns(); ++j) { // fields to return
+			for (int k = 0; k <= i; ++k) { //  Indexes
+				for(int64_t l = 1; l <= (int64_t)Precalculator::Matching(i); l *= 2) { // Documents to return
+					for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+						b->Args({i, j, k, l, d});
+					}
+				}
+			}
+		}
+	}
+}
+
+static void CustomArgumentsInserts3(benchmark::internal::Benchmark* b) {
+	for (int64_t i = 1; i <= (int64_t)Precalculator::Rows(); i *= 2) { // documents to process
+		b->Args({i});
+	}
+}
+
+static void CustomArgumentsInserts4(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= Precalculator::Columns(); ++i) { // fields to sort
+		for (int k = 0; k <= i; ++k) { //  Indexes
+			for(int64_t l = 1; l <= (int64_t)Precalculator::Rows(); l *= 2) { // Documents to return
+				b->Args({i, k, l});
+			}
+		}
+	}
+}
+
+static void CustomArgumentsInserts5(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= 2; ++i) { // fields to index
+		for(int64_t l = 1; l <= (int64_t)Precalculator::Rows(); l *= 2) { // Documents to return
+			b->Args({i, l});
+		}
+	}
+}
+
+static void CreateTable(std::shared_ptr<sqlite3> conn) {
+	static volatile bool created = false;
+	if(!created) {
+		cout << endl << "Creating SQLite Read Table...";
+		cout.flush();
+		auto start = chrono::steady_clock::now();
+		SQLiteDBHandler::DropTable(conn, "read_bench");
+		string createQuery = R"|(
+CREATE TABLE read_bench (
+	_id  INTEGER PRIMARY KEY,
+)|";
+		string insertQuery = "INSERT INTO read_bench VALUES (NULL";
+		for(int field = 0; field < Precalculator::Columns(); ++field) {
+			createQuery.append("a" + to_string(field) + " INT");
+			if(field != Precalculator::Columns()-1)
+				createQuery.append(",\r\n");
+			insertQuery.append(",?");
+		}
+		createQuery.append(R"|(
+);
+)|");
+		insertQuery.append(");");
+		SQLiteDBHandler::Exec(conn, createQuery);
+
+		SQLiteTransaction T(conn);
+		SQLiteStatement insert(conn, insertQuery);
+		for(uint64_t i = 0; i < Precalculator::Rows(); ++i) {
+			auto rowval = Precalculator::RowAt(i);
+			for(int f = 0; f < Precalculator::Columns(); ++f) {
+				insert.Bind(f + 1, (int64_t)rowval[f]);
+			}
+			insert.Execute();
+		}
+		T.Commit();
+		auto end = chrono::steady_clock::now();
+		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("sqlite", "read_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("sqlite", [&] { return SQLiteDBHandler::ServerInfo(conn); });
+		cout.flush();
+	}
+	created = true;
+}
+
+// Drops the indexes of earlier runs, then indexes (a0, .., a<columns-1>) together
+// or, if separate, each of them on its own
+static void CreateIndexes(std::shared_ptr<sqlite3> conn, int columns, bool separate = false) {
+	SQLiteDBHandler::Exec(conn, "DROP INDEX IF EXISTS read_bench_idx;");
+	for(int index = 0; index < Precalculator::Columns(); ++index) {
+		SQLiteDBHandler::Exec(conn, "DROP INDEX IF EXISTS read_bench_idx_a" + to_string(index) + ";");
+	}
+	if(separate) {
+		for(int index = 0; index < columns; ++index) {
+			SQLiteDBHandler::Exec(conn, "CREATE INDEX read_bench_idx_a" + to_string(index) + " on read_bench (a" + to_string(index) + ");");
+		}
+	} else if(columns > 0) {
+		string indexCreate = "CREATE INDEX read_bench_idx on read_bench (a0";
+		for(int index = 1; index < columns; ++index) {
+			indexCreate += ",a" + to_string(index);
+		}
+		indexCreate += ");";
+		SQLiteDBHandler::Exec(conn, indexCreate);
+	}
+	// Let the planner see the new indexes
+	SQLiteDBHandler::Exec(conn, "ANALYZE read_bench;");
+}
+
+// " WHERE a0 = ? AND .. a<fields-1> = ?", bound per iteration
+static string WhereClause(int fields) {
+	string where;
+	if(fields > 0)  {
+		where += " WHERE\r\n a0 = ?";
+		for(int n = 1; n < fields; ++n) {
+			where += " AND a" + to_string(n) + " = ?";
+		}
+	}
+	return where;
+}
+
+// Runs a prepared query in its own (read) transaction or autocommit, returns
+// the rows stepped through
+static uint64_t ReadAll(std::shared_ptr<sqlite3> conn, SQLiteStatement& query, bool transactions) {
+	uint64_t rows = 0;
+	unique_ptr<SQLiteTransaction> T;
+	if(transactions)
+		T = make_unique<SQLiteTransaction>(conn, false);
+	while(query.Step())
+		++rows;
+	query.Reset();
+	if(transactions)
+		T->Commit();
+	return rows;
+}
+
+static void BM_SQLITE_Read_Count(benchmark::State& state, bool transactions) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(2), 5);
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn);
+		CreateIndexes(conn, state.range(1));
+	}
+	unique_ptr<SQLiteStatement> query;
+	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		if(!query)
+			query = make_unique<SQLiteStatement>(conn, "SELECT COUNT(*) FROM read_bench" + WhereClause(state.range(0)));
+		for(int n = 0; n < state.range(0); ++n) {
+			query->Bind(n + 1, (int64_t)dis(gen));
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		unique_ptr<SQLiteTransaction> T;
+		if(transactions)
+			T = make_unique<SQLiteTransaction>(conn, false);
+		query->Step();
+		count += query->Int(0);
+		query->Reset();
+		if(transactions)
+			T->Commit();
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	state.SetItemsProcessed(count);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark.
+	// Meaning: per one second, how many 'foo's are processed?
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark, and the result inverted.
+	// Meaning: how many seconds it takes to process one 'foo'?
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Count, Normal, false)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Count, Transact, true)->Apply(CustomArgumentsInserts)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+static void BM_SQLITE_Reads(benchmark::State& state, bool transactions) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(4), 5);
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn);
+		CreateIndexes(conn, state.range(2));
+	}
+	unique_ptr<SQLiteStatement> query;
+	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		if(!query) {
+			string selectclause = "SELECT _id";
+			for(int i = 0; i < state.range(1); ++i) {
+				selectclause += ",a" + to_string(i);
+			}
+			query = make_unique<SQLiteStatement>(conn, selectclause + " FROM read_bench" + WhereClause(state.range(0)) + " LIMIT " + to_string(state.range(3)) + ";");
+		}
+		for(int n = 0; n < state.range(0); ++n) {
+			query->Bind(n + 1, (int64_t)dis(gen));
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		count += ReadAll(conn, *query, transactions);
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	state.SetItemsProcessed(count);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark.
+	// Meaning: per one second, how many 'foo's are processed?
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark, and the result inverted.
+	// Meaning: how many seconds it takes to process one 'foo'?
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsProj", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Reads, Normal, false)->Apply(CustomArgumentsInserts2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Reads, Transact, true)->Apply(CustomArgumentsInserts2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+// Sum, Avg and Mul: one prepared statement over the first range(0) rows
+static void BM_SQLITE_Read_Aggregate(benchmark::State& state, bool transactions, const string& selectclause, bool subquery) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn);
+		CreateIndexes(conn, 0);
+	}
+	unique_ptr<SQLiteStatement> query;
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		if(!query) {
+			string limit = " LIMIT " + to_string(state.range(0));
+			if(subquery)
+				query = make_unique<SQLiteStatement>(conn, selectclause + " FROM (SELECT * FROM read_bench" + limit + ") new;");
+			else
+				query = make_unique<SQLiteStatement>(conn, selectclause + " FROM read_bench" + limit + ";");
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		ReadAll(conn, *query, transactions);
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+	state.SetComplexityN(state.range(0));
+
+	state.SetItemsProcessed(state.range(0)*state.iterations());
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark.
+	// Meaning: per one second, how many 'foo's are processed?
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark, and the result inverted.
+	// Meaning: how many seconds it takes to process one 'foo'?
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+static void BM_SQLITE_Read_Sum(benchmark::State& state, bool transactions) {
+	BM_SQLITE_Read_Aggregate(state, transactions, "SELECT SUM(new.a0)", true);
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Sum, Normal, false)->Apply(CustomArgumentsInserts3)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Sum, Transact, true)->Apply(CustomArgumentsInserts3)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+static void BM_SQLITE_Read_Avg(benchmark::State& state, bool transactions) {
+	BM_SQLITE_Read_Aggregate(state, transactions, "SELECT AVG(new.a0)", true);
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Avg, Normal, false)->Apply(CustomArgumentsInserts3)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Avg, Transact, true)->Apply(CustomArgumentsInserts3)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+static void BM_SQLITE_Read_Mul(benchmark::State& state, bool transactions) {
+	BM_SQLITE_Read_Aggregate(state, transactions, "SELECT a0*2", false);
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Mul, Normal, false)->Apply(CustomArgumentsInserts3)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Mul, Transact, true)->Apply(CustomArgumentsInserts3)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+static void BM_SQLITE_Read_Sort(benchmark::State& state, bool transactions) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn);
+		CreateIndexes(conn, state.range(1));
+	}
+	unique_ptr<SQLiteStatement> query;
+	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		if(!query) {
+			string sql = "SELECT _id FROM read_bench";
+			if(state.range(0) > 0)  {
+				sql += " ORDER BY a0 DESC";
+				for(int n = 1; n < state.range(0); ++n) {
+					sql += ", a" + to_string(n) + " DESC";
+				}
+			}
+			sql += " LIMIT " + to_string(state.range(2)) + ";";
+			query = make_unique<SQLiteStatement>(conn, sql);
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		count += ReadAll(conn, *query, transactions);
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	state.SetItemsProcessed(count);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark.
+	// Meaning: per one second, how many 'foo's are processed?
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark, and the result inverted.
+	// Meaning: how many seconds it takes to process one 'foo'?
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Fields", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Sort, Normal, false)->Apply(CustomArgumentsInserts4)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Sort, Transact, true)->Apply(CustomArgumentsInserts4)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+static void BM_SQLITE_Read_Join(benchmark::State& state, bool transactions) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn);
+		CreateIndexes(conn, state.range(0), true);
+	}
+	unique_ptr<SQLiteStatement> query;
+	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		if(!query)
+			query = make_unique<SQLiteStatement>(conn, "SELECT * FROM read_bench b1 INNER JOIN read_bench b2 ON b1.a0 = b2.a1 AND b1._id != b2._id LIMIT " + to_string(state.range(1)) + ";");
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		count += ReadAll(conn, *query, transactions);
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+	state.SetComplexityN(state.range(1));
+
+	state.SetItemsProcessed(state.range(1)*state.iterations());
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark.
+	// Meaning: per one second, how many 'foo's are processed?
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark, and the result inverted.
+	// Meaning: how many seconds it takes to process one 'foo'?
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Indexes", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"Limit", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}});
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Join, Normal, false)->Apply(CustomArgumentsInserts5)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Read_Join, Transact, true)->Apply(CustomArgumentsInserts5)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
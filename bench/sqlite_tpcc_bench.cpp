@@ -0,0 +1,939 @@
+#include "benchmark/benchmark.h"
+#include "dbphd/sqlite/sqlite.hpp"
+#include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpcbackend.hpp"
+#include "dbphd/tpc/tpcpacing.hpp"
+#include "dbphd/tpc/tpcconflicts.hpp"
+#include "dbphd/tpc/tpcphases.hpp"
+#include "dbphd/tpc/tpcsnapshot.hpp"
+#include "tpccdriver.hpp"
+#include "tpccreport.hpp"
+
+using namespace tpcc;
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static string timestamp(const chrono::system_clock::time_point &time) {
+    return fmt::format("{:%Y-%m-%d %H:%M:%S}", time);
+}
+
+// Marks num random ids of [1, max] for the ORIGINAL / bad credit rows
+static vector<bool> selectIds(int num, int max) {
+    vector<bool> selected(max + 1, false);
+    for (int id : randomHelper.uniqueIds(num, 1, max)) {
+        selected[id] = true;
+    }
+    return selected;
+}
+
+// One writer at a time, so the tables load on a single connection in one
+// transaction per warehouse. The items are only loaded when loadItems.
+static void PopulateBenchmark(std::shared_ptr<sqlite3> conn, ScaleParameters &params,
+                              bool loadItems) {
+    seedLoader(0);
+    if (loadItems) {
+        SQLiteTransaction T(conn);
+        SQLiteStatement insertItem(conn, "INSERT INTO item VALUES (?, ?, ?, ?, ?);");
+        auto originalRows = selectIds(params.items / 10, params.items);
+        Item item;
+        for (int iId = 1; iId <= params.items; ++iId) {
+            randomHelper.generateItem(iId, originalRows[iId], item);
+            insertItem.Bind(1, (int64_t)item.iId).Bind(2, (int64_t)item.iImId)
+                .Bind(3, item.iName).Bind(4, item.iPrice).Bind(5, item.iData);
+            insertItem.Execute();
+        }
+        T.Commit();
+    }
+
+    SQLiteStatement insertWarehouse(
+        conn, "INSERT INTO warehouse VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);");
+    SQLiteStatement insertDistrict(
+        conn, "INSERT INTO district VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+    SQLiteStatement insertCustomer(
+        conn, "INSERT INTO customer VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+              "?, ?, ?, ?, ?, ?, ?, ?, ?);");
+    SQLiteStatement insertHistory(
+        conn, "INSERT INTO history VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+    SQLiteStatement insertOrder(
+        conn, "INSERT INTO orders VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+    SQLiteStatement insertOrderLine(
+        conn, "INSERT INTO order_line VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+    SQLiteStatement insertNewOrder(conn, "INSERT INTO new_order VALUES (?, ?, ?);");
+    SQLiteStatement insertStock(
+        conn, "INSERT INTO stock VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+              "?, ?, ?, ?);");
+    for (int wId = params.startingWarehouse; wId <= params.endingWarehouse; ++wId) {
+        SQLiteTransaction T(conn);
+        Warehouse warehouse;
+        randomHelper.generateWarehouse(wId, warehouse);
+        insertWarehouse.Bind(1, (int64_t)warehouse.wId).Bind(2, warehouse.wName)
+            .Bind(3, warehouse.wAddress.street1).Bind(4, warehouse.wAddress.street2)
+            .Bind(5, warehouse.wAddress.city).Bind(6, warehouse.wAddress.state)
+            .Bind(7, warehouse.wAddress.zip).Bind(8, warehouse.wTax)
+            .Bind(9, warehouse.wYtd);
+        insertWarehouse.Execute();
+
+        for (int dId = 1; dId <= params.districtsPerWarehouse; ++dId) {
+            District dist;
+            randomHelper.generateDistrict(dId, wId, params.customersPerDistrict + 1,
+                                          dist);
+            insertDistrict.Bind(1, (int64_t)dist.dWId).Bind(2, (int64_t)dist.dNextOId)
+                .Bind(3, (int64_t)dist.dId).Bind(4, dist.dYtd).Bind(5, dist.dTax)
+                .Bind(6, dist.dName).Bind(7, dist.dAddress.street1)
+                .Bind(8, dist.dAddress.street2).Bind(9, dist.dAddress.city)
+                .Bind(10, dist.dAddress.state).Bind(11, dist.dAddress.zip);
+            insertDistrict.Execute();
+
+            auto badCredit = selectIds(params.customersPerDistrict / 10,
+                                       params.customersPerDistrict);
+            vector<int> cIdPermutation;
+            cIdPermutation.reserve(params.customersPerDistrict);
+            Customer cust;
+            History hist;
+            for (int cId = 1; cId <= params.customersPerDistrict; ++cId) {
+                randomHelper.generateCustomer(wId, dId, cId, badCredit[cId], cust);
+                insertCustomer.Bind(1, (int64_t)cust.cId).Bind(2, (int64_t)cust.cWId)
+                    .Bind(3, (int64_t)cust.cDId).Bind(4, (int64_t)cust.cPaymentCnt)
+                    .Bind(5, (int64_t)cust.cDeliveryCnt).Bind(6, cust.cFirst)
+                    .Bind(7, cust.cMiddle).Bind(8, cust.cLast)
+                    .Bind(9, cust.cAddress.street1).Bind(10, cust.cAddress.street2)
+                    .Bind(11, cust.cAddress.city).Bind(12, cust.cAddress.state)
+                    .Bind(13, cust.cAddress.zip).Bind(14, cust.cPhone)
+                    .Bind(15, cust.cCredit).Bind(16, cust.cCreditLimit)
+                    .Bind(17, cust.cDiscount).Bind(18, cust.cBalance)
+                    .Bind(19, cust.cYtdPayment).Bind(20, cust.cData)
+                    .Bind(21, timestamp(cust.cSince));
+                insertCustomer.Execute();
+
+                randomHelper.generateHistory(wId, dId, cId, hist);
+                insertHistory.Bind(1, (int64_t)hist.hCId).Bind(2, (int64_t)hist.hCWId)
+                    .Bind(3, (int64_t)hist.hWId).Bind(4, (int64_t)hist.hCDId)
+                    .Bind(5, (int64_t)hist.hDId).Bind(6, hist.hAmount)
+                    .Bind(7, hist.hData).Bind(8, timestamp(hist.hDate));
+                insertHistory.Execute();
+
+                cIdPermutation.push_back(cId);
+            }
+            randomHelper.shuffle(cIdPermutation);
+
+            Order order;
+            OrderLine line;
+            for (int oId = 1; oId <= params.customersPerDistrict; ++oId) {
+                int oOlCnt = randomHelper.number(MIN_OL_CNT, MAX_OL_CNT);
+                bool newOrder =
+                    (params.customersPerDistrict - params.newOrdersPerDistrict) < oId;
+                randomHelper.generateOrder(wId, dId, oId, cIdPermutation[oId - 1],
+                                           oOlCnt, newOrder, order);
+                insertOrder.Bind(1, (int64_t)order.oId).Bind(2, (int64_t)order.oWId)
+                    .Bind(3, (int64_t)order.oDId).Bind(4, (int64_t)order.oCId);
+                if (order.oCarrierId == NULL_CARRIER_ID)
+                    insertOrder.BindNull(5);
+                else
+                    insertOrder.Bind(5, (int64_t)order.oCarrierId);
+                insertOrder.Bind(6, (int64_t)order.oOlCnt)
+                    .Bind(7, (int64_t)order.oAllLocal).Bind(8, timestamp(order.oEntryD));
+                insertOrder.Execute();
+
+                for (int olNumber = 1; olNumber <= oOlCnt; ++olNumber) {
+                    randomHelper.generateOrderLine(params, wId, dId, oId, olNumber,
+                                                   params.items, newOrder, line);
+                    insertOrderLine.Bind(1, (int64_t)line.olOId)
+                        .Bind(2, (int64_t)line.olWId).Bind(3, (int64_t)line.olDId)
+                        .Bind(4, (int64_t)line.olNumber).Bind(5, (int64_t)line.olIId)
+                        .Bind(6, (int64_t)line.olSupplyWId)
+                        .Bind(7, (int64_t)line.olQuantity).Bind(8, line.olAmount)
+                        .Bind(9, line.olDistInfo);
+                    if (line.olDeliveryD.time_since_epoch().count() == 0)
+                        insertOrderLine.BindNull(10);
+                    else
+                        insertOrderLine.Bind(10, timestamp(line.olDeliveryD));
+                    insertOrderLine.Execute();
+                }
+
+                if (newOrder) {
+                    insertNewOrder.Bind(1, (int64_t)wId).Bind(2, (int64_t)oId)
+                        .Bind(3, (int64_t)dId);
+                    insertNewOrder.Execute();
+                }
+            } // Order
+        }     // District
+
+        auto originalStockItems = selectIds(params.items / 10, params.items);
+        Stock stock;
+        for (int iId = 1; iId <= params.items; ++iId) {
+            randomHelper.generateStock(wId, iId, originalStockItems[iId], stock);
+            insertStock.Bind(1, (int64_t)stock.sIId).Bind(2, (int64_t)stock.sWId)
+                .Bind(3, (int64_t)stock.sYtd).Bind(4, (int64_t)stock.sQuantity)
+                .Bind(5, (int64_t)stock.sOrderCnt).Bind(6, (int64_t)stock.sRemoteCnt);
+            for (int dist = 0; dist < DISTRICTS_PER_WAREHOUSE; ++dist) {
+                insertStock.Bind(7 + dist, stock.sDists[dist]);
+            }
+            insertStock.Bind(17, stock.sData);
+            insertStock.Execute();
+        } // Stock items
+        T.Commit();
+    } // Warehouse
+}
+
+// Dropped in this order, the ones referring to others first
+static const vector<string> tpccTables = {"new_order", "history", "order_line", "orders", "stock",
+                                          "item", "customer", "district", "warehouse"};
+
+// What the transactions of a run change, put back from the snapshot of the
+// loaded dataset. The orders, order lines, new orders and payments of the run
+// are range deleted above the load-time marks of the snapshot (the next order
+// id of each district and the date of its latest payment), the new orders the
+// run delivered are inserted again and only the rows whose changed columns
+// differ from the snapshot are updated back.
+static const char *RESET_QUERY = R"|(
+DELETE FROM history WHERE h_date > (SELECT max(h_date) FROM snapshot.history);
+DELETE FROM new_order WHERE (no_w_id, no_d_id, no_o_id) IN (
+  SELECT n.no_w_id, n.no_d_id, n.no_o_id FROM snapshot.district d JOIN new_order n
+  ON n.no_w_id = d.d_w_id AND n.no_d_id = d.d_id AND n.no_o_id >= d.d_next_o_id);
+DELETE FROM order_line WHERE (ol_w_id, ol_d_id, ol_o_id) IN (
+  SELECT l.ol_w_id, l.ol_d_id, l.ol_o_id FROM snapshot.district d JOIN order_line l
+  ON l.ol_w_id = d.d_w_id AND l.ol_d_id = d.d_id AND l.ol_o_id >= d.d_next_o_id);
+DELETE FROM orders WHERE (o_w_id, o_d_id, o_id) IN (
+  SELECT o.o_w_id, o.o_d_id, o.o_id FROM snapshot.district d JOIN orders o
+  ON o.o_w_id = d.d_w_id AND o.o_d_id = d.d_id AND o.o_id >= d.d_next_o_id);
+INSERT OR IGNORE INTO new_order SELECT * FROM snapshot.new_order;
+UPDATE orders SET o_carrier_id = NULL FROM snapshot.orders s
+  WHERE orders.o_w_id = s.o_w_id AND orders.o_d_id = s.o_d_id AND orders.o_id = s.o_id
+  AND s.o_carrier_id IS NULL AND orders.o_carrier_id IS NOT NULL;
+UPDATE order_line SET ol_delivery_d = NULL FROM snapshot.order_line s
+  WHERE order_line.ol_w_id = s.ol_w_id AND order_line.ol_d_id = s.ol_d_id
+  AND order_line.ol_o_id = s.ol_o_id AND order_line.ol_number = s.ol_number
+  AND s.ol_delivery_d IS NULL AND order_line.ol_delivery_d IS NOT NULL;
+UPDATE customer SET (c_balance, c_ytd_payment, c_payment_cnt, c_delivery_cnt, c_data) =
+  (s.c_balance, s.c_ytd_payment, s.c_payment_cnt, s.c_delivery_cnt, s.c_data)
+  FROM snapshot.customer s
+  WHERE customer.c_w_id = s.c_w_id AND customer.c_d_id = s.c_d_id AND customer.c_id = s.c_id
+  AND (customer.c_payment_cnt, customer.c_delivery_cnt) IS NOT (s.c_payment_cnt, s.c_delivery_cnt);
+UPDATE stock SET (s_quantity, s_ytd, s_order_cnt, s_remote_cnt) =
+  (s.s_quantity, s.s_ytd, s.s_order_cnt, s.s_remote_cnt)
+  FROM snapshot.stock s
+  WHERE stock.s_w_id = s.s_w_id AND stock.s_i_id = s.s_i_id AND stock.s_order_cnt IS NOT s.s_order_cnt;
+UPDATE district SET (d_next_o_id, d_ytd) = (s.d_next_o_id, s.d_ytd) FROM snapshot.district s
+  WHERE district.d_w_id = s.d_w_id AND district.d_id = s.d_id
+  AND (district.d_next_o_id, district.d_ytd) IS NOT (s.d_next_o_id, s.d_ytd);
+UPDATE warehouse SET w_ytd = s.w_ytd FROM snapshot.warehouse s
+  WHERE warehouse.w_id = s.w_id AND warehouse.w_ytd IS NOT s.w_ytd;
+)|";
+
+// Puts the loaded dataset back the way it was loaded before the next run, so
+// repeated runs start from the same data. Without a snapshot the data of the
+// earlier runs stays.
+static void ResetBenchmark(std::shared_ptr<sqlite3> conn, const string &key) {
+    if (!snapshotsEnabled())
+        return;
+    auto start = chrono::steady_clock::now();
+    if (!SQLiteDBHandler::ResetTables(conn, snapshotDirectory() + "/" + key + ".sqlite",
+                                      RESET_QUERY)) {
+        cout << "No snapshot of " << key << " to reset to" << endl;
+        return;
+    }
+    auto end = chrono::steady_clock::now();
+    cout << "Reset SQLite TPC-C Tables in "
+         << chrono::duration<double, milli>(end - start).count() << " ms" << endl;
+    report::RunReport::global().recordLoad(
+        "sqlite", "tpcc_reset", chrono::duration<double, milli>(end - start).count());
+}
+
+// Adds the warehouses after the loaded ones, or deletes the surplus ones,
+// leaving the items alone, and snapshots the result as the resized dataset
+// key, so later runs are reset to it. Order lines of the remaining warehouses
+// supplied by a deleted one are supplied locally instead.
+static void ResizeBenchmark(std::shared_ptr<sqlite3> conn, const ScaleParameters &loaded,
+                            ScaleParameters &params, const string &key) {
+    cout << endl
+         << "Resizing SQLite TPC-C Tables from " << loaded.endingWarehouse << " to "
+         << params.endingWarehouse << " warehouses ..." << endl;
+    auto start = chrono::steady_clock::now();
+    if (params.endingWarehouse > loaded.endingWarehouse) {
+        auto added = warehouseRange(params, loaded.endingWarehouse + 1, params.endingWarehouse);
+        PopulateBenchmark(conn, added, false);
+    } else {
+        SQLiteTransaction T(conn);
+        for (auto &table : vector<pair<string, string>>{
+                 {"new_order", "no_w_id"}, {"order_line", "ol_w_id"}, {"history", "h_w_id"},
+                 {"orders", "o_w_id"}, {"customer", "c_w_id"}, {"stock", "s_w_id"},
+                 {"district", "d_w_id"}, {"warehouse", "w_id"}}) {
+            SQLiteDBHandler::Exec(conn, "DELETE FROM " + table.first + " WHERE " + table.second +
+                                            " > " + to_string(params.endingWarehouse));
+        }
+        SQLiteDBHandler::Exec(conn, "UPDATE order_line SET ol_supply_w_id = ol_w_id"
+                                    " WHERE ol_supply_w_id > " +
+                                        to_string(params.endingWarehouse));
+        T.Commit();
+    }
+    SQLiteDBHandler::Exec(conn, "ANALYZE");
+    if (snapshotsEnabled()) {
+        filesystem::create_directories(snapshotDirectory());
+        SQLiteDBHandler::SnapshotTables(conn, snapshotDirectory() + "/" + key + ".sqlite",
+                                        tpccTables);
+    }
+    auto end = chrono::steady_clock::now();
+    cout << " Done in " << chrono::duration<double, milli>(end - start).count()
+         << " ms" << endl
+         << endl;
+    report::RunReport::global().recordLoad(
+        "sqlite", "tpcc_resize", chrono::duration<double, milli>(end - start).count());
+}
+
+// The normalized schema of the Postgres old model, restored from the snapshot of
+// the dataset when there is one.
+static void LoadBenchmark(std::shared_ptr<sqlite3> conn, ScaleParameters &params,
+                          int clients) {
+    // The data stays for runs that only change the number of terminals, reset
+    // to the way it was loaded
+    static optional<DatasetKey> loaded;
+    DatasetKey dataset{"sqlite", "old", params, loadSeed()};
+    string key = dataset.name();
+    if (loaded && loaded->sameScale(dataset)) {
+        ResetBenchmark(conn, loaded->name());
+        return;
+    }
+    if (loaded && loaded->resizesTo(dataset)) {
+        ResetBenchmark(conn, loaded->name());
+        dataset.resized = true;
+        ResizeBenchmark(conn, loaded->params, params, dataset.name());
+        loaded = dataset;
+        return;
+    }
+    loaded.reset();
+    cout << endl << "Creating SQLite TPC-C Tables ..." << endl;
+    cout << "Warehouses: " << params.warehouses << " clients: " << clients << endl;
+    cout.flush();
+    auto start = chrono::steady_clock::now();
+    for (auto &table : tpccTables) {
+        SQLiteDBHandler::DropTable(conn, table);
+    }
+    string createQuery = R"|(
+CREATE TABLE warehouse (
+	w_id INTEGER PRIMARY KEY NOT NULL,
+	w_name VARCHAR(10) NOT NULL,
+	w_street_1 VARCHAR(20) NOT NULL,
+	w_street_2 VARCHAR(20) NOT NULL,
+	w_city VARCHAR(20) NOT NULL,
+	w_state VARCHAR(2) NOT NULL,
+	w_zip VARCHAR(9) NOT NULL,
+	w_tax REAL NOT NULL,
+	w_ytd REAL NOT NULL
+);
+
+CREATE TABLE district (
+  d_w_id INTEGER NOT NULL,
+  d_next_o_id INTEGER NOT NULL,
+  d_id INTEGER NOT NULL,
+  d_ytd REAL NOT NULL,
+  d_tax REAL NOT NULL,
+  d_name VARCHAR(10) NOT NULL,
+  d_street_1 VARCHAR(20) NOT NULL,
+  d_street_2 VARCHAR(20) NOT NULL,
+  d_city VARCHAR(20) NOT NULL,
+  d_state VARCHAR(2) NOT NULL,
+  d_zip VARCHAR(9) NOT NULL,
+  PRIMARY KEY (d_w_id, d_id)
+);
+
+CREATE TABLE customer (
+  c_id INTEGER NOT NULL,
+  c_w_id INTEGER NOT NULL,
+  c_d_id INTEGER NOT NULL,
+  c_payment_cnt INTEGER NOT NULL,
+  c_delivery_cnt INTEGER NOT NULL,
+  c_first VARCHAR(16) NOT NULL,
+  c_middle VARCHAR(2) NOT NULL,
+  c_last VARCHAR(16) NOT NULL,
+  c_street_1 VARCHAR(20) NOT NULL,
+  c_street_2 VARCHAR(20) NOT NULL,
+  c_city VARCHAR(20) NOT NULL,
+  c_state VARCHAR(2) NOT NULL,
+  c_zip VARCHAR(9) NOT NULL,
+  c_phone VARCHAR(16) NOT NULL,
+  c_credit VARCHAR(2) NOT NULL,
+  c_credit_lim REAL NOT NULL,
+  c_discount REAL NOT NULL,
+  c_balance REAL NOT NULL,
+  c_ytd_payment REAL NOT NULL,
+  c_data VARCHAR(500) NOT NULL,
+  c_since TEXT NOT NULL,
+  PRIMARY KEY (c_w_id, c_d_id, c_id)
+);
+
+CREATE TABLE history (
+  h_c_id INTEGER,
+  h_c_w_id INTEGER NOT NULL,
+  h_w_id INTEGER NOT NULL,
+  h_c_d_id INTEGER NOT NULL,
+  h_d_id INTEGER NOT NULL,
+  h_amount REAL NOT NULL,
+  h_data VARCHAR(24) NOT NULL,
+  h_date TEXT NOT NULL
+);
+
+CREATE TABLE new_order (
+  no_w_id INTEGER NOT NULL,
+  no_o_id INTEGER NOT NULL,
+  no_d_id INTEGER NOT NULL,
+  PRIMARY KEY (no_w_id, no_d_id, no_o_id)
+);
+
+CREATE TABLE orders (
+  o_id INTEGER NOT NULL,
+  o_w_id INTEGER NOT NULL,
+  o_d_id INTEGER NOT NULL,
+  o_c_id INTEGER NOT NULL,
+  o_carrier_id INTEGER,
+  o_ol_cnt INTEGER NOT NULL,
+  o_all_local INTEGER NOT NULL,
+  o_entry_d TEXT NOT NULL,
+  PRIMARY KEY (o_w_id, o_d_id, o_id)
+);
+
+CREATE TABLE order_line (
+  ol_o_id INTEGER NOT NULL,
+  ol_w_id INTEGER NOT NULL,
+  ol_d_id INTEGER NOT NULL,
+  ol_number INTEGER NOT NULL,
+  ol_i_id INTEGER NOT NULL,
+  ol_supply_w_id INTEGER NOT NULL,
+  ol_quantity INTEGER NOT NULL,
+  ol_amount REAL,
+  ol_dist_info VARCHAR(24),
+  ol_delivery_d TEXT,
+  PRIMARY KEY (ol_w_id, ol_d_id, ol_o_id, ol_number)
+);
+
+CREATE TABLE item (
+  i_id INTEGER PRIMARY KEY NOT NULL,
+  i_im_id INTEGER NOT NULL,
+  i_name VARCHAR(24) NOT NULL,
+  i_price REAL NOT NULL,
+  i_data VARCHAR(50) NOT NULL
+);
+
+CREATE TABLE stock (
+  s_i_id INTEGER NOT NULL,
+  s_w_id INTEGER NOT NULL,
+  s_ytd INTEGER NOT NULL,
+  s_quantity INTEGER NOT NULL,
+  s_order_cnt INTEGER NOT NULL,
+  s_remote_cnt INTEGER NOT NULL,
+  s_dist_01 VARCHAR(24) NOT NULL,
+  s_dist_02 VARCHAR(24) NOT NULL,
+  s_dist_03 VARCHAR(24) NOT NULL,
+  s_dist_04 VARCHAR(24) NOT NULL,
+  s_dist_05 VARCHAR(24) NOT NULL,
+  s_dist_06 VARCHAR(24) NOT NULL,
+  s_dist_07 VARCHAR(24) NOT NULL,
+  s_dist_08 VARCHAR(24) NOT NULL,
+  s_dist_09 VARCHAR(24) NOT NULL,
+  s_dist_10 VARCHAR(24) NOT NULL,
+  s_data VARCHAR(50) NOT NULL,
+  PRIMARY KEY (s_w_id, s_i_id)
+);
+)|";
+    SQLiteDBHandler::Exec(conn, createQuery);
+
+    string snapshot = snapshotDirectory() + "/" + key + ".sqlite";
+    bool restored = snapshotsEnabled() && SQLiteDBHandler::RestoreTables(conn, snapshot, tpccTables);
+    if (restored) {
+        cout << "Restored " << snapshot << endl;
+    } else {
+        PopulateBenchmark(conn, params, true);
+        if (snapshotsEnabled()) {
+            filesystem::create_directories(snapshotDirectory());
+            SQLiteDBHandler::SnapshotTables(conn, snapshot, tpccTables);
+        }
+    }
+
+    cout << "Done populating, indexing DB..." << endl;
+    SQLiteDBHandler::Exec(conn, R"|(
+CREATE UNIQUE INDEX customer_i2 ON customer (c_w_id, c_d_id, c_last, c_first, c_id);
+CREATE UNIQUE INDEX orders_i2 ON orders (o_w_id, o_d_id, o_c_id, o_id);
+ANALYZE;
+)|");
+    loaded = dataset;
+    auto end = chrono::steady_clock::now();
+    cout << " Done in " << chrono::duration<double, milli>(end - start).count()
+         << " ms" << endl
+         << endl;
+    report::RunReport::global().recordLoad(
+        "sqlite", restored ? "tpcc_restore" : "tpcc",
+        chrono::duration<double, milli>(end - start).count());
+    report::RunReport::global().describeEngine("sqlite",
+                                               [&] { return SQLiteDBHandler::ServerInfo(conn); });
+}
+
+namespace {
+// One terminal on its own connection. Every statement is prepared on first use
+// and kept for the rest of the run. The writing transactions begin IMMEDIATE, so
+// they wait for the write lock up front and never fail to upgrade a read lock.
+class SQLiteTPCC : public Backend {
+  public:
+    SQLiteTPCC() : conn(SQLiteDBHandler::GetConnection()) {}
+
+    void load(ScaleParameters &params, int clients) override {
+        LoadBenchmark(conn, params, clients);
+    }
+
+    bool newOrder(ScaleParameters &params) override {
+        randomHelper.generateNewOrderParams(params, noparams);
+        markPhase("begin", Phase::Execute);
+        SQLiteTransaction transaction(conn);
+
+        markPhase("NewOrderTXNUpdateDistrict", Phase::Build);
+        auto &district = statement(
+            "UPDATE district SET d_next_o_id = d_next_o_id + 1 WHERE d_w_id = ? "
+            "AND d_id = ? RETURNING d_tax, d_next_o_id - 1;");
+        district.Bind(1, (int64_t)noparams.wId).Bind(2, (int64_t)noparams.dId);
+        markPhase("NewOrderTXNUpdateDistrict", Phase::Execute);
+        district.Step();
+        markPhase("NewOrderTXNUpdateDistrict", Phase::Decode);
+        double dTax = district.Double(0);
+        int64_t oId = district.Int(1);
+        district.Execute();
+
+        markPhase("NewOrderTXNQueryWarehouse", Phase::Build);
+        auto &warehouse = statement("SELECT w_tax FROM warehouse WHERE w_id = ?;");
+        warehouse.Bind(1, (int64_t)noparams.wId);
+        markPhase("NewOrderTXNQueryWarehouse", Phase::Execute);
+        warehouse.Step();
+        markPhase("NewOrderTXNQueryWarehouse", Phase::Decode);
+        double wTax = warehouse.Double(0);
+        warehouse.Reset();
+
+        markPhase("NewOrderTXNQueryCustomer", Phase::Build);
+        auto &customer = statement("SELECT c_discount, c_last, c_credit FROM customer "
+                                   "WHERE c_w_id = ? AND c_d_id = ? AND c_id = ?;");
+        customer.Bind(1, (int64_t)noparams.wId).Bind(2, (int64_t)noparams.dId)
+            .Bind(3, (int64_t)noparams.cId);
+        markPhase("NewOrderTXNQueryCustomer", Phase::Execute);
+        customer.Step();
+        markPhase("NewOrderTXNQueryCustomer", Phase::Decode);
+        double cDiscount = customer.Double(0);
+        customer.Reset();
+
+        int olCnt = noparams.iIds.size();
+        bool allLocal = all_of(noparams.iIWds.begin(), noparams.iIWds.end(),
+                               [&](int wId) { return wId == noparams.wId; });
+        // Named like the other engines, which fetch the stock of a local
+        // order in one query and that of a remote one per warehouse
+        const char *stockPhase = allLocal ? "NewOrderTXNStockLocal" : "NewOrderTXNStockRemote";
+
+        markPhase("NewOrderTXNInsertOrder", Phase::Build);
+        auto &order = statement("INSERT INTO orders VALUES (?, ?, ?, ?, NULL, ?, ?, ?);");
+        order.Bind(1, oId).Bind(2, (int64_t)noparams.wId).Bind(3, (int64_t)noparams.dId)
+            .Bind(4, (int64_t)noparams.cId).Bind(5, (int64_t)olCnt)
+            .Bind(6, (int64_t)allLocal).Bind(7, timestamp(noparams.oEntryDate));
+        markPhase("NewOrderTXNInsertOrder", Phase::Execute);
+        order.Execute();
+
+        markPhase("NewOrderTXNInsertNewOrder", Phase::Build);
+        auto &newOrder = statement("INSERT INTO new_order VALUES (?, ?, ?);");
+        newOrder.Bind(1, (int64_t)noparams.wId).Bind(2, oId).Bind(3, (int64_t)noparams.dId);
+        markPhase("NewOrderTXNInsertNewOrder", Phase::Execute);
+        newOrder.Execute();
+
+        markPhase("NewOrderTXNItemQuery", Phase::Build);
+        auto &item = statement("SELECT i_price, i_name, i_data FROM item WHERE i_id = ?;");
+        auto &stock = statement(fmt::format(
+            "SELECT s_quantity, s_ytd, s_order_cnt, s_remote_cnt, s_data, s_dist_{:02d} "
+            "FROM stock WHERE s_w_id = ? AND s_i_id = ?;",
+            noparams.dId));
+        auto &updateStock = statement(
+            "UPDATE stock SET s_quantity = ?, s_ytd = ?, s_order_cnt = ?, "
+            "s_remote_cnt = ? WHERE s_w_id = ? AND s_i_id = ?;");
+        auto &orderLine = statement(
+            "INSERT INTO order_line VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, NULL);");
+        double total = 0;
+        for (int i = 0; i < olCnt; ++i) {
+            int olIId = noparams.iIds[i];
+            int olSupplyWId = noparams.iIWds[i];
+            int olQuantity = noparams.iQtys[i];
+
+            markPhase("NewOrderTXNItemQuery", Phase::Build);
+            item.Bind(1, (int64_t)olIId);
+            markPhase("NewOrderTXNItemQuery", Phase::Execute);
+            if (!item.Step()) {
+                // TPC-C 2.4.2.3, the unused item number rolls the order back
+                transaction.Rollback();
+                return false;
+            }
+            markPhase("NewOrderTXNItemQuery", Phase::Decode);
+            double iPrice = item.Double(0);
+            string iData = item.Text(2);
+            item.Reset();
+
+            markPhase(stockPhase, Phase::Build);
+            stock.Bind(1, (int64_t)olSupplyWId).Bind(2, (int64_t)olIId);
+            markPhase(stockPhase, Phase::Execute);
+            stock.Step();
+            markPhase(stockPhase, Phase::Decode);
+            int64_t sQuantity = stock.Int(0);
+            int64_t sYtd = stock.Int(1) + olQuantity;
+            int64_t sOrderCnt = stock.Int(2) + 1;
+            int64_t sRemoteCnt = stock.Int(3) + (olSupplyWId != noparams.wId ? 1 : 0);
+            string sData = stock.Text(4);
+            string sDistInfo = stock.Text(5);
+            stock.Reset();
+            if (sQuantity >= olQuantity + 10) {
+                sQuantity = sQuantity - olQuantity;
+            } else {
+                sQuantity = sQuantity + 91 - olQuantity;
+            }
+
+            markPhase("NewOrderTXNStockUpdate", Phase::Build);
+            updateStock.Bind(1, sQuantity).Bind(2, sYtd).Bind(3, sOrderCnt)
+                .Bind(4, sRemoteCnt).Bind(5, (int64_t)olSupplyWId)
+                .Bind(6, (int64_t)olIId);
+            markPhase("NewOrderTXNStockUpdate", Phase::Execute);
+            updateStock.Execute();
+
+            markPhase("NewOrderTXNInsertOrderLine", Phase::Build);
+            double olAmount = olQuantity * iPrice;
+            total += olAmount;
+            orderLine.Bind(1, oId).Bind(2, (int64_t)noparams.wId)
+                .Bind(3, (int64_t)noparams.dId).Bind(4, (int64_t)i + 1)
+                .Bind(5, (int64_t)olIId).Bind(6, (int64_t)olSupplyWId)
+                .Bind(7, (int64_t)olQuantity).Bind(8, olAmount).Bind(9, sDistInfo);
+            markPhase("NewOrderTXNInsertOrderLine", Phase::Execute);
+            orderLine.Execute();
+        }
+        total *= (1 - cDiscount) * (1 + wTax + dTax);
+
+        markPhase("commit", Phase::Execute);
+        transaction.Commit();
+        return true;
+    }
+
+    bool payment(ScaleParameters &params) override {
+        randomHelper.generatePaymentParams(params, pparams);
+        markPhase("begin", Phase::Execute);
+        SQLiteTransaction transaction(conn);
+
+        markPhase("PaymentTXNUpdateWarehouse", Phase::Build);
+        auto &warehouse = statement(
+            "UPDATE warehouse SET w_ytd = w_ytd + ? WHERE w_id = ? RETURNING w_name;");
+        warehouse.Bind(1, pparams.hAmount).Bind(2, (int64_t)pparams.wId);
+        markPhase("PaymentTXNUpdateWarehouse", Phase::Execute);
+        warehouse.Step();
+        markPhase("PaymentTXNUpdateWarehouse", Phase::Decode);
+        string wName = warehouse.Text(0);
+        warehouse.Execute();
+
+        markPhase("PaymentTXNUpdateDistrict", Phase::Build);
+        auto &district = statement("UPDATE district SET d_ytd = d_ytd + ? WHERE "
+                                   "d_w_id = ? AND d_id = ? RETURNING d_name;");
+        district.Bind(1, pparams.hAmount).Bind(2, (int64_t)pparams.wId)
+            .Bind(3, (int64_t)pparams.dId);
+        markPhase("PaymentTXNUpdateDistrict", Phase::Execute);
+        district.Step();
+        markPhase("PaymentTXNUpdateDistrict", Phase::Decode);
+        string dName = district.Text(0);
+        district.Execute();
+
+        int64_t cId = findCustomer(pparams.cWId, pparams.cDId, pparams.cId, pparams.cLast,
+                                   "PaymentTXNCustByLastName");
+
+        markPhase("PaymentTXNCustById", Phase::Build);
+        auto &customer = statement("SELECT c_credit, c_data FROM customer WHERE "
+                                   "c_w_id = ? AND c_d_id = ? AND c_id = ?;");
+        customer.Bind(1, (int64_t)pparams.cWId).Bind(2, (int64_t)pparams.cDId).Bind(3, cId);
+        markPhase("PaymentTXNCustById", Phase::Execute);
+        customer.Step();
+        markPhase("PaymentTXNCustById", Phase::Decode);
+        string cCredit = customer.Text(0);
+        string cData = customer.Text(1);
+        customer.Reset();
+
+        markPhase("PaymentTXNCustUpdate", Phase::Build);
+        if (cCredit == BAD_CREDIT) {
+            cData = fmt::format("{:d} {:d} {:d} {:d} {:d} {:f}|", cId, pparams.cDId,
+                                pparams.cWId, pparams.dId, pparams.wId,
+                                pparams.hAmount) +
+                    cData;
+            if (cData.length() > MAX_C_DATA)
+                cData.resize(MAX_C_DATA);
+            auto &update = statement(
+                "UPDATE customer SET c_balance = c_balance - ?, c_ytd_payment = "
+                "c_ytd_payment + ?, c_payment_cnt = c_payment_cnt + 1, c_data = ? "
+                "WHERE c_w_id = ? AND c_d_id = ? AND c_id = ?;");
+            update.Bind(1, pparams.hAmount).Bind(2, pparams.hAmount).Bind(3, cData)
+                .Bind(4, (int64_t)pparams.cWId).Bind(5, (int64_t)pparams.cDId)
+                .Bind(6, cId);
+            markPhase("PaymentTXNCustUpdate", Phase::Execute);
+            update.Execute();
+        } else {
+            auto &update = statement(
+                "UPDATE customer SET c_balance = c_balance - ?, c_ytd_payment = "
+                "c_ytd_payment + ?, c_payment_cnt = c_payment_cnt + 1 "
+                "WHERE c_w_id = ? AND c_d_id = ? AND c_id = ?;");
+            update.Bind(1, pparams.hAmount).Bind(2, pparams.hAmount)
+                .Bind(3, (int64_t)pparams.cWId).Bind(4, (int64_t)pparams.cDId)
+                .Bind(5, cId);
+            markPhase("PaymentTXNCustUpdate", Phase::Execute);
+            update.Execute();
+        }
+
+        markPhase("PaymentTXNHistory", Phase::Build);
+        auto &history = statement("INSERT INTO history VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+        history.Bind(1, cId).Bind(2, (int64_t)pparams.cWId).Bind(3, (int64_t)pparams.wId)
+            .Bind(4, (int64_t)pparams.cDId).Bind(5, (int64_t)pparams.dId)
+            .Bind(6, pparams.hAmount).Bind(7, wName + "    " + dName)
+            .Bind(8, timestamp(pparams.hDate));
+        markPhase("PaymentTXNHistory", Phase::Execute);
+        history.Execute();
+
+        markPhase("commit", Phase::Execute);
+        transaction.Commit();
+        return true;
+    }
+
+    bool orderStatus(ScaleParameters &params) override {
+        randomHelper.generateOrderStatusParams(params, osparams);
+        markPhase("begin", Phase::Execute);
+        SQLiteTransaction transaction(conn, false);
+
+        int64_t cId = findCustomer(osparams.wId, osparams.dId, osparams.cId, osparams.cLast,
+                                   "OrderStatusTXNCustByLastName");
+
+        markPhase("OrderStatusTXNCustById", Phase::Build);
+        auto &customer = statement("SELECT c_balance, c_first, c_middle, c_last FROM "
+                                   "customer WHERE c_w_id = ? AND c_d_id = ? AND c_id = ?;");
+        customer.Bind(1, (int64_t)osparams.wId).Bind(2, (int64_t)osparams.dId).Bind(3, cId);
+        markPhase("OrderStatusTXNCustById", Phase::Execute);
+        customer.Step();
+        customer.Reset();
+
+        markPhase("OrderStatusTXNOrders", Phase::Build);
+        auto &order = statement("SELECT o_id, o_carrier_id, o_entry_d FROM orders WHERE "
+                                "o_w_id = ? AND o_d_id = ? AND o_c_id = ? ORDER BY o_id "
+                                "DESC LIMIT 1;");
+        order.Bind(1, (int64_t)osparams.wId).Bind(2, (int64_t)osparams.dId).Bind(3, cId);
+        markPhase("OrderStatusTXNOrders", Phase::Execute);
+        bool found = order.Step();
+        assert(found);
+        markPhase("OrderStatusTXNOrders", Phase::Decode);
+        int64_t oId = order.Int(0);
+        order.Reset();
+
+        markPhase("OrderStatusTXNOrderLines", Phase::Build);
+        auto &orderLines = statement(
+            "SELECT ol_i_id, ol_supply_w_id, ol_quantity, ol_amount, ol_delivery_d "
+            "FROM order_line WHERE ol_w_id = ? AND ol_d_id = ? AND ol_o_id = ?;");
+        orderLines.Bind(1, (int64_t)osparams.wId).Bind(2, (int64_t)osparams.dId).Bind(3, oId);
+        int lines = 0;
+        markPhase("OrderStatusTXNOrderLines", Phase::Execute);
+        while (orderLines.Step()) {
+            lines++;
+        }
+        orderLines.Reset();
+        assert(lines > 0);
+
+        markPhase("commit", Phase::Execute);
+        transaction.Commit();
+        return true;
+    }
+
+    bool delivery(ScaleParameters &params) override {
+        randomHelper.generateDeliveryParams(params, dparams);
+        markPhase("begin", Phase::Execute);
+        SQLiteTransaction transaction(conn);
+
+        markPhase("DeliveryTXNNewOrder", Phase::Build);
+        auto &newOrder = statement("SELECT no_o_id FROM new_order WHERE no_w_id = ? AND "
+                                   "no_d_id = ? ORDER BY no_o_id ASC LIMIT 1;");
+        auto &deleteNewOrder = statement(
+            "DELETE FROM new_order WHERE no_w_id = ? AND no_d_id = ? AND no_o_id = ?;");
+        auto &order = statement("UPDATE orders SET o_carrier_id = ? WHERE o_w_id = ? "
+                                "AND o_d_id = ? AND o_id = ? RETURNING o_c_id;");
+        auto &orderLines = statement(
+            "UPDATE order_line SET ol_delivery_d = ? WHERE ol_w_id = ? AND ol_d_id = ? "
+            "AND ol_o_id = ? RETURNING ol_amount;");
+        auto &customer = statement(
+            "UPDATE customer SET c_balance = c_balance + ?, c_delivery_cnt = "
+            "c_delivery_cnt + 1 WHERE c_w_id = ? AND c_d_id = ? AND c_id = ?;");
+        string deliveryDate = timestamp(dparams.olDeliveryD);
+        for (int dId = 1; dId <= params.districtsPerWarehouse; ++dId) {
+            markConflictKey(dparams.wId, dId);
+            markPhase("DeliveryTXNNewOrder", Phase::Build);
+            newOrder.Bind(1, (int64_t)dparams.wId).Bind(2, (int64_t)dId);
+            markPhase("DeliveryTXNNewOrder", Phase::Execute);
+            if (!newOrder.Step()) {
+                // No orders for this district, counted as no_new_orders
+                newOrder.Reset();
+                noNewOrders++;
+                continue;
+            }
+            markPhase("DeliveryTXNNewOrder", Phase::Decode);
+            int64_t oId = newOrder.Int(0);
+            newOrder.Reset();
+
+            markPhase("DeliveryTXNNewOrderDelete", Phase::Build);
+            deleteNewOrder.Bind(1, (int64_t)dparams.wId).Bind(2, (int64_t)dId).Bind(3, oId);
+            markPhase("DeliveryTXNNewOrderDelete", Phase::Execute);
+            deleteNewOrder.Execute();
+
+            markPhase("DeliveryTXNUpdateOrder", Phase::Build);
+            order.Bind(1, (int64_t)dparams.oCarrierId).Bind(2, (int64_t)dparams.wId)
+                .Bind(3, (int64_t)dId).Bind(4, oId);
+            markPhase("DeliveryTXNUpdateOrder", Phase::Execute);
+            order.Step();
+            markPhase("DeliveryTXNUpdateOrder", Phase::Decode);
+            int64_t cId = order.Int(0);
+            order.Execute();
+
+            markPhase("DeliveryTXNUpdateOrderLines", Phase::Build);
+            orderLines.Bind(1, deliveryDate).Bind(2, (int64_t)dparams.wId)
+                .Bind(3, (int64_t)dId).Bind(4, oId);
+            double total = 0;
+            markPhase("DeliveryTXNUpdateOrderLines", Phase::Execute);
+            while (orderLines.Step()) {
+                total += orderLines.Double(0);
+            }
+            orderLines.Reset();
+
+            markPhase("DeliveryTXNUpdateCust", Phase::Build);
+            customer.Bind(1, total).Bind(2, (int64_t)dparams.wId).Bind(3, (int64_t)dId)
+                .Bind(4, cId);
+            markPhase("DeliveryTXNUpdateCust", Phase::Execute);
+            customer.Execute();
+        }
+
+        markPhase("commit", Phase::Execute);
+        transaction.Commit();
+        return true;
+    }
+
+    bool stockLevel(ScaleParameters &params) override {
+        randomHelper.generateStockLevelParams(params, sparams);
+        markPhase("begin", Phase::Execute);
+        SQLiteTransaction transaction(conn, false);
+
+        markPhase("StockLevelTXNDistQuery", Phase::Build);
+        auto &district = statement(
+            "SELECT d_next_o_id FROM district WHERE d_w_id = ? AND d_id = ?;");
+        district.Bind(1, (int64_t)sparams.wId).Bind(2, (int64_t)sparams.dId);
+        markPhase("StockLevelTXNDistQuery", Phase::Execute);
+        district.Step();
+        markPhase("StockLevelTXNDistQuery", Phase::Decode);
+        int64_t nextOId = district.Int(0);
+        district.Reset();
+
+        markPhase("StockLevelTXNStockQuery", Phase::Build);
+        auto &stock = statement(
+            "SELECT COUNT(DISTINCT(s_i_id)) FROM order_line, stock WHERE ol_w_id = ? "
+            "AND ol_d_id = ? AND ol_o_id < ? AND ol_o_id >= ? AND s_w_id = ? AND "
+            "s_i_id = ol_i_id AND s_quantity < ?;");
+        stock.Bind(1, (int64_t)sparams.wId).Bind(2, (int64_t)sparams.dId)
+            .Bind(3, nextOId).Bind(4, nextOId - 20).Bind(5, (int64_t)sparams.wId)
+            .Bind(6, (int64_t)sparams.threshold);
+        markPhase("StockLevelTXNStockQuery", Phase::Execute);
+        stock.Step();
+        stock.Reset();
+
+        markPhase("commit", Phase::Execute);
+        transaction.Commit();
+        return true;
+    }
+
+    // A writer that waited out the busy timeout lost to the others
+    FailureKind classify(const std::exception &e) const override {
+        auto error = dynamic_cast<const SQLiteException *>(&e);
+        if (error != nullptr && error->IsBusy())
+            return FailureKind::Conflict;
+        return FailureKind::Transient;
+    }
+
+    void counters(std::map<std::string, double> &out) const override {
+        out["no_new_orders"] = noNewOrders;
+    }
+
+    // TPC-C 3.3.2.1-3.3.2.3 as anomaly counts, like the in-memory engine
+    void finish(std::map<std::string, double> &out) override {
+        SQLiteTransaction transaction(conn, false);
+        auto count = [&](const string &sql) {
+            auto &anomalies = statement(sql);
+            anomalies.Step();
+            int64_t result = anomalies.Int(0);
+            anomalies.Reset();
+            return result;
+        };
+        // Money is summed in doubles, allow for the rounding
+        out["anomalyWarehouseYtd"] =
+            count("SELECT COUNT(*) FROM warehouse WHERE abs(w_ytd - (SELECT "
+                  "SUM(d_ytd) FROM district WHERE d_w_id = w_id)) > 0.005;");
+        out["anomalyDistrictNextOId"] =
+            count("SELECT COUNT(*) FROM district WHERE d_next_o_id - 1 != (SELECT "
+                  "MAX(o_id) FROM orders WHERE o_w_id = d_w_id AND o_d_id = d_id);");
+        out["anomalyNewOrderGaps"] =
+            count("SELECT COUNT(*) FROM (SELECT no_w_id FROM new_order GROUP BY "
+                  "no_w_id, no_d_id HAVING MAX(no_o_id) - MIN(no_o_id) + 1 != COUNT(*));");
+        transaction.Commit();
+    }
+
+  private:
+    shared_ptr<sqlite3> conn;
+    map<string, unique_ptr<SQLiteStatement>> statements;
+    int noNewOrders = 0;
+    // Reused so generating the inputs does not allocate on every transaction
+    NewOrderParams noparams;
+    PaymentParams pparams;
+    OrderStatusParams osparams;
+    DeliveryParams dparams;
+    StockLevelParams sparams;
+
+    // Reset, in case a failed transaction left it mid step
+    SQLiteStatement &statement(const string &sql) {
+        auto &prepared = statements[sql];
+        if (!prepared)
+            prepared = make_unique<SQLiteStatement>(conn, sql);
+        prepared->Reset(true);
+        return *prepared;
+    }
+
+    // The customer by id, or the middle one by last name ordered by c_first
+    // (2.5.2.2), the lookup timed as phase
+    int64_t findCustomer(int wId, int dId, int cId, const string &cLast,
+                         const char *phase) {
+        if (cId != INT32_MIN)
+            return cId;
+        markPhase(phase, Phase::Build);
+        auto &byLast = statement("SELECT c_id FROM customer WHERE c_w_id = ? AND "
+                                 "c_d_id = ? AND c_last = ? ORDER BY c_first;");
+        byLast.Bind(1, (int64_t)wId).Bind(2, (int64_t)dId).Bind(3, cLast);
+        vector<int64_t> customers;
+        markPhase(phase, Phase::Execute);
+        while (byLast.Step()) {
+            customers.push_back(byLast.Int(0));
+        }
+        byLast.Reset();
+        assert(!customers.empty());
+        return customers[(customers.size() - 1) / 2];
+    }
+};
+} // namespace
+
+static void BM_SQLITE_TPCC(benchmark::State &state, ArrivalProcess arrival) {
+    runTPCC(state, "sqlite_tpcc", arrival, [](benchmark::State & /*state*/) {
+        return make_unique<SQLiteTPCC>();
+    });
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_TPCC, Closed, ArrivalProcess::Closed)->RangeMultiplier(2)->Range(1,10)->ThreadRange(1,16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_SQLITE_TPCC, Constant, ArrivalProcess::Constant)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
+BENCHMARK_CAPTURE(BM_SQLITE_TPCC, Poisson, ArrivalProcess::Poisson)->Apply(TPCCOpenLoopArguments)->Threads(16)->Apply(TPCCMeasurementWindow);
@@ -0,0 +1,299 @@
+#include "benchmark/benchmark.h"
+#include "dbphd/sqlite/sqlite.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "benchperf.hpp"
+#include "precalculate.hpp"
+
+#include <random>
+#include <iostream>
+#include <chrono>
+
+using namespace std;
+
+static void CustomArgumentsUpdates(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
+			for (int k = 0; k <= i; ++k) { //  Indexes
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
+			}
+		}
+	}
+}
+
+static void CustomArgumentsUpdates2(benchmark::internal::Benchmark* b) {
+	for (int i = 0; i <= Precalculator::Columns(); ++i) { // fields to query
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
+			for (int k = 0; k <= j; ++k) { //  Indexes
+				for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+					b->Args({i, j, k, d});
+				}
+			}
+		}
+	}
+}
+
+// Keyed batches of changes: batch size, fields changed and how many of them
+// are indexed, with every bulk update method and key distribution
+static void CustomArgumentsBulkUpdates(benchmark::internal::Benchmark* b) {
+	for (int i = 1; i <= 10000 && i <= (int64_t)Precalculator::Rows(); i *= 10) { // Changes per batch
+		for (int j = 1; j <= Precalculator::Columns(); ++j) { // fields to write
+			for (int k = 0; k <= j; ++k) { //  Indexes on the written fields
+				for (int l = 0; l <= 1; ++l) { // Bulk update method
+					for (int d = 0; d < Precalculator::QueryDistributions(); ++d) { // Key distributions
+						b->Args({i, j, k, l, d});
+					}
+				}
+			}
+		}
+	}
+}
+
+static void CreateTable(std::shared_ptr<sqlite3> conn, bool doublefields = false) {
+	static volatile bool created = false;
+	if(!created) {
+		cout << endl << "Creating SQLite Update Table...";
+		cout.flush();
+		auto start = chrono::steady_clock::now();
+		SQLiteDBHandler::DropTable(conn, "update_bench");
+		string createQuery = R"|(
+CREATE TABLE update_bench (
+	_id  INTEGER PRIMARY KEY,
+)|";
+		string insertQuery = "INSERT INTO update_bench VALUES (NULL";
+		for(int field = 0; field < Precalculator::Columns(); ++field) {
+			createQuery.append("a" + to_string(field) + " INT");
+			if(field != Precalculator::Columns()-1)
+				createQuery.append(",\r\n");
+			insertQuery.append(",?");
+		}
+		if(doublefields) {
+			createQuery.append(",\r\n");
+			for(int field = 0; field < Precalculator::Columns(); ++field) {
+				createQuery.append("b" + to_string(field) + " INT");
+				if(field != Precalculator::Columns()-1)
+					createQuery.append(",\r\n");
+				insertQuery.append(",?");
+			}
+		}
+		createQuery.append(R"|(
+);
+)|");
+		insertQuery.append(");");
+		SQLiteDBHandler::Exec(conn, createQuery);
+
+		SQLiteTransaction T(conn);
+		SQLiteStatement insert(conn, insertQuery);
+		for(uint64_t i = 0; i < Precalculator::Rows(); ++i) {
+			auto rowval = Precalculator::RowAt(i);
+			int column = 1;
+			for(int f = 0; f < Precalculator::Columns(); ++f) {
+				insert.Bind(column++, (int64_t)rowval[f]);
+			}
+			if(doublefields) {
+				for(int f = 0; f < Precalculator::Columns(); ++f) {
+					insert.Bind(column++, (int64_t)rowval[f]);
+				}
+			}
+			insert.Execute();
+		}
+		T.Commit();
+		auto end = chrono::steady_clock::now();
+		cout<< " Done in " << chrono::duration <double, milli> (end-start).count() << " ms" << endl << endl;
+		report::RunReport::global().recordLoad("sqlite", "update_bench", chrono::duration <double, milli> (end-start).count());
+		report::RunReport::global().describeEngine("sqlite", [&] { return SQLiteDBHandler::ServerInfo(conn); });
+		cout.flush();
+	}
+	created = true;
+}
+
+static void CreateIndex(std::shared_ptr<sqlite3> conn, const string& name, const string& prefix, int columns) {
+	if(columns > 0) {
+		string indexCreate = "CREATE INDEX " + name + " on update_bench (" + prefix + "0";
+		for(int index = 1; index < columns; ++index) {
+			indexCreate += "," + prefix + to_string(index);
+		}
+		indexCreate += ");";
+		SQLiteDBHandler::Exec(conn, indexCreate);
+	}
+}
+
+static void BM_SQLITE_Update(benchmark::State& state, bool transactions, bool testwriteindexes) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	KeyDistribution dis = Precalculator::QueryKeys(state.range(3), 5);
+	std::uniform_int_distribution<> dis2(1, 100);
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn, true);
+		SQLiteDBHandler::Exec(conn, "DROP INDEX IF EXISTS update_bench_idx;");
+		SQLiteDBHandler::Exec(conn, "DROP INDEX IF EXISTS update_bench_idx2;");
+		if(testwriteindexes) {
+			CreateIndex(conn, "update_bench_idx", "a", state.range(0));
+			CreateIndex(conn, "update_bench_idx2", "b", state.range(2));
+		} else {
+			CreateIndex(conn, "update_bench_idx", "a", state.range(2));
+		}
+		SQLiteDBHandler::Exec(conn, "ANALYZE update_bench;");
+	}
+	// The increments are bound first, then the WHERE values
+	string query = "UPDATE update_bench SET b0 = b0 + ?";
+	for(int i = 1; i < state.range(1); ++i) {
+		query += ",b" + to_string(i) + " = b" + to_string(i) + " + ?";
+	}
+	if(state.range(0) > 0)  {
+		query += " WHERE\r\n a0 = ?";
+		for(int n = 1; n < state.range(0); ++n) {
+			query += " AND a" + to_string(n) + " = ?";
+		}
+	}
+	query += ";";
+	unique_ptr<SQLiteStatement> update;
+	uint64_t count = 0;
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		// Prepared after the start barrier, when thread 0 built the indexes
+		if(!update)
+			update = make_unique<SQLiteStatement>(conn, query);
+		int parameter = 1;
+		for(int i = 0; i < state.range(1); ++i) {
+			update->Bind(parameter++, (int64_t)dis2(gen));
+		}
+		for(int n = 0; n < state.range(0); ++n) {
+			update->Bind(parameter++, (int64_t)dis(gen));
+		}
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		unique_ptr<SQLiteTransaction> T;
+		if(transactions)
+			T = make_unique<SQLiteTransaction>(conn);
+		count += update->Execute();
+		if(transactions)
+			T->Commit();
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	state.SetItemsProcessed(count);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark.
+	// Meaning: per one second, how many 'foo's are processed?
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+
+	// Set the counter as a rate. It will be presented divided
+	// by the duration of the benchmark, and the result inverted.
+	// Meaning: how many seconds it takes to process one 'foo'?
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"FieldsQueried", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsChanged", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, dis);
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Update, Normal, false, false)->Apply(CustomArgumentsUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Update, Transact, true, false)->Apply(CustomArgumentsUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Update, NormalWriteIdx, false, true)->Apply(CustomArgumentsUpdates2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Update, TransactWriteIdx, true, true)->Apply(CustomArgumentsUpdates2)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+
+// How BM_SQLITE_Update_Bulk applies a batch of keyed changes
+enum class BulkUpdate {
+	Values = 0, // UPDATE ... FROM (VALUES ...)
+	Upsert = 1  // INSERT ... VALUES ... ON CONFLICT DO UPDATE
+};
+
+// Sets the first fields b columns of a batch of rows picked by their _id, all
+// in one statement with the changes in its text, as an ETL job applying
+// keyed changes would. The statement is prepared in the timed part, like the
+// servers parse theirs. The keys of a batch are sorted and each is sent once,
+// as by the server engines.
+static void BM_SQLITE_Update_Bulk(benchmark::State& state, bool transactions) {
+	auto conn = SQLiteDBHandler::GetConnection();
+	std::random_device rd;  //Will be used to obtain a seed for the random number engine
+	std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
+	KeyDistribution keys = Precalculator::QueryKeys(state.range(4), Precalculator::Rows());
+	std::uniform_int_distribution<> dis2(1, 100);
+	// Per thread settings...
+	if(state.thread_index() == 0) {
+		// This is the first thread, so do initialization here, build indexes etc...
+		CreateTable(conn, true);
+		SQLiteDBHandler::Exec(conn, "DROP INDEX IF EXISTS update_bench_idx;");
+		SQLiteDBHandler::Exec(conn, "DROP INDEX IF EXISTS update_bench_idx2;");
+		CreateIndex(conn, "update_bench_idx2", "b", state.range(2));
+		SQLiteDBHandler::Exec(conn, "ANALYZE update_bench;");
+	}
+	const int batch = state.range(0), fields = state.range(1);
+	auto method = (BulkUpdate)state.range(3);
+	string prefix, suffix;
+	if(method == BulkUpdate::Values) {
+		prefix = "UPDATE update_bench SET b0 = v.column2";
+		for(int i = 1; i < fields; ++i) {
+			prefix += ",b" + to_string(i) + " = v.column" + to_string(i + 2);
+		}
+		prefix += " FROM (VALUES ";
+		suffix = ") AS v WHERE update_bench._id = v.column1;";
+	} else {
+		prefix = "INSERT INTO update_bench (_id,b0";
+		suffix = " ON CONFLICT(_id) DO UPDATE SET b0 = excluded.b0";
+		for(int i = 1; i < fields; ++i) {
+			prefix += ",b" + to_string(i);
+			suffix += ",b" + to_string(i) + " = excluded.b" + to_string(i);
+		}
+		prefix += ") VALUES ";
+		suffix += ";";
+	}
+	int64_t changes = 0;
+	PerfIterations perfIterations(state);
+	for(auto _ : state) {
+		state.PauseTiming();
+		auto batchKeys = keys.Batch(gen, batch);
+		string query = prefix;
+		for(size_t n = 0; n < batchKeys.size(); ++n) {
+			query += (n == 0 ? "(" : ",(") + to_string(batchKeys[n] + 1);
+			for(int i = 0; i < fields; ++i) {
+				query += "," + to_string(dis2(gen));
+			}
+			query += ")";
+		}
+		query += suffix;
+		state.ResumeTiming();
+		perfIterations.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		unique_ptr<SQLiteTransaction> T;
+		if(transactions)
+			T = make_unique<SQLiteTransaction>(conn);
+		SQLiteStatement update(conn, query);
+		update.Execute();
+		if(transactions)
+			T->Commit();
+		changes += batchKeys.size();
+		auto end = std::chrono::high_resolution_clock::now();
+		perfIterations.stop();
+
+		auto elapsed_seconds =
+			std::chrono::duration_cast<std::chrono::duration<double>>(
+					end - start);
+
+		state.SetIterationTime(elapsed_seconds.count());
+	}
+
+	state.SetComplexityN(state.range(0));
+	// The changes committed, a key drawn more than once in a batch counts once
+	state.SetItemsProcessed(changes);
+	state.counters["Ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+	state.counters["OpsInv"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters.insert({{"Batch", benchmark::Counter(state.range(0), benchmark::Counter::kAvgThreads)}, {"FieldsChanged", benchmark::Counter(state.range(1), benchmark::Counter::kAvgThreads)}, {"Indexes", benchmark::Counter(state.range(2), benchmark::Counter::kAvgThreads)}, {"Method", benchmark::Counter(state.range(3), benchmark::Counter::kAvgThreads)}});
+	Precalculator::KeyCounters(state, keys);
+}
+
+BENCHMARK_CAPTURE(BM_SQLITE_Update_Bulk, Normal, false)->Apply(CustomArgumentsBulkUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
+BENCHMARK_CAPTURE(BM_SQLITE_Update_Bulk, Transact, true)->Apply(CustomArgumentsBulkUpdates)->Complexity()->DenseThreadRange(1, 8, 2)->UseManualTime();
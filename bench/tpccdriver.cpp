@@ -0,0 +1,287 @@
+#include "tpccdriver.hpp"
+#include "dbphd/tpc/tpchistogram.hpp"
+#include "dbphd/tpc/tpcmetrics.hpp"
+#include "dbphd/tpc/tpcconflicts.hpp"
+#include "dbphd/tpc/tpcphases.hpp"
+#include "dbphd/tpc/tpcregistry.hpp"
+#include "dbphd/tpc/tpcwindow.hpp"
+#include "dbphd/perf/affinity.hpp"
+#include "dbphd/perf/perfcounters.hpp"
+#include "dbphd/report/runreport.hpp"
+#include "tpccreport.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace tpcc;
+
+// Written by thread 0 before the benchmark's start barrier, read by all terminals
+static ScaleParameters params = ScaleParameters::makeDefault(4);
+
+// Hardware counter totals per terminal, one kind per transaction type. Like the
+// latency histograms they are merged by thread 0 after the end of loop barrier.
+static TerminalRegistry<perf::EventTotals, TransactionLatencies::TYPES> terminalEvents;
+using TransactionEvents = array<perf::EventTotals *, TransactionLatencies::TYPES>;
+
+static TransactionEvents eventsForThread(int thread) {
+    TransactionEvents events;
+    for (int i = 0; i < TransactionLatencies::TYPES; ++i)
+        events[i] = &terminalEvents.forThread(thread, i);
+    return events;
+}
+
+// <type><Event> and txn<Event>, the average per transaction of every open event
+static void publishEvents(benchmark::State &state) {
+    auto &counters = perf::ThreadCounters::forThread();
+    perf::EventTotals all;
+    for (int i = 0; i < TransactionLatencies::TYPES; ++i) {
+        perf::EventTotals merged = terminalEvents.merge(state.threads(), i);
+        all.merge(merged);
+        for (int e = 0; e < perf::EVENTS; ++e) {
+            auto event = static_cast<perf::Event>(e);
+            if (counters.isOpen(event))
+                state.counters[string(transactionTypeName(static_cast<TransactionType>(i))) +
+                               perf::eventName(event)] = merged.average(event);
+        }
+    }
+    for (int e = 0; e < perf::EVENTS; ++e) {
+        auto event = static_cast<perf::Event>(e);
+        if (counters.isOpen(event))
+            state.counters[string("txn") + perf::eventName(event)] = all.average(event);
+    }
+}
+
+// CPUs each terminal ran on, written by the terminal itself once pinned
+static mutex cpusMutex;
+static vector<string> terminalCpus;
+
+static void recordTerminalCpus(int thread) {
+    string cpus = perf::formatCpuList(perf::currentCpus());
+    lock_guard<mutex> lock(cpusMutex);
+    if (terminalCpus.size() <= (size_t)thread)
+        terminalCpus.resize(thread + 1);
+    terminalCpus[thread] = cpus;
+}
+
+static vector<string> runCpus(int threads) {
+    lock_guard<mutex> lock(cpusMutex);
+    return vector<string>(terminalCpus.begin(),
+                          terminalCpus.begin() + min((size_t)threads, terminalCpus.size()));
+}
+
+static void publishRate(benchmark::State &state, const string &name, int count) {
+    state.counters[name] = count;
+    state.counters[name + "Rate"] =
+        benchmark::Counter(count, benchmark::Counter::kIsRate);
+    state.counters[name + "RateInv"] = benchmark::Counter(
+        count, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+void runTPCC(benchmark::State &state, const string &name,
+             ArrivalProcess arrival, const BackendFactory &factory) {
+    // Before the backend and the per terminal state are allocated, so that they
+    // end up on the terminal's NUMA node
+    perf::ScopedAffinity pinned(perf::workerCpus(state.thread_index()));
+    recordTerminalCpus(state.thread_index());
+    auto backend = factory(state);
+    if (state.thread_index() == 0) {
+        int warehouses = state.range(0);
+        params = ScaleParameters::makeDefault(warehouses);
+        try {
+            backend->load(params, state.threads());
+        } catch (...) {
+            cerr << "Error loading benchmark" << endl;
+            throw;
+        }
+    }
+    array<int, TransactionLatencies::TYPES> counts{};
+    int numFailedNewOrders = 0;
+    int numConflicts = 0;
+    int numErrors = 0;
+    double cpuTime = 0;
+    ArrivalSchedule schedule = terminalSchedule(state, arrival);
+    auto &latencies = LatencyRegistry::forThread(state.thread_index());
+    auto &responseLatencies =
+        LatencyRegistry::forThread(state.thread_index(), LatencyKind::Response);
+    perf::ThreadCounters *hardware =
+        perf::enabled() ? &perf::ThreadCounters::forThread() : nullptr;
+    auto events = eventsForThread(state.thread_index());
+    PhaseProfile *phases =
+        phasesEnabled() ? &PhaseRegistry::forThread(state.thread_index()) : nullptr;
+    auto window = MeasurementWindow::fromEnvironment();
+    auto &throughput = ThroughputRegistry::forThread(state.thread_index());
+    auto &conflicts = ConflictRegistry::forThread(state.thread_index());
+    // Backend counters (e.g. retries) at the start and end of the measurement window
+    map<string, double> countersBefore, countersAfter;
+    // Server statistics are global, terminal 0 snapshots them for the whole run
+    map<string, double> statisticsBefore, statisticsAfter;
+    bool windowStarted = false, windowEnded = false;
+    for (auto _ : state) {
+        // params is only complete after the start barrier
+        if (homeWarehousesEnabled())
+            RandomHelper::setHome(makeTerminalHome(params, state.thread_index()));
+        auto runStart = chrono::steady_clock::now();
+        // A terminal that is behind schedule stops at the end of the ramp down even
+        // with transactions of the measurement window still queued
+        while (chrono::steady_clock::now() - runStart < window.total()) {
+            auto intended = schedule.next();
+            RunStage stage = window.stageAt(intended - runStart);
+            if (stage == RunStage::Done)
+                break;
+            bool measured = stage == RunStage::Measure;
+            if (measured && !windowStarted) {
+                backend->counters(countersBefore);
+                if (state.thread_index() == 0)
+                    backend->serverStatistics(statisticsBefore);
+                windowStarted = true;
+            } else if (stage == RunStage::RampDown && !windowEnded) {
+                backend->counters(countersAfter);
+                if (state.thread_index() == 0)
+                    backend->serverStatistics(statisticsAfter);
+                windowEnded = true;
+            }
+            TransactionType type = randomHelper.nextTransactionType();
+            perf::Sample eventsStart;
+            if (hardware && measured)
+                eventsStart = hardware->read();
+            auto start = chrono::steady_clock::now();
+            double cpuStart = threadCPUTime();
+            if (phases && measured)
+                phases->begin(type);
+            if (measured)
+                conflicts.begin(type);
+            try {
+                bool result = false;
+                switch (type) {
+                case TransactionType::Delivery:
+                    result = backend->delivery(params);
+                    break;
+                case TransactionType::OrderStatus:
+                    result = backend->orderStatus(params);
+                    break;
+                case TransactionType::Payment:
+                    result = backend->payment(params);
+                    break;
+                case TransactionType::StockLevel:
+                    result = backend->stockLevel(params);
+                    break;
+                case TransactionType::NewOrder:
+                    result = backend->newOrder(params);
+                    break;
+                }
+                auto end = chrono::steady_clock::now();
+                throughput.record(end - runStart);
+                if (measured) {
+                    latencies.record(type, end - start);
+                    responseLatencies.record(type, end - intended);
+                    counts[static_cast<int>(type)]++;
+                    if (!result && type == TransactionType::NewOrder)
+                        numFailedNewOrders++;
+                }
+            } catch (std::exception &e) {
+                switch (backend->classify(e)) {
+                case FailureKind::Conflict:
+                    cout << this_thread::get_id() << " Conflict!\r\n" << e.what() << endl;
+                    if (measured) {
+                        numConflicts++;
+                        conflicts.record(ConflictKind::Abort);
+                    }
+                    break;
+                case FailureKind::Transient:
+                    cout << this_thread::get_id() << " Transient error!\r\n" << e.what() << endl;
+                    if (measured)
+                        numErrors++;
+                    break;
+                case FailureKind::Fatal:
+                    cout << this_thread::get_id() << " std exception!\r\n" << e.what() << endl;
+                    throw;
+                }
+            } catch (...) {
+                cout << this_thread::get_id() << " Unknown exception!\r\n" << endl;
+                throw;
+            }
+            if (!measured)
+                continue;
+            conflicts.end();
+            if (phases)
+                phases->end();
+            cpuTime += threadCPUTime() - cpuStart;
+            if (hardware)
+                events[static_cast<int>(type)]->add(eventsStart, hardware->read());
+        }
+        // The rate counters are per second of the measurement window
+        state.SetIterationTime(window.measure.count());
+    }
+    RandomHelper::setHome({});
+    if (!windowEnded) {
+        backend->counters(countersAfter);
+        if (state.thread_index() == 0)
+            backend->serverStatistics(statisticsAfter);
+    }
+
+    int total = 0;
+    for (int count : counts) {
+        total += count;
+    }
+
+    for (auto &counter : countersAfter) {
+        auto before = countersBefore.find(counter.first);
+        state.counters[counter.first] =
+            counter.second - (before != countersBefore.end() ? before->second : 0);
+    }
+    state.counters["conflicts"] = numConflicts;
+    state.counters["errors"] = numErrors;
+    // Contention normalised by the work done, comparable between runs with and
+    // without home warehouses
+    state.counters["conflictsPerKTxn"] = benchmark::Counter(
+        total > 0 ? numConflicts * 1000.0 / total : 0, benchmark::Counter::kAvgThreads);
+    if (countersAfter.count("retries") > 0)
+        state.counters["retriesPerKTxn"] = benchmark::Counter(
+            total > 0 ? state.counters["retries"].value * 1000.0 / total : 0,
+            benchmark::Counter::kAvgThreads);
+    // Client CPU per transaction in microseconds, averaged over the terminals
+    state.counters["cpuPerTxn"] = benchmark::Counter(
+        total > 0 ? cpuTime * 1e6 / total : 0, benchmark::Counter::kAvgThreads);
+
+    publishRate(state, "txn", total);
+    publishRate(state, "delivery", counts[static_cast<int>(TransactionType::Delivery)]);
+    publishRate(state, "newOrder", counts[static_cast<int>(TransactionType::NewOrder)]);
+    state.counters["newOrderFail"] = numFailedNewOrders;
+    publishRate(state, "payment", counts[static_cast<int>(TransactionType::Payment)]);
+    publishRate(state, "status", counts[static_cast<int>(TransactionType::OrderStatus)]);
+    publishRate(state, "stock", counts[static_cast<int>(TransactionType::StockLevel)]);
+
+    if (state.thread_index() == 0) {
+        map<string, double> finished;
+        backend->finish(finished);
+        for (auto &counter : finished) {
+            state.counters[counter.first] = counter.second;
+        }
+        for (auto &statistic : report::statisticsDelta(statisticsBefore, statisticsAfter))
+            state.counters[statistic.first] = statistic.second;
+        if (perf::enabled())
+            publishEvents(state);
+        string run = reportLatencies(state, name, arrival);
+        reportThroughput(state, ThroughputRegistry::merge(state.threads()), window, run);
+        report::RunReport::global().addTerminalCpus(run, runCpus(state.threads()));
+        reportConflicts(state, ConflictRegistry::merge(state.threads()), run);
+        if (phases)
+            reportPhases(state, PhaseRegistry::merge(state.threads()), run);
+        report::RunReport::global().describeRun(
+            run, {{"warehouses", params.warehouses},
+                  {"items", params.items},
+                  {"districtsPerWarehouse", params.districtsPerWarehouse},
+                  {"customersPerDistrict", params.customersPerDistrict},
+                  {"newOrdersPerDistrict", params.newOrdersPerDistrict},
+                  {"terminals", state.threads()},
+                  {"homeWarehouse", homeWarehousesEnabled() ? 1 : 0}});
+    }
+    PhaseRegistry::deactivate();
+    ConflictRegistry::deactivate();
+}
@@ -0,0 +1,30 @@
+#ifndef TPCCDRIVER_HPP
+#define TPCCDRIVER_HPP
+
+#include "benchmark/benchmark.h"
+#include "dbphd/tpc/tpcbackend.hpp"
+#include "dbphd/tpc/tpcpacing.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+// Creates the backend of one terminal
+using BackendFactory = std::function<std::unique_ptr<tpcc::Backend>(benchmark::State&)>;
+
+// Runs the TPC-C mix for one benchmark thread (terminal). Thread 0 loads the
+// database through its backend; afterwards every terminal runs the mix with the
+// given arrival process for the ramp up, measurement window and ramp down of
+// $DBPHD_RAMP_UP/MEASURE/RAMP_DOWN (register the benchmark with
+// TPCCMeasurementWindow). Only transactions started in the measurement window
+// count, and the counters, latency histograms and backend counters are
+// published the same way for every engine, next to the per second throughput
+// and when it became steady. name prefixes the histogram files. With $DBPHD_PERF set the hardware counters of every
+// transaction are sampled too and published per type, e.g. newOrderInstructions.
+// With $DBPHD_AFFINITY set each terminal is pinned by its thread index for the
+// run (see perf::AffinityPolicy) and the CPUs it ran on go to the run report.
+// With $DBPHD_HOME_WAREHOUSE set terminal N runs against a fixed home warehouse
+// and district (see RandomHelper::setHome) instead of random ones.
+void runTPCC(benchmark::State& state, const std::string& name, tpcc::ArrivalProcess arrival, const BackendFactory& factory);
+
+#endif /* TPCCDRIVER_HPP */
@@ -0,0 +1,177 @@
+#ifndef TPCCREPORT_HPP
+#define TPCCREPORT_HPP
+
+#include "benchmark/benchmark.h"
+#include "dbphd/tpc/tpcconflicts.hpp"
+#include "dbphd/tpc/tpchistogram.hpp"
+#include "dbphd/tpc/tpcpacing.hpp"
+#include "dbphd/tpc/tpcphases.hpp"
+#include "dbphd/tpc/tpcwindow.hpp"
+#include "dbphd/report/runreport.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+
+// Open loop runs: warehouses x total offered load (txn/s, spread over the
+// terminals), doubling up to well past what one server saturates at.
+inline void TPCCOpenLoopArguments(benchmark::internal::Benchmark* b) {
+	for(int warehouses : {1, 10}) {
+		for(int rate = 100; rate <= 25600; rate *= 2) {
+			b->Args({warehouses, rate});
+		}
+	}
+}
+
+// Time based runs: runTPCC runs the single iteration of every terminal for the
+// measurement window of $DBPHD_RAMP_UP/MEASURE/RAMP_DOWN and reports the
+// measurement window as its time, so the rate counters are per measured second.
+inline void TPCCMeasurementWindow(benchmark::internal::Benchmark* b) {
+	b->Iterations(1)->UseManualTime();
+}
+
+// The arrival schedule of one terminal, the offered load is range(1) for open loops
+inline tpcc::ArrivalSchedule terminalSchedule(benchmark::State& state, tpcc::ArrivalProcess arrival) {
+	if(arrival == tpcc::ArrivalProcess::Closed)
+		return tpcc::ArrivalSchedule(arrival, 0);
+	return tpcc::ArrivalSchedule(arrival, (double)state.range(1) / state.threads());
+}
+
+inline void reportHistograms(benchmark::State& state, const tpcc::TransactionLatencies& latencies, const std::string& name, const std::string& kind, const std::string& counterSuffix, const std::string& fileSuffix) {
+	report::RunReport::global().addLatencies(name, kind, latencies);
+	const char* dir = std::getenv("DBPHD_HISTOGRAM_DIR");
+	std::filesystem::path directory = dir != nullptr ? dir : "histograms";
+	std::filesystem::create_directories(directory);
+	for(int i = 0; i < tpcc::TransactionLatencies::TYPES; ++i) {
+		auto type = static_cast<tpcc::TransactionType>(i);
+		auto& histogram = latencies[type];
+		std::string prefix = std::string(tpcc::transactionTypeName(type)) + counterSuffix;
+		state.counters[prefix + "P50"] = histogram.valueAtPercentile(50);
+		state.counters[prefix + "P90"] = histogram.valueAtPercentile(90);
+		state.counters[prefix + "P99"] = histogram.valueAtPercentile(99);
+		state.counters[prefix + "P999"] = histogram.valueAtPercentile(99.9);
+		state.counters[prefix + "Max"] = histogram.max();
+
+		std::ofstream out(directory / fmt::format("{}_{}{}.hgrm", name, tpcc::transactionTypeName(type), fileSuffix));
+		histogram.writePercentiles(out, 1000);
+	}
+}
+
+// Publishes the merged latencies of all terminals of a TPC-C run as counters, in
+// microseconds, and writes one .hgrm percentile file (in milliseconds) per
+// transaction type to $DBPHD_HISTOGRAM_DIR (default "histograms"). Open loop runs
+// report the response time (from the intended start, corrected for coordinated
+// omission) as <type>P99 and the service time as <type>ServiceP99. Call it from
+// thread 0 after the state loop, when every terminal has stopped recording.
+// Returns the name of the run, which also labels it in the run report.
+inline std::string reportLatencies(benchmark::State& state, const std::string& name, tpcc::ArrivalProcess arrival = tpcc::ArrivalProcess::Closed) {
+	std::string run = fmt::format("{}_{}_w{}_t{}", name, tpcc::arrivalProcessName(arrival), state.range(0), state.threads());
+	if(arrival == tpcc::ArrivalProcess::Closed) {
+		state.SetLabel(run);
+		reportHistograms(state, tpcc::LatencyRegistry::merge(state.threads()), run, "service", "", "");
+		return run;
+	}
+	run += fmt::format("_r{}", state.range(1));
+	state.SetLabel(run);
+	state.counters["offeredRate"] = state.range(1);
+	reportHistograms(state, tpcc::LatencyRegistry::merge(state.threads(), tpcc::LatencyKind::Response), run, "response", "", "");
+	reportHistograms(state, tpcc::LatencyRegistry::merge(state.threads(), tpcc::LatencyKind::Service), run, "service", "Service", "_service");
+	return run;
+}
+
+// Publishes the client phases of a TPC-C run as <type>Build, <type>Execute and
+// <type>Decode counters, in microseconds per transaction, and writes the time of
+// every statement to <run>_phases.csv in $DBPHD_PHASE_DIR (default "phases").
+inline void reportPhases(benchmark::State& state, const tpcc::PhaseProfile& phases, const std::string& run) {
+	for(int i = 0; i < tpcc::TransactionLatencies::TYPES; ++i) {
+		auto type = static_cast<tpcc::TransactionType>(i);
+		int64_t transactions = phases.transactions(type);
+		for(int p = 0; p < tpcc::PHASES; ++p) {
+			auto phase = static_cast<tpcc::Phase>(p);
+			state.counters[std::string(tpcc::transactionTypeName(type)) + tpcc::phaseName(phase)] =
+				transactions > 0 ? phases.nanoseconds(type, phase) / 1e3 / transactions : 0;
+		}
+	}
+
+	const char* dir = std::getenv("DBPHD_PHASE_DIR");
+	std::filesystem::path directory = dir != nullptr ? dir : "phases";
+	std::filesystem::create_directories(directory);
+	std::ofstream out(directory / fmt::format("{}_phases.csv", run));
+	// Per execution of the statement, in microseconds
+	out << "type,statement,executions,build,execute,decode" << std::endl;
+	for(auto& statement : phases.statements()) {
+		double executions = std::max<int64_t>(statement.executions, 1);
+		out << fmt::format("{},{},{},{:.3f},{:.3f},{:.3f}", tpcc::transactionTypeName(statement.type), statement.statement, statement.executions,
+		                   statement.nanoseconds[0] / 1e3 / executions, statement.nanoseconds[1] / 1e3 / executions, statement.nanoseconds[2] / 1e3 / executions)
+		    << std::endl;
+	}
+}
+
+// Publishes when the throughput of a time based run became steady as the
+// steadyStateAt counter (seconds from the start, -1 if it never did) and the
+// variation (coefficient of variation) of the measured seconds as
+// measureVariation. Warns when the measurement window started before the steady
+// state. The per second series goes to the run report and to
+// <run>_throughput.csv in $DBPHD_HISTOGRAM_DIR.
+inline void reportThroughput(benchmark::State& state, const tpcc::ThroughputSeries& series, const tpcc::MeasurementWindow& window, const std::string& run) {
+	auto& perSecond = series.perSecond();
+	// The last second of the ramp down is cut short, terminals may run past it
+	size_t complete = std::min(perSecond.size(), (size_t)window.total().count());
+	std::vector<int64_t> seconds(perSecond.begin(), perSecond.begin() + complete);
+	int steady = tpcc::steadyStateStart(seconds);
+	state.counters["steadyStateAt"] = steady;
+	state.counters["measureVariation"] =
+		tpcc::coefficientOfVariation(seconds, (size_t)std::ceil(window.rampUp.count()), (size_t)(window.rampUp + window.measure).count());
+	if(steady < 0 || steady > window.rampUp.count())
+		std::cerr << run << ": throughput was not steady when the measurement window started, "
+		          << (steady < 0 ? std::string("it never settled") : fmt::format("it settled after {} s", steady))
+		          << ", consider a longer $DBPHD_RAMP_UP" << std::endl;
+
+	report::RunReport::global().addThroughput(run, perSecond);
+	const char* dir = std::getenv("DBPHD_HISTOGRAM_DIR");
+	std::filesystem::path directory = dir != nullptr ? dir : "histograms";
+	std::filesystem::create_directories(directory);
+	std::ofstream out(directory / fmt::format("{}_throughput.csv", run));
+	out << "second,stage,txn" << std::endl;
+	for(size_t s = 0; s < perSecond.size(); ++s)
+		out << s << "," << tpcc::runStageName(window.stageAt(std::chrono::duration<double>(s))) << "," << perSecond[s] << std::endl;
+}
+
+// Aborts and retries by transaction type, statement, warehouse and district as
+// <run>_conflicts.csv in $DBPHD_HISTOGRAM_DIR, one row per site so it can be
+// pivoted into a warehouse x district heatmap per statement. hotKeyShare is the
+// share of all conflicts on the busiest (w_id, d_id).
+inline void reportConflicts(benchmark::State& state, const tpcc::ConflictMap& conflicts, const std::string& run) {
+	std::map<std::pair<int, int>, int64_t> byKey;
+	int64_t all = 0;
+	for(auto& site : conflicts.sites()) {
+		int64_t count = 0;
+		for(int64_t kind : site.second)
+			count += kind;
+		byKey[{site.first.wId, site.first.dId}] += count;
+		all += count;
+	}
+	int64_t hottest = 0;
+	for(auto& key : byKey)
+		hottest = std::max(hottest, key.second);
+	state.counters["hotKeyShare"] = all > 0 ? (double)hottest / all : 0;
+
+	const char* dir = std::getenv("DBPHD_HISTOGRAM_DIR");
+	std::filesystem::path directory = dir != nullptr ? dir : "histograms";
+	std::filesystem::create_directories(directory);
+	std::ofstream out(directory / fmt::format("{}_conflicts.csv", run));
+	out << "type,statement,w_id,d_id,aborts,retries" << std::endl;
+	for(auto& site : conflicts.sites())
+		out << fmt::format("{},{},{},{},{},{}", tpcc::transactionTypeName(site.first.type), site.first.statement, site.first.wId, site.first.dId,
+		                   site.second[static_cast<int>(tpcc::ConflictKind::Abort)], site.second[static_cast<int>(tpcc::ConflictKind::Retry)])
+		    << std::endl;
+}
+
+#endif /* TPCCREPORT_HPP */
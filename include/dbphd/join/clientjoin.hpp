@@ -0,0 +1,121 @@
+#ifndef CLIENTJOIN_HPP
+#define CLIENTJOIN_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Client side join algorithms for the manual join benchmarks. Both only deal in
+// keys and row indexes, rows stay wherever the caller decoded them.
+enum class JoinAlgorithm {
+	Hash = 0,
+	SortMerge = 1
+};
+
+inline const char* JoinAlgorithmName(JoinAlgorithm algorithm) {
+	switch(algorithm) {
+		case JoinAlgorithm::Hash:
+			return "Hash";
+		case JoinAlgorithm::SortMerge:
+			return "SortMerge";
+	}
+	return "Unknown";
+}
+
+// Hash table over the build side (the batched outer rows), probed by each inner
+// row as it streams from the cursor. Rows with equal keys are chained through
+// m_Next, so duplicate keys cost no extra allocation. Clear() keeps the buckets,
+// a table reused across batches stops allocating once it saw the largest batch.
+template <typename Key, typename Hash = std::hash<Key>>
+class HashJoin
+{
+private:
+	static constexpr size_t END = static_cast<size_t>(-1);
+	std::unordered_map<Key, size_t, Hash> m_Heads;
+	std::vector<size_t> m_Next;
+
+public:
+	void Reserve(size_t rows) {
+		m_Heads.reserve(rows);
+		m_Next.reserve(rows);
+	}
+
+	void Clear() {
+		m_Heads.clear();
+		m_Next.clear();
+	}
+
+	size_t Size() const { return m_Next.size(); }
+
+	// Adds a build row, its index is the number of rows inserted before it.
+	size_t Insert(const Key& key) {
+		size_t row = m_Next.size();
+		auto inserted = m_Heads.emplace(key, row);
+		if(inserted.second) {
+			m_Next.push_back(END);
+		} else {
+			m_Next.push_back(inserted.first->second);
+			inserted.first->second = row;
+		}
+		return row;
+	}
+
+	// Calls onMatch(buildRow) for every build row with key, returns the number of
+	// calls. onMatch may return false to skip a row (e.g. a residual predicate).
+	template <typename F>
+	size_t Probe(const Key& key, F&& onMatch) const {
+		auto head = m_Heads.find(key);
+		if(head == m_Heads.end())
+			return 0;
+		size_t matches = 0;
+		for(size_t row = head->second; row != END; row = m_Next[row]) {
+			if(onMatch(row))
+				++matches;
+		}
+		return matches;
+	}
+};
+
+// Sorts both sides on their key and merges them, calling onMatch(leftRow,
+// rightRow) for every pair of equal keys. Like HashJoin::Probe, onMatch returns
+// whether the pair counts; returning false does not stop the merge. Both vectors
+// are reordered in place.
+template <typename L, typename R, typename LeftKey, typename RightKey, typename F>
+size_t SortMergeJoin(std::vector<L>& left, std::vector<R>& right, LeftKey&& leftKey, RightKey&& rightKey, F&& onMatch) {
+	std::sort(left.begin(), left.end(), [&](const L& a, const L& b) { return leftKey(a) < leftKey(b); });
+	std::sort(right.begin(), right.end(), [&](const R& a, const R& b) { return rightKey(a) < rightKey(b); });
+	size_t matches = 0;
+	size_t l = 0;
+	size_t r = 0;
+	while(l < left.size() && r < right.size()) {
+		const auto& lk = leftKey(left[l]);
+		const auto& rk = rightKey(right[r]);
+		if(lk < rk) {
+			++l;
+		} else if(rk < lk) {
+			++r;
+		} else {
+			// Cross product of the two runs of equal keys
+			size_t lEnd = l;
+			while(lEnd < left.size() && !(lk < leftKey(left[lEnd])))
+				++lEnd;
+			size_t rEnd = r;
+			while(rEnd < right.size() && !(rk < rightKey(right[rEnd])))
+				++rEnd;
+			for(size_t i = l; i < lEnd; ++i) {
+				for(size_t j = r; j < rEnd; ++j) {
+					if(onMatch(left[i], right[j]))
+						++matches;
+				}
+			}
+			l = lEnd;
+			r = rEnd;
+		}
+	}
+	return matches;
+}
+
+#endif /* CLIENTJOIN_HPP */
@@ -0,0 +1,69 @@
+#ifndef BSONCOMMAND_HPP
+#define BSONCOMMAND_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <bsoncxx/document/view.hpp>
+
+// A slot is the location of a fixed width value inside a prebuilt BSON document.
+struct BSONSlot {
+	size_t offset = 0;
+	uint8_t type = 0;
+};
+
+// A BSON document that is built once and reused for every call, only the values
+// in its slots are overwritten. Only fixed width types (int32, int64, double,
+// date, bool) can be slots, since patching them never moves the rest of the document.
+class BSONCommand
+{
+private:
+	std::vector<uint8_t> m_Buffer;
+	std::vector<BSONSlot> m_Slots;
+
+public:
+	BSONCommand() = default;
+	explicit BSONCommand(bsoncxx::document::view doc);
+	BSONCommand(const uint8_t* data, size_t length);
+	// Resolves the given paths once, in the order Bind() expects its values.
+	BSONCommand(bsoncxx::document::view doc, std::initializer_list<std::string_view> paths);
+
+	// Dotted path into the document, e.g. "ol_o_id.$lt". Throws std::invalid_argument
+	// when the path does not exist or does not name a fixed width value.
+	BSONSlot Slot(std::string_view path) const;
+
+	void Set(const BSONSlot& slot, int32_t value);
+	void Set(const BSONSlot& slot, int64_t value);
+	void Set(const BSONSlot& slot, double value);
+	void Set(const BSONSlot& slot, bool value);
+	void Set(const BSONSlot& slot, std::chrono::system_clock::time_point value);
+
+	// One value per slot, in the order of the paths. Throws std::invalid_argument
+	// when the count differs, rather than leaving the last call's values behind.
+	template <typename... T>
+	bsoncxx::document::view Bind(const T&... values) {
+		if (sizeof...(T) != m_Slots.size())
+			throw std::invalid_argument("BSON command has " + std::to_string(m_Slots.size()) +
+										" slots, bound " + std::to_string(sizeof...(T)));
+		size_t i = 0;
+		(Set(m_Slots[i++], values), ...);
+		return view();
+	}
+
+	bsoncxx::document::view view() const {
+		return bsoncxx::document::view{m_Buffer.data(), m_Buffer.size()};
+	}
+	const std::vector<uint8_t>& buffer() const { return m_Buffer; }
+
+	// Raw helper shared with the decoders, returns false when path is not found.
+	static bool FindValue(const uint8_t* data, size_t length, std::string_view path, size_t& offset, uint8_t& type);
+	static size_t ValueSize(const uint8_t* value, uint8_t type);
+};
+
+#endif /* BSONCOMMAND_HPP */
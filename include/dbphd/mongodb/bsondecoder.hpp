@@ -0,0 +1,57 @@
+#ifndef BSONDECODER_HPP
+#define BSONDECODER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <bsoncxx/array/view.hpp>
+#include <bsoncxx/document/view.hpp>
+
+// Reads a fixed set of fields straight from a document view without copying it.
+// Every Decode() walks the document once; the element position of each bound field
+// is remembered, so documents of the same shape (same projection) resolve every
+// field with a single key compare. Values point into the decoded view and are only
+// valid as long as that view is (for cursors: until the cursor advances).
+class BSONDecoder
+{
+private:
+	std::vector<std::string> m_Fields;
+	std::vector<const uint8_t*> m_Values;
+	std::vector<uint8_t> m_Types;
+	// Bound field index at each element position of the last document, UNBOUND
+	// for an element no field is bound to, whose key is kept in m_UnboundKeys so
+	// the next document of the same shape skips it with one compare as well
+	static constexpr int UNKNOWN = -1;
+	static constexpr int UNBOUND = -2;
+	std::vector<int> m_Shape;
+	std::vector<std::string> m_UnboundKeys;
+
+	const uint8_t* value(size_t field, uint8_t type) const;
+
+public:
+	BSONDecoder(std::initializer_list<std::string_view> fields);
+	explicit BSONDecoder(const std::vector<std::string>& fields);
+
+	// Returns the number of bound fields present in doc.
+	size_t Decode(bsoncxx::document::view doc);
+
+	size_t Fields() const { return m_Fields.size(); }
+	bool Has(size_t field) const { return m_Values[field] != nullptr; }
+
+	// Typed getters, throw std::invalid_argument when the field is missing or of another type.
+	int32_t Int32(size_t field) const;
+	int64_t Int64(size_t field) const;
+	double Double(size_t field) const;
+	bool Bool(size_t field) const;
+	std::string_view String(size_t field) const;
+	std::chrono::system_clock::time_point Date(size_t field) const;
+	bsoncxx::document::view Document(size_t field) const;
+	bsoncxx::array::view Array(size_t field) const;
+};
+
+#endif /* BSONDECODER_HPP */
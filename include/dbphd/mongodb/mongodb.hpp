@@ -1,7 +1,10 @@
 #ifndef MONGODB_HPP
 #define MONGODB_HPP
 
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <bsoncxx/builder/stream/array.hpp>
 #include <bsoncxx/builder/stream/document.hpp>
@@ -33,6 +36,25 @@ public:
 	MongoDBHandler();
 	virtual ~MongoDBHandler();
 	
+	// Server version, storage engine and cache size of the server behind the pool
+	static std::map<std::string, std::string> ServerInfo(mongocxx::client& client);
+	// Cumulative serverStatus counters (operations, documents, scans, write
+	// conflicts, transactions, WiredTiger cache and log, lock waits) as mongo_*
+	// and, for each of collections in database, its $collStats latency totals
+	// and storage sizes as mongo_<collection>_*
+	static std::map<std::string, double> ServerStats(mongocxx::client& client, const std::string& database = "", const std::vector<std::string>& collections = {});
+	// Copies collections of database into the database snapshot with $out
+	// (MongoDB 4.4 or later), marking the snapshot complete once all are copied
+	static void SnapshotCollections(mongocxx::client& client, const std::string& database, const std::string& snapshot, const std::vector<std::string>& collections);
+	// Copies the collections of a complete snapshot back into database,
+	// replacing them, false when there is no complete snapshot
+	static bool RestoreCollections(mongocxx::client& client, const std::string& snapshot, const std::string& database, const std::vector<std::string>& collections);
+	static bool SnapshotExists(mongocxx::client& client, const std::string& snapshot);
+	// Replaces the documents of collection in database with their copies in the
+	// snapshot (matched on _id) for the snapshot documents matching filter, with
+	// $merge (MongoDB 4.4 or later). The copies no longer in database are
+	// inserted again when insertMissing.
+	static void ResetCollection(mongocxx::client& client, const std::string& snapshot, const std::string& database, const std::string& collection, bsoncxx::document::view filter, bool insertMissing);
 	static mongocxx::pool::entry GetConnection(std::string connstr = "mongodb://localhost:27017/?maxPoolSize=100&minPoolSize=8&compressors=zstd,snappy,zlib");
 };
 
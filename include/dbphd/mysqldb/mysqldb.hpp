@@ -1,7 +1,9 @@
 #ifndef MYSQLDB_HPP
 #define MYSQLDB_HPP
 
+#include <map>
 #include <memory>
+#include <string>
 #include <optional>
 #include <mysqlx/xdevapi.h>
 
@@ -30,6 +32,12 @@ public:
 	static mysqlx::Schema CreateDatabase(mysqlx::Session& session, std::string dbname);
 	static bool DropDatabase(mysqlx::Session& session, std::string dbname);
 	static bool DropTable(mysqlx::Session& session, std::string dbname, std::string tablename);
+	// Server version and the settings that matter for the benchmarks
+	static std::map<std::string, std::string> ServerInfo(mysqlx::Session& session);
+	// Cumulative InnoDB and statement counters: global status (mysql_*),
+	// innodb_metrics (mysql_innodb_*) and the statement digest totals
+	// of schema (mysql_statements_*) when performance_schema is enabled
+	static std::map<std::string, double> ServerStats(mysqlx::Session& session, const std::string& schema = "bench");
 };
 
 #endif /* MYSQLDB_HPP */
@@ -0,0 +1,72 @@
+#if !defined(AFFINITY)
+#define AFFINITY
+#include <string>
+#include <vector>
+
+namespace perf {
+
+// Where benchmark terminals and loader threads run. Compact fills the CPUs of
+// one NUMA node before moving to the next, scatter deals one CPU of every node
+// in turn and node binds each thread to all CPUs of one node, nodes in turn.
+// None leaves placement to the scheduler.
+enum class AffinityPolicy {
+    None = 0,
+    Compact = 1,
+    Scatter = 2,
+    Node = 3
+};
+
+// Lower case name as accepted by $DBPHD_AFFINITY, e.g. "scatter"
+const char *affinityPolicyName(AffinityPolicy policy);
+// None for anything but compact, scatter or node
+AffinityPolicy affinityPolicyFromName(const std::string &name);
+// The policy in $DBPHD_AFFINITY, None when it is not set
+AffinityPolicy affinityPolicy();
+
+// Linux CPU lists as in sysfs, e.g. "0-3,8,10-11"
+std::vector<int> parseCpuList(const std::string &list);
+std::string formatCpuList(std::vector<int> cpus);
+
+// The CPUs the process may run on, grouped by NUMA node
+struct CpuTopology {
+    std::vector<std::vector<int>> nodes;
+
+    int cpus() const;
+    // From /sys/devices/system/node, one node with every allowed CPU when the
+    // machine (or the container) exposes no NUMA information
+    static CpuTopology detect();
+};
+
+// The topology when first asked, before any thread of this process was pinned
+const CpuTopology &cpuTopology();
+
+// The CPUs of worker slot (terminal or loader thread number) under policy:
+// one CPU for compact and scatter, a whole node for node, none for None. Slots
+// beyond the number of CPUs (or nodes) wrap around.
+std::vector<int> placement(AffinityPolicy policy, const CpuTopology &topology, int slot);
+// placement of slot under $DBPHD_AFFINITY on this machine
+std::vector<int> workerCpus(int slot);
+
+// The CPUs the calling thread may run on
+std::vector<int> currentCpus();
+
+// Pins the calling thread while in scope. Benchmark thread 0 and the OpenMP
+// master are long lived threads, so the previous mask is restored at the end.
+// Empty cpus leave the thread alone. Memory the thread touches first while
+// pinned is allocated on its node by the kernel's default policy, so per
+// thread state should be allocated after pinning.
+class ScopedAffinity {
+  public:
+    explicit ScopedAffinity(const std::vector<int> &cpus);
+    ~ScopedAffinity();
+    ScopedAffinity(const ScopedAffinity &) = delete;
+    ScopedAffinity &operator=(const ScopedAffinity &) = delete;
+
+    bool pinned() const { return !previous.empty(); }
+
+  private:
+    std::vector<int> previous;
+};
+
+} // namespace perf
+#endif
@@ -0,0 +1,77 @@
+#if !defined(PERFCOUNTERS)
+#define PERFCOUNTERS
+#include <array>
+#include <cstdint>
+
+namespace perf {
+
+enum class Event {
+    Cycles = 0,
+    Instructions = 1,
+    LLCMisses = 2,
+    ContextSwitches = 3,
+    Syscalls = 4
+};
+
+const int EVENTS = 5;
+
+// Upper camel case name used as a counter suffix, e.g. "Instructions"
+const char *eventName(Event event);
+
+// True when $DBPHD_PERF is set to anything but "" or "0". Opening the counters
+// costs a few syscalls per thread and reading them two per sample, so they are
+// off unless asked for.
+bool enabled();
+
+// Raw counter values at one point in time, zero for events that are not open
+struct Sample {
+    std::array<uint64_t, EVENTS> values{};
+};
+
+// Counter deltas summed over a number of samples, e.g. all transactions of a type
+class EventTotals {
+  public:
+    void add(const Sample &begin, const Sample &end);
+    void merge(const EventTotals &other);
+    void reset();
+
+    uint64_t total(Event event) const { return totals[static_cast<int>(event)]; }
+    int64_t samples() const { return count; }
+    // Average per sample, 0 without samples
+    double average(Event event) const;
+
+  private:
+    std::array<uint64_t, EVENTS> totals{};
+    int64_t count = 0;
+};
+
+// perf_event_open counters of the calling thread (on any CPU), opened as one
+// group so a sample is one read. Kernel time is counted when
+// /proc/sys/kernel/perf_event_paranoid allows it, otherwise user space only.
+// Events the machine or the permissions do not provide (no PMU in most VMs, no
+// tracefs for syscalls) are left closed and read as zero.
+class ThreadCounters {
+  public:
+    ThreadCounters();
+    ~ThreadCounters();
+    ThreadCounters(const ThreadCounters &) = delete;
+    ThreadCounters &operator=(const ThreadCounters &) = delete;
+
+    bool isOpen(Event event) const { return slots[static_cast<int>(event)] >= 0; }
+    // At least one event is open
+    bool available() const { return leader >= 0; }
+    Sample read() const;
+
+    // The counters of the calling thread, opened on its first call
+    static ThreadCounters &forThread();
+
+  private:
+    int leader = -1;
+    std::array<int, EVENTS> fds;
+    // Position of each event in the group read, -1 when it is not open
+    std::array<int, EVENTS> slots;
+    int opened = 0;
+};
+
+} // namespace perf
+#endif
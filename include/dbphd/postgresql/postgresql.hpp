@@ -1,7 +1,10 @@
 #ifndef POSTGRESQL_HPP
 #define POSTGRESQL_HPP
 
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 #include <pqxx/pqxx>
 class PostgreSQLDBHandler
 {
@@ -16,6 +19,23 @@ public:
 	static bool DropDatabase(std::shared_ptr<pqxx::connection> conn, std::string dbname);
 	static bool DropTable(std::shared_ptr<pqxx::connection> conn, std::string dbname, std::string tablename);
 	static bool TruncateTable(std::shared_ptr<pqxx::connection> conn, std::string dbname, std::string tablename);
+	// Copies the rows of tables in dbname into the schema snapshot, in one
+	// transaction. Columns of types defined in dbname are kept as text, so
+	// dropping dbname later does not take them along.
+	static void SnapshotTables(std::shared_ptr<pqxx::connection> conn, std::string dbname, std::string snapshot, const std::vector<std::string>& tables);
+	// Inserts the rows of tables from the schema snapshot into the (empty)
+	// tables of the same name in dbname, false when there is no such snapshot
+	static bool RestoreTables(std::shared_ptr<pqxx::connection> conn, std::string snapshot, std::string dbname, const std::vector<std::string>& tables);
+	// Runs sql in one transaction when the schema snapshot exists, to put the
+	// rows a benchmark changed back the way the snapshot has them. False when
+	// there is no such snapshot.
+	static bool ResetTables(std::shared_ptr<pqxx::connection> conn, std::string snapshot, std::string sql);
+	// Server version and the settings that matter for the benchmarks
+	static std::map<std::string, std::string> ServerInfo(std::shared_ptr<pqxx::connection> conn);
+	// Cumulative statistics of the current database: pg_stat_database (pg_*),
+	// pg_stat_bgwriter (pg_bgwriter_*), WAL position (pg_wal_bytes) and the
+	// pg_stat_statements totals (pg_statements_*) when the extension is installed
+	static std::map<std::string, double> ServerStats(std::shared_ptr<pqxx::connection> conn);
 	virtual ~PostgreSQLDBHandler();
 };
 
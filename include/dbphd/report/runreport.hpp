@@ -0,0 +1,122 @@
+#if !defined(RUNREPORT)
+#define RUNREPORT
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include "dbphd/tpc/tpchistogram.hpp"
+
+namespace report {
+
+// Settings of one engine as strings, "version" is the server (or library) version
+using EngineInfo = std::map<std::string, std::string>;
+
+// Microseconds, like the TPC-C latency counters
+struct LatencySummary {
+    int64_t count = 0;
+    double mean = 0;
+    int64_t p50 = 0;
+    int64_t p90 = 0;
+    int64_t p99 = 0;
+    int64_t p999 = 0;
+    int64_t max = 0;
+
+    static LatencySummary of(const tpcc::Histogram &histogram);
+};
+
+// One reported benchmark run. Scale and latencies come from the benchmark itself
+// and are matched to the run by its label.
+struct RunRecord {
+    std::string name;
+    std::string label;
+    bool aggregate = false;
+    int threads = 1;
+    int64_t iterations = 0;
+    double realTime = 0;
+    double cpuTime = 0;
+    std::string timeUnit;
+    std::map<std::string, double> counters;
+    std::map<std::string, double> scale;
+    // kind ("service" or "response") -> transaction type -> summary
+    std::map<std::string, std::map<std::string, LatencySummary>> latencies;
+    // Transactions completed per second of time based runs, from their start
+    std::vector<int64_t> throughput;
+    // CPU list of each terminal, e.g. "0-3" or "12"
+    std::vector<std::string> terminalCpus;
+};
+
+struct LoadTiming {
+    std::string engine;
+    std::string phase;
+    double milliseconds;
+};
+
+// Cumulative server statistics by name, e.g. from PostgreSQLDBHandler::ServerStats
+using ServerStats = std::map<std::string, double>;
+
+// after - before of the statistics in both snapshots. Statistics that went
+// down (a restart or a stats reset in between) are left out.
+ServerStats statisticsDelta(const ServerStats &before, const ServerStats &after);
+
+// CPU model, core count, NUMA nodes, affinity policy, host, kernel and compiler
+// of this process
+std::map<std::string, std::string> captureEnvironment();
+
+// Everything one bench_dbphd process measured, written as one JSON document. The
+// benches add to the global report from any thread; it is written once at exit.
+class RunReport {
+  public:
+    static RunReport &global();
+
+    // Keeps the first description of an engine, describe is only called once
+    void describeEngine(const std::string &engine, const std::function<EngineInfo()> &describe);
+    void recordLoad(const std::string &engine, const std::string &phase, double milliseconds);
+    void describeRun(const std::string &label, const std::map<std::string, double> &scale);
+    void addLatencies(const std::string &label, const std::string &kind,
+                      const tpcc::TransactionLatencies &latencies);
+    void addThroughput(const std::string &label, const std::vector<int64_t> &perSecond);
+    void addTerminalCpus(const std::string &label, const std::vector<std::string> &cpus);
+    void addRun(RunRecord run);
+
+    void write(std::ostream &out) const;
+    void clear();
+
+  private:
+    mutable std::mutex lock;
+    std::map<std::string, EngineInfo> engines;
+    std::vector<LoadTiming> loads;
+    std::vector<RunRecord> runs;
+    // Details of labelled runs that have not been reported yet
+    std::map<std::string, RunRecord> pending;
+};
+
+// A metric of a run that got worse by more than the threshold (a fraction).
+// change is candidate / baseline - 1.
+struct Regression {
+    std::string run;
+    std::string metric;
+    double baseline;
+    double candidate;
+    double change;
+};
+
+// Throughput metrics are the counters named Ops or ending in Rate and the
+// items_per_second counter, higher is better. p99 metrics are the counters
+// ending in P99, lower is better. Runs are matched by name, metrics missing on
+// either side are skipped.
+std::vector<Regression> compareReports(const boost::property_tree::ptree &baseline,
+                                       const boost::property_tree::ptree &candidate,
+                                       double threshold);
+
+// Engines whose version differs between two reports: engine -> (baseline, candidate)
+std::map<std::string, std::pair<std::string, std::string>>
+engineChanges(const boost::property_tree::ptree &baseline,
+              const boost::property_tree::ptree &candidate);
+
+} // namespace report
+#endif
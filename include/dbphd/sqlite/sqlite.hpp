@@ -0,0 +1,106 @@
+#ifndef SQLITE_HPP
+#define SQLITE_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <sqlite3.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// sqlite3 error codes as exceptions, so the benches handle them like the errors
+// of the other client libraries
+class SQLiteException : public std::runtime_error
+{
+private:
+	int m_Code;
+
+public:
+	SQLiteException(sqlite3* db, const std::string& what);
+	int Code() const { return m_Code; }
+	// Another connection holds the lock for longer than the busy timeout
+	bool IsBusy() const { return (m_Code & 0xff) == SQLITE_BUSY || (m_Code & 0xff) == SQLITE_LOCKED; }
+};
+
+// A statement prepared once and stepped many times. Bind indexes start at 1,
+// column indexes at 0, like the sqlite3 API.
+class SQLiteStatement
+{
+private:
+	std::shared_ptr<sqlite3> m_Conn;
+	sqlite3_stmt* m_Stmt = nullptr;
+
+public:
+	SQLiteStatement(std::shared_ptr<sqlite3> conn, const std::string& sql);
+	SQLiteStatement(const SQLiteStatement&) = delete;
+	SQLiteStatement& operator=(const SQLiteStatement&) = delete;
+	virtual ~SQLiteStatement();
+
+	SQLiteStatement& Bind(int index, int64_t value);
+	SQLiteStatement& Bind(int index, double value);
+	SQLiteStatement& Bind(int index, const std::string& value);
+	SQLiteStatement& BindNull(int index);
+	// True while there is a row to read
+	bool Step();
+	// Steps to completion and resets, returns the rows changed
+	int64_t Execute();
+	// Ready to step again, the bindings stay unless cleared
+	void Reset(bool clearBindings = false);
+
+	int Columns() const { return sqlite3_column_count(m_Stmt); }
+	int64_t Int(int column) const { return sqlite3_column_int64(m_Stmt, column); }
+	double Double(int column) const { return sqlite3_column_double(m_Stmt, column); }
+	std::string Text(int column) const;
+};
+
+// BEGIN on construction, rolls back unless committed. Write transactions begin
+// IMMEDIATE so they queue on the busy timeout for the single writer instead of
+// failing when a read lock cannot be upgraded.
+class SQLiteTransaction
+{
+private:
+	std::shared_ptr<sqlite3> m_Conn;
+	bool m_Open;
+
+public:
+	SQLiteTransaction(std::shared_ptr<sqlite3> conn, bool write = true);
+	SQLiteTransaction(const SQLiteTransaction&) = delete;
+	SQLiteTransaction& operator=(const SQLiteTransaction&) = delete;
+	virtual ~SQLiteTransaction();
+	void Commit();
+	void Rollback();
+};
+
+class SQLiteDBHandler
+{
+private:
+
+
+public:
+	SQLiteDBHandler();
+
+	// One connection per thread, in WAL mode with synchronous=NORMAL (durable on
+	// checkpoint, not on every commit) and a busy timeout for the writer lock.
+	// The path defaults to $DBPHD_SQLITE_PATH or phdtests.sqlite.
+	static std::shared_ptr<sqlite3> GetConnection(std::string path = "");
+	static void Exec(std::shared_ptr<sqlite3> conn, const std::string& sql);
+	static bool DropTable(std::shared_ptr<sqlite3> conn, std::string tablename);
+	static bool TruncateTable(std::shared_ptr<sqlite3> conn, std::string tablename);
+	static bool TableExists(std::shared_ptr<sqlite3> conn, std::string tablename);
+	// Copies the rows of tables into a new database file at path. The copy is
+	// written to path.partial first and renamed once complete.
+	static void SnapshotTables(std::shared_ptr<sqlite3> conn, const std::string& path, const std::vector<std::string>& tables);
+	// Inserts the rows of tables from the snapshot at path into the (empty)
+	// tables of the same name, false when there is no snapshot at path
+	static bool RestoreTables(std::shared_ptr<sqlite3> conn, const std::string& path, const std::vector<std::string>& tables);
+	// Runs sql in one transaction with the snapshot at path attached as
+	// "snapshot", to put the rows a benchmark changed back the way the snapshot
+	// has them. False when there is no snapshot at path.
+	static bool ResetTables(std::shared_ptr<sqlite3> conn, const std::string& path, const std::string& sql);
+	// Library version and the pragmas that matter for the benchmarks
+	static std::map<std::string, std::string> ServerInfo(std::shared_ptr<sqlite3> conn);
+	virtual ~SQLiteDBHandler();
+};
+
+#endif /* SQLITE_HPP */
@@ -0,0 +1,56 @@
+#if !defined(TPCBACKEND)
+#define TPCBACKEND
+#include <exception>
+#include <map>
+#include <string>
+
+#include "dbphd/tpc/tpchelpers.hpp"
+
+namespace tpcc {
+
+// What the driver does with a transaction that threw
+enum class FailureKind {
+    Conflict,  // deadlock or serialization failure, counted and the terminal goes on
+    Transient, // e.g. a lost connection or a transaction the server gave up on
+    Fatal      // stops the run
+};
+
+// One terminal's view of a TPC-C implementation. The driver creates one backend
+// per terminal (so a backend can own its connection and caches) and owns the
+// transaction mix, pacing, timing and reporting.
+class Backend {
+  public:
+    virtual ~Backend() = default;
+
+    // Creates the database for params, only called on one terminal before the
+    // run. Implementations keep the existing data when params and clients match.
+    virtual void load(ScaleParameters &params, int clients) = 0;
+
+    // Each transaction returns false when it rolled back by design (the 1% of
+    // NewOrders with an unused item number), and throws on any other failure.
+    virtual bool newOrder(ScaleParameters &params) = 0;
+    virtual bool payment(ScaleParameters &params) = 0;
+    virtual bool orderStatus(ScaleParameters &params) = 0;
+    virtual bool delivery(ScaleParameters &params) = 0;
+    virtual bool stockLevel(ScaleParameters &params) = 0;
+
+    virtual FailureKind classify(const std::exception & /*e*/) const {
+        return FailureKind::Fatal;
+    }
+
+    // Engine specific counters of this terminal (e.g. retries), summed over the
+    // terminals of the run
+    virtual void counters(std::map<std::string, double> & /*out*/) const {}
+
+    // Cumulative server side statistics (buffer pool reads, lock waits, WAL
+    // bytes, ...), snapshotted by one terminal at both edges of the measurement
+    // window; the driver reports the difference
+    virtual void serverStatistics(std::map<std::string, double> & /*out*/) {}
+
+    // Called on one terminal once every terminal stopped, e.g. to check the
+    // consistency of the database after the run
+    virtual void finish(std::map<std::string, double> & /*out*/) {}
+};
+
+} // namespace tpcc
+#endif
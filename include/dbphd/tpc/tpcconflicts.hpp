@@ -0,0 +1,94 @@
+#if !defined(TPCCONFLICTS)
+#define TPCCONFLICTS
+#include <array>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpcregistry.hpp"
+
+namespace tpcc {
+
+// Aborts are transactions the driver counted as conflicts (deadlocks, busy
+// databases), retries are attempts a backend repeated itself, e.g. MongoDB
+// transactions with a transient transaction error.
+enum class ConflictKind {
+    Abort = 0,
+    Retry = 1
+};
+
+const int CONFLICT_KINDS = 2;
+
+// Where a conflict hit: the transaction type, the statement running at the time
+// (the last one marked with markPhase) and the warehouse and district of the
+// transaction. dId is 0 for transactions without a district, e.g. a Delivery
+// that conflicted before its first district.
+struct ConflictSite {
+    TransactionType type;
+    std::string statement;
+    int wId;
+    int dId;
+
+    bool operator<(const ConflictSite &other) const {
+        return std::tie(type, statement, wId, dId) <
+               std::tie(other.type, other.statement, other.wId, other.dId);
+    }
+};
+
+using ConflictCounts = std::array<int64_t, CONFLICT_KINDS>;
+
+// The conflicts of one terminal by site. Like PhaseProfile only conflicts
+// between begin() and end() are recorded.
+class ConflictMap {
+  public:
+    void begin(TransactionType type);
+    void markStatement(const char *name) { statement = name; }
+    void markKey(int warehouse, int district) {
+        wId = warehouse;
+        dId = district;
+    }
+    void record(ConflictKind kind);
+    void end() { running = false; }
+    void merge(const ConflictMap &other);
+
+    const std::map<ConflictSite, ConflictCounts> &sites() const { return counts; }
+    int64_t total(ConflictKind kind) const;
+
+  private:
+    bool running = false;
+    TransactionType type = TransactionType::NewOrder;
+    const char *statement = nullptr;
+    int wId = 0;
+    int dId = 0;
+    std::map<ConflictSite, ConflictCounts> counts;
+};
+
+// Per terminal maps like the phase profiles, merged once every terminal has
+// stopped. forThread also makes the map the one the free functions below
+// record into on the calling thread.
+class ConflictRegistry {
+  public:
+    static ConflictMap &forThread(int thread);
+    static ConflictMap merge(int threads);
+    static ConflictMap *active();
+    static void deactivate();
+
+  private:
+    static TerminalRegistry<ConflictMap> terminals;
+};
+
+// The warehouse and district the calling thread's transaction works on, set
+// by the parameter generators and refined by loops over districts
+inline void markConflictKey(int wId, int dId) {
+    if (ConflictMap *conflicts = ConflictRegistry::active())
+        conflicts->markKey(wId, dId);
+}
+
+inline void recordConflict(ConflictKind kind) {
+    if (ConflictMap *conflicts = ConflictRegistry::active())
+        conflicts->record(kind);
+}
+
+} // namespace tpcc
+#endif
@@ -356,6 +356,12 @@ struct History {
         << "\r\n";
     }
 };
+// A terminal's fixed home warehouse and district, wId 0 for none
+struct TerminalHome {
+    int wId = 0;
+    int dId = 0;
+};
+
 class RandomHelper {
 public:
     RandomHelper()  {
@@ -397,6 +403,13 @@ public:
     int makeDistrictId(const ScaleParameters& params);
     int makeCustomerId(const ScaleParameters& params);
     int makeItemId(const ScaleParameters& params);
+    // Binds the terminal on the calling thread to home, as TPC-C 2.4.1.1 does:
+    // every transaction then runs against the home warehouse and StockLevel
+    // against the home district, other warehouses are only reached through the
+    // remote NewOrder supply (1%) and Payment customer (15%) picks. Without a
+    // home every transaction picks a random warehouse.
+    static void setHome(const TerminalHome& home) { terminalHome = home; }
+    static TerminalHome home() { return terminalHome; }
     // Transactions
     void generateDeliveryParams(const ScaleParameters& params, DeliveryParams& out);
     void generateNewOrderParams(const ScaleParameters& params, NewOrderParams& out);
@@ -423,6 +436,7 @@ private:
 
     thread_local static std::random_device rd;
     thread_local static std::mt19937 gen;
+    thread_local static TerminalHome terminalHome;
 
     NuRandC cValues;
 };
@@ -456,6 +470,13 @@ struct ScaleParameters {
     }
 };
 
+// The home of terminal (0 based). Terminals are spread over the warehouses
+// first and then over the districts, so as few as possible share a warehouse.
+TerminalHome makeTerminalHome(const ScaleParameters& params, int terminal);
+
+// True when $DBPHD_HOME_WAREHOUSE is set to anything but "" or "0"
+bool homeWarehousesEnabled();
+
 } // namespace tpcc
 
 
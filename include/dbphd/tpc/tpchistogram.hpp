@@ -0,0 +1,103 @@
+#if !defined(TPCHISTOGRAM)
+#define TPCHISTOGRAM
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpcregistry.hpp"
+
+namespace tpcc {
+
+// High dynamic range histogram: values are kept to a fixed number of significant
+// digits over the whole trackable range, in log-linear buckets. Recording is a
+// plain counter increment, so a histogram must only be written by one thread.
+class Histogram {
+  public:
+    // One hour in microseconds, to 3 significant digits
+    explicit Histogram(int64_t highestTrackable = 3600LL * 1000 * 1000,
+                       int significantDigits = 3);
+
+    // Values above the highest trackable value are clamped to it.
+    void record(int64_t value, int64_t count = 1);
+    void merge(const Histogram &other);
+    void reset();
+
+    int64_t count() const { return totalCount; }
+    int64_t min() const { return totalCount == 0 ? 0 : minValue; }
+    int64_t max() const { return maxValue; }
+    double mean() const;
+    double stdDev() const;
+    // Highest value equivalent to the one at percentile (0-100)
+    int64_t valueAtPercentile(double percentile) const;
+
+    // Percentile distribution in the HdrHistogram text format (.hgrm), values are
+    // divided by unitScale, e.g. 1000 to write microsecond values as milliseconds.
+    void writePercentiles(std::ostream &out, double unitScale = 1.0,
+                          int ticksPerHalfDistance = 5) const;
+
+  private:
+    int subBucketBits;
+    int64_t subBucketHalfCount;
+    int64_t subBucketMask;
+    int64_t highestTrackable;
+    std::vector<int64_t> counts;
+    int64_t totalCount = 0;
+    int64_t minValue = INT64_MAX;
+    int64_t maxValue = 0;
+    double sum = 0;
+    double sumSquares = 0;
+
+    size_t indexOf(int64_t value) const;
+    int64_t highestEquivalent(size_t index) const;
+};
+
+// The latency histograms of one terminal, one per transaction type, in microseconds
+class TransactionLatencies {
+  public:
+    static const int TYPES = 5;
+
+    void record(TransactionType type, std::chrono::nanoseconds latency) {
+        histograms[static_cast<int>(type)].record(
+            std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    }
+    Histogram &operator[](TransactionType type) {
+        return histograms[static_cast<int>(type)];
+    }
+    const Histogram &operator[](TransactionType type) const {
+        return histograms[static_cast<int>(type)];
+    }
+    void merge(const TransactionLatencies &other);
+    void reset();
+
+  private:
+    std::array<Histogram, TYPES> histograms;
+};
+
+// Lower camel case name used in counters and file names, e.g. "newOrder"
+const char *transactionTypeName(TransactionType type);
+
+// Service latency is measured from the actual start of a transaction. Response
+// latency is measured from its intended start, which adds the time an open loop
+// terminal was behind schedule; in a closed loop both are the same.
+enum class LatencyKind {
+    Service = 0,
+    Response = 1
+};
+
+// Per terminal latencies of both kinds, see TerminalRegistry
+class LatencyRegistry {
+  public:
+    static TransactionLatencies &forThread(int thread,
+                                           LatencyKind kind = LatencyKind::Service);
+    static TransactionLatencies merge(int threads,
+                                      LatencyKind kind = LatencyKind::Service);
+
+  private:
+    static TerminalRegistry<TransactionLatencies, 2> terminals;
+};
+
+} // namespace tpcc
+#endif
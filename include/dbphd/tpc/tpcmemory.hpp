@@ -0,0 +1,110 @@
+#if !defined(TPCMEMORY)
+#define TPCMEMORY
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dbphd/tpc/tpcbackend.hpp"
+#include "dbphd/tpc/tpchelpers.hpp"
+
+namespace tpcc {
+
+// In process TPC-C database with no network, parser or durability cost, the
+// ceiling the client/server engines are compared against. Rows live in vectors
+// addressed by (w_id, d_id, id). Everything a district owns (customers, orders,
+// new orders and history) is guarded by that district's mutex. Warehouse YTD and
+// stock rows, which transactions of any district update, have their own locks
+// that are always taken last and one at a time, so locking cannot deadlock.
+class MemoryDatabase {
+  public:
+    // Creates the database for params, keeps the existing one when params match.
+    // Not thread safe, call it before the terminals start.
+    void load(ScaleParameters &params);
+
+    // The five transactions, each atomic with respect to the others. newOrder
+    // returns false when it rolled back on an unused item number, payment the
+    // c_id it paid, orderStatus the number of lines of the customer's last
+    // order, delivery the number of districts that had an order to deliver and
+    // stockLevel the number of recently sold items below the threshold.
+    bool newOrder(const NewOrderParams &in);
+    int payment(const PaymentParams &in);
+    int orderStatus(const OrderStatusParams &in);
+    int delivery(const DeliveryParams &in);
+    int stockLevel(const StockLevelParams &in);
+
+    // Only valid while no transaction runs
+    const District &district(int wId, int dId) const;
+    const Warehouse &warehouse(int wId) const;
+    // TPC-C 3.3.2.1-3.3.2.3 as anomaly counts: W_YTD = sum(D_YTD), D_NEXT_O_ID - 1
+    // = max(O_ID) and contiguous NEW-ORDER ids, per warehouse or district.
+    void checkConsistency(std::map<std::string, double> &out) const;
+
+  private:
+    static const int STOCK_LOCK_STRIPES = 256;
+
+    struct WarehouseRow {
+        std::mutex lock;
+        Warehouse warehouse;
+    };
+    // Allocated separately so the mutexes of two districts never share a cache line
+    struct DistrictPartition {
+        std::mutex lock;
+        District district;
+        std::vector<Customer> customers; // c_id - 1
+        // c_id - 1 of every customer with a last name, ordered by c_first
+        std::unordered_map<std::string, std::vector<int>> customersByLast;
+        std::vector<int> lastOrder; // c_id - 1 -> o_id of the customer's latest order
+        std::vector<Order> orders;  // o_id - 1, lines in Order::oLines
+        std::deque<int> newOrders;  // undelivered o_ids, ascending
+        std::vector<History> history;
+    };
+    struct StockTable {
+        std::vector<Stock> rows; // i_id - 1
+        std::vector<std::mutex> locks =
+            std::vector<std::mutex>(STOCK_LOCK_STRIPES); // by (i_id - 1) % stripes
+    };
+
+    bool loaded = false;
+    ScaleParameters params = ScaleParameters::makeDefault(1);
+    std::vector<Item> items; // i_id - 1, read only after load
+    std::vector<std::unique_ptr<WarehouseRow>> warehouses;     // w_id - 1
+    std::vector<std::unique_ptr<DistrictPartition>> districts; // (w_id - 1) * districts + d_id - 1
+    std::vector<std::unique_ptr<StockTable>> stock;            // w_id - 1
+
+    DistrictPartition &partition(int wId, int dId) const;
+    // c_id - 1 of the customer by id, or the middle one by last name (2.5.2.2)
+    static int findCustomer(const DistrictPartition &district, int cId,
+                            const std::string &cLast);
+};
+
+// One terminal of the in-memory engine, all terminals share one database
+class MemoryBackend : public Backend {
+  public:
+    explicit MemoryBackend(MemoryDatabase &database) : database(database) {}
+
+    void load(ScaleParameters &params, int clients) override;
+    bool newOrder(ScaleParameters &params) override;
+    bool payment(ScaleParameters &params) override;
+    bool orderStatus(ScaleParameters &params) override;
+    bool delivery(ScaleParameters &params) override;
+    bool stockLevel(ScaleParameters &params) override;
+    void counters(std::map<std::string, double> &out) const override;
+    void finish(std::map<std::string, double> &out) override;
+
+  private:
+    MemoryDatabase &database;
+    int noNewOrders = 0;
+    // Reused so generating the inputs does not allocate on every transaction
+    NewOrderParams noparams;
+    PaymentParams pparams;
+    OrderStatusParams osparams;
+    DeliveryParams dparams;
+    StockLevelParams sparams;
+};
+
+} // namespace tpcc
+#endif
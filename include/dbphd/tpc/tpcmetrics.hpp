@@ -0,0 +1,16 @@
+#if !defined(TPCMETRICS)
+#define TPCMETRICS
+#include <ctime>
+
+namespace tpcc {
+
+// CPU time consumed by the calling thread, in seconds. Used to measure the client
+// side cost of a transaction, which wall time hides behind server round trips.
+inline double threadCPUTime() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+} // namespace tpcc
+#endif
@@ -0,0 +1,47 @@
+#if !defined(TPCPACING)
+#define TPCPACING
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace tpcc {
+
+// How a terminal schedules its transactions. Closed issues the next transaction
+// as soon as the previous one finished, the open processes issue them at a target
+// arrival rate regardless of how long the previous ones took.
+enum class ArrivalProcess {
+    Closed = 0,
+    Constant = 1,
+    Poisson = 2
+};
+
+const char *arrivalProcessName(ArrivalProcess process);
+
+class ArrivalSchedule {
+  public:
+    // ratePerSecond is the arrival rate of this terminal, ignored when closed
+    ArrivalSchedule(ArrivalProcess process, double ratePerSecond,
+                    uint64_t seed = std::random_device{}());
+
+    bool isOpen() const { return process != ArrivalProcess::Closed; }
+
+    // Waits for the intended start of the next transaction and returns it. A
+    // terminal that fell behind does not wait, its intended start stays in the
+    // past so the queueing delay counts towards the response time (no
+    // coordinated omission). Closed schedules return now.
+    std::chrono::steady_clock::time_point next();
+
+    // The intended start after the next one, without waiting
+    std::chrono::steady_clock::time_point advance();
+
+  private:
+    ArrivalProcess process;
+    std::chrono::duration<double> meanInterval;
+    std::chrono::steady_clock::time_point intended;
+    bool started = false;
+    std::mt19937_64 gen;
+    std::exponential_distribution<double> exponential;
+};
+
+} // namespace tpcc
+#endif
@@ -0,0 +1,97 @@
+#if !defined(TPCPHASES)
+#define TPCPHASES
+#include <array>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dbphd/tpc/tpcconflicts.hpp"
+#include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpchistogram.hpp"
+#include "dbphd/tpc/tpcregistry.hpp"
+
+namespace tpcc {
+
+// Where the client spends the time of one statement: building the query text
+// or document, executing it (sending it and waiting on the server, which the
+// blocking drivers do in one call) and decoding the result.
+enum class Phase {
+    Build = 0,
+    Execute = 1,
+    Decode = 2
+};
+
+const int PHASES = 3;
+
+// Upper camel case name used as a counter suffix, e.g. "Execute"
+const char *phaseName(Phase phase);
+
+// True when $DBPHD_PHASES is set to anything but "" or "0"
+bool phasesEnabled();
+
+// The time of one statement of one transaction type, summed over its executions
+struct StatementPhases {
+    TransactionType type;
+    std::string statement;
+    int64_t executions = 0;
+    std::array<int64_t, PHASES> nanoseconds{};
+};
+
+// The phase times of one terminal. A transaction is a sequence of marks, each
+// ending the phase running before it; end() ends the last one. Marks outside
+// begin()/end(), e.g. while loading, are ignored. Statements are told apart by
+// the address of their name, so names must be string literals.
+class PhaseProfile {
+  public:
+    void begin(TransactionType type);
+    void mark(const char *statement, Phase phase);
+    void end();
+    void reset();
+    // Adds other's statements, matched by type and name
+    void merge(const PhaseProfile &other);
+
+    const std::vector<StatementPhases> &statements() const { return entries; }
+    int64_t transactions(TransactionType type) const {
+        return counts[static_cast<int>(type)];
+    }
+    // Summed over the statements of a transaction type
+    int64_t nanoseconds(TransactionType type, Phase phase) const;
+
+  private:
+    bool running = false;
+    TransactionType type = TransactionType::NewOrder;
+    int current = -1;
+    Phase currentPhase = Phase::Build;
+    std::chrono::steady_clock::time_point since;
+    std::array<std::unordered_map<const char *, int>, TransactionLatencies::TYPES> index;
+    std::vector<StatementPhases> entries;
+    std::array<int64_t, TransactionLatencies::TYPES> counts{};
+};
+
+// Per terminal profiles like the latency histograms, merged once every terminal
+// has stopped. forThread also makes the profile the one markPhase records into
+// on the calling thread.
+class PhaseRegistry {
+  public:
+    static PhaseProfile &forThread(int thread);
+    static PhaseProfile merge(int threads);
+    // The profile of the calling thread, nullptr when phases are not recorded
+    static PhaseProfile *active();
+    static void deactivate();
+
+  private:
+    static TerminalRegistry<PhaseProfile> terminals;
+};
+
+// Starts phase of statement in the calling thread's transaction, a no-op unless
+// the driver records phases. Also names the statement conflicts are blamed on.
+inline void markPhase(const char *statement, Phase phase) {
+    if (PhaseProfile *profile = PhaseRegistry::active())
+        profile->mark(statement, phase);
+    if (ConflictMap *conflicts = ConflictRegistry::active())
+        conflicts->markStatement(statement);
+}
+
+} // namespace tpcc
+#endif
@@ -0,0 +1,48 @@
+#if !defined(TPCREGISTRY)
+#define TPCREGISTRY
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tpcc {
+
+// Per terminal instances of T (latency histograms, phase profiles, ...), so
+// recording never takes a lock. Each terminal replaces its own slot when it
+// starts and the run's totals are merged once every terminal has stopped
+// recording (after the benchmark's end of loop barrier). A terminal may keep
+// the reference forThread returns while others register, the instances live
+// outside the growing vector. Kinds are independent slots of one terminal,
+// e.g. service and response latencies.
+template <typename T, int Kinds = 1> class TerminalRegistry {
+  public:
+    T &forThread(int thread, int kind = 0) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (terminals.size() <= (size_t)thread)
+            terminals.resize(thread + 1);
+        auto &slot = terminals[thread][kind];
+        // Allocated afresh by the (possibly pinned) terminal rather than reset,
+        // so the pages are first touched on the terminal's NUMA node
+        slot = std::make_unique<T>();
+        return *slot;
+    }
+
+    // The first threads terminals merged with T::merge
+    T merge(int threads, int kind = 0) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        T merged;
+        for (int i = 0; i < threads && i < (int)terminals.size(); ++i) {
+            auto &slot = terminals[i][kind];
+            if (slot)
+                merged.merge(*slot);
+        }
+        return merged;
+    }
+
+  private:
+    std::mutex registryMutex;
+    std::vector<std::array<std::unique_ptr<T>, Kinds>> terminals;
+};
+
+} // namespace tpcc
+#endif
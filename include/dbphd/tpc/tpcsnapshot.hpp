@@ -0,0 +1,58 @@
+#if !defined(TPCSNAPSHOT)
+#define TPCSNAPSHOT
+#include <cstdint>
+#include <string>
+
+#include "dbphd/tpc/tpchelpers.hpp"
+
+namespace tpcc {
+
+// Bumped whenever a loader changes what it generates, so older snapshots are
+// no longer restored
+const int DATASET_VERSION = 1;
+
+// One generated TPC-C dataset: the engine and data model it was loaded for,
+// its scale and the seed of the generators. The client count is not part of
+// it, loading is spread over the OpenMP threads, not the terminals.
+struct DatasetKey {
+    std::string engine;
+    std::string model;
+    ScaleParameters params;
+    uint64_t seed;
+    // Grown or shrunk from another scale rather than loaded at this one. The
+    // remote warehouses of its order lines differ from a fresh load, so it is
+    // snapshotted under a name of its own.
+    bool resized = false;
+
+    // e.g. "tpcc_postgres_old_v1_w1_4_i100000_d10_c3000_n900_s0", with "_r"
+    // appended when resized. Short and plain enough for a Postgres schema, a
+    // MongoDB database or a file name.
+    std::string name() const;
+    // True when other is this dataset, however either of them was made
+    bool sameScale(const DatasetKey &other) const;
+    // True when other is this dataset with more or fewer warehouses, which a
+    // loader can add to or delete from the loaded data instead of reloading
+    bool resizesTo(const DatasetKey &other) const;
+};
+
+// Warehouses first to last of params, with the same items, districts and
+// customers, for loading the warehouses a dataset grows by
+ScaleParameters warehouseRange(const ScaleParameters &params, int first, int last);
+
+// Loaders keep a snapshot of every dataset they generate and restore it on
+// later runs instead of generating it again, unless $DBPHD_SNAPSHOTS is "0"
+bool snapshotsEnabled();
+// Where file based engines keep their snapshots, $DBPHD_SNAPSHOT_DIR or
+// "snapshots" in the working directory
+std::string snapshotDirectory();
+
+// $DBPHD_SEED, 0 when not set: the generators keep their random seeds, and
+// the first snapshot of a scale is the one every later run restores
+uint64_t loadSeed();
+// Seeds the calling loader thread's generators with loadSeed() + thread, so a
+// seeded dataset comes out the same for the same number of loader threads.
+// Does nothing without a seed.
+void seedLoader(int thread);
+
+} // namespace tpcc
+#endif
@@ -0,0 +1,74 @@
+#if !defined(TPCWINDOW)
+#define TPCWINDOW
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "dbphd/tpc/tpcregistry.hpp"
+
+namespace tpcc {
+
+// The stages of a time based run. Every terminal runs the mix from the start
+// to the end of the ramp down, only transactions started in the measurement
+// window count towards the results; the ramp down keeps the load up until the
+// last measured transactions have finished.
+enum class RunStage {
+    RampUp = 0,
+    Measure = 1,
+    RampDown = 2,
+    Done = 3
+};
+
+const char *runStageName(RunStage stage);
+
+struct MeasurementWindow {
+    std::chrono::duration<double> rampUp{10};
+    std::chrono::duration<double> measure{60};
+    std::chrono::duration<double> rampDown{5};
+
+    // Seconds from $DBPHD_RAMP_UP, $DBPHD_MEASURE and $DBPHD_RAMP_DOWN, the
+    // defaults above for the ones that are not set or not valid
+    static MeasurementWindow fromEnvironment();
+
+    // The stage at elapsed time since the start of the run
+    RunStage stageAt(std::chrono::duration<double> elapsed) const;
+    std::chrono::duration<double> total() const { return rampUp + measure + rampDown; }
+};
+
+// Transactions completed per second since the start of one terminal's run.
+// Terminals start together after the benchmark's start barrier, so their
+// seconds line up closely enough to be summed.
+class ThroughputSeries {
+  public:
+    void record(std::chrono::duration<double> elapsed);
+    void merge(const ThroughputSeries &other);
+    void reset() { seconds.clear(); }
+    const std::vector<int64_t> &perSecond() const { return seconds; }
+
+  private:
+    std::vector<int64_t> seconds;
+};
+
+// Per terminal series like the latency histograms, merged once every terminal
+// has stopped
+class ThroughputRegistry {
+  public:
+    static ThroughputSeries &forThread(int thread);
+    static ThroughputSeries merge(int threads);
+
+  private:
+    static TerminalRegistry<ThroughputSeries> terminals;
+};
+
+// Standard deviation over mean of perSecond[from, to), 0 for an empty or idle range
+double coefficientOfVariation(const std::vector<int64_t> &perSecond, size_t from, size_t to);
+
+// The first second from which the throughput of window consecutive seconds
+// varies (coefficient of variation) by at most maxVariation, or by at most twice
+// what Poisson arrivals at that rate would vary by on their own, whichever is
+// larger. -1 when the throughput never settles.
+int steadyStateStart(const std::vector<int64_t> &perSecond, size_t window = 5,
+                     double maxVariation = 0.05);
+
+} // namespace tpcc
+#endif
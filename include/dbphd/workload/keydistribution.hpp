@@ -0,0 +1,215 @@
+#ifndef KEYDISTRIBUTION_HPP
+#define KEYDISTRIBUTION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// How often each of the keys 0 .. keys-1 is chosen. Uniform picks them
+// equally, Zipfian picks key k in proportion to 1/(k+1)^theta (YCSB's
+// generator after Gray et al.), Hotspot picks the first hotKeys of them
+// hotAccesses of the time and Latest is Zipfian from the last key down, for
+// workloads that mostly touch the newest rows.
+enum class Distribution {
+	Uniform = 0,
+	Zipfian = 1,
+	Hotspot = 2,
+	Latest = 3
+};
+
+inline const char* DistributionName(Distribution distribution) {
+	switch(distribution) {
+		case Distribution::Uniform:
+			return "uniform";
+		case Distribution::Zipfian:
+			return "zipfian";
+		case Distribution::Hotspot:
+			return "hotspot";
+		case Distribution::Latest:
+			return "latest";
+	}
+	return "unknown";
+}
+
+// Maps a uniform number in [0, 1) to a key, so the same distribution can draw
+// query keys from a generator and derive fixture values from a hash of the row.
+// The Zipfian constants are summed over every key once per number of keys and
+// theta, the benchmarks construct the same distributions over and over.
+class KeyDistribution
+{
+private:
+	Distribution m_Type = Distribution::Uniform;
+	uint64_t m_Keys = 1;
+	// Zipfian and Latest
+	double m_Theta = 0;
+	double m_Zetan = 0;
+	double m_Alpha = 0;
+	double m_Eta = 0;
+	// Hotspot
+	uint64_t m_HotKeys = 0;
+	double m_HotAccesses = 0;
+
+	// Sum of 1/i^theta over i = 1 .. keys
+	static double zeta(uint64_t keys, double theta) {
+		static std::mutex mutex;
+		static std::map<std::pair<uint64_t, double>, double> sums;
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = sums.find({keys, theta});
+		if(found != sums.end())
+			return found->second;
+		double sum = 0;
+		for(uint64_t i = 1; i <= keys; ++i)
+			sum += 1.0 / std::pow((double)i, theta);
+		sums.emplace(std::make_pair(keys, theta), sum);
+		return sum;
+	}
+
+	uint64_t zipfian(double u) const {
+		double uz = u * m_Zetan;
+		if(uz < 1.0)
+			return 0;
+		if(uz < 1.0 + std::pow(0.5, m_Theta))
+			return std::min<uint64_t>(1, m_Keys - 1);
+		uint64_t key = (uint64_t)(m_Keys * std::pow(m_Eta * u - m_Eta + 1, m_Alpha));
+		return std::min(key, m_Keys - 1);
+	}
+
+public:
+	explicit KeyDistribution(uint64_t keys = 1) : m_Keys(std::max<uint64_t>(keys, 1)) {}
+
+	static KeyDistribution Uniform(uint64_t keys) {
+		return KeyDistribution(keys);
+	}
+
+	// theta in (0, 1), the larger the more skewed
+	static KeyDistribution Zipfian(uint64_t keys, double theta = 0.99) {
+		KeyDistribution d(keys);
+		d.m_Type = Distribution::Zipfian;
+		d.m_Theta = theta;
+		d.m_Zetan = zeta(d.m_Keys, theta);
+		double zeta2 = 1.0 + std::pow(0.5, theta);
+		d.m_Alpha = 1.0 / (1.0 - theta);
+		d.m_Eta = d.m_Keys < 2 ? 0 : (1.0 - std::pow(2.0 / d.m_Keys, 1.0 - theta)) / (1.0 - zeta2 / d.m_Zetan);
+		return d;
+	}
+
+	// hotKeys and hotAccesses as fractions, e.g. 0.2 and 0.8 for 80% of the
+	// accesses to 20% of the keys
+	static KeyDistribution Hotspot(uint64_t keys, double hotKeys = 0.2, double hotAccesses = 0.8) {
+		KeyDistribution d(keys);
+		d.m_Type = Distribution::Hotspot;
+		d.m_HotKeys = std::min(d.m_Keys, std::max<uint64_t>(1, (uint64_t)(hotKeys * d.m_Keys)));
+		d.m_HotAccesses = hotAccesses;
+		return d;
+	}
+
+	static KeyDistribution Latest(uint64_t keys, double theta = 0.99) {
+		KeyDistribution d = Zipfian(keys, theta);
+		d.m_Type = Distribution::Latest;
+		return d;
+	}
+
+	// "name[:parameter[:parameter]]" with the parameters of the factories
+	// above, e.g. "zipfian:0.9" or "hotspot:0.1:0.9". False when spec is not
+	// one, out is left alone then.
+	static bool Parse(const std::string& spec, uint64_t keys, KeyDistribution& out) {
+		std::vector<std::string> parts;
+		size_t start = 0;
+		while(true) {
+			size_t colon = spec.find(':', start);
+			parts.push_back(spec.substr(start, colon == std::string::npos ? std::string::npos : colon - start));
+			if(colon == std::string::npos)
+				break;
+			start = colon + 1;
+		}
+		std::vector<double> parameters;
+		for(size_t i = 1; i < parts.size(); ++i) {
+			char* end;
+			double value = std::strtod(parts[i].c_str(), &end);
+			if(parts[i].empty() || *end != '\0')
+				return false;
+			parameters.push_back(value);
+		}
+		auto parameter = [&](size_t i, double fallback) { return i < parameters.size() ? parameters[i] : fallback; };
+		const std::string& name = parts[0];
+		if(name == "uniform" && parameters.empty()) {
+			out = Uniform(keys);
+		} else if((name == "zipfian" || name == "latest") && parameters.size() <= 1) {
+			double theta = parameter(0, 0.99);
+			if(theta <= 0 || theta >= 1)
+				return false;
+			out = name == "zipfian" ? Zipfian(keys, theta) : Latest(keys, theta);
+		} else if(name == "hotspot" && parameters.size() <= 2) {
+			double hotKeys = parameter(0, 0.2), hotAccesses = parameter(1, 0.8);
+			if(hotKeys <= 0 || hotKeys > 1 || hotAccesses <= 0 || hotAccesses > 1)
+				return false;
+			out = Hotspot(keys, hotKeys, hotAccesses);
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	Distribution Type() const { return m_Type; }
+	uint64_t Keys() const { return m_Keys; }
+	// The parameters of the factories, 0 for the distributions without them
+	double Theta() const { return m_Theta; }
+	double HotKeys() const { return m_Type == Distribution::Hotspot ? (double)m_HotKeys / m_Keys : 0; }
+	double HotAccesses() const { return m_HotAccesses; }
+
+	// The key for u in [0, 1)
+	uint64_t Key(double u) const {
+		switch(m_Type) {
+			case Distribution::Uniform:
+				break;
+			case Distribution::Zipfian:
+				return zipfian(u);
+			case Distribution::Latest:
+				return m_Keys - 1 - zipfian(u);
+			case Distribution::Hotspot:
+				if(m_HotKeys == m_Keys) // every key is hot
+					break;
+				if(u < m_HotAccesses)
+					return std::min(m_HotKeys - 1, (uint64_t)(u / m_HotAccesses * m_HotKeys));
+				return std::min(m_Keys - 1, m_HotKeys + (uint64_t)((u - m_HotAccesses) / (1 - m_HotAccesses) * (m_Keys - m_HotKeys)));
+		}
+		return std::min(m_Keys - 1, (uint64_t)(u * m_Keys));
+	}
+
+	// Draws a key, like a std:: distribution
+	template <typename Generator>
+	int64_t operator()(Generator& gen) const {
+		return (int64_t)Key(std::generate_canonical<double, 53>(gen));
+	}
+
+	// count keys drawn with gen, sorted and without repeats: the rows of a
+	// batch, which concurrent batches then lock in the same order
+	template <typename Generator>
+	std::vector<uint64_t> Batch(Generator& gen, size_t count) const {
+		std::vector<uint64_t> keys(count);
+		for(auto& key : keys)
+			key = (uint64_t)(*this)(gen);
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+		return keys;
+	}
+
+	// The key of a position, e.g. a row and column of a fixture, the same every time
+	uint64_t KeyAt(uint64_t position) const {
+		// splitmix64, whose top 53 bits make the uniform number
+		uint64_t z = position + 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		z = z ^ (z >> 31);
+		return Key((z >> 11) * 0x1.0p-53);
+	}
+};
+
+#endif /* KEYDISTRIBUTION_HPP */
@@ -0,0 +1,34 @@
+#include <cstdlib>
+#include <exception>
+#include <fmt/core.h>
+#include <iostream>
+#include <boost/property_tree/json_parser.hpp>
+#include "dbphd/report/runreport.hpp"
+
+// Compares two run reports of bench_dbphd, exits with 1 when a throughput or p99
+// metric regressed by more than the threshold (in percent, 5 by default).
+auto main(int argc, char **argv) -> int {
+	if(argc < 3) {
+		std::cerr << "Usage: " << argv[0] << " <baseline.json> <candidate.json> [threshold %]" << std::endl;
+		return 2;
+	}
+	double threshold = argc > 3 ? std::atof(argv[3]) / 100 : 0.05;
+	boost::property_tree::ptree baseline, candidate;
+	try {
+		boost::property_tree::read_json(argv[1], baseline);
+		boost::property_tree::read_json(argv[2], candidate);
+	} catch(std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 2;
+	}
+
+	for(auto& change : report::engineChanges(baseline, candidate)) {
+		std::cout << fmt::format("{}: {} -> {}", change.first, change.second.first, change.second.second) << std::endl;
+	}
+	auto regressions = report::compareReports(baseline, candidate, threshold);
+	for(auto& regression : regressions) {
+		std::cout << fmt::format("{} {}: {:.6g} -> {:.6g} ({:+.1f}%)", regression.run, regression.metric, regression.baseline, regression.candidate, regression.change * 100) << std::endl;
+	}
+	std::cout << fmt::format("{} regressions beyond {:.1f}%", regressions.size(), threshold * 100) << std::endl;
+	return regressions.empty() ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+#include "dbphd/mongodb/bsoncommand.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// BSON is little endian, as is every platform we run the benchmarks on.
+static int32_t readInt32(const uint8_t* p) {
+	int32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static size_t cstringSize(const uint8_t* p) {
+	return strlen(reinterpret_cast<const char*>(p)) + 1;
+}
+
+BSONCommand::BSONCommand(bsoncxx::document::view doc) : BSONCommand(doc.data(), doc.length()) {
+}
+
+BSONCommand::BSONCommand(const uint8_t* data, size_t length) : m_Buffer(data, data + length) {
+}
+
+BSONCommand::BSONCommand(bsoncxx::document::view doc, std::initializer_list<std::string_view> paths) : BSONCommand(doc) {
+	m_Slots.reserve(paths.size());
+	for(auto path : paths) {
+		m_Slots.push_back(Slot(path));
+	}
+}
+
+size_t BSONCommand::ValueSize(const uint8_t* value, uint8_t type) {
+	switch(type) {
+		case 0x01: // double
+		case 0x09: // date
+		case 0x11: // timestamp
+		case 0x12: // int64
+			return 8;
+		case 0x02: // string
+		case 0x0D: // javascript
+		case 0x0E: // symbol
+			return 4 + readInt32(value);
+		case 0x03: // document
+		case 0x04: // array
+		case 0x0F: // code with scope
+			return readInt32(value);
+		case 0x05: // binary
+			return 4 + 1 + readInt32(value);
+		case 0x06: // undefined
+		case 0x0A: // null
+		case 0x7F: // max key
+		case 0xFF: // min key
+			return 0;
+		case 0x07: // oid
+			return 12;
+		case 0x08: // bool
+			return 1;
+		case 0x0B: { // regex
+			size_t pattern = cstringSize(value);
+			return pattern + cstringSize(value + pattern);
+		}
+		case 0x0C: // db pointer
+			return 4 + readInt32(value) + 12;
+		case 0x10: // int32
+			return 4;
+		case 0x13: // decimal128
+			return 16;
+	}
+	throw std::invalid_argument("Unknown BSON type " + std::to_string(type));
+}
+
+bool BSONCommand::FindValue(const uint8_t* data, size_t length, std::string_view path, size_t& offset, uint8_t& type) {
+	size_t dot = path.find('.');
+	std::string_view key = path.substr(0, dot);
+	size_t pos = 4;
+	size_t end = std::min(length, static_cast<size_t>(readInt32(data))) - 1;
+	while(pos < end) {
+		uint8_t elementType = data[pos++];
+		const char* name = reinterpret_cast<const char*>(data + pos);
+		size_t nameSize = cstringSize(data + pos);
+		pos += nameSize;
+		if(std::string_view(name, nameSize - 1) == key) {
+			if(dot == std::string_view::npos) {
+				offset = pos;
+				type = elementType;
+				return true;
+			}
+			if(elementType != 0x03 && elementType != 0x04)
+				return false;
+			size_t inner = 0;
+			if(!FindValue(data + pos, readInt32(data + pos), path.substr(dot + 1), inner, type))
+				return false;
+			offset = pos + inner;
+			return true;
+		}
+		pos += ValueSize(data + pos, elementType);
+	}
+	return false;
+}
+
+BSONSlot BSONCommand::Slot(std::string_view path) const {
+	BSONSlot slot;
+	if(!FindValue(m_Buffer.data(), m_Buffer.size(), path, slot.offset, slot.type))
+		throw std::invalid_argument("No BSON slot at " + std::string(path));
+	switch(slot.type) {
+		case 0x01: case 0x08: case 0x09: case 0x10: case 0x12:
+			return slot;
+	}
+	throw std::invalid_argument("BSON slot is not fixed width at " + std::string(path));
+}
+
+static void checkType(const BSONSlot& slot, uint8_t type) {
+	if(slot.type != type)
+		throw std::invalid_argument("BSON slot type mismatch");
+}
+
+void BSONCommand::Set(const BSONSlot& slot, int32_t value) {
+	checkType(slot, 0x10);
+	memcpy(m_Buffer.data() + slot.offset, &value, sizeof(value));
+}
+
+void BSONCommand::Set(const BSONSlot& slot, int64_t value) {
+	checkType(slot, 0x12);
+	memcpy(m_Buffer.data() + slot.offset, &value, sizeof(value));
+}
+
+void BSONCommand::Set(const BSONSlot& slot, double value) {
+	checkType(slot, 0x01);
+	memcpy(m_Buffer.data() + slot.offset, &value, sizeof(value));
+}
+
+void BSONCommand::Set(const BSONSlot& slot, bool value) {
+	checkType(slot, 0x08);
+	m_Buffer[slot.offset] = value ? 1 : 0;
+}
+
+void BSONCommand::Set(const BSONSlot& slot, std::chrono::system_clock::time_point value) {
+	checkType(slot, 0x09);
+	int64_t millis = std::chrono::duration_cast<std::chrono::milliseconds>(value.time_since_epoch()).count();
+	memcpy(m_Buffer.data() + slot.offset, &millis, sizeof(millis));
+}
@@ -0,0 +1,123 @@
+#include "dbphd/mongodb/bsondecoder.hpp"
+#include "dbphd/mongodb/bsoncommand.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+BSONDecoder::BSONDecoder(std::initializer_list<std::string_view> fields) {
+	for(auto field : fields) {
+		m_Fields.emplace_back(field);
+	}
+	m_Values.resize(m_Fields.size(), nullptr);
+	m_Types.resize(m_Fields.size(), 0);
+}
+
+BSONDecoder::BSONDecoder(const std::vector<std::string>& fields) : m_Fields(fields) {
+	m_Values.resize(m_Fields.size(), nullptr);
+	m_Types.resize(m_Fields.size(), 0);
+}
+
+size_t BSONDecoder::Decode(bsoncxx::document::view doc) {
+	std::fill(m_Values.begin(), m_Values.end(), nullptr);
+	const uint8_t* data = doc.data();
+	size_t end = doc.length() - 1;
+	size_t pos = 4;
+	size_t found = 0;
+	for(size_t element = 0; pos < end; ++element) {
+		uint8_t type = data[pos++];
+		const char* key = reinterpret_cast<const char*>(data + pos);
+		size_t keyLength = strlen(key);
+		pos += keyLength + 1;
+
+		if(element >= m_Shape.size()) {
+			m_Shape.push_back(UNKNOWN);
+			m_UnboundKeys.emplace_back();
+		}
+		int field = m_Shape[element];
+		const std::string* expected = nullptr;
+		if(field >= 0) {
+			expected = &m_Fields[field];
+		} else if(field == UNBOUND) {
+			expected = &m_UnboundKeys[element];
+		}
+		if(expected == nullptr || expected->size() != keyLength || memcmp(expected->data(), key, keyLength) != 0) {
+			// Shape changed (or first document), look the key up and remember it
+			field = UNBOUND;
+			for(size_t f = 0; f < m_Fields.size(); ++f) {
+				if(m_Fields[f].size() == keyLength && memcmp(m_Fields[f].data(), key, keyLength) == 0) {
+					field = f;
+					break;
+				}
+			}
+			m_Shape[element] = field;
+			if(field == UNBOUND) {
+				m_UnboundKeys[element].assign(key, keyLength);
+			}
+		}
+		if(field >= 0) {
+			m_Values[field] = data + pos;
+			m_Types[field] = type;
+			++found;
+		}
+		pos += BSONCommand::ValueSize(data + pos, type);
+	}
+	return found;
+}
+
+const uint8_t* BSONDecoder::value(size_t field, uint8_t type) const {
+	if(m_Values[field] == nullptr)
+		throw std::invalid_argument("Missing BSON field " + m_Fields[field]);
+	if(m_Types[field] != type)
+		throw std::invalid_argument("Unexpected BSON type for field " + m_Fields[field]);
+	return m_Values[field];
+}
+
+int32_t BSONDecoder::Int32(size_t field) const {
+	int32_t v;
+	memcpy(&v, value(field, 0x10), sizeof(v));
+	return v;
+}
+
+int64_t BSONDecoder::Int64(size_t field) const {
+	int64_t v;
+	memcpy(&v, value(field, 0x12), sizeof(v));
+	return v;
+}
+
+double BSONDecoder::Double(size_t field) const {
+	double v;
+	memcpy(&v, value(field, 0x01), sizeof(v));
+	return v;
+}
+
+bool BSONDecoder::Bool(size_t field) const {
+	return *value(field, 0x08) != 0;
+}
+
+std::string_view BSONDecoder::String(size_t field) const {
+	const uint8_t* v = value(field, 0x02);
+	int32_t length;
+	memcpy(&length, v, sizeof(length));
+	return std::string_view(reinterpret_cast<const char*>(v + 4), length - 1);
+}
+
+std::chrono::system_clock::time_point BSONDecoder::Date(size_t field) const {
+	int64_t millis;
+	memcpy(&millis, value(field, 0x09), sizeof(millis));
+	return std::chrono::system_clock::time_point(std::chrono::milliseconds(millis));
+}
+
+bsoncxx::document::view BSONDecoder::Document(size_t field) const {
+	const uint8_t* v = value(field, 0x03);
+	int32_t length;
+	memcpy(&length, v, sizeof(length));
+	return bsoncxx::document::view(v, length);
+}
+
+bsoncxx::array::view BSONDecoder::Array(size_t field) const {
+	const uint8_t* v = value(field, 0x04);
+	int32_t length;
+	memcpy(&length, v, sizeof(length));
+	return bsoncxx::array::view(v, length);
+}
@@ -1,4 +1,5 @@
 #include "dbphd/mongodb/mongodb.hpp"
+#include <mongocxx/pipeline.hpp>
 
 std::shared_ptr<mongocxx::pool> MongoDBHandler::m_Pool;
 mongocxx::pool::entry MongoDBHandler::GetConnection(std::string connstr) {
@@ -9,3 +10,149 @@ mongocxx::pool::entry MongoDBHandler::GetConnection(std::string connstr) {
 
 	return m_Pool->acquire();
 }
+
+// Runs the aggregation, $out only writes while the cursor is read
+static void copyCollection(mongocxx::collection from, const std::string& database, const std::string& collection) {
+	using bsoncxx::builder::basic::kvp;
+	using bsoncxx::builder::basic::make_document;
+	mongocxx::pipeline pipeline;
+	pipeline.append_stage(make_document(kvp("$out", make_document(kvp("db", database), kvp("coll", collection)))));
+	for(auto&& document : from.aggregate(pipeline))
+		(void)document;
+}
+
+// Written last, a snapshot without it was interrupted
+static const char* SNAPSHOT_COMPLETE = "snapshot_complete";
+
+void MongoDBHandler::SnapshotCollections(mongocxx::client& client, const std::string& database, const std::string& snapshot, const std::vector<std::string>& collections) {
+	client[snapshot].drop();
+	for(auto& collection : collections)
+		copyCollection(client[database][collection], snapshot, collection);
+	client[snapshot][SNAPSHOT_COMPLETE].insert_one(bsoncxx::builder::basic::make_document());
+}
+
+bool MongoDBHandler::RestoreCollections(mongocxx::client& client, const std::string& snapshot, const std::string& database, const std::vector<std::string>& collections) {
+	if(!SnapshotExists(client, snapshot))
+		return false;
+	for(auto& collection : collections)
+		copyCollection(client[snapshot][collection], database, collection);
+	return true;
+}
+
+bool MongoDBHandler::SnapshotExists(mongocxx::client& client, const std::string& snapshot) {
+	return client[snapshot][SNAPSHOT_COMPLETE].count_documents({}) != 0;
+}
+
+void MongoDBHandler::ResetCollection(mongocxx::client& client, const std::string& snapshot, const std::string& database, const std::string& collection, bsoncxx::document::view filter, bool insertMissing) {
+	using bsoncxx::builder::basic::kvp;
+	using bsoncxx::builder::basic::make_document;
+	mongocxx::pipeline pipeline;
+	if(!filter.empty())
+		pipeline.match(filter);
+	pipeline.append_stage(make_document(kvp("$merge", make_document(kvp("into", make_document(kvp("db", database), kvp("coll", collection))), kvp("on", "_id"), kvp("whenMatched", "replace"), kvp("whenNotMatched", insertMissing ? "insert" : "discard")))));
+	for(auto&& document : client[snapshot][collection].aggregate(pipeline))
+		(void)document;
+}
+
+std::map<std::string, std::string> MongoDBHandler::ServerInfo(mongocxx::client& client) {
+	using bsoncxx::builder::basic::kvp;
+	using bsoncxx::builder::basic::make_document;
+	std::map<std::string, std::string> info;
+	auto admin = client["admin"];
+	auto build = admin.run_command(make_document(kvp("buildInfo", 1)));
+	info["version"] = std::string(build.view()["version"].get_string());
+	auto status = admin.run_command(make_document(kvp("serverStatus", 1)));
+	auto engine = status.view()["storageEngine"];
+	if(engine)
+		info["storageEngine"] = std::string(engine["name"].get_string());
+	auto cache = status.view()["wiredTiger"]["cache"]["maximum bytes configured"];
+	if(cache && cache.type() == bsoncxx::type::k_double)
+		info["wiredTigerCacheBytes"] = std::to_string((int64_t)cache.get_double().value);
+	else if(cache && cache.type() == bsoncxx::type::k_int64)
+		info["wiredTigerCacheBytes"] = std::to_string(cache.get_int64().value);
+	else if(cache && cache.type() == bsoncxx::type::k_int32)
+		info["wiredTigerCacheBytes"] = std::to_string(cache.get_int32().value);
+	auto repl = status.view()["repl"];
+	info["replicaSet"] = repl && repl["setName"] ? std::string(repl["setName"].get_string()) : "";
+	return info;
+}
+
+// The number at a dotted path, e.g. "opcounters.insert", false if missing
+static bool numberAt(bsoncxx::document::view document, const std::string& path, double& value) {
+	bsoncxx::document::element element;
+	size_t start = 0;
+	while(true) {
+		size_t dot = path.find('.', start);
+		std::string key = path.substr(start, dot == std::string::npos ? std::string::npos : dot - start);
+		element = document[key];
+		if(!element)
+			return false;
+		if(dot == std::string::npos)
+			break;
+		if(element.type() != bsoncxx::type::k_document)
+			return false;
+		document = element.get_document().value;
+		start = dot + 1;
+	}
+	switch(element.type()) {
+		case bsoncxx::type::k_int32:
+			value = element.get_int32().value;
+			return true;
+		case bsoncxx::type::k_int64:
+			value = (double)element.get_int64().value;
+			return true;
+		case bsoncxx::type::k_double:
+			value = element.get_double().value;
+			return true;
+		default:
+			return false;
+	}
+}
+
+static std::string statName(std::string path) {
+	for(auto& c : path) {
+		if(c == '.' || c == ' ')
+			c = '_';
+	}
+	return path;
+}
+
+std::map<std::string, double> MongoDBHandler::ServerStats(mongocxx::client& client, const std::string& database, const std::vector<std::string>& collections) {
+	using bsoncxx::builder::basic::kvp;
+	using bsoncxx::builder::basic::make_document;
+	std::map<std::string, double> stats;
+	try {
+		auto status = client["admin"].run_command(make_document(kvp("serverStatus", 1)));
+		for(auto& path : {"opcounters.insert", "opcounters.query", "opcounters.update", "opcounters.delete", "opcounters.getmore", "opcounters.command",
+		                  "metrics.document.returned", "metrics.document.inserted", "metrics.document.updated", "metrics.document.deleted",
+		                  "metrics.queryExecutor.scanned", "metrics.queryExecutor.scannedObjects", "metrics.operation.writeConflicts",
+		                  "transactions.totalStarted", "transactions.totalCommitted", "transactions.totalAborted",
+		                  "wiredTiger.cache.bytes read into cache", "wiredTiger.cache.bytes written from cache",
+		                  "wiredTiger.cache.pages read into cache", "wiredTiger.cache.pages written from cache",
+		                  "wiredTiger.log.log bytes written", "wiredTiger.log.log sync operations",
+		                  "locks.Global.acquireWaitCount.r", "locks.Global.acquireWaitCount.w"}) {
+			double value;
+			if(numberAt(status.view(), path, value))
+				stats["mongo_" + statName(path)] = value;
+		}
+	} catch(std::exception&) {
+	}
+	for(auto& collection : collections) {
+		try {
+			mongocxx::pipeline pipeline;
+			pipeline.append_stage(make_document(kvp("$collStats", make_document(kvp("latencyStats", make_document()), kvp("storageStats", make_document())))));
+			auto cursor = client[database][collection].aggregate(pipeline);
+			for(auto document : cursor) {
+				for(auto& path : {"latencyStats.reads.ops", "latencyStats.reads.latency", "latencyStats.writes.ops", "latencyStats.writes.latency",
+				                  "latencyStats.transactions.ops", "latencyStats.transactions.latency", "storageStats.size", "storageStats.storageSize",
+				                  "storageStats.totalIndexSize"}) {
+					double value;
+					if(numberAt(document, path, value))
+						stats["mongo_" + collection + "_" + statName(path)] += value;
+				}
+			}
+		} catch(std::exception&) {
+		}
+	}
+	return stats;
+}
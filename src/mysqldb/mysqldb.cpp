@@ -1,4 +1,6 @@
 #include "dbphd/mysqldb/mysqldb.hpp"
+#include <cctype>
+#include <cstdlib>
 
 using namespace std;
 
@@ -28,3 +30,63 @@ bool MySQLDBHandler::DropTable(mysqlx::Session& session, std::string dbname, std
 	mysqlx::SqlResult result = sqlstatement.execute();
 	return result.getWarningsCount() == 0;
 }
+
+std::map<std::string, std::string> MySQLDBHandler::ServerInfo(mysqlx::Session& session) {
+	std::map<std::string, std::string> info;
+	mysqlx::SqlResult result = session.sql("show global variables where Variable_name in ('version', 'innodb_buffer_pool_size', 'innodb_flush_log_at_trx_commit', 'innodb_log_file_size', 'innodb_redo_log_capacity', 'sync_binlog', 'log_bin', 'transaction_isolation', 'max_connections')").execute();
+	for(auto row : result.fetchAll()) {
+		info[row[0].get<std::string>()] = row[1].get<std::string>();
+	}
+	return info;
+}
+
+static double numberOf(const mysqlx::Value& value) {
+	switch(value.getType()) {
+		case mysqlx::Value::INT64:
+			return (double)value.get<int64_t>();
+		case mysqlx::Value::UINT64:
+			return (double)value.get<uint64_t>();
+		case mysqlx::Value::FLOAT:
+		case mysqlx::Value::DOUBLE:
+			return value.get<double>();
+		case mysqlx::Value::STRING:
+			return strtod(value.get<std::string>().c_str(), nullptr);
+		default:
+			return 0;
+	}
+}
+
+static std::string lowercase(std::string name) {
+	for(auto& c : name)
+		c = tolower(c);
+	return name;
+}
+
+std::map<std::string, double> MySQLDBHandler::ServerStats(mysqlx::Session& session, const std::string& schema) {
+	std::map<std::string, double> stats;
+	// One by one, innodb_metrics and performance_schema may be disabled or not granted
+	try {
+		mysqlx::SqlResult result = session.sql("show global status where Variable_name in ('Innodb_buffer_pool_reads', 'Innodb_buffer_pool_read_requests', 'Innodb_buffer_pool_write_requests', 'Innodb_buffer_pool_pages_flushed', 'Innodb_data_read', 'Innodb_data_written', 'Innodb_os_log_written', 'Innodb_log_waits', 'Innodb_row_lock_waits', 'Innodb_row_lock_time', 'Innodb_rows_read', 'Innodb_rows_inserted', 'Innodb_rows_updated', 'Innodb_rows_deleted', 'Com_select', 'Com_insert', 'Com_update', 'Com_delete', 'Com_commit', 'Com_rollback', 'Handler_read_key', 'Handler_read_next', 'Handler_read_rnd_next', 'Questions')").execute();
+		for(auto row : result.fetchAll())
+			stats["mysql_" + lowercase(row[0].get<std::string>())] = numberOf(row[1]);
+	} catch(std::exception&) {
+	}
+	try {
+		mysqlx::SqlResult result = session.sql("select name, count from information_schema.innodb_metrics where name in ('lock_deadlocks', 'lock_timeouts', 'lock_row_lock_waits', 'lock_row_lock_time', 'trx_rw_commits', 'trx_ro_commits', 'trx_rollbacks', 'buffer_pool_reads', 'log_waits', 'os_data_fsyncs') and status = 'enabled'").execute();
+		for(auto row : result.fetchAll())
+			stats["mysql_innodb_" + row[0].get<std::string>()] = numberOf(row[1]);
+	} catch(std::exception&) {
+	}
+	try {
+		mysqlx::SqlResult result = session.sql("select sum(count_star) as calls, sum(sum_timer_wait) / 1000000 as time_us, sum(sum_lock_time) / 1000000 as lock_time_us, sum(sum_rows_examined) as rows_examined, sum(sum_rows_sent) as rows_sent, sum(sum_rows_affected) as rows_affected, sum(sum_no_index_used) as no_index_used from performance_schema.events_statements_summary_by_digest where schema_name = ?").bind(schema).execute();
+		auto& columns = result.getColumns();
+		for(auto row : result.fetchAll()) {
+			for(unsigned i = 0; i < row.colCount(); ++i) {
+				if(!row[i].isNull())
+					stats["mysql_statements_" + std::string(columns[i].getColumnLabel())] = numberOf(row[i]);
+			}
+		}
+	} catch(std::exception&) {
+	}
+	return stats;
+}
@@ -0,0 +1,209 @@
+#include "dbphd/perf/affinity.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sched.h>
+
+using namespace std;
+
+namespace perf {
+
+const char *affinityPolicyName(AffinityPolicy policy) {
+    switch (policy) {
+    case AffinityPolicy::None:
+        return "none";
+    case AffinityPolicy::Compact:
+        return "compact";
+    case AffinityPolicy::Scatter:
+        return "scatter";
+    case AffinityPolicy::Node:
+        return "node";
+    }
+    return "unknown";
+}
+
+AffinityPolicy affinityPolicyFromName(const string &name) {
+    for (auto policy : {AffinityPolicy::Compact, AffinityPolicy::Scatter, AffinityPolicy::Node}) {
+        if (name == affinityPolicyName(policy))
+            return policy;
+    }
+    return AffinityPolicy::None;
+}
+
+AffinityPolicy affinityPolicy() {
+    static const AffinityPolicy policy = [] {
+        const char *value = getenv("DBPHD_AFFINITY");
+        if (value == nullptr || *value == '\0')
+            return AffinityPolicy::None;
+        auto parsed = affinityPolicyFromName(value);
+        if (parsed == AffinityPolicy::None && strcmp(value, "none") != 0)
+            cerr << "Unknown $DBPHD_AFFINITY " << value
+                 << ", expected compact, scatter or node; threads are not pinned" << endl;
+        return parsed;
+    }();
+    return policy;
+}
+
+vector<int> parseCpuList(const string &list) {
+    vector<int> cpus;
+    size_t position = 0;
+    while (position < list.size()) {
+        size_t comma = list.find(',', position);
+        if (comma == string::npos)
+            comma = list.size();
+        string range = list.substr(position, comma - position);
+        position = comma + 1;
+        char *end;
+        long first = strtol(range.c_str(), &end, 10);
+        if (end == range.c_str() || first < 0)
+            continue;
+        long last = first;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+        for (long cpu = first; cpu <= last; ++cpu)
+            cpus.push_back((int)cpu);
+    }
+    sort(cpus.begin(), cpus.end());
+    cpus.erase(unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+string formatCpuList(vector<int> cpus) {
+    sort(cpus.begin(), cpus.end());
+    string list;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t last = i;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1)
+            last++;
+        if (!list.empty())
+            list += ",";
+        list += to_string(cpus[i]);
+        if (last > i)
+            list += "-" + to_string(cpus[last]);
+        i = last + 1;
+    }
+    return list;
+}
+
+int CpuTopology::cpus() const {
+    int total = 0;
+    for (auto &node : nodes)
+        total += node.size();
+    return total;
+}
+
+CpuTopology CpuTopology::detect() {
+    vector<int> allowed = currentCpus();
+    // node number -> CPUs
+    vector<pair<int, vector<int>>> found;
+    if (DIR *directory = opendir("/sys/devices/system/node")) {
+        while (dirent *entry = readdir(directory)) {
+            int node;
+            if (sscanf(entry->d_name, "node%d", &node) != 1)
+                continue;
+            ifstream file(string("/sys/devices/system/node/") + entry->d_name + "/cpulist");
+            string list;
+            getline(file, list);
+            vector<int> cpus;
+            for (int cpu : parseCpuList(list)) {
+                if (binary_search(allowed.begin(), allowed.end(), cpu))
+                    cpus.push_back(cpu);
+            }
+            // Memory only nodes and nodes outside our cpuset
+            if (!cpus.empty())
+                found.emplace_back(node, cpus);
+        }
+        closedir(directory);
+    }
+    sort(found.begin(), found.end());
+    CpuTopology topology;
+    for (auto &node : found)
+        topology.nodes.push_back(node.second);
+    if (topology.nodes.empty() && !allowed.empty())
+        topology.nodes.push_back(allowed);
+    return topology;
+}
+
+const CpuTopology &cpuTopology() {
+    static const CpuTopology topology = CpuTopology::detect();
+    return topology;
+}
+
+vector<int> placement(AffinityPolicy policy, const CpuTopology &topology, int slot) {
+    if (topology.nodes.empty() || slot < 0)
+        return {};
+    int nodes = topology.nodes.size();
+    switch (policy) {
+    case AffinityPolicy::None:
+        return {};
+    case AffinityPolicy::Compact: {
+        int index = slot % topology.cpus();
+        for (auto &node : topology.nodes) {
+            if (index < (int)node.size())
+                return {node[index]};
+            index -= node.size();
+        }
+        return {};
+    }
+    case AffinityPolicy::Scatter: {
+        auto &node = topology.nodes[slot % nodes];
+        return {node[(slot / nodes) % node.size()]};
+    }
+    case AffinityPolicy::Node:
+        return topology.nodes[slot % nodes];
+    }
+    return {};
+}
+
+vector<int> workerCpus(int slot) {
+    auto policy = affinityPolicy();
+    if (policy == AffinityPolicy::None)
+        return {};
+    return placement(policy, cpuTopology(), slot);
+}
+
+vector<int> currentCpus() {
+    vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set))
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+static bool setCpus(const vector<int> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+ScopedAffinity::ScopedAffinity(const vector<int> &cpus) {
+    if (cpus.empty())
+        return;
+    auto before = currentCpus();
+    if (setCpus(cpus))
+        previous = move(before);
+    else
+        cerr << "Could not pin thread to CPUs " << formatCpuList(cpus) << ": "
+             << strerror(errno) << endl;
+}
+
+ScopedAffinity::~ScopedAffinity() {
+    if (!previous.empty())
+        setCpus(previous);
+}
+
+} // namespace perf
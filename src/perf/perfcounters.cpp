@@ -0,0 +1,155 @@
+#include "dbphd/perf/perfcounters.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace perf {
+
+const char *eventName(Event event) {
+    switch (event) {
+    case Event::Cycles:
+        return "Cycles";
+    case Event::Instructions:
+        return "Instructions";
+    case Event::LLCMisses:
+        return "LLCMisses";
+    case Event::ContextSwitches:
+        return "ContextSwitches";
+    case Event::Syscalls:
+        return "Syscalls";
+    }
+    return "unknown";
+}
+
+bool enabled() {
+    static const bool on = [] {
+        const char *value = getenv("DBPHD_PERF");
+        return value != nullptr && *value != '\0' && strcmp(value, "0") != 0;
+    }();
+    return on;
+}
+
+void EventTotals::add(const Sample &begin, const Sample &end) {
+    for (int i = 0; i < EVENTS; ++i)
+        totals[i] += end.values[i] - begin.values[i];
+    count++;
+}
+
+void EventTotals::merge(const EventTotals &other) {
+    for (int i = 0; i < EVENTS; ++i)
+        totals[i] += other.totals[i];
+    count += other.count;
+}
+
+void EventTotals::reset() {
+    totals.fill(0);
+    count = 0;
+}
+
+double EventTotals::average(Event event) const {
+    return count > 0 ? (double)total(event) / count : 0;
+}
+
+// Id of the raw_syscalls:sys_enter tracepoint, -1 without a readable tracefs
+static int64_t syscallTracepoint() {
+    for (const char *path : {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                             "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"}) {
+        ifstream in(path);
+        int64_t id;
+        if (in >> id)
+            return id;
+    }
+    return -1;
+}
+
+static int openEvent(uint32_t type, uint64_t config, int group) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    // The leader starts disabled and enables the whole group once it is complete
+    attr.disabled = group < 0;
+    attr.exclude_hv = 1;
+    int fd = syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        attr.exclude_kernel = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC);
+    }
+    return fd;
+}
+
+ThreadCounters::ThreadCounters() {
+    fds.fill(-1);
+    slots.fill(-1);
+    int64_t tracepoint = syscallTracepoint();
+    for (int i = 0; i < EVENTS; ++i) {
+        int fd = -1;
+        switch (static_cast<Event>(i)) {
+        case Event::Cycles:
+            fd = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, leader);
+            break;
+        case Event::Instructions:
+            fd = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, leader);
+            break;
+        case Event::LLCMisses:
+            fd = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, leader);
+            break;
+        case Event::ContextSwitches:
+            fd = openEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, leader);
+            break;
+        case Event::Syscalls:
+            if (tracepoint >= 0)
+                fd = openEvent(PERF_TYPE_TRACEPOINT, tracepoint, leader);
+            break;
+        }
+        if (fd < 0)
+            continue;
+        if (leader < 0)
+            leader = fd;
+        fds[i] = fd;
+        slots[i] = opened++;
+    }
+    if (leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+ThreadCounters::~ThreadCounters() {
+    for (int fd : fds) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+Sample ThreadCounters::read() const {
+    Sample sample;
+    if (leader < 0)
+        return sample;
+    // PERF_FORMAT_GROUP: the number of events, then their values in open order
+    array<uint64_t, EVENTS + 1> buffer{};
+    ssize_t size = ::read(leader, buffer.data(), sizeof(uint64_t) * (opened + 1));
+    if (size < (ssize_t)sizeof(uint64_t) * (opened + 1))
+        return sample;
+    for (int i = 0; i < EVENTS; ++i) {
+        if (slots[i] >= 0)
+            sample.values[i] = buffer[slots[i] + 1];
+    }
+    return sample;
+}
+
+ThreadCounters &ThreadCounters::forThread() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+} // namespace perf
@@ -1,4 +1,6 @@
 #include "dbphd/postgresql/postgresql.hpp"
+#include <cstdlib>
+#include <vector>
 
 using namespace std;
 PostgreSQLDBHandler::PostgreSQLDBHandler() {
@@ -53,3 +55,120 @@ bool PostgreSQLDBHandler::TruncateTable(std::shared_ptr<pqxx::connection> conn,
 	pqxx::row r = N.exec1("select count(*) from " + N.esc(tablename));
 	return r[0].as<int>() == 0;
 }
+
+struct SnapshotColumn {
+	std::string name;
+	std::string type;
+	// Of a type (or an array of a type) defined in the schema itself
+	bool local;
+};
+
+static std::vector<SnapshotColumn> snapshotColumns(pqxx::transaction_base& T, const std::string& dbname, const std::string& tablename) {
+	pqxx::result r = T.exec("select quote_ident(a.attname), format_type(a.atttypid, a.atttypmod), "
+	                        "coalesce(t.typnamespace = n.oid, false) or coalesce(e.typnamespace = n.oid, false) "
+	                        "from pg_attribute a join pg_namespace n on n.nspname = " + T.quote(dbname) + " "
+	                        "left join pg_type t on t.oid = a.atttypid left join pg_type e on e.oid = t.typelem "
+	                        "where a.attrelid = to_regclass(" + T.quote(T.quote_name(dbname) + "." + T.quote_name(tablename)) + ") "
+	                        "and a.attnum > 0 and not a.attisdropped order by a.attnum");
+	if(r.empty())
+		throw std::runtime_error("no table " + dbname + "." + tablename);
+	std::vector<SnapshotColumn> columns;
+	for(auto row : r)
+		columns.push_back({row[0].as<std::string>(), row[1].as<std::string>(), row[2].as<bool>()});
+	return columns;
+}
+
+void PostgreSQLDBHandler::SnapshotTables(std::shared_ptr<pqxx::connection> conn, std::string dbname, std::string snapshot, const std::vector<std::string>& tables) {
+	pqxx::work W(*conn);
+	W.exec0("drop schema if exists " + W.quote_name(snapshot) + " cascade");
+	W.exec0("create schema " + W.quote_name(snapshot));
+	for(auto& table : tables) {
+		std::string select;
+		for(auto& column : snapshotColumns(W, dbname, table)) {
+			if(!select.empty())
+				select += ", ";
+			select += column.local ? column.name + "::text as " + column.name : column.name;
+		}
+		W.exec0("create table " + W.quote_name(snapshot) + "." + W.quote_name(table) + " as select " + select + " from " +
+		        W.quote_name(dbname) + "." + W.quote_name(table));
+	}
+	W.commit();
+}
+
+bool PostgreSQLDBHandler::RestoreTables(std::shared_ptr<pqxx::connection> conn, std::string snapshot, std::string dbname, const std::vector<std::string>& tables) {
+	pqxx::work W(*conn);
+	if(W.exec("select 1 from pg_namespace where nspname = " + W.quote(snapshot)).empty())
+		return false;
+	for(auto& table : tables) {
+		std::string select;
+		for(auto& column : snapshotColumns(W, dbname, table)) {
+			if(!select.empty())
+				select += ", ";
+			// Back from text to the type of the freshly created table
+			select += column.local ? column.name + "::" + column.type : column.name;
+		}
+		W.exec0("insert into " + W.quote_name(dbname) + "." + W.quote_name(table) + " select " + select + " from " +
+		        W.quote_name(snapshot) + "." + W.quote_name(table));
+	}
+	W.commit();
+	return true;
+}
+
+bool PostgreSQLDBHandler::ResetTables(std::shared_ptr<pqxx::connection> conn, std::string snapshot, std::string sql) {
+	pqxx::work W(*conn);
+	if(W.exec("select 1 from pg_namespace where nspname = " + W.quote(snapshot)).empty())
+		return false;
+	W.exec(sql);
+	W.commit();
+	return true;
+}
+
+std::map<std::string, std::string> PostgreSQLDBHandler::ServerInfo(std::shared_ptr<pqxx::connection> conn) {
+	std::map<std::string, std::string> info;
+	pqxx::nontransaction N(*conn);
+	pqxx::result r = N.exec("select name, setting from pg_settings where name in ('server_version', 'shared_buffers', 'work_mem', 'effective_cache_size', 'max_connections', 'synchronous_commit', 'fsync', 'wal_level', 'checkpoint_timeout', 'max_wal_size', 'default_transaction_isolation', 'jit')");
+	for(auto row : r) {
+		info[row[0].as<string>()] = row[1].as<string>();
+	}
+	info["version"] = info["server_version"];
+	info.erase("server_version");
+	return info;
+}
+
+// Adds the numeric columns of the rows as <prefix><column>, summed over the
+// rows, except for the columns starting with one of skip
+static void addNumbers(const pqxx::result& r, const std::string& prefix, std::map<std::string, double>& stats, const std::vector<std::string>& skip) {
+	for(auto row : r) {
+		for(auto field : row) {
+			std::string name = field.name();
+			bool skipped = field.is_null();
+			for(auto& start : skip)
+				skipped = skipped || name.rfind(start, 0) == 0;
+			if(skipped)
+				continue;
+			char* end;
+			double value = strtod(field.c_str(), &end);
+			// Timestamps, names and booleans do not parse completely
+			if(end != field.c_str() && *end == '\0')
+				stats[prefix + name] += value;
+		}
+	}
+}
+
+std::map<std::string, double> PostgreSQLDBHandler::ServerStats(std::shared_ptr<pqxx::connection> conn) {
+	std::map<std::string, double> stats;
+	// One by one, the views differ between versions and pg_stat_statements is an extension
+	auto add = [&](const std::string& query, const std::string& prefix, const std::vector<std::string>& skip) {
+		try {
+			pqxx::nontransaction N(*conn);
+			addNumbers(N.exec(query), prefix, stats, skip);
+		} catch(std::exception&) {
+		}
+	};
+	add("select * from pg_stat_database where datname = current_database()", "pg_", {"datid", "numbackends"});
+	add("select * from pg_stat_bgwriter", "pg_bgwriter_", {});
+	add("select pg_wal_lsn_diff(pg_current_wal_lsn(), '0/0') as wal_bytes", "pg_", {});
+	add("select * from pg_stat_statements where dbid = (select oid from pg_database where datname = current_database())", "pg_statements_",
+	    {"userid", "dbid", "queryid", "toplevel", "min_", "max_", "mean_", "stddev_"});
+	return stats;
+}
@@ -0,0 +1,322 @@
+#include "dbphd/report/runreport.hpp"
+#include "dbphd/perf/affinity.hpp"
+#include <chrono>
+#include <cmath>
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+using namespace std;
+namespace pt = boost::property_tree;
+
+namespace report {
+
+LatencySummary LatencySummary::of(const tpcc::Histogram &histogram) {
+    LatencySummary summary;
+    summary.count = histogram.count();
+    summary.mean = histogram.mean();
+    summary.p50 = histogram.valueAtPercentile(50);
+    summary.p90 = histogram.valueAtPercentile(90);
+    summary.p99 = histogram.valueAtPercentile(99);
+    summary.p999 = histogram.valueAtPercentile(99.9);
+    summary.max = histogram.max();
+    return summary;
+}
+
+ServerStats statisticsDelta(const ServerStats &before, const ServerStats &after) {
+    ServerStats delta;
+    for (auto &stat : after) {
+        auto previous = before.find(stat.first);
+        if (previous == before.end() || stat.second < previous->second)
+            continue;
+        delta[stat.first] = stat.second - previous->second;
+    }
+    return delta;
+}
+
+map<string, string> captureEnvironment() {
+    map<string, string> environment;
+    environment["cpuModel"] = "unknown";
+    ifstream cpuinfo("/proc/cpuinfo");
+    string line;
+    while (getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            auto colon = line.find(':');
+            if (colon != string::npos && colon + 2 <= line.size())
+                environment["cpuModel"] = line.substr(colon + 2);
+            break;
+        }
+    }
+    environment["cores"] = to_string(thread::hardware_concurrency());
+    environment["numaNodes"] = to_string(perf::cpuTopology().nodes.size());
+    environment["affinity"] = perf::affinityPolicyName(perf::affinityPolicy());
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) == 0)
+        environment["hostname"] = host;
+    utsname system;
+    if (uname(&system) == 0)
+        environment["kernel"] =
+            fmt::format("{} {} {}", system.sysname, system.release, system.machine);
+#if defined(__VERSION__)
+    environment["compiler"] = __VERSION__;
+#endif
+#if defined(NDEBUG)
+    environment["build"] = "release";
+#else
+    environment["build"] = "debug";
+#endif
+    return environment;
+}
+
+RunReport &RunReport::global() {
+    static RunReport report;
+    return report;
+}
+
+void RunReport::describeEngine(const string &engine, const function<EngineInfo()> &describe) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (engines.count(engine) > 0)
+            return;
+    }
+    // Queries the server, so not under the lock
+    EngineInfo info;
+    try {
+        info = describe();
+    } catch (std::exception &e) {
+        info["error"] = e.what();
+    }
+    lock_guard<mutex> guard(lock);
+    engines.emplace(engine, move(info));
+}
+
+void RunReport::recordLoad(const string &engine, const string &phase, double milliseconds) {
+    lock_guard<mutex> guard(lock);
+    loads.push_back({engine, phase, milliseconds});
+}
+
+void RunReport::describeRun(const string &label, const map<string, double> &scale) {
+    lock_guard<mutex> guard(lock);
+    pending[label].scale = scale;
+}
+
+void RunReport::addLatencies(const string &label, const string &kind,
+                             const tpcc::TransactionLatencies &latencies) {
+    lock_guard<mutex> guard(lock);
+    auto &summaries = pending[label].latencies[kind];
+    for (int i = 0; i < tpcc::TransactionLatencies::TYPES; ++i) {
+        auto type = static_cast<tpcc::TransactionType>(i);
+        summaries[tpcc::transactionTypeName(type)] = LatencySummary::of(latencies[type]);
+    }
+}
+
+void RunReport::addThroughput(const string &label, const vector<int64_t> &perSecond) {
+    lock_guard<mutex> guard(lock);
+    pending[label].throughput = perSecond;
+}
+
+void RunReport::addTerminalCpus(const string &label, const vector<string> &cpus) {
+    lock_guard<mutex> guard(lock);
+    pending[label].terminalCpus = cpus;
+}
+
+void RunReport::addRun(RunRecord run) {
+    lock_guard<mutex> guard(lock);
+    // Kept, the aggregates of repeated runs share the label
+    auto details = pending.find(run.label);
+    if (!run.label.empty() && details != pending.end()) {
+        run.scale = details->second.scale;
+        run.latencies = details->second.latencies;
+        run.throughput = details->second.throughput;
+        run.terminalCpus = details->second.terminalCpus;
+    }
+    runs.push_back(move(run));
+}
+
+void RunReport::clear() {
+    lock_guard<mutex> guard(lock);
+    engines.clear();
+    loads.clear();
+    runs.clear();
+    pending.clear();
+}
+
+static string quote(const string &value) {
+    string quoted = "\"";
+    for (char c : value) {
+        switch (c) {
+        case '"':
+            quoted += "\\\"";
+            break;
+        case '\\':
+            quoted += "\\\\";
+            break;
+        case '\n':
+            quoted += "\\n";
+            break;
+        case '\r':
+            quoted += "\\r";
+            break;
+        case '\t':
+            quoted += "\\t";
+            break;
+        default:
+            if ((unsigned char)c < 0x20)
+                quoted += fmt::format("\\u{:04x}", (int)c);
+            else
+                quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+// JSON has no NaN or infinity
+static string number(double value) {
+    return isfinite(value) ? fmt::format("{}", value) : "null";
+}
+
+template <typename T, typename Format>
+static void writeObject(ostream &out, const map<string, T> &values, Format format) {
+    out << "{";
+    bool first = true;
+    for (auto &value : values) {
+        out << (first ? "" : ", ") << quote(value.first) << ": " << format(value.second);
+        first = false;
+    }
+    out << "}";
+}
+
+static void writeLatencies(ostream &out,
+                           const map<string, map<string, LatencySummary>> &latencies) {
+    writeObject(out, latencies, [](const map<string, LatencySummary> &types) {
+        ostringstream typesOut;
+        writeObject(typesOut, types, [](const LatencySummary &s) {
+            return fmt::format("{{\"count\": {}, \"mean\": {}, \"p50\": {}, \"p90\": {}, "
+                               "\"p99\": {}, \"p999\": {}, \"max\": {}}}",
+                               s.count, number(s.mean), s.p50, s.p90, s.p99, s.p999,
+                               s.max);
+        });
+        return typesOut.str();
+    });
+}
+
+void RunReport::write(ostream &out) const {
+    lock_guard<mutex> guard(lock);
+    out << "{\n  \"date\": "
+        << quote(fmt::format("{:%Y-%m-%dT%H:%M:%S}", chrono::system_clock::now()))
+        << ",\n  \"environment\": ";
+    writeObject(out, captureEnvironment(), quote);
+    out << ",\n  \"engines\": ";
+    writeObject(out, engines, [](const EngineInfo &info) {
+        ostringstream infoOut;
+        writeObject(infoOut, info, quote);
+        return infoOut.str();
+    });
+    out << ",\n  \"loads\": [";
+    for (size_t i = 0; i < loads.size(); ++i) {
+        out << (i == 0 ? "\n" : ",\n")
+            << fmt::format("    {{\"engine\": {}, \"phase\": {}, \"ms\": {}}}",
+                           quote(loads[i].engine), quote(loads[i].phase),
+                           number(loads[i].milliseconds));
+    }
+    out << "\n  ],\n  \"runs\": [";
+    for (size_t i = 0; i < runs.size(); ++i) {
+        auto &run = runs[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << fmt::format("    {{\"name\": {}, \"label\": {}, \"aggregate\": {}, "
+                           "\"threads\": {}, \"iterations\": {}, \"real_time\": {}, "
+                           "\"cpu_time\": {}, \"time_unit\": {},\n      \"scale\": ",
+                           quote(run.name), quote(run.label), run.aggregate, run.threads,
+                           run.iterations, number(run.realTime), number(run.cpuTime),
+                           quote(run.timeUnit));
+        writeObject(out, run.scale, number);
+        out << ",\n      \"counters\": ";
+        writeObject(out, run.counters, number);
+        out << ",\n      \"latencies\": ";
+        writeLatencies(out, run.latencies);
+        out << ",\n      \"throughput\": [";
+        for (size_t s = 0; s < run.throughput.size(); ++s)
+            out << (s == 0 ? "" : ", ") << run.throughput[s];
+        out << "],\n      \"terminalCpus\": [";
+        for (size_t t = 0; t < run.terminalCpus.size(); ++t)
+            out << (t == 0 ? "" : ", ") << quote(run.terminalCpus[t]);
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+static bool endsWith(const string &value, const string &suffix) {
+    return value.size() >= suffix.size() &&
+           value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// run name -> counter -> value
+static map<string, map<string, double>> runCounters(const pt::ptree &report) {
+    map<string, map<string, double>> runs;
+    auto children = report.get_child_optional("runs");
+    if (!children)
+        return runs;
+    for (auto &run : *children) {
+        auto &counters = runs[run.second.get<string>("name", "")];
+        auto values = run.second.get_child_optional("counters");
+        if (!values)
+            continue;
+        for (auto &counter : *values) {
+            auto value = counter.second.get_value_optional<double>();
+            if (value)
+                counters[counter.first] = *value;
+        }
+    }
+    return runs;
+}
+
+vector<Regression> compareReports(const pt::ptree &baseline, const pt::ptree &candidate,
+                                  double threshold) {
+    vector<Regression> regressions;
+    auto before = runCounters(baseline);
+    auto after = runCounters(candidate);
+    for (auto &run : before) {
+        auto candidateRun = after.find(run.first);
+        if (candidateRun == after.end())
+            continue;
+        for (auto &metric : run.second) {
+            auto value = candidateRun->second.find(metric.first);
+            if (value == candidateRun->second.end() || metric.second <= 0)
+                continue;
+            const string &name = metric.first;
+            double change = value->second / metric.second - 1;
+            // offeredRate is an input of open loop runs, not a result
+            bool throughput = name == "Ops" || name == "items_per_second" ||
+                              (endsWith(name, "Rate") && name != "offeredRate");
+            bool latency = endsWith(name, "P99");
+            if ((throughput && change < -threshold) || (latency && change > threshold))
+                regressions.push_back({run.first, name, metric.second, value->second, change});
+        }
+    }
+    return regressions;
+}
+
+map<string, pair<string, string>> engineChanges(const pt::ptree &baseline,
+                                                const pt::ptree &candidate) {
+    map<string, pair<string, string>> changes;
+    auto before = baseline.get_child_optional("engines");
+    auto after = candidate.get_child_optional("engines");
+    if (!before || !after)
+        return changes;
+    for (auto &engine : *before) {
+        auto other = after->get_child_optional(pt::ptree::path_type(engine.first, '\0'));
+        if (!other)
+            continue;
+        string from = engine.second.get<string>("version", "");
+        string to = other->get<string>("version", "");
+        if (from != to)
+            changes[engine.first] = {from, to};
+    }
+    return changes;
+}
+
+} // namespace report
@@ -0,0 +1,225 @@
+#include "dbphd/sqlite/sqlite.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+SQLiteException::SQLiteException(sqlite3* db, const std::string& what)
+	: runtime_error(what + ": " + sqlite3_errmsg(db)), m_Code(sqlite3_extended_errcode(db)) {
+}
+
+SQLiteStatement::SQLiteStatement(std::shared_ptr<sqlite3> conn, const std::string& sql) : m_Conn(conn) {
+	if(sqlite3_prepare_v3(m_Conn.get(), sql.c_str(), sql.size() + 1, SQLITE_PREPARE_PERSISTENT, &m_Stmt, nullptr) != SQLITE_OK)
+		throw SQLiteException(m_Conn.get(), "prepare " + sql);
+}
+
+SQLiteStatement::~SQLiteStatement() {
+	sqlite3_finalize(m_Stmt);
+}
+
+SQLiteStatement& SQLiteStatement::Bind(int index, int64_t value) {
+	if(sqlite3_bind_int64(m_Stmt, index, value) != SQLITE_OK)
+		throw SQLiteException(m_Conn.get(), "bind");
+	return *this;
+}
+
+SQLiteStatement& SQLiteStatement::Bind(int index, double value) {
+	if(sqlite3_bind_double(m_Stmt, index, value) != SQLITE_OK)
+		throw SQLiteException(m_Conn.get(), "bind");
+	return *this;
+}
+
+SQLiteStatement& SQLiteStatement::Bind(int index, const std::string& value) {
+	if(sqlite3_bind_text(m_Stmt, index, value.data(), value.size(), SQLITE_TRANSIENT) != SQLITE_OK)
+		throw SQLiteException(m_Conn.get(), "bind");
+	return *this;
+}
+
+SQLiteStatement& SQLiteStatement::BindNull(int index) {
+	if(sqlite3_bind_null(m_Stmt, index) != SQLITE_OK)
+		throw SQLiteException(m_Conn.get(), "bind");
+	return *this;
+}
+
+bool SQLiteStatement::Step() {
+	int rc = sqlite3_step(m_Stmt);
+	if(rc == SQLITE_ROW)
+		return true;
+	if(rc == SQLITE_DONE)
+		return false;
+	SQLiteException e(m_Conn.get(), "step");
+	sqlite3_reset(m_Stmt);
+	throw e;
+}
+
+int64_t SQLiteStatement::Execute() {
+	while(Step()) {
+	}
+	Reset();
+	return sqlite3_changes64(m_Conn.get());
+}
+
+void SQLiteStatement::Reset(bool clearBindings) {
+	sqlite3_reset(m_Stmt);
+	if(clearBindings)
+		sqlite3_clear_bindings(m_Stmt);
+}
+
+std::string SQLiteStatement::Text(int column) const {
+	auto text = sqlite3_column_text(m_Stmt, column);
+	return text == nullptr ? string() : string(reinterpret_cast<const char*>(text), sqlite3_column_bytes(m_Stmt, column));
+}
+
+SQLiteTransaction::SQLiteTransaction(std::shared_ptr<sqlite3> conn, bool write) : m_Conn(conn), m_Open(false) {
+	SQLiteDBHandler::Exec(m_Conn, write ? "BEGIN IMMEDIATE" : "BEGIN");
+	m_Open = true;
+}
+
+SQLiteTransaction::~SQLiteTransaction() {
+	if(m_Open)
+		sqlite3_exec(m_Conn.get(), "ROLLBACK", nullptr, nullptr, nullptr);
+}
+
+void SQLiteTransaction::Commit() {
+	SQLiteDBHandler::Exec(m_Conn, "COMMIT");
+	m_Open = false;
+}
+
+void SQLiteTransaction::Rollback() {
+	m_Open = false;
+	SQLiteDBHandler::Exec(m_Conn, "ROLLBACK");
+}
+
+SQLiteDBHandler::SQLiteDBHandler() {
+
+}
+SQLiteDBHandler::~SQLiteDBHandler() {
+
+}
+
+std::shared_ptr<sqlite3> SQLiteDBHandler::GetConnection(std::string path) {
+	if(path.empty()) {
+		const char* env = getenv("DBPHD_SQLITE_PATH");
+		path = env != nullptr ? env : "phdtests.sqlite";
+	}
+	sqlite3* db = nullptr;
+	// Connections are never shared between threads, skip sqlite's own mutexes
+	int rc = sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr);
+	shared_ptr<sqlite3> conn(db, sqlite3_close_v2);
+	if(rc != SQLITE_OK)
+		throw SQLiteException(db, "open " + path);
+	sqlite3_busy_timeout(db, 10000);
+	Exec(conn, "PRAGMA journal_mode=WAL");
+	Exec(conn, "PRAGMA synchronous=NORMAL");
+	return conn;
+}
+
+void SQLiteDBHandler::Exec(std::shared_ptr<sqlite3> conn, const std::string& sql) {
+	if(sqlite3_exec(conn.get(), sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+		throw SQLiteException(conn.get(), sql);
+}
+
+bool SQLiteDBHandler::TableExists(std::shared_ptr<sqlite3> conn, std::string tablename) {
+	SQLiteStatement exists(conn, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?");
+	exists.Bind(1, tablename);
+	bool found = exists.Step();
+	exists.Reset();
+	return found;
+}
+
+bool SQLiteDBHandler::DropTable(std::shared_ptr<sqlite3> conn, std::string tablename) {
+	Exec(conn, "DROP TABLE IF EXISTS \"" + tablename + "\"");
+	return !TableExists(conn, tablename);
+}
+
+bool SQLiteDBHandler::TruncateTable(std::shared_ptr<sqlite3> conn, std::string tablename) {
+	// No TRUNCATE, an unconditional DELETE takes the truncate optimization
+	Exec(conn, "DELETE FROM \"" + tablename + "\"");
+	SQLiteStatement count(conn, "SELECT COUNT(*) FROM \"" + tablename + "\"");
+	count.Step();
+	bool empty = count.Int(0) == 0;
+	count.Reset();
+	return empty;
+}
+
+static string quoted(const string& value) {
+	string result = "'";
+	for(char c : value) {
+		if(c == '\'')
+			result += '\'';
+		result += c;
+	}
+	return result + "'";
+}
+
+void SQLiteDBHandler::SnapshotTables(std::shared_ptr<sqlite3> conn, const std::string& path, const std::vector<std::string>& tables) {
+	string partial = path + ".partial";
+	remove(partial.c_str());
+	Exec(conn, "ATTACH DATABASE " + quoted(partial) + " AS snapshot");
+	try {
+		SQLiteTransaction transaction(conn);
+		for(auto& table : tables)
+			Exec(conn, "CREATE TABLE snapshot.\"" + table + "\" AS SELECT * FROM main.\"" + table + "\"");
+		transaction.Commit();
+	} catch(...) {
+		Exec(conn, "DETACH DATABASE snapshot");
+		remove(partial.c_str());
+		throw;
+	}
+	Exec(conn, "DETACH DATABASE snapshot");
+	if(rename(partial.c_str(), path.c_str()) != 0)
+		throw runtime_error("rename " + partial + " to " + path);
+}
+
+// Not through ATTACH, which would create an empty database at path
+static bool snapshotExists(const std::string& path) {
+	sqlite3* probe = nullptr;
+	bool found = sqlite3_open_v2(path.c_str(), &probe, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK;
+	sqlite3_close_v2(probe);
+	return found;
+}
+
+bool SQLiteDBHandler::RestoreTables(std::shared_ptr<sqlite3> conn, const std::string& path, const std::vector<std::string>& tables) {
+	if(!snapshotExists(path))
+		return false;
+	Exec(conn, "ATTACH DATABASE " + quoted(path) + " AS snapshot");
+	try {
+		SQLiteTransaction transaction(conn);
+		for(auto& table : tables)
+			Exec(conn, "INSERT INTO main.\"" + table + "\" SELECT * FROM snapshot.\"" + table + "\"");
+		transaction.Commit();
+	} catch(...) {
+		Exec(conn, "DETACH DATABASE snapshot");
+		throw;
+	}
+	Exec(conn, "DETACH DATABASE snapshot");
+	return true;
+}
+
+bool SQLiteDBHandler::ResetTables(std::shared_ptr<sqlite3> conn, const std::string& path, const std::string& sql) {
+	if(!snapshotExists(path))
+		return false;
+	Exec(conn, "ATTACH DATABASE " + quoted(path) + " AS snapshot");
+	try {
+		SQLiteTransaction transaction(conn);
+		Exec(conn, sql);
+		transaction.Commit();
+	} catch(...) {
+		Exec(conn, "DETACH DATABASE snapshot");
+		throw;
+	}
+	Exec(conn, "DETACH DATABASE snapshot");
+	return true;
+}
+
+std::map<std::string, std::string> SQLiteDBHandler::ServerInfo(std::shared_ptr<sqlite3> conn) {
+	std::map<std::string, std::string> info;
+	info["version"] = sqlite3_libversion();
+	for(auto pragma : {"journal_mode", "synchronous", "page_size", "cache_size", "mmap_size", "wal_autocheckpoint"}) {
+		SQLiteStatement value(conn, string("PRAGMA ") + pragma);
+		if(value.Step())
+			info[pragma] = value.Text(0);
+	}
+	return info;
+}
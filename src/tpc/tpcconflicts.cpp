@@ -0,0 +1,51 @@
+#include "dbphd/tpc/tpcconflicts.hpp"
+
+using namespace std;
+
+namespace tpcc {
+
+void ConflictMap::begin(TransactionType transaction) {
+    running = true;
+    type = transaction;
+    statement = nullptr;
+    wId = 0;
+    dId = 0;
+}
+
+void ConflictMap::record(ConflictKind kind) {
+    if (!running)
+        return;
+    ConflictSite site{type, statement != nullptr ? statement : "unknown", wId, dId};
+    counts[site][static_cast<int>(kind)]++;
+}
+
+void ConflictMap::merge(const ConflictMap &other) {
+    for (auto &site : other.counts) {
+        auto &mine = counts[site.first];
+        for (int i = 0; i < CONFLICT_KINDS; ++i)
+            mine[i] += site.second[i];
+    }
+}
+
+int64_t ConflictMap::total(ConflictKind kind) const {
+    int64_t total = 0;
+    for (auto &site : counts)
+        total += site.second[static_cast<int>(kind)];
+    return total;
+}
+
+TerminalRegistry<ConflictMap> ConflictRegistry::terminals;
+static thread_local ConflictMap *activeConflicts = nullptr;
+
+ConflictMap &ConflictRegistry::forThread(int thread) {
+    activeConflicts = &terminals.forThread(thread);
+    return *activeConflicts;
+}
+
+ConflictMap ConflictRegistry::merge(int threads) { return terminals.merge(threads); }
+
+ConflictMap *ConflictRegistry::active() { return activeConflicts; }
+
+void ConflictRegistry::deactivate() { activeConflicts = nullptr; }
+
+} // namespace tpcc
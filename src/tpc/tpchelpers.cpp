@@ -1,6 +1,8 @@
 #include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpcconflicts.hpp"
 #include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <random>
@@ -14,6 +16,7 @@ bool NuRandC::isValid(int cRun, int cLoad) {
 }
 thread_local random_device RandomHelper::rd;
 thread_local mt19937 RandomHelper::gen(rd()); // "static" does not appear here
+thread_local TerminalHome RandomHelper::terminalHome;
 
 NuRandC NuRandC::createRandom() {
     return NuRandC(randomHelper.number(0, 255), randomHelper.number(0, 1023),
@@ -145,6 +148,21 @@ ScaleParameters ScaleParameters::makeDefault(int Warehouses) {
                            INITIAL_NEW_ORDERS_PER_DISTRICT);
 }
 
+TerminalHome makeTerminalHome(const ScaleParameters &params, int terminal) {
+    TerminalHome home;
+    home.wId = params.startingWarehouse + terminal % params.warehouses;
+    home.dId = 1 + (terminal / params.warehouses) % params.districtsPerWarehouse;
+    return home;
+}
+
+bool homeWarehousesEnabled() {
+    static const bool on = [] {
+        const char *value = getenv("DBPHD_HOME_WAREHOUSE");
+        return value != nullptr && *value != '\0' && strcmp(value, "0") != 0;
+    }();
+    return on;
+}
+
 ScaleParameters ScaleParameters::makeScaled(int Warehouses,
                                             double scaleFactor) {
     assert(scaleFactor >= 1.0);
@@ -159,6 +177,8 @@ ScaleParameters ScaleParameters::makeScaled(int Warehouses,
 }
 
 int RandomHelper::makeWarehouseId(const ScaleParameters &params) {
+    if (terminalHome.wId > 0)
+        return terminalHome.wId;
     int wId = number(params.startingWarehouse, params.endingWarehouse);
     assert(wId >= params.startingWarehouse);
     assert(wId <= params.endingWarehouse);
@@ -177,6 +197,7 @@ int RandomHelper::makeItemId(const ScaleParameters &params) {
 void RandomHelper::generateDeliveryParams(const ScaleParameters &params,
                                           DeliveryParams &out) {
     out.wId = makeWarehouseId(params);
+    markConflictKey(out.wId, 0);
     out.oCarrierId = number(MIN_CARRIER_ID, MAX_CARRIER_ID);
     out.olDeliveryD = chrono::system_clock::now();
 }
@@ -184,6 +205,7 @@ void RandomHelper::generateNewOrderParams(const ScaleParameters &params,
                                           NewOrderParams &out) {
     out.wId = makeWarehouseId(params);
     out.dId = makeDistrictId(params);
+    markConflictKey(out.wId, out.dId);
     out.cId = makeCustomerId(params);
     int olCnt = number(MIN_OL_CNT, MAX_OL_CNT);
     out.oEntryDate = chrono::system_clock::now();
@@ -222,6 +244,7 @@ void RandomHelper::generateOrderStatusParams(const ScaleParameters &params,
                                              OrderStatusParams &out) {
     out.wId = makeWarehouseId(params);
     out.dId = makeDistrictId(params);
+    markConflictKey(out.wId, out.dId);
     out.cLast.clear();
     out.cId = INT32_MIN;
     if (number(1, 100) <= 60) {
@@ -236,6 +259,7 @@ void RandomHelper::generatePaymentParams(const ScaleParameters &params,
     int y = number(1, 100);
     out.wId = makeWarehouseId(params);
     out.dId = makeDistrictId(params);
+    markConflictKey(out.wId, out.dId);
     out.cWId = INT32_MIN;
     out.cDId = INT32_MIN;
     out.cId = INT32_MIN;
@@ -262,7 +286,9 @@ void RandomHelper::generatePaymentParams(const ScaleParameters &params,
 void RandomHelper::generateStockLevelParams(const ScaleParameters &params,
                                             StockLevelParams &out) {
     out.wId = makeWarehouseId(params);
-    out.dId = makeDistrictId(params);
+    // The other transactions pick a district of the home warehouse at random
+    out.dId = terminalHome.dId > 0 ? terminalHome.dId : makeDistrictId(params);
+    markConflictKey(out.wId, out.dId);
     out.threshold =
         number(MIN_STOCK_LEVEL_THRESHOLD, MAX_STOCK_LEVEL_THRESHOLD);
 }
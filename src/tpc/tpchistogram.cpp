@@ -0,0 +1,171 @@
+#include "dbphd/tpc/tpchistogram.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fmt/core.h>
+
+using namespace std;
+
+namespace tpcc {
+
+static int highestBit(uint64_t value) { return 63 - __builtin_clzll(value); }
+
+Histogram::Histogram(int64_t highestTrackable, int significantDigits)
+    : highestTrackable(highestTrackable) {
+    // Enough sub buckets to tell apart values that differ in the last digit
+    int64_t largestSingleUnit = 2 * (int64_t)pow(10, significantDigits);
+    subBucketBits = highestBit(largestSingleUnit - 1) + 1;
+    subBucketHalfCount = 1LL << (subBucketBits - 1);
+    subBucketMask = (1LL << subBucketBits) - 1;
+    counts.resize(indexOf(highestTrackable) + 1);
+}
+
+// Bucket b holds the values of [2^(b + subBucketBits - 1), 2^(b + subBucketBits))
+// (bucket 0 everything below) in steps of 2^b, its lower half overlaps bucket b - 1
+// so only the upper half gets its own counts.
+size_t Histogram::indexOf(int64_t value) const {
+    int bucket = std::max(0, highestBit(value | subBucketMask) - subBucketBits + 1);
+    int64_t subBucket = value >> bucket;
+    return bucket * subBucketHalfCount + subBucket;
+}
+
+int64_t Histogram::highestEquivalent(size_t index) const {
+    int bucket = std::max<int64_t>(0, (int64_t)index / subBucketHalfCount - 1);
+    int64_t subBucket = index - bucket * subBucketHalfCount;
+    return ((subBucket + 1) << bucket) - 1;
+}
+
+void Histogram::record(int64_t value, int64_t count) {
+    value = clamp<int64_t>(value, 0, highestTrackable);
+    counts[indexOf(value)] += count;
+    totalCount += count;
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+    sum += (double)value * count;
+    sumSquares += (double)value * value * count;
+}
+
+void Histogram::merge(const Histogram &other) {
+    if (other.counts.size() == counts.size()) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+    } else {
+        // Differently shaped, re-record every bucket at its highest equivalent value
+        for (size_t i = 0; i < other.counts.size(); ++i) {
+            if (other.counts[i] > 0)
+                counts[indexOf(std::min(other.highestEquivalent(i), highestTrackable))] +=
+                    other.counts[i];
+        }
+    }
+    totalCount += other.totalCount;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+    sum += other.sum;
+    sumSquares += other.sumSquares;
+}
+
+void Histogram::reset() {
+    fill(counts.begin(), counts.end(), 0);
+    totalCount = 0;
+    minValue = INT64_MAX;
+    maxValue = 0;
+    sum = 0;
+    sumSquares = 0;
+}
+
+double Histogram::mean() const { return totalCount == 0 ? 0 : sum / totalCount; }
+
+double Histogram::stdDev() const {
+    if (totalCount == 0)
+        return 0;
+    double m = mean();
+    return sqrt(std::max(0.0, sumSquares / totalCount - m * m));
+}
+
+int64_t Histogram::valueAtPercentile(double percentile) const {
+    if (totalCount == 0)
+        return 0;
+    percentile = clamp(percentile, 0.0, 100.0);
+    int64_t target = std::max<int64_t>(1, (int64_t)ceil(percentile / 100 * totalCount));
+    int64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target)
+            return std::min(highestEquivalent(i), maxValue);
+    }
+    return maxValue;
+}
+
+void Histogram::writePercentiles(ostream &out, double unitScale,
+                                 int ticksPerHalfDistance) const {
+    out << fmt::format("{:>12} {:>14} {:>10} {:>14}\n\n", "Value", "Percentile",
+                       "TotalCount", "1/(1-Percentile)");
+    if (totalCount > 0) {
+        // Ticks get twice as dense every time the distance to 100% halves
+        size_t index = 0;
+        int64_t seen = 0;
+        for (int tick = 0;; ++tick) {
+            double percentile =
+                100.0 * (1 - pow(0.5, (double)tick / ticksPerHalfDistance));
+            int64_t target =
+                std::max<int64_t>(1, (int64_t)ceil(percentile / 100 * totalCount));
+            while (seen < target) {
+                seen += counts[index++];
+            }
+            if (seen >= totalCount)
+                break;
+            out << fmt::format("{:12.3f} {:14.12f} {:10d} {:14.2f}\n",
+                               std::min(highestEquivalent(index - 1), maxValue) / unitScale,
+                               percentile / 100, seen, 1 / (1 - percentile / 100));
+        }
+        out << fmt::format("{:12.3f} {:14.12f} {:10d}\n", maxValue / unitScale,
+                           1.0, totalCount);
+    }
+    out << fmt::format("#[Mean    = {:12.3f}, StdDeviation   = {:12.3f}]\n",
+                       mean() / unitScale, stdDev() / unitScale);
+    out << fmt::format("#[Max     = {:12.3f}, Total count    = {:12d}]\n",
+                       max() / unitScale, totalCount);
+    out << fmt::format("#[Buckets = {:12d}, SubBuckets     = {:12d}]\n",
+                       (int64_t)(counts.size() / subBucketHalfCount - 1),
+                       subBucketMask + 1);
+}
+
+void TransactionLatencies::merge(const TransactionLatencies &other) {
+    for (int i = 0; i < TYPES; ++i) {
+        histograms[i].merge(other.histograms[i]);
+    }
+}
+
+void TransactionLatencies::reset() {
+    for (auto &histogram : histograms) {
+        histogram.reset();
+    }
+}
+
+const char *transactionTypeName(TransactionType type) {
+    switch (type) {
+    case TransactionType::NewOrder:
+        return "newOrder";
+    case TransactionType::Payment:
+        return "payment";
+    case TransactionType::OrderStatus:
+        return "status";
+    case TransactionType::Delivery:
+        return "delivery";
+    case TransactionType::StockLevel:
+        return "stock";
+    }
+    return "unknown";
+}
+
+TerminalRegistry<TransactionLatencies, 2> LatencyRegistry::terminals;
+
+TransactionLatencies &LatencyRegistry::forThread(int thread, LatencyKind kind) {
+    return terminals.forThread(thread, static_cast<int>(kind));
+}
+
+TransactionLatencies LatencyRegistry::merge(int threads, LatencyKind kind) {
+    return terminals.merge(threads, static_cast<int>(kind));
+}
+
+} // namespace tpcc
@@ -0,0 +1,372 @@
+#include "dbphd/tpc/tpcmemory.hpp"
+#include "dbphd/report/runreport.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+
+using namespace std;
+
+namespace tpcc {
+
+// Marks num random ids of [1, max] for the ORIGINAL / bad credit rows
+static vector<bool> selectIds(int num, int max) {
+    vector<bool> selected(max + 1, false);
+    for (int id : randomHelper.uniqueIds(num, 1, max)) {
+        selected[id] = true;
+    }
+    return selected;
+}
+
+void MemoryDatabase::load(ScaleParameters &newParams) {
+    if (loaded && params == newParams)
+        return;
+    loaded = false;
+    params = newParams;
+    cout << endl << "Creating in-memory TPC-C tables ..." << endl;
+    auto start = chrono::steady_clock::now();
+
+    items.assign(params.items, Item());
+    auto originalItems = selectIds(params.items / 10, params.items);
+    for (int iId = 1; iId <= params.items; ++iId) {
+        randomHelper.generateItem(iId, originalItems[iId], items[iId - 1]);
+    }
+
+    warehouses.clear();
+    districts.clear();
+    stock.clear();
+    for (int wId = params.startingWarehouse; wId <= params.endingWarehouse; ++wId) {
+        auto warehouse = make_unique<WarehouseRow>();
+        randomHelper.generateWarehouse(wId, warehouse->warehouse);
+        warehouses.push_back(move(warehouse));
+
+        auto table = make_unique<StockTable>();
+        table->rows.resize(params.items);
+        auto originalStock = selectIds(params.items / 10, params.items);
+        for (int iId = 1; iId <= params.items; ++iId) {
+            randomHelper.generateStock(wId, iId, originalStock[iId],
+                                       table->rows[iId - 1]);
+        }
+        stock.push_back(move(table));
+
+        for (int dId = 1; dId <= params.districtsPerWarehouse; ++dId) {
+            auto district = make_unique<DistrictPartition>();
+            randomHelper.generateDistrict(dId, wId, params.customersPerDistrict + 1,
+                                          district->district);
+
+            auto badCredit = selectIds(params.customersPerDistrict / 10,
+                                       params.customersPerDistrict);
+            district->customers.resize(params.customersPerDistrict);
+            district->history.resize(params.customersPerDistrict);
+            vector<int> cIdPermutation;
+            cIdPermutation.reserve(params.customersPerDistrict);
+            for (int cId = 1; cId <= params.customersPerDistrict; ++cId) {
+                Customer &customer = district->customers[cId - 1];
+                randomHelper.generateCustomer(wId, dId, cId, badCredit[cId], customer);
+                district->customersByLast[customer.cLast].push_back(cId - 1);
+                randomHelper.generateHistory(wId, dId, cId, district->history[cId - 1]);
+                cIdPermutation.push_back(cId);
+            }
+            for (auto &byLast : district->customersByLast) {
+                auto &customers = district->customers;
+                sort(byLast.second.begin(), byLast.second.end(), [&](int a, int b) {
+                    return customers[a].cFirst < customers[b].cFirst;
+                });
+            }
+            randomHelper.shuffle(cIdPermutation);
+
+            district->lastOrder.resize(params.customersPerDistrict);
+            district->orders.resize(params.customersPerDistrict);
+            for (int oId = 1; oId <= params.customersPerDistrict; ++oId) {
+                int oOlCnt = randomHelper.number(MIN_OL_CNT, MAX_OL_CNT);
+                bool newOrder =
+                    (params.customersPerDistrict - params.newOrdersPerDistrict) < oId;
+                Order &order = district->orders[oId - 1];
+                randomHelper.generateOrder(wId, dId, oId, cIdPermutation[oId - 1],
+                                           oOlCnt, newOrder, order);
+                order.oLines.resize(oOlCnt);
+                for (int olNumber = 0; olNumber < oOlCnt; ++olNumber) {
+                    randomHelper.generateOrderLine(params, wId, dId, oId, olNumber + 1,
+                                                   params.items, newOrder,
+                                                   order.oLines[olNumber]);
+                }
+                order.oDeliveryD = newOrder ? chrono::system_clock::time_point(0s)
+                                            : chrono::system_clock::now();
+                order.oNew = newOrder;
+                district->lastOrder[order.oCId - 1] = oId;
+                if (newOrder)
+                    district->newOrders.push_back(oId);
+            }
+            districts.push_back(move(district));
+        }
+    }
+    loaded = true;
+    auto end = chrono::steady_clock::now();
+    cout << " Done in " << chrono::duration<double, milli>(end - start).count()
+         << " ms" << endl;
+    report::RunReport::global().recordLoad(
+        "memory", "tpcc", chrono::duration<double, milli>(end - start).count());
+    report::RunReport::global().describeEngine(
+        "memory", [] { return report::EngineInfo{{"version", "in-process"}}; });
+}
+
+MemoryDatabase::DistrictPartition &MemoryDatabase::partition(int wId, int dId) const {
+    return *districts[(wId - params.startingWarehouse) * params.districtsPerWarehouse +
+                      dId - 1];
+}
+
+const District &MemoryDatabase::district(int wId, int dId) const {
+    return partition(wId, dId).district;
+}
+
+const Warehouse &MemoryDatabase::warehouse(int wId) const {
+    return warehouses[wId - params.startingWarehouse]->warehouse;
+}
+
+int MemoryDatabase::findCustomer(const DistrictPartition &district, int cId,
+                                 const string &cLast) {
+    if (cId != INT32_MIN)
+        return cId - 1;
+    auto byLast = district.customersByLast.find(cLast);
+    assert(byLast != district.customersByLast.end());
+    return byLast->second[(byLast->second.size() - 1) / 2];
+}
+
+bool MemoryDatabase::newOrder(const NewOrderParams &in) {
+    // The unused item number is known before anything changes, nothing to undo
+    for (int iId : in.iIds) {
+        if (iId < 1 || iId > params.items)
+            return false;
+    }
+    bool allLocal = all_of(in.iIWds.begin(), in.iIWds.end(),
+                           [&](int wId) { return wId == in.wId; });
+
+    DistrictPartition &district = partition(in.wId, in.dId);
+    lock_guard<mutex> lock(district.lock);
+    int oId = district.district.dNextOId++;
+
+    district.orders.emplace_back();
+    Order &order = district.orders.back();
+    int olCnt = in.iIds.size();
+    randomHelper.generateOrder(in.wId, in.dId, oId, in.cId, olCnt, true, order);
+    order.oEntryD = in.oEntryDate;
+    order.oAllLocal = allLocal;
+    order.oNew = true;
+    order.oDeliveryD = chrono::system_clock::time_point(0s);
+    order.oLines.resize(olCnt);
+
+    for (int i = 0; i < olCnt; ++i) {
+        int olIId = in.iIds[i];
+        int olSupplyWId = in.iIWds[i];
+        int olQuantity = in.iQtys[i];
+        const Item &item = items[olIId - 1];
+        OrderLine &line = order.oLines[i];
+
+        StockTable &table = *stock[olSupplyWId - params.startingWarehouse];
+        {
+            lock_guard<mutex> stockLock(table.locks[(olIId - 1) % STOCK_LOCK_STRIPES]);
+            Stock &row = table.rows[olIId - 1];
+            if (row.sQuantity >= olQuantity + 10) {
+                row.sQuantity -= olQuantity;
+            } else {
+                row.sQuantity += 91 - olQuantity;
+            }
+            row.sYtd += olQuantity;
+            row.sOrderCnt++;
+            if (olSupplyWId != in.wId)
+                row.sRemoteCnt++;
+            line.olDistInfo = row.sDists[in.dId - 1];
+        }
+
+        line.olOId = oId;
+        line.olNumber = i + 1;
+        line.olWId = in.wId;
+        line.olDId = in.dId;
+        line.olIId = olIId;
+        line.olSupplyWId = olSupplyWId;
+        line.olDeliveryD = chrono::system_clock::time_point(0s);
+        line.olQuantity = olQuantity;
+        line.olAmount = olQuantity * item.iPrice;
+    }
+
+    district.newOrders.push_back(oId);
+    district.lastOrder[in.cId - 1] = oId;
+    return true;
+}
+
+int MemoryDatabase::payment(const PaymentParams &in) {
+    DistrictPartition &district = partition(in.wId, in.dId);
+    DistrictPartition &customerDistrict = partition(in.cWId, in.cDId);
+    // Remote customers belong to another district, std::lock orders the two
+    unique_lock<mutex> lock(district.lock, defer_lock);
+    unique_lock<mutex> customerLock;
+    if (&customerDistrict != &district) {
+        customerLock = unique_lock<mutex>(customerDistrict.lock, defer_lock);
+        std::lock(lock, customerLock);
+    } else {
+        lock.lock();
+    }
+
+    district.district.dYtd += in.hAmount;
+    WarehouseRow &warehouse = *warehouses[in.wId - params.startingWarehouse];
+    {
+        lock_guard<mutex> warehouseLock(warehouse.lock);
+        warehouse.warehouse.wYtd += in.hAmount;
+    }
+
+    int index = findCustomer(customerDistrict, in.cId, in.cLast);
+    Customer &customer = customerDistrict.customers[index];
+    customer.cBalance -= in.hAmount;
+    customer.cYtdPayment += in.hAmount;
+    customer.cPaymentCnt++;
+    if (customer.cCredit == BAD_CREDIT) {
+        string newData = fmt::format("{:d} {:d} {:d} {:d} {:d} {:f}", customer.cId,
+                                     in.cDId, in.cWId, in.dId, in.wId, in.hAmount);
+        customer.cData = newData + "|" + customer.cData;
+        if (customer.cData.length() > MAX_C_DATA) {
+            customer.cData.resize(MAX_C_DATA);
+        }
+    }
+
+    district.history.emplace_back();
+    History &history = district.history.back();
+    history.hWId = in.wId;
+    history.hDId = in.dId;
+    history.hCWId = in.cWId;
+    history.hCDId = in.cDId;
+    history.hCId = customer.cId;
+    history.hDate = in.hDate;
+    history.hAmount = in.hAmount;
+    // w_name is never updated
+    history.hData = warehouse.warehouse.wName + "    " + district.district.dName;
+    return customer.cId;
+}
+
+int MemoryDatabase::orderStatus(const OrderStatusParams &in) {
+    DistrictPartition &district = partition(in.wId, in.dId);
+    lock_guard<mutex> lock(district.lock);
+    int index = findCustomer(district, in.cId, in.cLast);
+    const Order &order = district.orders[district.lastOrder[index] - 1];
+    return order.oLines.size();
+}
+
+int MemoryDatabase::delivery(const DeliveryParams &in) {
+    // Every district is delivered in its own transaction, as 2.7.4.2 allows
+    int delivered = 0;
+    for (int dId = 1; dId <= params.districtsPerWarehouse; ++dId) {
+        DistrictPartition &district = partition(in.wId, dId);
+        lock_guard<mutex> lock(district.lock);
+        if (district.newOrders.empty())
+            continue;
+        int oId = district.newOrders.front();
+        district.newOrders.pop_front();
+
+        Order &order = district.orders[oId - 1];
+        order.oCarrierId = in.oCarrierId;
+        order.oNew = false;
+        order.oDeliveryD = in.olDeliveryD;
+        double total = 0;
+        for (auto &line : order.oLines) {
+            line.olDeliveryD = in.olDeliveryD;
+            total += line.olAmount;
+        }
+
+        Customer &customer = district.customers[order.oCId - 1];
+        customer.cBalance += total;
+        customer.cDeliveryCnt++;
+        delivered++;
+    }
+    return delivered;
+}
+
+int MemoryDatabase::stockLevel(const StockLevelParams &in) {
+    DistrictPartition &district = partition(in.wId, in.dId);
+    lock_guard<mutex> lock(district.lock);
+    int nextOId = district.district.dNextOId;
+    vector<int> itemIds;
+    itemIds.reserve(20 * MAX_OL_CNT);
+    for (int oId = max(1, nextOId - 20); oId < nextOId; ++oId) {
+        for (auto &line : district.orders[oId - 1].oLines) {
+            itemIds.push_back(line.olIId);
+        }
+    }
+    sort(itemIds.begin(), itemIds.end());
+    itemIds.erase(unique(itemIds.begin(), itemIds.end()), itemIds.end());
+
+    StockTable &table = *stock[in.wId - params.startingWarehouse];
+    int lowStock = 0;
+    for (int iId : itemIds) {
+        lock_guard<mutex> stockLock(table.locks[(iId - 1) % STOCK_LOCK_STRIPES]);
+        if (table.rows[iId - 1].sQuantity < in.threshold)
+            lowStock++;
+    }
+    return lowStock;
+}
+
+void MemoryDatabase::checkConsistency(map<string, double> &out) const {
+    int warehouseYtd = 0;
+    int districtNextOId = 0;
+    int newOrderGaps = 0;
+    for (int wId = params.startingWarehouse; wId <= params.endingWarehouse; ++wId) {
+        double dYtd = 0;
+        for (int dId = 1; dId <= params.districtsPerWarehouse; ++dId) {
+            const DistrictPartition &district = partition(wId, dId);
+            dYtd += district.district.dYtd;
+            if (district.district.dNextOId - 1 != (int)district.orders.size())
+                districtNextOId++;
+            auto &newOrders = district.newOrders;
+            if (!newOrders.empty() &&
+                newOrders.back() - newOrders.front() + 1 != (int)newOrders.size())
+                newOrderGaps++;
+        }
+        // Money is summed in doubles, allow for the rounding
+        if (fabs(warehouse(wId).wYtd - dYtd) > 0.005)
+            warehouseYtd++;
+    }
+    out["anomalyWarehouseYtd"] = warehouseYtd;
+    out["anomalyDistrictNextOId"] = districtNextOId;
+    out["anomalyNewOrderGaps"] = newOrderGaps;
+}
+
+void MemoryBackend::load(ScaleParameters &params, int /*clients*/) {
+    database.load(params);
+}
+
+bool MemoryBackend::newOrder(ScaleParameters &params) {
+    randomHelper.generateNewOrderParams(params, noparams);
+    return database.newOrder(noparams);
+}
+
+bool MemoryBackend::payment(ScaleParameters &params) {
+    randomHelper.generatePaymentParams(params, pparams);
+    database.payment(pparams);
+    return true;
+}
+
+bool MemoryBackend::orderStatus(ScaleParameters &params) {
+    randomHelper.generateOrderStatusParams(params, osparams);
+    database.orderStatus(osparams);
+    return true;
+}
+
+bool MemoryBackend::delivery(ScaleParameters &params) {
+    randomHelper.generateDeliveryParams(params, dparams);
+    noNewOrders += params.districtsPerWarehouse - database.delivery(dparams);
+    return true;
+}
+
+bool MemoryBackend::stockLevel(ScaleParameters &params) {
+    randomHelper.generateStockLevelParams(params, sparams);
+    database.stockLevel(sparams);
+    return true;
+}
+
+void MemoryBackend::counters(map<string, double> &out) const {
+    out["no_new_orders"] = noNewOrders;
+}
+
+void MemoryBackend::finish(map<string, double> &out) {
+    database.checkConsistency(out);
+}
+
+} // namespace tpcc
@@ -0,0 +1,53 @@
+#include "dbphd/tpc/tpcpacing.hpp"
+#include <thread>
+
+using namespace std;
+
+namespace tpcc {
+
+const char *arrivalProcessName(ArrivalProcess process) {
+    switch (process) {
+    case ArrivalProcess::Closed:
+        return "closed";
+    case ArrivalProcess::Constant:
+        return "constant";
+    case ArrivalProcess::Poisson:
+        return "poisson";
+    }
+    return "unknown";
+}
+
+ArrivalSchedule::ArrivalSchedule(ArrivalProcess process, double ratePerSecond,
+                                 uint64_t seed)
+    : process(process),
+      meanInterval(ratePerSecond > 0 ? 1.0 / ratePerSecond : 0.0), gen(seed),
+      exponential(ratePerSecond > 0 ? ratePerSecond : 1.0) {}
+
+chrono::steady_clock::time_point ArrivalSchedule::advance() {
+    if (!started) {
+        // Random phase, so terminals with a constant rate do not fire in lock step
+        started = true;
+        uniform_real_distribution<double> phase(0, meanInterval.count());
+        intended = chrono::steady_clock::now() +
+                   chrono::duration_cast<chrono::steady_clock::duration>(
+                       chrono::duration<double>(phase(gen)));
+        return intended;
+    }
+    chrono::duration<double> interval =
+        process == ArrivalProcess::Poisson
+            ? chrono::duration<double>(exponential(gen))
+            : meanInterval;
+    intended += chrono::duration_cast<chrono::steady_clock::duration>(interval);
+    return intended;
+}
+
+chrono::steady_clock::time_point ArrivalSchedule::next() {
+    if (!isOpen())
+        return chrono::steady_clock::now();
+    auto start = advance();
+    if (chrono::steady_clock::now() < start)
+        this_thread::sleep_until(start);
+    return start;
+}
+
+} // namespace tpcc
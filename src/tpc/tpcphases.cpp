@@ -0,0 +1,118 @@
+#include "dbphd/tpc/tpcphases.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace tpcc {
+
+const char *phaseName(Phase phase) {
+    switch (phase) {
+    case Phase::Build:
+        return "Build";
+    case Phase::Execute:
+        return "Execute";
+    case Phase::Decode:
+        return "Decode";
+    }
+    return "unknown";
+}
+
+bool phasesEnabled() {
+    static const bool on = [] {
+        const char *value = getenv("DBPHD_PHASES");
+        return value != nullptr && *value != '\0' && strcmp(value, "0") != 0;
+    }();
+    return on;
+}
+
+void PhaseProfile::begin(TransactionType transaction) {
+    running = true;
+    type = transaction;
+    current = -1;
+    counts[static_cast<int>(type)]++;
+}
+
+void PhaseProfile::mark(const char *statement, Phase phase) {
+    if (!running)
+        return;
+    auto now = chrono::steady_clock::now();
+    if (current >= 0)
+        entries[current].nanoseconds[static_cast<int>(currentPhase)] +=
+            chrono::duration_cast<chrono::nanoseconds>(now - since).count();
+    auto &statements = index[static_cast<int>(type)];
+    auto found = statements.find(statement);
+    if (found == statements.end()) {
+        StatementPhases entry;
+        entry.type = type;
+        entry.statement = statement;
+        entries.push_back(entry);
+        found = statements.emplace(statement, (int)entries.size() - 1).first;
+    }
+    current = found->second;
+    currentPhase = phase;
+    if (phase == Phase::Execute)
+        entries[current].executions++;
+    since = now;
+}
+
+void PhaseProfile::end() {
+    if (running && current >= 0)
+        entries[current].nanoseconds[static_cast<int>(currentPhase)] +=
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - since)
+                .count();
+    running = false;
+    current = -1;
+}
+
+void PhaseProfile::reset() {
+    running = false;
+    current = -1;
+    for (auto &statements : index)
+        statements.clear();
+    entries.clear();
+    counts.fill(0);
+}
+
+void PhaseProfile::merge(const PhaseProfile &other) {
+    for (auto &entry : other.entries) {
+        auto same = find_if(entries.begin(), entries.end(), [&](const StatementPhases &mine) {
+            return mine.type == entry.type && mine.statement == entry.statement;
+        });
+        if (same == entries.end()) {
+            entries.push_back(entry);
+            continue;
+        }
+        same->executions += entry.executions;
+        for (int i = 0; i < PHASES; ++i)
+            same->nanoseconds[i] += entry.nanoseconds[i];
+    }
+    for (int i = 0; i < TransactionLatencies::TYPES; ++i)
+        counts[i] += other.counts[i];
+}
+
+int64_t PhaseProfile::nanoseconds(TransactionType transaction, Phase phase) const {
+    int64_t total = 0;
+    for (auto &entry : entries) {
+        if (entry.type == transaction)
+            total += entry.nanoseconds[static_cast<int>(phase)];
+    }
+    return total;
+}
+
+TerminalRegistry<PhaseProfile> PhaseRegistry::terminals;
+static thread_local PhaseProfile *activeProfile = nullptr;
+
+PhaseProfile &PhaseRegistry::forThread(int thread) {
+    activeProfile = &terminals.forThread(thread);
+    return *activeProfile;
+}
+
+PhaseProfile PhaseRegistry::merge(int threads) { return terminals.merge(threads); }
+
+PhaseProfile *PhaseRegistry::active() { return activeProfile; }
+
+void PhaseRegistry::deactivate() { activeProfile = nullptr; }
+
+} // namespace tpcc
@@ -0,0 +1,67 @@
+#include "dbphd/tpc/tpcsnapshot.hpp"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace tpcc {
+
+string DatasetKey::name() const {
+    return "tpcc_" + engine + "_" + model + "_v" + to_string(DATASET_VERSION) + "_w" +
+           to_string(params.startingWarehouse) + "_" + to_string(params.endingWarehouse) +
+           "_i" + to_string(params.items) + "_d" + to_string(params.districtsPerWarehouse) +
+           "_c" + to_string(params.customersPerDistrict) + "_n" +
+           to_string(params.newOrdersPerDistrict) + "_s" + to_string(seed) +
+           (resized ? "_r" : "");
+}
+
+bool DatasetKey::sameScale(const DatasetKey &other) const {
+    DatasetKey scale = other;
+    scale.resized = resized;
+    return name() == scale.name();
+}
+
+bool DatasetKey::resizesTo(const DatasetKey &other) const {
+    return engine == other.engine && model == other.model && seed == other.seed &&
+           params.items == other.params.items &&
+           params.startingWarehouse == other.params.startingWarehouse &&
+           params.districtsPerWarehouse == other.params.districtsPerWarehouse &&
+           params.customersPerDistrict == other.params.customersPerDistrict &&
+           params.newOrdersPerDistrict == other.params.newOrdersPerDistrict &&
+           params.endingWarehouse != other.params.endingWarehouse;
+}
+
+ScaleParameters warehouseRange(const ScaleParameters &params, int first, int last) {
+    ScaleParameters range = params;
+    range.startingWarehouse = first;
+    range.endingWarehouse = last;
+    range.warehouses = last - first + 1;
+    return range;
+}
+
+bool snapshotsEnabled() {
+    const char *value = getenv("DBPHD_SNAPSHOTS");
+    return value == nullptr || strcmp(value, "0") != 0;
+}
+
+string snapshotDirectory() {
+    const char *value = getenv("DBPHD_SNAPSHOT_DIR");
+    return value != nullptr && *value != '\0' ? value : "snapshots";
+}
+
+uint64_t loadSeed() {
+    const char *value = getenv("DBPHD_SEED");
+    if (value == nullptr || *value == '\0')
+        return 0;
+    char *end;
+    unsigned long long seed = strtoull(value, &end, 10);
+    return *end == '\0' ? seed : 0;
+}
+
+void seedLoader(int thread) {
+    uint64_t seed = loadSeed();
+    if (seed != 0)
+        randomHelper.seed((int)(seed + thread));
+}
+
+} // namespace tpcc
@@ -0,0 +1,112 @@
+#include "dbphd/tpc/tpcwindow.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+namespace tpcc {
+
+const char *runStageName(RunStage stage) {
+    switch (stage) {
+    case RunStage::RampUp:
+        return "rampUp";
+    case RunStage::Measure:
+        return "measure";
+    case RunStage::RampDown:
+        return "rampDown";
+    case RunStage::Done:
+        return "done";
+    }
+    return "unknown";
+}
+
+static chrono::duration<double> secondsFromEnvironment(const char *name,
+                                                       chrono::duration<double> fallback,
+                                                       bool allowZero) {
+    const char *value = getenv(name);
+    if (value == nullptr || *value == '\0')
+        return fallback;
+    char *end;
+    double seconds = strtod(value, &end);
+    if (*end != '\0' || !isfinite(seconds) || seconds < 0 || (seconds == 0 && !allowZero))
+        return fallback;
+    return chrono::duration<double>(seconds);
+}
+
+MeasurementWindow MeasurementWindow::fromEnvironment() {
+    MeasurementWindow window;
+    window.rampUp = secondsFromEnvironment("DBPHD_RAMP_UP", window.rampUp, true);
+    window.measure = secondsFromEnvironment("DBPHD_MEASURE", window.measure, false);
+    window.rampDown = secondsFromEnvironment("DBPHD_RAMP_DOWN", window.rampDown, true);
+    return window;
+}
+
+RunStage MeasurementWindow::stageAt(chrono::duration<double> elapsed) const {
+    if (elapsed < rampUp)
+        return RunStage::RampUp;
+    if (elapsed < rampUp + measure)
+        return RunStage::Measure;
+    if (elapsed < total())
+        return RunStage::RampDown;
+    return RunStage::Done;
+}
+
+void ThroughputSeries::record(chrono::duration<double> elapsed) {
+    size_t second = elapsed.count() > 0 ? (size_t)elapsed.count() : 0;
+    if (seconds.size() <= second)
+        seconds.resize(second + 1);
+    seconds[second]++;
+}
+
+void ThroughputSeries::merge(const ThroughputSeries &other) {
+    if (seconds.size() < other.seconds.size())
+        seconds.resize(other.seconds.size());
+    for (size_t i = 0; i < other.seconds.size(); ++i)
+        seconds[i] += other.seconds[i];
+}
+
+TerminalRegistry<ThroughputSeries> ThroughputRegistry::terminals;
+
+ThroughputSeries &ThroughputRegistry::forThread(int thread) {
+    return terminals.forThread(thread);
+}
+
+ThroughputSeries ThroughputRegistry::merge(int threads) { return terminals.merge(threads); }
+
+double coefficientOfVariation(const vector<int64_t> &perSecond, size_t from, size_t to) {
+    to = min(to, perSecond.size());
+    if (from >= to)
+        return 0;
+    double mean = 0;
+    for (size_t i = from; i < to; ++i)
+        mean += perSecond[i];
+    mean /= to - from;
+    if (mean <= 0)
+        return 0;
+    double variance = 0;
+    for (size_t i = from; i < to; ++i)
+        variance += (perSecond[i] - mean) * (perSecond[i] - mean);
+    variance /= to - from;
+    return sqrt(variance) / mean;
+}
+
+int steadyStateStart(const vector<int64_t> &perSecond, size_t window, double maxVariation) {
+    if (window == 0)
+        window = 1;
+    for (size_t start = 0; start + window <= perSecond.size(); ++start) {
+        double mean = 0;
+        for (size_t i = start; i < start + window; ++i)
+            mean += perSecond[i];
+        mean /= window;
+        // Nothing completed yet, e.g. terminals still stuck on cold caches
+        if (mean <= 0)
+            continue;
+        double allowed = max(maxVariation, 2 / sqrt(mean));
+        if (coefficientOfVariation(perSecond, start, start + window) <= allowed)
+            return (int)start;
+    }
+    return -1;
+}
+
+} // namespace tpcc
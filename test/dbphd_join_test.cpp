@@ -0,0 +1,79 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include "dbphd/join/clientjoin.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Reference nested loop join, (left index, right index) of every equal key
+static vector<pair<int, int>> nestedLoop(const vector<pair<int, int>>& left, const vector<pair<int, int>>& right) {
+	vector<pair<int, int>> joined;
+	for(auto& l : left) {
+		for(auto& r : right) {
+			if(l.second == r.second)
+				joined.emplace_back(l.first, r.first);
+		}
+	}
+	sort(joined.begin(), joined.end());
+	return joined;
+}
+
+static const vector<pair<int, int>> LEFT = {{0, 5}, {1, 3}, {2, 5}, {3, 7}, {4, 1}};
+static const vector<pair<int, int>> RIGHT = {{10, 5}, {11, 2}, {12, 3}, {13, 5}, {14, 5}, {15, 8}};
+
+TEST(ClientJoin, HashJoin) {
+	HashJoin<int> join;
+	for(auto& l : LEFT) {
+		join.Insert(l.second);
+	}
+	EXPECT_EQ(join.Size(), LEFT.size());
+	vector<pair<int, int>> joined;
+	size_t matches = 0;
+	for(auto& r : RIGHT) {
+		matches += join.Probe(r.second, [&](size_t row) {
+			joined.emplace_back(LEFT[row].first, r.first);
+			return true;
+		});
+	}
+	sort(joined.begin(), joined.end());
+	EXPECT_EQ(matches, 7);
+	EXPECT_EQ(joined, nestedLoop(LEFT, RIGHT));
+
+	// Residual predicate, rejected rows are not counted
+	EXPECT_EQ(join.Probe(5, [](size_t row) { return row != 0; }), 1);
+	EXPECT_EQ(join.Probe(42, [](size_t) { return true; }), 0);
+
+	join.Clear();
+	EXPECT_EQ(join.Size(), 0);
+	EXPECT_EQ(join.Probe(5, [](size_t) { return true; }), 0);
+	EXPECT_EQ(join.Insert(9), 0);
+}
+
+TEST(ClientJoin, SortMergeJoin) {
+	auto left = LEFT;
+	auto right = RIGHT;
+	vector<pair<int, int>> joined;
+	auto key = [](const pair<int, int>& p) { return p.second; };
+	size_t matches = SortMergeJoin(left, right, key, key, [&](const pair<int, int>& l, const pair<int, int>& r) {
+		joined.emplace_back(l.first, r.first);
+		return true;
+	});
+	sort(joined.begin(), joined.end());
+	EXPECT_EQ(matches, 7);
+	EXPECT_EQ(joined, nestedLoop(LEFT, RIGHT));
+
+	// Rejected pairs are skipped without ending the merge
+	left = LEFT;
+	right = RIGHT;
+	matches = SortMergeJoin(left, right, key, key, [](const pair<int, int>& l, const pair<int, int>&) {
+		return l.first != 0;
+	});
+	EXPECT_EQ(matches, 4);
+
+	vector<pair<int, int>> empty;
+	EXPECT_EQ(SortMergeJoin(empty, right, key, key, [](const pair<int, int>&, const pair<int, int>&) { return true; }), 0);
+}
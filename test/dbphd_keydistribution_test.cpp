@@ -0,0 +1,112 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include "dbphd/workload/keydistribution.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// How often each key of d comes out of draws draws
+static vector<int> histogram(const KeyDistribution& d, int draws) {
+	mt19937 gen(42);
+	vector<int> counts(d.Keys());
+	for(int i = 0; i < draws; ++i) {
+		int64_t key = d(gen);
+		EXPECT_GE(key, 0);
+		EXPECT_LT(key, (int64_t)d.Keys());
+		counts[key]++;
+	}
+	return counts;
+}
+
+TEST(KeyDistribution, Uniform) {
+	auto counts = histogram(KeyDistribution::Uniform(10), 100000);
+	for(int count : counts) {
+		EXPECT_NEAR(count, 10000, 600);
+	}
+	EXPECT_EQ(KeyDistribution::Uniform(10).Key(0.0), 0u);
+	EXPECT_EQ(KeyDistribution::Uniform(10).Key(0.999999), 9u);
+}
+
+TEST(KeyDistribution, Zipfian) {
+	auto counts = histogram(KeyDistribution::Zipfian(100, 0.99), 100000);
+	// The first keys are the hot ones, each about twice as popular as the
+	// key twice as far down
+	EXPECT_GT(counts[0], counts[1]);
+	EXPECT_GT(counts[1], counts[3]);
+	EXPECT_GT(counts[3], counts[7]);
+	EXPECT_GT(counts[0], 100000 / 10);
+	EXPECT_NEAR((double)counts[0] / counts[1], 2.0, 0.3);
+}
+
+TEST(KeyDistribution, Latest) {
+	auto counts = histogram(KeyDistribution::Latest(100, 0.99), 100000);
+	EXPECT_GT(counts[99], counts[98]);
+	EXPECT_GT(counts[98], counts[50]);
+	EXPECT_GT(counts[99], counts[0]);
+}
+
+TEST(KeyDistribution, Hotspot) {
+	auto counts = histogram(KeyDistribution::Hotspot(100, 0.2, 0.8), 100000);
+	int hot = 0;
+	for(int key = 0; key < 20; ++key) {
+		hot += counts[key];
+	}
+	EXPECT_NEAR(hot, 80000, 1000);
+	// Uniform within both sets
+	EXPECT_NEAR(counts[0], 4000, 400);
+	EXPECT_NEAR(counts[50], 250, 100);
+}
+
+TEST(KeyDistribution, Parse) {
+	KeyDistribution d;
+	ASSERT_TRUE(KeyDistribution::Parse("uniform", 10, d));
+	EXPECT_EQ(d.Type(), Distribution::Uniform);
+	EXPECT_EQ(d.Keys(), 10u);
+	ASSERT_TRUE(KeyDistribution::Parse("zipfian", 10, d));
+	EXPECT_EQ(d.Type(), Distribution::Zipfian);
+	ASSERT_TRUE(KeyDistribution::Parse("latest:0.5", 10, d));
+	EXPECT_EQ(d.Type(), Distribution::Latest);
+	EXPECT_DOUBLE_EQ(d.Theta(), 0.5);
+	ASSERT_TRUE(KeyDistribution::Parse("hotspot:0.1:0.9", 10, d));
+	EXPECT_EQ(d.Type(), Distribution::Hotspot);
+	EXPECT_EQ(d.Key(0.89), 0u);
+	EXPECT_EQ(d.Key(0.9), 1u);
+	EXPECT_DOUBLE_EQ(d.HotKeys(), 0.1);
+	EXPECT_DOUBLE_EQ(d.HotAccesses(), 0.9);
+
+	EXPECT_FALSE(KeyDistribution::Parse("", 10, d));
+	EXPECT_FALSE(KeyDistribution::Parse("gaussian", 10, d));
+	EXPECT_FALSE(KeyDistribution::Parse("zipfian:1", 10, d));
+	EXPECT_FALSE(KeyDistribution::Parse("zipfian:x", 10, d));
+	EXPECT_FALSE(KeyDistribution::Parse("uniform:0.5", 10, d));
+	EXPECT_FALSE(KeyDistribution::Parse("hotspot:0.2:0.8:1", 10, d));
+	EXPECT_FALSE(KeyDistribution::Parse("hotspot:0.2:0", 10, d));
+	// Left alone by the failures
+	EXPECT_EQ(d.Type(), Distribution::Hotspot);
+	EXPECT_STREQ(DistributionName(d.Type()), "hotspot");
+}
+
+TEST(KeyDistribution, Batch) {
+	mt19937 gen(42);
+	auto keys = KeyDistribution::Zipfian(100, 0.99).Batch(gen, 1000);
+	// The hot keys repeat, each is in the batch once
+	EXPECT_LT(keys.size(), 100u);
+	EXPECT_TRUE(is_sorted(keys.begin(), keys.end()));
+	EXPECT_EQ(adjacent_find(keys.begin(), keys.end()), keys.end());
+	EXPECT_EQ(keys.front(), 0u);
+	EXPECT_TRUE(KeyDistribution::Uniform(10).Batch(gen, 0).empty());
+}
+
+TEST(KeyDistribution, KeyAt) {
+	auto d = KeyDistribution::Zipfian(10, 0.99);
+	vector<int> counts(10);
+	for(uint64_t position = 0; position < 10000; ++position) {
+		EXPECT_EQ(d.KeyAt(position), d.KeyAt(position));
+		counts[d.KeyAt(position)]++;
+	}
+	EXPECT_GT(counts[0], counts[9] * 3);
+}
@@ -2,8 +2,51 @@
 #include "gtest/gtest.h"
 
 #include "dbphd/mongodb/mongodb.hpp"
+#include "dbphd/mongodb/bsoncommand.hpp"
+#include "dbphd/mongodb/bsondecoder.hpp"
 
 TEST(MongoDB, Connection) {
 	auto conn = MongoDBHandler::GetConnection();
 	ASSERT_TRUE(conn);
 }
+
+TEST(MongoDB, BSONCommandBind) {
+	BSONCommand cmd(MDV("ol_w_id", 0, "ol_o_id", MDV("$lt", 0, "$gte", 0), "ol_amount", 0.0), {"ol_w_id", "ol_o_id.$lt", "ol_o_id.$gte", "ol_amount"});
+	auto view = cmd.Bind(3, 21, 1, 2.5);
+	EXPECT_EQ(view["ol_w_id"].get_int32(), 3);
+	EXPECT_EQ(view["ol_o_id"]["$lt"].get_int32(), 21);
+	EXPECT_EQ(view["ol_o_id"]["$gte"].get_int32(), 1);
+	EXPECT_DOUBLE_EQ(view["ol_amount"].get_double(), 2.5);
+	cmd.Bind(4, 22, 2, 1.0);
+	EXPECT_EQ(view["ol_w_id"].get_int32(), 4);
+	EXPECT_THROW(cmd.Slot("ol_i_id"), std::invalid_argument);
+	EXPECT_THROW(cmd.Set(cmd.Slot("ol_w_id"), 1.0), std::invalid_argument);
+	EXPECT_THROW(cmd.Bind(5, 23, 3), std::invalid_argument);
+	EXPECT_THROW(cmd.Bind(5, 23, 3, 1.0, 7), std::invalid_argument);
+}
+
+TEST(MongoDB, BSONDecoderShapes) {
+	BSONDecoder decoder{"i_id", "i_price", "i_name"};
+	auto first = MDV("i_id", 7, "i_price", 1.5, "i_name", "abc");
+	ASSERT_EQ(decoder.Decode(first.view()), 3);
+	EXPECT_EQ(decoder.Int32(0), 7);
+	EXPECT_DOUBLE_EQ(decoder.Double(1), 1.5);
+	EXPECT_EQ(decoder.String(2), "abc");
+	// Different field order and a missing field
+	auto second = MDV("i_name", "de", "other", 1, "i_id", 8);
+	ASSERT_EQ(decoder.Decode(second.view()), 2);
+	EXPECT_EQ(decoder.Int32(0), 8);
+	EXPECT_EQ(decoder.String(2), "de");
+	EXPECT_FALSE(decoder.Has(1));
+	EXPECT_THROW(decoder.Double(1), std::invalid_argument);
+	EXPECT_THROW(decoder.Double(0), std::invalid_argument);
+	// Same shape, the unbound element is skipped
+	auto third = MDV("i_name", "fg", "other", 2, "i_id", 9);
+	ASSERT_EQ(decoder.Decode(third.view()), 2);
+	EXPECT_EQ(decoder.Int32(0), 9);
+	EXPECT_FALSE(decoder.Has(1));
+	// A bound field where the unbound one was
+	auto fourth = MDV("i_name", "h", "i_price", 2.5, "i_id", 10);
+	ASSERT_EQ(decoder.Decode(fourth.view()), 3);
+	EXPECT_DOUBLE_EQ(decoder.Double(1), 2.5);
+}
@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+
+#include "dbphd/perf/affinity.hpp"
+#include "dbphd/perf/perfcounters.hpp"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+TEST(PerfCounters, eventName) {
+    EXPECT_EQ(string(perf::eventName(perf::Event::Cycles)), "Cycles");
+    EXPECT_EQ(string(perf::eventName(perf::Event::Instructions)), "Instructions");
+    EXPECT_EQ(string(perf::eventName(perf::Event::LLCMisses)), "LLCMisses");
+    EXPECT_EQ(string(perf::eventName(perf::Event::ContextSwitches)), "ContextSwitches");
+    EXPECT_EQ(string(perf::eventName(perf::Event::Syscalls)), "Syscalls");
+}
+
+TEST(PerfCounters, totals) {
+    perf::Sample begin, end;
+    begin.values = {100, 200, 3, 0, 10};
+    end.values = {400, 1200, 5, 1, 14};
+    perf::EventTotals totals;
+    EXPECT_EQ(totals.average(perf::Event::Cycles), 0);
+    totals.add(begin, end);
+    totals.add(begin, begin);
+    EXPECT_EQ(totals.samples(), 2);
+    EXPECT_EQ(totals.total(perf::Event::Instructions), 1000u);
+    EXPECT_DOUBLE_EQ(totals.average(perf::Event::Cycles), 150);
+    EXPECT_DOUBLE_EQ(totals.average(perf::Event::Syscalls), 2);
+
+    perf::EventTotals other;
+    other.add(begin, end);
+    totals.merge(other);
+    EXPECT_EQ(totals.samples(), 3);
+    EXPECT_EQ(totals.total(perf::Event::LLCMisses), 4u);
+    totals.reset();
+    EXPECT_EQ(totals.samples(), 0);
+    EXPECT_EQ(totals.total(perf::Event::Cycles), 0u);
+}
+
+TEST(PerfCounters, threadCounters) {
+    auto &counters = perf::ThreadCounters::forThread();
+    EXPECT_EQ(&counters, &perf::ThreadCounters::forThread());
+    if (!counters.available())
+        GTEST_SKIP() << "perf_event_open is not permitted here";
+    auto before = counters.read();
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < 1000000; ++i)
+        sum += i;
+    this_thread::sleep_for(chrono::milliseconds(1));
+    auto after = counters.read();
+    for (int i = 0; i < perf::EVENTS; ++i) {
+        auto event = static_cast<perf::Event>(i);
+        if (!counters.isOpen(event)) {
+            EXPECT_EQ(after.values[i], 0u) << perf::eventName(event);
+        } else {
+            EXPECT_GE(after.values[i], before.values[i]) << perf::eventName(event);
+        }
+    }
+    if (counters.isOpen(perf::Event::Instructions)) {
+        EXPECT_GT(after.values[static_cast<int>(perf::Event::Instructions)] -
+                      before.values[static_cast<int>(perf::Event::Instructions)],
+                  1000000u);
+    }
+    // Sleeping gives up the CPU
+    if (counters.isOpen(perf::Event::ContextSwitches)) {
+        EXPECT_GT(after.values[static_cast<int>(perf::Event::ContextSwitches)],
+                  before.values[static_cast<int>(perf::Event::ContextSwitches)]);
+    }
+}
+
+TEST(Affinity, policyName) {
+    EXPECT_STREQ(perf::affinityPolicyName(perf::AffinityPolicy::Scatter), "scatter");
+    EXPECT_EQ(perf::affinityPolicyFromName("compact"), perf::AffinityPolicy::Compact);
+    EXPECT_EQ(perf::affinityPolicyFromName("node"), perf::AffinityPolicy::Node);
+    EXPECT_EQ(perf::affinityPolicyFromName("sideways"), perf::AffinityPolicy::None);
+}
+
+TEST(Affinity, cpuList) {
+    EXPECT_EQ(perf::parseCpuList("0-3,8,10-11\n"), vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(perf::parseCpuList("").empty());
+    EXPECT_EQ(perf::formatCpuList({11, 0, 1, 2, 3, 8, 10}), "0-3,8,10-11");
+    EXPECT_EQ(perf::formatCpuList({5}), "5");
+    EXPECT_EQ(perf::formatCpuList({}), "");
+}
+
+TEST(Affinity, placement) {
+    // Two nodes with hyperthread siblings numbered after the cores
+    perf::CpuTopology topology;
+    topology.nodes = {{0, 1, 4, 5}, {2, 3, 6, 7}};
+    EXPECT_EQ(topology.cpus(), 8);
+    vector<int> compact, scatter;
+    for (int slot = 0; slot < 5; ++slot) {
+        compact.push_back(perf::placement(perf::AffinityPolicy::Compact, topology, slot)[0]);
+        scatter.push_back(perf::placement(perf::AffinityPolicy::Scatter, topology, slot)[0]);
+    }
+    EXPECT_EQ(compact, vector<int>({0, 1, 4, 5, 2}));
+    EXPECT_EQ(scatter, vector<int>({0, 2, 1, 3, 4}));
+    EXPECT_EQ(perf::placement(perf::AffinityPolicy::Compact, topology, 8)[0], 0);
+    EXPECT_EQ(perf::placement(perf::AffinityPolicy::Node, topology, 3), vector<int>({2, 3, 6, 7}));
+    EXPECT_TRUE(perf::placement(perf::AffinityPolicy::None, topology, 0).empty());
+    EXPECT_TRUE(perf::placement(perf::AffinityPolicy::Compact, perf::CpuTopology(), 0).empty());
+}
+
+TEST(Affinity, scopedAffinity) {
+    auto &topology = perf::cpuTopology();
+    ASSERT_FALSE(topology.nodes.empty());
+    auto before = perf::currentCpus();
+    thread([&] {
+        {
+            perf::ScopedAffinity none({});
+            EXPECT_FALSE(none.pinned());
+        }
+        int cpu = perf::placement(perf::AffinityPolicy::Compact, topology, 1)[0];
+        {
+            perf::ScopedAffinity pinned({cpu});
+            EXPECT_TRUE(pinned.pinned());
+            EXPECT_EQ(perf::currentCpus(), vector<int>({cpu}));
+        }
+        EXPECT_EQ(perf::currentCpus(), before);
+    }).join();
+}
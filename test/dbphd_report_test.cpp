@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+
+#include "dbphd/report/runreport.hpp"
+#include <boost/property_tree/json_parser.hpp>
+#include <chrono>
+#include <sstream>
+
+using namespace std;
+namespace pt = boost::property_tree;
+
+static pt::ptree roundTrip(const report::RunReport &runReport) {
+    stringstream out;
+    runReport.write(out);
+    pt::ptree tree;
+    pt::read_json(out, tree);
+    return tree;
+}
+
+static pt::ptree reportWith(const string &version, double txnRate, double newOrderP99,
+                            double offeredRate) {
+    report::RunReport runReport;
+    runReport.describeEngine("postgres", [&] {
+        return report::EngineInfo{{"version", version}};
+    });
+    report::RunRecord run;
+    run.name = "pqxx_tpcc_old/1/threads:4";
+    run.counters = {{"txnRate", txnRate},
+                    {"newOrderP99", newOrderP99},
+                    {"offeredRate", offeredRate}};
+    runReport.addRun(run);
+    return roundTrip(runReport);
+}
+
+TEST(RunReport, write) {
+    report::RunReport runReport;
+    int described = 0;
+    runReport.describeEngine("sqlite", [&] {
+        described++;
+        return report::EngineInfo{{"version", "3.45.1"}, {"journal_mode", "wal"}};
+    });
+    runReport.describeEngine("sqlite", [&] {
+        described++;
+        return report::EngineInfo{{"version", "other"}};
+    });
+    runReport.describeEngine("broken", []() -> report::EngineInfo {
+        throw runtime_error("no server");
+    });
+    EXPECT_EQ(described, 1);
+    runReport.recordLoad("sqlite", "tpcc", 12.5);
+
+    tpcc::TransactionLatencies latencies;
+    latencies.record(tpcc::TransactionType::NewOrder, chrono::microseconds(100));
+    latencies.record(tpcc::TransactionType::NewOrder, chrono::microseconds(300));
+    runReport.describeRun("sqlite_tpcc closed", {{"warehouses", 2}, {"terminals", 4}});
+    runReport.addLatencies("sqlite_tpcc closed", "service", latencies);
+    runReport.addThroughput("sqlite_tpcc closed", {120, 480, 500});
+    runReport.addTerminalCpus("sqlite_tpcc closed", {"0", "16", "1", "17"});
+
+    report::RunRecord run;
+    run.name = "BM_TPCC_SQLITE/2/threads:4";
+    run.label = "sqlite_tpcc closed";
+    run.threads = 4;
+    run.iterations = 1000;
+    run.realTime = 1.5;
+    run.timeUnit = "ms";
+    run.counters = {{"txnRate", 5000}, {"quoted \"name\"", 1}};
+    runReport.addRun(run);
+    report::RunRecord unlabelled;
+    unlabelled.name = "BM_SQLITE_Read_Count/1";
+    runReport.addRun(unlabelled);
+
+    auto tree = roundTrip(runReport);
+    EXPECT_FALSE(tree.get<string>("environment.cores").empty());
+    EXPECT_GE(tree.get<int>("environment.numaNodes"), 1);
+    EXPECT_FALSE(tree.get<string>("environment.affinity").empty());
+    EXPECT_EQ(tree.get<string>("engines.sqlite.version"), "3.45.1");
+    EXPECT_EQ(tree.get<string>("engines.sqlite.journal_mode"), "wal");
+    EXPECT_EQ(tree.get<string>("engines.broken.error"), "no server");
+    auto &loads = tree.get_child("loads");
+    ASSERT_EQ(loads.size(), 1u);
+    EXPECT_EQ(loads.front().second.get<string>("engine"), "sqlite");
+    EXPECT_DOUBLE_EQ(loads.front().second.get<double>("ms"), 12.5);
+
+    auto &runs = tree.get_child("runs");
+    ASSERT_EQ(runs.size(), 2u);
+    auto &tpcc = runs.front().second;
+    EXPECT_EQ(tpcc.get<string>("name"), "BM_TPCC_SQLITE/2/threads:4");
+    EXPECT_EQ(tpcc.get<int>("threads"), 4);
+    EXPECT_EQ(tpcc.get<int>("iterations"), 1000);
+    EXPECT_EQ(tpcc.get<string>("time_unit"), "ms");
+    EXPECT_DOUBLE_EQ(tpcc.get<double>("counters.txnRate"), 5000);
+    EXPECT_DOUBLE_EQ(tpcc.get_child("counters").get<double>(
+                         pt::ptree::path_type("quoted \"name\"", '\0')),
+                     1);
+    EXPECT_DOUBLE_EQ(tpcc.get<double>("scale.warehouses"), 2);
+    EXPECT_EQ(tpcc.get<int>("latencies.service.newOrder.count"), 2);
+    EXPECT_GE(tpcc.get<int>("latencies.service.newOrder.max"), 300);
+    EXPECT_EQ(tpcc.get<int>("latencies.service.payment.count"), 0);
+    auto &throughput = tpcc.get_child("throughput");
+    ASSERT_EQ(throughput.size(), 3u);
+    EXPECT_EQ(throughput.front().second.get_value<int>(), 120);
+    EXPECT_EQ(throughput.back().second.get_value<int>(), 500);
+    auto &cpus = tpcc.get_child("terminalCpus");
+    ASSERT_EQ(cpus.size(), 4u);
+    EXPECT_EQ(cpus.begin()->second.get_value<string>(), "0");
+    EXPECT_EQ(cpus.back().second.get_value<string>(), "17");
+    EXPECT_EQ(runs.back().second.get_child("latencies").size(), 0u);
+    EXPECT_EQ(runs.back().second.get_child("throughput").size(), 0u);
+}
+
+TEST(RunReport, compareReports) {
+    auto baseline = reportWith("16.1", 1000, 2000, 100);
+    auto same = reportWith("16.1", 980, 2050, 100);
+    EXPECT_TRUE(report::compareReports(baseline, same, 0.05).empty());
+
+    auto slower = reportWith("16.1", 900, 2500, 50);
+    auto regressions = report::compareReports(baseline, slower, 0.05);
+    ASSERT_EQ(regressions.size(), 2u);
+    EXPECT_EQ(regressions[0].metric, "newOrderP99");
+    EXPECT_NEAR(regressions[0].change, 0.25, 1e-9);
+    EXPECT_EQ(regressions[1].metric, "txnRate");
+    EXPECT_DOUBLE_EQ(regressions[1].baseline, 1000);
+    EXPECT_DOUBLE_EQ(regressions[1].candidate, 900);
+    EXPECT_NEAR(regressions[1].change, -0.1, 1e-9);
+
+    auto faster = reportWith("16.1", 2000, 1000, 100);
+    EXPECT_TRUE(report::compareReports(baseline, faster, 0.05).empty());
+}
+
+TEST(RunReport, engineChanges) {
+    auto baseline = reportWith("16.1", 1000, 2000, 100);
+    EXPECT_TRUE(report::engineChanges(baseline, baseline).empty());
+    auto upgraded = reportWith("16.2", 1000, 2000, 100);
+    auto changes = report::engineChanges(baseline, upgraded);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes["postgres"].first, "16.1");
+    EXPECT_EQ(changes["postgres"].second, "16.2");
+}
+
+TEST(RunReport, statisticsDelta) {
+    report::ServerStats before{{"pg_blks_hit", 1000}, {"pg_wal_bytes", 4096}, {"pg_deadlocks", 3}};
+    report::ServerStats after{{"pg_blks_hit", 1500}, {"pg_wal_bytes", 8192}, {"pg_deadlocks", 1},
+                              {"pg_statements_calls", 10}};
+    auto delta = report::statisticsDelta(before, after);
+    EXPECT_EQ(delta.size(), 2u);
+    EXPECT_DOUBLE_EQ(delta["pg_blks_hit"], 500);
+    EXPECT_DOUBLE_EQ(delta["pg_wal_bytes"], 4096);
+    // Reset in between, and only in the second snapshot
+    EXPECT_EQ(delta.count("pg_deadlocks"), 0u);
+    EXPECT_EQ(delta.count("pg_statements_calls"), 0u);
+}
@@ -0,0 +1,130 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include "dbphd/sqlite/sqlite.hpp"
+using namespace std;
+
+static const string db = "dbphd_test_sqlite.sqlite";
+
+TEST(SQLite, Connection) {
+	auto conn = SQLiteDBHandler::GetConnection(db);
+	ASSERT_TRUE(conn);
+	SQLiteStatement mode(conn, "PRAGMA journal_mode");
+	ASSERT_TRUE(mode.Step());
+	ASSERT_EQ(mode.Text(0), "wal");
+}
+
+TEST(SQLite, DropTable) {
+	auto conn = SQLiteDBHandler::GetConnection(db);
+	SQLiteDBHandler::Exec(conn, "create table if not exists DropTable (test int)");
+	ASSERT_TRUE(SQLiteDBHandler::TableExists(conn, "DropTable"));
+	ASSERT_TRUE(SQLiteDBHandler::DropTable(conn, "DropTable"));
+	ASSERT_FALSE(SQLiteDBHandler::TableExists(conn, "DropTable"));
+}
+
+TEST(SQLite, TruncateTable) {
+	auto conn = SQLiteDBHandler::GetConnection(db);
+	SQLiteDBHandler::Exec(conn, "create table if not exists TruncateTable (test int)");
+	SQLiteStatement insert(conn, "insert into TruncateTable values (1),(2),(3),(4)");
+	ASSERT_EQ(insert.Execute(), 4);
+	ASSERT_TRUE(SQLiteDBHandler::TruncateTable(conn, "TruncateTable"));
+	ASSERT_TRUE(SQLiteDBHandler::DropTable(conn, "TruncateTable"));
+}
+
+TEST(SQLite, Statement) {
+	auto conn = SQLiteDBHandler::GetConnection(db);
+	SQLiteDBHandler::DropTable(conn, "Statement");
+	SQLiteDBHandler::Exec(conn, "create table Statement (a int, b real, c text)");
+	SQLiteStatement insert(conn, "insert into Statement values (?, ?, ?)");
+	for(int i = 0; i < 10; ++i) {
+		ASSERT_EQ(insert.Bind(1, (int64_t)i).Bind(2, i * 0.5).Bind(3, to_string(i)).Execute(), 1);
+	}
+	SQLiteStatement select(conn, "select a, b, c from Statement where a >= ? order by a");
+	select.Bind(1, (int64_t)8);
+	ASSERT_TRUE(select.Step());
+	ASSERT_EQ(select.Columns(), 3);
+	ASSERT_EQ(select.Int(0), 8);
+	ASSERT_DOUBLE_EQ(select.Double(1), 4.0);
+	ASSERT_EQ(select.Text(2), "8");
+	ASSERT_TRUE(select.Step());
+	ASSERT_FALSE(select.Step());
+	select.Reset();
+	// Same binding after a reset
+	ASSERT_TRUE(select.Step());
+	ASSERT_EQ(select.Int(0), 8);
+	select.Reset();
+	ASSERT_THROW(SQLiteStatement(conn, "select * from NoSuchTable"), SQLiteException);
+	ASSERT_TRUE(SQLiteDBHandler::DropTable(conn, "Statement"));
+}
+
+TEST(SQLite, Transaction) {
+	auto conn = SQLiteDBHandler::GetConnection(db);
+	SQLiteDBHandler::DropTable(conn, "Transaction");
+	SQLiteDBHandler::Exec(conn, "create table \"Transaction\" (a int)");
+	SQLiteStatement insert(conn, "insert into \"Transaction\" values (1)");
+	SQLiteStatement count(conn, "select count(*) from \"Transaction\"");
+	{
+		SQLiteTransaction transaction(conn);
+		insert.Execute();
+		// Rolled back when it goes out of scope
+	}
+	ASSERT_TRUE(count.Step());
+	ASSERT_EQ(count.Int(0), 0);
+	count.Reset();
+	{
+		SQLiteTransaction transaction(conn);
+		insert.Execute();
+		transaction.Commit();
+	}
+	ASSERT_TRUE(count.Step());
+	ASSERT_EQ(count.Int(0), 1);
+	count.Reset();
+	ASSERT_TRUE(SQLiteDBHandler::DropTable(conn, "Transaction"));
+}
+
+TEST(SQLite, Snapshot) {
+	auto conn = SQLiteDBHandler::GetConnection(db);
+	const string snapshot = "dbphd_test_sqlite_snapshot.sqlite";
+	remove(snapshot.c_str());
+	SQLiteDBHandler::DropTable(conn, "Snapshot");
+	SQLiteDBHandler::Exec(conn, "create table Snapshot (a int primary key, b text)");
+	SQLiteDBHandler::Exec(conn, "insert into Snapshot values (1, 'one'), (2, 'two')");
+	ASSERT_FALSE(SQLiteDBHandler::RestoreTables(conn, snapshot, {"Snapshot"}));
+	SQLiteDBHandler::SnapshotTables(conn, snapshot, {"Snapshot"});
+	ASSERT_TRUE(SQLiteDBHandler::TruncateTable(conn, "Snapshot"));
+	ASSERT_TRUE(SQLiteDBHandler::RestoreTables(conn, snapshot, {"Snapshot"}));
+	SQLiteStatement select(conn, "select b from Snapshot order by a");
+	ASSERT_TRUE(select.Step());
+	ASSERT_EQ(select.Text(0), "one");
+	ASSERT_TRUE(select.Step());
+	ASSERT_EQ(select.Text(0), "two");
+	ASSERT_FALSE(select.Step());
+	select.Reset();
+	ASSERT_TRUE(SQLiteDBHandler::DropTable(conn, "Snapshot"));
+	remove(snapshot.c_str());
+}
+
+TEST(SQLite, ResetTables) {
+	auto conn = SQLiteDBHandler::GetConnection(db);
+	const string snapshot = "dbphd_test_sqlite_reset.sqlite";
+	remove(snapshot.c_str());
+	SQLiteDBHandler::DropTable(conn, "Reset");
+	SQLiteDBHandler::Exec(conn, "create table Reset (a int primary key, b text)");
+	SQLiteDBHandler::Exec(conn, "insert into Reset values (1, 'one'), (2, 'two')");
+	const string reset = "delete from Reset where a > (select max(a) from snapshot.Reset);"
+	                     "update Reset set b = s.b from snapshot.Reset s where Reset.a = s.a and Reset.b is not s.b;";
+	ASSERT_FALSE(SQLiteDBHandler::ResetTables(conn, snapshot, reset));
+	SQLiteDBHandler::SnapshotTables(conn, snapshot, {"Reset"});
+	SQLiteDBHandler::Exec(conn, "update Reset set b = 'changed' where a = 2");
+	SQLiteDBHandler::Exec(conn, "insert into Reset values (3, 'three')");
+	ASSERT_TRUE(SQLiteDBHandler::ResetTables(conn, snapshot, reset));
+	SQLiteStatement select(conn, "select b from Reset order by a");
+	ASSERT_TRUE(select.Step());
+	ASSERT_EQ(select.Text(0), "one");
+	ASSERT_TRUE(select.Step());
+	ASSERT_EQ(select.Text(0), "two");
+	ASSERT_FALSE(select.Step());
+	select.Reset();
+	ASSERT_TRUE(SQLiteDBHandler::DropTable(conn, "Reset"));
+	remove(snapshot.c_str());
+}
@@ -2,7 +2,17 @@
 #include "gtest/gtest.h"
 #include <unordered_map>
 
+#include "dbphd/tpc/tpcconflicts.hpp"
 #include "dbphd/tpc/tpchelpers.hpp"
+#include "dbphd/tpc/tpchistogram.hpp"
+#include "dbphd/tpc/tpcmemory.hpp"
+#include "dbphd/tpc/tpcpacing.hpp"
+#include "dbphd/tpc/tpcphases.hpp"
+#include "dbphd/tpc/tpcsnapshot.hpp"
+#include "dbphd/tpc/tpcwindow.hpp"
+#include <map>
+#include <sstream>
+#include <thread>
 
 using namespace tpcc;
 using namespace std;
@@ -117,3 +127,495 @@ TEST(TPCHelpers, nextTransactionType) {
     EXPECT_EQ(map[TransactionType::Delivery], 4);
     EXPECT_EQ(map[TransactionType::StockLevel], 4);
 }
+
+TEST(TPCHelpers, terminalHome) {
+    auto params = ScaleParameters::makeDefault(3);
+    // One terminal per warehouse before any warehouse gets a second one
+    EXPECT_EQ(makeTerminalHome(params, 0).wId, 1);
+    EXPECT_EQ(makeTerminalHome(params, 2).wId, 3);
+    EXPECT_EQ(makeTerminalHome(params, 2).dId, 1);
+    EXPECT_EQ(makeTerminalHome(params, 3).wId, 1);
+    EXPECT_EQ(makeTerminalHome(params, 3).dId, 2);
+    EXPECT_EQ(makeTerminalHome(params, 30).dId, 1);
+
+    randomHelper.seed(0);
+    RandomHelper::setHome({2, 7});
+    int remoteCustomers = 0, remoteItems = 0, items = 0;
+    for (int i = 0; i < 10000; ++i) {
+        PaymentParams payment;
+        randomHelper.generatePaymentParams(params, payment);
+        EXPECT_EQ(payment.wId, 2);
+        remoteCustomers += payment.cWId != 2;
+        NewOrderParams newOrder;
+        randomHelper.generateNewOrderParams(params, newOrder);
+        EXPECT_EQ(newOrder.wId, 2);
+        for (int supplier : newOrder.iIWds)
+            remoteItems += supplier != 2;
+        items += newOrder.iIWds.size();
+    }
+    EXPECT_NEAR(remoteCustomers / 10000.0, 0.15, 0.02);
+    EXPECT_NEAR(remoteItems / (double)items, 0.01, 0.005);
+    StockLevelParams stock;
+    randomHelper.generateStockLevelParams(params, stock);
+    EXPECT_EQ(stock.wId, 2);
+    EXPECT_EQ(stock.dId, 7);
+    DeliveryParams delivery;
+    randomHelper.generateDeliveryParams(params, delivery);
+    EXPECT_EQ(delivery.wId, 2);
+
+    RandomHelper::setHome({});
+    bool otherWarehouse = false;
+    for (int i = 0; i < 100 && !otherWarehouse; ++i)
+        otherWarehouse = randomHelper.makeWarehouseId(params) != 2;
+    EXPECT_TRUE(otherWarehouse);
+}
+
+// Histogram
+TEST(TPCHistogram, percentiles) {
+    Histogram histogram;
+    for (int i = 1; i <= 10000; ++i) {
+        histogram.record(i);
+    }
+    EXPECT_EQ(histogram.count(), 10000);
+    EXPECT_EQ(histogram.min(), 1);
+    EXPECT_EQ(histogram.max(), 10000);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 5000.5);
+    // 3 significant digits
+    EXPECT_NEAR(histogram.valueAtPercentile(50), 5000, 5);
+    EXPECT_NEAR(histogram.valueAtPercentile(99), 9900, 10);
+    EXPECT_NEAR(histogram.valueAtPercentile(99.9), 9990, 10);
+    EXPECT_EQ(histogram.valueAtPercentile(100), 10000);
+    EXPECT_EQ(histogram.valueAtPercentile(0), 1);
+}
+
+TEST(TPCHistogram, mergeAndReset) {
+    Histogram a, b;
+    a.record(100, 99);
+    b.record(1000000);
+    a.merge(b);
+    EXPECT_EQ(a.count(), 100);
+    EXPECT_EQ(a.valueAtPercentile(99), 100);
+    EXPECT_NEAR(a.valueAtPercentile(100), 1000000, 1000);
+    // Clamped to the highest trackable value
+    a.record(INT64_MAX);
+    EXPECT_EQ(a.max(), 3600LL * 1000 * 1000);
+    a.reset();
+    EXPECT_EQ(a.count(), 0);
+    EXPECT_EQ(a.valueAtPercentile(99), 0);
+}
+
+TEST(TPCHistogram, writePercentiles) {
+    Histogram histogram;
+    for (int i = 1; i <= 1000; ++i) {
+        histogram.record(i);
+    }
+    stringstream out;
+    histogram.writePercentiles(out, 1000);
+    string text = out.str();
+    EXPECT_EQ(text.find("Value"), text.find_first_not_of(' '));
+    EXPECT_NE(text.find("       1.000 1.000000000000       1000"), string::npos);
+    EXPECT_NE(text.find("#[Max     =        1.000, Total count    =         1000]"), string::npos);
+}
+
+TEST(TPCHistogram, registry) {
+    auto &first = LatencyRegistry::forThread(0);
+    auto &second = LatencyRegistry::forThread(1);
+    first.record(TransactionType::NewOrder, chrono::milliseconds(2));
+    second.record(TransactionType::NewOrder, chrono::milliseconds(4));
+    second.record(TransactionType::Payment, chrono::microseconds(10));
+    auto merged = LatencyRegistry::merge(2);
+    EXPECT_EQ(merged[TransactionType::NewOrder].count(), 2);
+    EXPECT_EQ(merged[TransactionType::NewOrder].max(), 4000);
+    EXPECT_EQ(merged[TransactionType::Payment].count(), 1);
+    EXPECT_EQ(merged[TransactionType::Delivery].count(), 0);
+    // A new run resets the slot
+    EXPECT_EQ(LatencyRegistry::forThread(1)[TransactionType::Payment].count(), 0);
+    EXPECT_STREQ(transactionTypeName(TransactionType::OrderStatus), "status");
+}
+
+// Pacing
+TEST(TPCPacing, constant) {
+    ArrivalSchedule schedule(ArrivalProcess::Constant, 1000, 0);
+    EXPECT_TRUE(schedule.isOpen());
+    auto first = schedule.advance();
+    for (int i = 1; i <= 100; ++i) {
+        EXPECT_EQ(schedule.advance() - first, i * chrono::milliseconds(1));
+    }
+}
+
+TEST(TPCPacing, poisson) {
+    ArrivalSchedule schedule(ArrivalProcess::Poisson, 1000, 0);
+    auto first = schedule.advance();
+    auto last = first;
+    for (int i = 0; i < 10000; ++i) {
+        auto next = schedule.advance();
+        EXPECT_GE(next, last);
+        last = next;
+    }
+    // Mean interval of 1 ms
+    EXPECT_NEAR(chrono::duration<double>(last - first).count(), 10, 0.5);
+}
+
+TEST(TPCPacing, behindSchedule) {
+    // A terminal that is behind does not wait and keeps its intended starts
+    ArrivalSchedule schedule(ArrivalProcess::Constant, 1e6, 0);
+    auto first = schedule.next();
+    this_thread::sleep_for(chrono::milliseconds(5));
+    auto before = chrono::steady_clock::now();
+    auto second = schedule.next();
+    EXPECT_LT(second, before);
+    EXPECT_EQ(second - first, chrono::microseconds(1));
+
+    ArrivalSchedule closed(ArrivalProcess::Closed, 0);
+    EXPECT_FALSE(closed.isOpen());
+    EXPECT_GE(closed.next(), before);
+    EXPECT_STREQ(arrivalProcessName(ArrivalProcess::Poisson), "poisson");
+}
+
+// Phases
+TEST(TPCPhases, profile) {
+    PhaseProfile profile;
+    // Ignored outside a transaction
+    profile.mark("load", Phase::Execute);
+    EXPECT_TRUE(profile.statements().empty());
+
+    profile.begin(TransactionType::Payment);
+    profile.mark("getCustomer", Phase::Build);
+    this_thread::sleep_for(chrono::milliseconds(2));
+    profile.mark("getCustomer", Phase::Execute);
+    this_thread::sleep_for(chrono::milliseconds(4));
+    profile.mark("getCustomer", Phase::Decode);
+    profile.mark("updateCustomer", Phase::Execute);
+    this_thread::sleep_for(chrono::milliseconds(2));
+    profile.end();
+    profile.mark("updateCustomer", Phase::Execute);
+
+    profile.begin(TransactionType::Payment);
+    profile.mark("getCustomer", Phase::Execute);
+    profile.end();
+
+    ASSERT_EQ(profile.statements().size(), 2u);
+    auto &customer = profile.statements()[0];
+    EXPECT_EQ(customer.statement, "getCustomer");
+    EXPECT_EQ(customer.type, TransactionType::Payment);
+    EXPECT_EQ(customer.executions, 2);
+    EXPECT_GE(customer.nanoseconds[static_cast<int>(Phase::Build)], 2000000);
+    EXPECT_GE(customer.nanoseconds[static_cast<int>(Phase::Execute)], 4000000);
+    auto &update = profile.statements()[1];
+    EXPECT_EQ(update.executions, 1);
+    EXPECT_GE(update.nanoseconds[static_cast<int>(Phase::Execute)], 2000000);
+    EXPECT_EQ(profile.transactions(TransactionType::Payment), 2);
+    EXPECT_EQ(profile.transactions(TransactionType::NewOrder), 0);
+    EXPECT_GE(profile.nanoseconds(TransactionType::Payment, Phase::Execute), 6000000);
+    EXPECT_EQ(profile.nanoseconds(TransactionType::NewOrder, Phase::Execute), 0);
+    EXPECT_STREQ(phaseName(Phase::Decode), "Decode");
+}
+
+TEST(TPCPhases, registry) {
+    EXPECT_EQ(PhaseRegistry::active(), nullptr);
+    markPhase("getCustomer", Phase::Execute);
+
+    // The same statement on two terminals is merged by name
+    for (int thread = 0; thread < 2; ++thread) {
+        auto &profile = PhaseRegistry::forThread(thread);
+        EXPECT_EQ(PhaseRegistry::active(), &profile);
+        profile.begin(TransactionType::NewOrder);
+        markPhase("getItem", Phase::Execute);
+        markPhase(thread == 0 ? "getStock" : "getItem", Phase::Execute);
+        profile.end();
+    }
+    PhaseRegistry::deactivate();
+    EXPECT_EQ(PhaseRegistry::active(), nullptr);
+    auto merged = PhaseRegistry::merge(2);
+    ASSERT_EQ(merged.statements().size(), 2u);
+    EXPECT_EQ(merged.statements()[0].statement, "getItem");
+    EXPECT_EQ(merged.statements()[0].executions, 3);
+    EXPECT_EQ(merged.statements()[1].executions, 1);
+    EXPECT_EQ(merged.transactions(TransactionType::NewOrder), 2);
+    // A new run resets the slot
+    EXPECT_TRUE(PhaseRegistry::forThread(1).statements().empty());
+    PhaseRegistry::deactivate();
+}
+
+// Conflicts
+TEST(TPCConflicts, map) {
+    ConflictMap conflicts;
+    // Ignored outside a transaction
+    conflicts.record(ConflictKind::Abort);
+    EXPECT_TRUE(conflicts.sites().empty());
+
+    conflicts.begin(TransactionType::NewOrder);
+    conflicts.markKey(2, 7);
+    conflicts.markStatement("getDistrict");
+    conflicts.markStatement("incrementNextOrderId");
+    conflicts.record(ConflictKind::Retry);
+    conflicts.record(ConflictKind::Abort);
+    conflicts.end();
+    conflicts.begin(TransactionType::Payment);
+    conflicts.record(ConflictKind::Abort);
+    conflicts.end();
+
+    ASSERT_EQ(conflicts.sites().size(), 2u);
+    auto &newOrder = *conflicts.sites().begin();
+    EXPECT_EQ(newOrder.first.statement, "incrementNextOrderId");
+    EXPECT_EQ(newOrder.first.wId, 2);
+    EXPECT_EQ(newOrder.first.dId, 7);
+    EXPECT_EQ(newOrder.second[static_cast<int>(ConflictKind::Abort)], 1);
+    EXPECT_EQ(newOrder.second[static_cast<int>(ConflictKind::Retry)], 1);
+    // Nothing marked yet
+    auto &payment = *conflicts.sites().rbegin();
+    EXPECT_EQ(payment.first.statement, "unknown");
+    EXPECT_EQ(payment.first.wId, 0);
+    EXPECT_EQ(conflicts.total(ConflictKind::Abort), 2);
+    EXPECT_EQ(conflicts.total(ConflictKind::Retry), 1);
+}
+
+TEST(TPCConflicts, registry) {
+    auto params = ScaleParameters::makeDefault(2);
+    recordConflict(ConflictKind::Abort);
+    for (int thread = 0; thread < 2; ++thread) {
+        auto &conflicts = ConflictRegistry::forThread(thread);
+        EXPECT_EQ(ConflictRegistry::active(), &conflicts);
+        conflicts.begin(TransactionType::StockLevel);
+        // The parameter generators and markPhase name the site
+        RandomHelper::setHome({2, 4});
+        StockLevelParams stock;
+        randomHelper.generateStockLevelParams(params, stock);
+        markPhase("getStockCount", Phase::Execute);
+        recordConflict(ConflictKind::Retry);
+        conflicts.end();
+    }
+    RandomHelper::setHome({});
+    ConflictRegistry::deactivate();
+    auto merged = ConflictRegistry::merge(2);
+    ASSERT_EQ(merged.sites().size(), 1u);
+    auto &site = *merged.sites().begin();
+    EXPECT_EQ(site.first.type, TransactionType::StockLevel);
+    EXPECT_EQ(site.first.statement, "getStockCount");
+    EXPECT_EQ(site.first.wId, 2);
+    EXPECT_EQ(site.first.dId, 4);
+    EXPECT_EQ(merged.total(ConflictKind::Retry), 2);
+    // A new run resets the slot
+    EXPECT_TRUE(ConflictRegistry::forThread(1).sites().empty());
+    ConflictRegistry::deactivate();
+}
+
+// Window
+TEST(TPCWindow, stages) {
+    MeasurementWindow window;
+    window.rampUp = chrono::duration<double>(2);
+    window.measure = chrono::duration<double>(3);
+    window.rampDown = chrono::duration<double>(1);
+    EXPECT_EQ(window.total().count(), 6);
+    EXPECT_EQ(window.stageAt(chrono::duration<double>(0)), RunStage::RampUp);
+    EXPECT_EQ(window.stageAt(chrono::duration<double>(1.99)), RunStage::RampUp);
+    EXPECT_EQ(window.stageAt(chrono::duration<double>(2)), RunStage::Measure);
+    EXPECT_EQ(window.stageAt(chrono::duration<double>(4.99)), RunStage::Measure);
+    EXPECT_EQ(window.stageAt(chrono::duration<double>(5)), RunStage::RampDown);
+    EXPECT_EQ(window.stageAt(chrono::duration<double>(6)), RunStage::Done);
+    EXPECT_STREQ(runStageName(RunStage::RampDown), "rampDown");
+}
+
+TEST(TPCWindow, environment) {
+    unsetenv("DBPHD_RAMP_UP");
+    unsetenv("DBPHD_MEASURE");
+    unsetenv("DBPHD_RAMP_DOWN");
+    auto defaults = MeasurementWindow::fromEnvironment();
+    EXPECT_EQ(defaults.rampUp.count(), 10);
+    EXPECT_EQ(defaults.measure.count(), 60);
+    EXPECT_EQ(defaults.rampDown.count(), 5);
+
+    setenv("DBPHD_RAMP_UP", "0", 1);
+    setenv("DBPHD_MEASURE", "2.5", 1);
+    setenv("DBPHD_RAMP_DOWN", "soon", 1);
+    auto window = MeasurementWindow::fromEnvironment();
+    EXPECT_EQ(window.rampUp.count(), 0);
+    EXPECT_EQ(window.measure.count(), 2.5);
+    EXPECT_EQ(window.rampDown.count(), 5);
+    // A measurement window can't be empty
+    setenv("DBPHD_MEASURE", "0", 1);
+    EXPECT_EQ(MeasurementWindow::fromEnvironment().measure.count(), 60);
+    unsetenv("DBPHD_RAMP_UP");
+    unsetenv("DBPHD_MEASURE");
+    unsetenv("DBPHD_RAMP_DOWN");
+}
+
+TEST(TPCWindow, throughput) {
+    for (int thread = 0; thread < 2; ++thread) {
+        auto &series = ThroughputRegistry::forThread(thread);
+        series.record(chrono::duration<double>(0.5));
+        series.record(chrono::duration<double>(2.1));
+        if (thread == 1)
+            series.record(chrono::duration<double>(3.9));
+    }
+    auto merged = ThroughputRegistry::merge(2);
+    EXPECT_EQ(merged.perSecond(), vector<int64_t>({2, 0, 2, 1}));
+    // A new run resets the slot
+    EXPECT_TRUE(ThroughputRegistry::forThread(1).perSecond().empty());
+
+    EXPECT_EQ(coefficientOfVariation({100, 100, 100}, 0, 3), 0);
+    EXPECT_NEAR(coefficientOfVariation({50, 150}, 0, 2), 0.5, 1e-9);
+    EXPECT_EQ(coefficientOfVariation({0, 0}, 0, 2), 0);
+    EXPECT_EQ(coefficientOfVariation({1, 2}, 2, 5), 0);
+}
+
+TEST(TPCWindow, steadyState) {
+    // Warming up for four seconds, then flat
+    vector<int64_t> warming{0, 100, 400, 800, 1000, 1010, 990, 1000, 1005, 995};
+    EXPECT_EQ(steadyStateStart(warming), 4);
+    EXPECT_EQ(steadyStateStart(warming, 3), 4);
+    vector<int64_t> wild{1000, 100, 1000, 100, 1000, 100, 1000, 100};
+    EXPECT_EQ(steadyStateStart(wild), -1);
+    EXPECT_EQ(steadyStateStart({}), -1);
+    // A handful of transactions per second can't be steadier than Poisson noise
+    EXPECT_EQ(steadyStateStart({4, 6, 5, 3, 5}), 0);
+}
+
+// Snapshots
+TEST(TPCSnapshot, datasetKey) {
+    auto params = ScaleParameters::makeDefault(4);
+    DatasetKey key{"postgres", "old", params, 0};
+    EXPECT_EQ(key.name(), "tpcc_postgres_old_v" + to_string(DATASET_VERSION) +
+                              "_w1_4_i100000_d10_c3000_n900_s0");
+    // Postgres identifiers and MongoDB database names
+    EXPECT_LT(key.name().size(), 64u);
+    DatasetKey other{"postgres", "old", ScaleParameters::makeDefault(2), 0};
+    EXPECT_NE(key.name(), other.name());
+    other = {"postgres", "old", params, 42};
+    EXPECT_NE(key.name(), other.name());
+    // Never overwrites the snapshot of a fresh load
+    other = key;
+    other.resized = true;
+    EXPECT_EQ(other.name(), key.name() + "_r");
+    EXPECT_TRUE(key.sameScale(other));
+    other.seed = 42;
+    EXPECT_FALSE(key.sameScale(other));
+}
+
+TEST(TPCSnapshot, resize) {
+    DatasetKey four{"mongodb", "modern", ScaleParameters::makeDefault(4), 0};
+    DatasetKey eight{"mongodb", "modern", ScaleParameters::makeDefault(8), 0};
+    EXPECT_TRUE(four.resizesTo(eight));
+    EXPECT_TRUE(eight.resizesTo(four));
+    EXPECT_FALSE(four.resizesTo(four));
+    DatasetKey other = eight;
+    other.model = "old";
+    EXPECT_FALSE(four.resizesTo(other));
+    other = eight;
+    other.params.customersPerDistrict = 100;
+    EXPECT_FALSE(four.resizesTo(other));
+
+    auto added = warehouseRange(eight.params, 5, 8);
+    EXPECT_EQ(added.startingWarehouse, 5);
+    EXPECT_EQ(added.endingWarehouse, 8);
+    EXPECT_EQ(added.warehouses, 4);
+    EXPECT_EQ(added.items, eight.params.items);
+}
+
+TEST(TPCSnapshot, environment) {
+    unsetenv("DBPHD_SNAPSHOTS");
+    unsetenv("DBPHD_SNAPSHOT_DIR");
+    unsetenv("DBPHD_SEED");
+    EXPECT_TRUE(snapshotsEnabled());
+    EXPECT_EQ(snapshotDirectory(), "snapshots");
+    EXPECT_EQ(loadSeed(), 0u);
+    setenv("DBPHD_SNAPSHOTS", "0", 1);
+    setenv("DBPHD_SNAPSHOT_DIR", "/tmp/tpcc", 1);
+    setenv("DBPHD_SEED", "42", 1);
+    EXPECT_FALSE(snapshotsEnabled());
+    EXPECT_EQ(snapshotDirectory(), "/tmp/tpcc");
+    EXPECT_EQ(loadSeed(), 42u);
+    // Seeded loader threads generate the same data every time
+    seedLoader(1);
+    int first = randomHelper.number(1, 1000000);
+    seedLoader(1);
+    EXPECT_EQ(randomHelper.number(1, 1000000), first);
+    setenv("DBPHD_SEED", "many", 1);
+    EXPECT_EQ(loadSeed(), 0u);
+    unsetenv("DBPHD_SNAPSHOTS");
+    unsetenv("DBPHD_SNAPSHOT_DIR");
+    unsetenv("DBPHD_SEED");
+}
+
+// In-memory engine
+TEST(TPCMemory, transactions) {
+    auto params = ScaleParameters::makeScaled(2, 100);
+    MemoryDatabase database;
+    database.load(params);
+    EXPECT_EQ(database.district(2, 3).dNextOId, params.customersPerDistrict + 1);
+
+    NewOrderParams noparams;
+    randomHelper.generateNewOrderParams(params, noparams);
+    noparams.wId = 2;
+    noparams.dId = 3;
+    noparams.iIds.back() = params.items + 1;
+    EXPECT_FALSE(database.newOrder(noparams));
+    EXPECT_EQ(database.district(2, 3).dNextOId, params.customersPerDistrict + 1);
+    noparams.iIds.back() = 1;
+    EXPECT_TRUE(database.newOrder(noparams));
+    EXPECT_EQ(database.district(2, 3).dNextOId, params.customersPerDistrict + 2);
+
+    OrderStatusParams osparams{2, 3, noparams.cId, ""};
+    EXPECT_EQ(database.orderStatus(osparams), (int)noparams.iIds.size());
+
+    PaymentParams pparams;
+    randomHelper.generatePaymentParams(params, pparams);
+    double wYtd = database.warehouse(pparams.wId).wYtd;
+    double dYtd = database.district(pparams.wId, pparams.dId).dYtd;
+    database.payment(pparams);
+    EXPECT_DOUBLE_EQ(database.warehouse(pparams.wId).wYtd, wYtd + pparams.hAmount);
+    EXPECT_DOUBLE_EQ(database.district(pparams.wId, pparams.dId).dYtd,
+                     dYtd + pparams.hAmount);
+
+    DeliveryParams dparams;
+    randomHelper.generateDeliveryParams(params, dparams);
+    EXPECT_EQ(database.delivery(dparams), params.districtsPerWarehouse);
+
+    StockLevelParams sparams{2, 3, MAX_QUANTITY + 1};
+    EXPECT_GT(database.stockLevel(sparams), 0);
+
+    map<string, double> anomalies;
+    database.checkConsistency(anomalies);
+    EXPECT_EQ(anomalies["anomalyWarehouseYtd"], 0);
+    EXPECT_EQ(anomalies["anomalyDistrictNextOId"], 0);
+    EXPECT_EQ(anomalies["anomalyNewOrderGaps"], 0);
+}
+
+TEST(TPCMemory, concurrentTerminals) {
+    auto params = ScaleParameters::makeScaled(2, 100);
+    MemoryDatabase database;
+    MemoryBackend(database).load(params, 4);
+    vector<thread> terminals;
+    for (int t = 0; t < 4; ++t) {
+        terminals.emplace_back([&]() {
+            MemoryBackend backend(database);
+            for (int i = 0; i < 2000; ++i) {
+                switch (randomHelper.nextTransactionType()) {
+                case TransactionType::NewOrder:
+                    backend.newOrder(params);
+                    break;
+                case TransactionType::Payment:
+                    backend.payment(params);
+                    break;
+                case TransactionType::OrderStatus:
+                    backend.orderStatus(params);
+                    break;
+                case TransactionType::Delivery:
+                    backend.delivery(params);
+                    break;
+                case TransactionType::StockLevel:
+                    backend.stockLevel(params);
+                    break;
+                }
+            }
+        });
+    }
+    for (auto &terminal : terminals) {
+        terminal.join();
+    }
+    map<string, double> anomalies;
+    MemoryBackend(database).finish(anomalies);
+    EXPECT_EQ(anomalies["anomalyWarehouseYtd"], 0);
+    EXPECT_EQ(anomalies["anomalyDistrictNextOId"], 0);
+    EXPECT_EQ(anomalies["anomalyNewOrderGaps"], 0);
+}